@@ -0,0 +1,591 @@
+// ============================================================================
+// native_audio_bench - capture pipeline benchmark on a synthetic device
+//
+// Runs N sessions of one scenario against the synthetic device and reports
+// what performance work on the library needs to compare between versions:
+//
+//   direct     one platform session per recorder (the default path)
+//   shared     N subscribers of one CaptureEngine capture, each converting
+//   combined   N CombinedCaptures, each aligning a microphone and system source
+//
+// Every chunk goes through an event queue built like the addon's: a
+// ChunkRecordHeader plus payload in an SpscRing (or a ChunkPool slab with
+// --zero-copy), dropping the oldest record when full. A consumer thread
+// drains all queues on a fixed interval, standing in for the JS event loop, and
+// measures latency from each chunk's host time to its delivery.
+//
+// The signal is deterministic (see synthetic_device.h), so two runs with the
+// same arguments do the same work.
+// ============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "audio_bridge.h"
+#include "audio_dsp.h"
+#include "capture_engine.h"
+#include "capture_stats.h"
+#include "chunk_pool.h"
+#include "combined_capture.h"
+#include "duration_histogram.h"
+#include "spsc_ring.h"
+#include "synthetic_device.h"
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+
+namespace {
+std::atomic<uint64_t> gAllocations{0};
+}
+
+void* operator new(size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// ============================================================================
+// Options
+// ============================================================================
+
+enum class Scenario { Direct, Shared, Combined };
+
+struct BenchOptions {
+    Scenario scenario = Scenario::Direct;
+    int sessions = 8;
+    SyntheticDeviceConfig device;
+    double sampleRate = 16000;      // Output; 0 keeps the device rate
+    bool stereo = false;
+    double chunkDurationMs = 100;
+    ResamplerQuality quality = ResamplerQuality::Balanced;
+    double seconds = 5;
+    double warmupSeconds = 1;
+    double pollMs = 5;
+    bool zeroCopy = false;
+    size_t queueCapacityBytes = 1024 * 1024;
+    bool json = false;
+};
+
+void PrintUsage() {
+    std::printf(
+        "usage: native_audio_bench [options]\n"
+        "  --scenario direct|shared|combined   capture path to exercise (direct)\n"
+        "  --sessions N                        concurrent recorders (8)\n"
+        "  --channels N                        device channels (2)\n"
+        "  --device-rate HZ                    device sample rate (48000)\n"
+        "  --packet-frames N                   frames per device callback (480)\n"
+        "  --rate HZ                           output sample rate, 0 = device rate (16000)\n"
+        "  --stereo                            keep two channels instead of downmixing\n"
+        "  --chunk-ms MS                       chunk duration (100)\n"
+        "  --quality fast|balanced|high        resampler quality (balanced)\n"
+        "  --seconds S                         measured duration (5)\n"
+        "  --warmup S                          unmeasured lead-in (1)\n"
+        "  --poll-ms MS                        consumer drain interval (5)\n"
+        "  --freerun                           generate packets as fast as possible (no latency)\n"
+        "  --zero-copy                         queue ChunkPool slabs instead of copies\n"
+        "  --queue-bytes N                     event queue capacity (1048576)\n"
+        "  --seed N                            signal seed (1)\n"
+        "  --json                              print one JSON object\n");
+}
+
+bool ParseOptions(int argc, char** argv, BenchOptions* options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&](const char** out) {
+            if (i + 1 >= argc) return false;
+            *out = argv[++i];
+            return true;
+        };
+        const char* v = nullptr;
+
+        if (arg == "--stereo") {
+            options->stereo = true;
+        } else if (arg == "--freerun") {
+            options->device.realtime = false;
+        } else if (arg == "--zero-copy") {
+            options->zeroCopy = true;
+        } else if (arg == "--json") {
+            options->json = true;
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (!value(&v)) {
+            return false;
+        } else if (arg == "--scenario") {
+            std::string s = v;
+            if (s == "direct") options->scenario = Scenario::Direct;
+            else if (s == "shared") options->scenario = Scenario::Shared;
+            else if (s == "combined") options->scenario = Scenario::Combined;
+            else return false;
+        } else if (arg == "--quality") {
+            std::string s = v;
+            if (s == "fast") options->quality = ResamplerQuality::Fast;
+            else if (s == "balanced") options->quality = ResamplerQuality::Balanced;
+            else if (s == "high") options->quality = ResamplerQuality::High;
+            else return false;
+        } else if (arg == "--sessions") {
+            options->sessions = std::atoi(v);
+        } else if (arg == "--channels") {
+            options->device.channels = static_cast<uint32_t>(std::atoi(v));
+        } else if (arg == "--device-rate") {
+            options->device.sampleRate = std::atof(v);
+        } else if (arg == "--packet-frames") {
+            options->device.packetFrames = static_cast<uint32_t>(std::atoi(v));
+        } else if (arg == "--rate") {
+            options->sampleRate = std::atof(v);
+        } else if (arg == "--chunk-ms") {
+            options->chunkDurationMs = std::atof(v);
+        } else if (arg == "--seconds") {
+            options->seconds = std::atof(v);
+        } else if (arg == "--warmup") {
+            options->warmupSeconds = std::atof(v);
+        } else if (arg == "--poll-ms") {
+            options->pollMs = std::atof(v);
+        } else if (arg == "--queue-bytes") {
+            options->queueCapacityBytes = static_cast<size_t>(std::atoll(v));
+        } else if (arg == "--seed") {
+            options->device.seed = static_cast<uint32_t>(std::atoi(v));
+        } else {
+            return false;
+        }
+    }
+    return options->sessions > 0 && options->device.channels > 0 && options->device.sampleRate > 0 &&
+           options->device.packetFrames > 0 && options->seconds > 0;
+}
+
+const char* ScenarioName(Scenario scenario) {
+    switch (scenario) {
+        case Scenario::Direct: return "direct";
+        case Scenario::Shared: return "shared";
+        case Scenario::Combined: return "combined";
+    }
+    return "";
+}
+
+// Process CPU time, all threads, in seconds
+double CpuSeconds() {
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto seconds = [](const FILETIME& t) {
+        return static_cast<double>((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 1e7;
+    };
+    return seconds(kernel) + seconds(user);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+// ============================================================================
+// Event queue, laid out like the addon's
+// ============================================================================
+
+struct ChunkRecordHeader {
+    AudioChunkInfo info;
+    uint64_t sequence;
+};
+
+constexpr uint32_t kEventData = 0;
+constexpr uint32_t kEventDataSlab = 100;
+
+class EventQueue {
+public:
+    EventQueue(size_t capacityBytes, std::shared_ptr<ChunkPool> pool) : ring_(capacityBytes), pool_(std::move(pool)) {}
+
+    // Producer: the capture callback
+    void WriteChunk(const uint8_t* data, size_t size, const AudioChunkInfo& info) {
+        ChunkRecordHeader header;
+        header.info = info;
+        header.sequence = sequence_++;
+
+        ChunkPool::Slab* slab = pool_ ? pool_->Acquire(size) : nullptr;
+        if (slab) {
+            memcpy(slab->data, data, size);
+            if (!WriteRecord(kEventDataSlab, header, &slab, sizeof(slab))) {
+                ChunkPool::Release(slab);
+            }
+        } else {
+            WriteRecord(kEventData, header, data, size);
+        }
+    }
+
+    // Consumer: deliver every queued chunk, recording its latency into `latency`
+    uint64_t Drain(std::vector<uint8_t>& scratch, DurationHistogram* latency) {
+        uint64_t now = audio_stats_now_ns();
+        uint64_t delivered = 0;
+
+        SpscRing::Record record;
+        while (ring_.Peek(&record)) {
+            ChunkRecordHeader header;
+            memcpy(&header, record.payload, sizeof(header));
+            const uint8_t* payload = record.payload + sizeof(header);
+            size_t payloadSize = record.header.size - sizeof(header);
+
+            if (record.header.type == kEventDataSlab) {
+                ChunkPool::Slab* slab;
+                memcpy(&slab, payload, sizeof(slab));
+                if (!ring_.Claim(record)) continue;
+                // JS would hold the slab until GC; hand it straight back
+                ChunkPool::Release(slab);
+            } else {
+                // Stands in for Buffer::Copy, without counting V8's allocation
+                if (scratch.size() < payloadSize) scratch.resize(payloadSize);
+                memcpy(scratch.data(), payload, payloadSize);
+                if (!ring_.Claim(record)) continue;
+            }
+
+            delivered++;
+            if (latency && header.info.hostTimeNs != 0 && now > header.info.hostTimeNs) {
+                latency->Record(now - header.info.hostTimeNs);
+            }
+        }
+        return delivered;
+    }
+
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    size_t HighWater() const { return highWater_.load(std::memory_order_relaxed); }
+    size_t Capacity() const { return ring_.Capacity(); }
+
+private:
+    bool WriteRecord(uint32_t type, const ChunkRecordHeader& header, const void* payload, size_t size) {
+        size_t recordSize = sizeof(header) + size;
+        if (recordSize > ring_.MaxPayload()) {
+            dropped_++;
+            return false;
+        }
+
+        uint8_t* dest;
+        while ((dest = ring_.BeginWrite(recordSize)) == nullptr) {
+            SpscRing::Record oldest;
+            if (!ring_.DropOldest(&oldest)) {
+                dropped_++;
+                return false;
+            }
+            if (oldest.header.type == kEventDataSlab) {
+                ChunkPool::Slab* slab;
+                memcpy(&slab, oldest.payload + sizeof(ChunkRecordHeader), sizeof(slab));
+                ChunkPool::Release(slab);
+            }
+            dropped_++;
+        }
+
+        memcpy(dest, &header, sizeof(header));
+        memcpy(dest + sizeof(header), payload, size);
+        ring_.CommitWrite(type, static_cast<uint32_t>(recordSize), seq_++);
+
+        size_t used = ring_.Used();
+        if (used > highWater_.load(std::memory_order_relaxed)) {
+            highWater_.store(used, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    SpscRing ring_;
+    std::shared_ptr<ChunkPool> pool_;
+    uint64_t sequence_ = 0;
+    uint64_t seq_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<size_t> highWater_{0};
+};
+
+// ============================================================================
+// Sessions
+// ============================================================================
+
+struct BenchSession {
+    std::unique_ptr<EventQueue> queue;
+    AudioRecorderHandle handle = nullptr;
+    std::unique_ptr<CaptureSubscription> subscription;
+    std::unique_ptr<CombinedCapture> combined;
+    std::atomic<uint64_t> errors{0};
+
+    static void OnData(const uint8_t* data, int32_t length, const AudioChunkInfo* info, void* context) {
+        static_cast<BenchSession*>(context)->queue->WriteChunk(data, static_cast<size_t>(length), *info);
+    }
+
+    static void OnEvent(int32_t eventType, const char* message, void* context) {
+        if (eventType == 2) {
+            static_cast<BenchSession*>(context)->errors++;
+            std::fprintf(stderr, "capture error: %s\n", message ? message : "");
+        }
+    }
+
+    static void OnMetadata(double, uint32_t, uint32_t, bool, const char*, void*) {}
+
+    void GetStats(AudioStatsSnapshot* stats) const {
+        *stats = {};
+        if (subscription) {
+            subscription->GetStats(stats);
+        } else if (combined) {
+            combined->GetStats(stats);
+        } else if (handle) {
+            audio_get_stats(handle, stats);
+        }
+    }
+
+    void Stop() {
+        subscription.reset();
+        combined.reset();
+        if (handle) {
+            audio_destroy(handle);
+            handle = nullptr;
+        }
+    }
+};
+
+int32_t StartSession(BenchSession& session, const BenchOptions& options) {
+    int32_t result = 0;
+    switch (options.scenario) {
+        case Scenario::Direct: {
+            session.handle = audio_create(&BenchSession::OnData, &BenchSession::OnEvent, &BenchSession::OnMetadata,
+                                          &session);
+            audio_set_resampler_quality(session.handle, static_cast<int32_t>(options.quality));
+            result = audio_start_system_audio(session.handle, options.sampleRate, options.chunkDurationMs, false,
+                                              !options.stereo, true, nullptr, 0, nullptr, 0);
+            break;
+        }
+        case Scenario::Shared: {
+            CaptureSource source;
+            SubscriberFormat format;
+            format.sampleRate = options.sampleRate;
+            format.chunkDurationMs = options.chunkDurationMs;
+            format.mono = !options.stereo;
+            format.quality = options.quality;
+            session.subscription = CaptureEngine::Subscribe(source, format, &BenchSession::OnData,
+                                                            &BenchSession::OnEvent, &BenchSession::OnMetadata,
+                                                            &session, &result);
+            break;
+        }
+        case Scenario::Combined: {
+            CombinedCaptureOptions combined;
+            combined.sampleRate = options.sampleRate > 0 ? options.sampleRate : options.device.sampleRate;
+            combined.chunkDurationMs = options.chunkDurationMs;
+            combined.mono = !options.stereo;
+            combined.quality = options.quality;
+            session.combined = CombinedCapture::Start(combined, &BenchSession::OnData, &BenchSession::OnEvent,
+                                                      &BenchSession::OnMetadata, &session, &result);
+            break;
+        }
+    }
+    return result;
+}
+
+// Largest chunk a session delivers, for sizing zero-copy slabs
+size_t ChunkBytesFor(const BenchOptions& options) {
+    double rate = options.sampleRate > 0 ? options.sampleRate : options.device.sampleRate;
+    uint32_t channels = options.stereo ? options.device.channels : 1;
+    if (options.scenario == Scenario::Combined) channels = (options.stereo ? 2 : 1) * 2;
+    return static_cast<size_t>(rate * options.chunkDurationMs / 1000.0 + 1) * channels * sizeof(float);
+}
+
+struct Totals {
+    uint64_t framesCaptured = 0;
+    uint64_t framesEmitted = 0;
+    uint64_t framesDropped = 0;
+    uint64_t callbackCount = 0;
+    uint64_t callbackP50Ns = 0;     // Worst session
+    uint64_t callbackP99Ns = 0;
+    uint64_t callbackMaxNs = 0;
+    uint64_t conversionNs = 0;
+};
+
+Totals CollectTotals(const std::vector<std::unique_ptr<BenchSession>>& sessions) {
+    Totals totals;
+    for (const auto& session : sessions) {
+        AudioStatsSnapshot stats;
+        session->GetStats(&stats);
+        totals.framesCaptured += stats.framesCaptured;
+        totals.framesEmitted += stats.framesEmitted;
+        totals.framesDropped += stats.framesDropped;
+        totals.callbackCount += stats.callbackCount;
+        totals.callbackP50Ns = std::max(totals.callbackP50Ns, stats.callbackP50Ns);
+        totals.callbackP99Ns = std::max(totals.callbackP99Ns, stats.callbackP99Ns);
+        totals.callbackMaxNs = std::max(totals.callbackMaxNs, stats.callbackMaxNs);
+        totals.conversionNs += stats.conversionNs;
+    }
+    return totals;
+}
+
+double Ms(uint64_t ns) {
+    return static_cast<double>(ns) / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage();
+        return 2;
+    }
+    synthetic_device_configure(options.device);
+
+    std::vector<std::unique_ptr<BenchSession>> sessions;
+    for (int i = 0; i < options.sessions; i++) {
+        auto session = std::make_unique<BenchSession>();
+        std::shared_ptr<ChunkPool> pool;
+        if (options.zeroCopy) {
+            pool = ChunkPool::Create(ChunkBytesFor(options), ChunkPoolSlabCountFor(options.chunkDurationMs));
+        }
+        session->queue = std::make_unique<EventQueue>(options.queueCapacityBytes, pool);
+        sessions.push_back(std::move(session));
+    }
+
+    // Consumer: drains every queue each poll interval
+    std::atomic<bool> consuming{true};
+    std::atomic<bool> measuring{false};
+    std::atomic<uint64_t> delivered{0};
+    DurationHistogram latency;
+    std::thread consumer([&] {
+        std::vector<uint8_t> scratch(ChunkBytesFor(options) + 1024);
+        auto interval = std::chrono::duration<double, std::milli>(options.pollMs);
+        while (consuming.load()) {
+            std::this_thread::sleep_for(interval);
+            // Free-running host times don't follow the audio, so latency means nothing there
+            bool measure = measuring.load();
+            DurationHistogram* histogram = measure && options.device.realtime ? &latency : nullptr;
+            for (auto& session : sessions) {
+                uint64_t n = session->queue->Drain(scratch, histogram);
+                if (measure) delivered += n;
+            }
+        }
+    });
+
+    for (auto& session : sessions) {
+        int32_t result = StartSession(*session, options);
+        if (result != 0) {
+            std::fprintf(stderr, "failed to start session: %d\n", result);
+            consuming = false;
+            consumer.join();
+            return 1;
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.warmupSeconds));
+
+    Totals before = CollectTotals(sessions);
+    uint64_t allocationsBefore = gAllocations.load();
+    double cpuBefore = CpuSeconds();
+    auto wallBefore = std::chrono::steady_clock::now();
+    measuring = true;
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+
+    measuring = false;
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallBefore).count();
+    double cpu = CpuSeconds() - cpuBefore;
+    uint64_t allocations = gAllocations.load() - allocationsBefore;
+    Totals after = CollectTotals(sessions);
+
+    for (auto& session : sessions) {
+        session->Stop();
+    }
+    consuming = false;
+    consumer.join();
+
+    uint64_t dropped = 0;
+    size_t highWater = 0;
+    uint64_t errors = 0;
+    for (const auto& session : sessions) {
+        dropped += session->queue->Dropped();
+        highWater = std::max(highWater, session->queue->HighWater());
+        errors += session->errors.load();
+    }
+
+    // Device audio processed, in seconds of one stream. Combined sessions run
+    // two sources, which the captured counter already includes, and count
+    // them after each source's conversion to the common rate.
+    uint64_t captured = after.framesCaptured - before.framesCaptured;
+    double capturedRate = options.device.sampleRate;
+    if (options.scenario == Scenario::Combined && options.sampleRate > 0) capturedRate = options.sampleRate;
+    double streamSeconds = static_cast<double>(captured) / capturedRate;
+    double channelSeconds = streamSeconds * options.device.channels;
+    double channelsPerCore = cpu > 0 ? channelSeconds / cpu : 0;
+    double realtimeFactor = wall > 0 ? streamSeconds / wall : 0;
+    double allocationsPerSecond = wall > 0 ? allocations / wall : 0;
+    uint64_t framesDropped = after.framesDropped - before.framesDropped;
+
+    if (options.json) {
+        std::printf(
+            "{\"scenario\":\"%s\",\"sessions\":%d,\"channels\":%u,\"deviceRate\":%.0f,\"packetFrames\":%u,"
+            "\"outputRate\":%.0f,\"chunkMs\":%.1f,\"realtime\":%s,\"zeroCopy\":%s,\"dsp\":\"%s\","
+            "\"wallSeconds\":%.3f,\"cpuSeconds\":%.3f,\"channelsPerCore\":%.1f,\"realtimeFactor\":%.2f,"
+            "\"callbackP50Ms\":%.4f,\"callbackP99Ms\":%.4f,\"callbackMaxMs\":%.4f,"
+            "\"latencyCount\":%llu,\"latencyP50Ms\":%.3f,\"latencyP99Ms\":%.3f,\"latencyMaxMs\":%.3f,"
+            "\"conversionMs\":%.3f,\"allocationsPerSecond\":%.1f,\"chunksDelivered\":%llu,\"chunksDropped\":%llu,"
+            "\"framesDropped\":%llu,\"queueHighWaterBytes\":%zu,\"errors\":%llu}\n",
+            ScenarioName(options.scenario), options.sessions, options.device.channels, options.device.sampleRate,
+            options.device.packetFrames, options.sampleRate, options.chunkDurationMs,
+            options.device.realtime ? "true" : "false", options.zeroCopy ? "true" : "false", audio_dsp_isa(), wall,
+            cpu, channelsPerCore, realtimeFactor, Ms(after.callbackP50Ns), Ms(after.callbackP99Ns),
+            Ms(after.callbackMaxNs), static_cast<unsigned long long>(latency.Count()),
+            Ms(latency.Percentile(0.50)), Ms(latency.Percentile(0.99)), Ms(latency.Max()),
+            Ms(after.conversionNs - before.conversionNs), allocationsPerSecond,
+            static_cast<unsigned long long>(delivered.load()), static_cast<unsigned long long>(dropped),
+            static_cast<unsigned long long>(framesDropped), highWater, static_cast<unsigned long long>(errors));
+    } else {
+        std::printf("scenario          %s, %d sessions, %s\n", ScenarioName(options.scenario), options.sessions,
+                    options.device.realtime ? "realtime" : "freerun");
+        std::printf("device            %u ch @ %.0f Hz, %u-frame packets\n", options.device.channels,
+                    options.device.sampleRate, options.device.packetFrames);
+        std::printf("output            %s @ %.0f Hz, %.0f ms chunks%s, dsp %s\n", options.stereo ? "stereo" : "mono",
+                    options.sampleRate > 0 ? options.sampleRate : options.device.sampleRate, options.chunkDurationMs,
+                    options.zeroCopy ? ", zero-copy" : "", audio_dsp_isa());
+        std::printf("measured          %.2f s wall, %.3f s cpu\n", wall, cpu);
+        std::printf("throughput        %.1f channels per core (%.2fx realtime across sessions)\n", channelsPerCore,
+                    realtimeFactor);
+        std::printf("callback          p50 %.4f  p99 %.4f  max %.4f ms (worst session)\n", Ms(after.callbackP50Ns),
+                    Ms(after.callbackP99Ns), Ms(after.callbackMaxNs));
+        std::printf("latency           p50 %.3f  p99 %.3f  max %.3f ms over %llu chunks\n",
+                    Ms(latency.Percentile(0.50)), Ms(latency.Percentile(0.99)), Ms(latency.Max()),
+                    static_cast<unsigned long long>(latency.Count()));
+        std::printf("conversion        %.3f ms\n", Ms(after.conversionNs - before.conversionNs));
+        std::printf("allocations       %.1f per second\n", allocationsPerSecond);
+        std::printf("queue             %llu delivered, %llu dropped, high water %zu of %zu bytes\n",
+                    static_cast<unsigned long long>(delivered.load()), static_cast<unsigned long long>(dropped),
+                    highWater, sessions.empty() ? 0 : sessions.front()->queue->Capacity());
+        std::printf("frames dropped    %llu\n", static_cast<unsigned long long>(framesDropped));
+        if (errors) {
+            std::printf("errors            %llu\n", static_cast<unsigned long long>(errors));
+        }
+    }
+    return errors ? 1 : 0;
+}
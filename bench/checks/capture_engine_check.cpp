@@ -0,0 +1,134 @@
+// ============================================================================
+// capture_engine_check - CaptureEngine events on the synthetic device
+//
+// The synthetic device warns, as WASAPI does, when a microphone start asks
+// for a latency mode it can't give. The warning is raised inside the platform
+// start, before the first subscriber is attached, so this checks that every
+// subscriber to a shared microphone still hears it, after its start event and
+// ahead of its first chunk, and that a default-mode capture stays quiet.
+// ============================================================================
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture_engine.h"
+#include "check.h"
+#include "synthetic_device.h"
+
+namespace {
+
+struct Recorded {
+    std::mutex mutex;
+    std::vector<int32_t> events;        // -1 marks the first data chunk
+    std::vector<std::string> warnings;
+    bool sawData = false;
+};
+
+void OnData(const uint8_t* data, int32_t length, const AudioChunkInfo* info, void* context) {
+    (void)data;
+    (void)length;
+    (void)info;
+    Recorded* recorded = static_cast<Recorded*>(context);
+    std::lock_guard<std::mutex> lock(recorded->mutex);
+    if (!recorded->sawData) {
+        recorded->sawData = true;
+        recorded->events.push_back(-1);
+    }
+}
+
+void OnEvent(int32_t eventType, const char* message, void* context) {
+    Recorded* recorded = static_cast<Recorded*>(context);
+    std::lock_guard<std::mutex> lock(recorded->mutex);
+    recorded->events.push_back(eventType);
+    if (eventType == 3) {
+        recorded->warnings.push_back(message ? message : "");
+    }
+}
+
+void OnMetadata(double sampleRate, uint32_t channelsPerFrame, uint32_t bitsPerChannel, bool isFloat,
+                const char* encoding, void* context) {
+    (void)sampleRate;
+    (void)channelsPerFrame;
+    (void)bitsPerChannel;
+    (void)isFloat;
+    (void)encoding;
+    (void)context;
+}
+
+std::unique_ptr<CaptureSubscription> Subscribe(const CaptureSource& source, Recorded* recorded) {
+    SubscriberFormat format;
+    format.chunkDurationMs = 20;
+    int32_t result = 0;
+    std::unique_ptr<CaptureSubscription> subscription =
+        CaptureEngine::Subscribe(source, format, &OnData, &OnEvent, &OnMetadata, recorded, &result);
+    CHECK(subscription != nullptr);
+    CHECK(result == 0);
+    return subscription;
+}
+
+// Start, the one warning, data, stop; in that order
+void CheckWarned(Recorded& recorded) {
+    std::lock_guard<std::mutex> lock(recorded.mutex);
+    CHECK(recorded.warnings.size() == 1);
+    CHECK(recorded.events.size() == 4);
+    if (recorded.events.size() == 4) {
+        CHECK(recorded.events[0] == 0);
+        CHECK(recorded.events[1] == 3);
+        CHECK(recorded.events[2] == -1);
+        CHECK(recorded.events[3] == 1);
+    }
+}
+
+}  // namespace
+
+int main() {
+    SyntheticDeviceConfig device;
+    synthetic_device_configure(device);
+
+    CaptureSource source;
+    source.microphone = true;
+    source.latencyMode = 1;
+
+    // The first subscriber starts the capture, the second attaches to it;
+    // both hear the warning the start raised
+    {
+        Recorded first;
+        Recorded second;
+        std::unique_ptr<CaptureSubscription> a = Subscribe(source, &first);
+        std::unique_ptr<CaptureSubscription> b = Subscribe(source, &second);
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        b.reset();
+        a.reset();
+        CheckWarned(first);
+        CheckWarned(second);
+    }
+
+    // A fresh capture of the same source warns its own first subscriber again
+    {
+        Recorded again;
+        std::unique_ptr<CaptureSubscription> a = Subscribe(source, &again);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        a.reset();
+        CheckWarned(again);
+    }
+
+    // The default mode has nothing to fall back from
+    {
+        CaptureSource quiet = source;
+        quiet.latencyMode = 0;
+        Recorded recorded;
+        std::unique_ptr<CaptureSubscription> a = Subscribe(quiet, &recorded);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        a.reset();
+        std::lock_guard<std::mutex> lock(recorded.mutex);
+        CHECK(recorded.warnings.empty());
+        CHECK(recorded.events.size() == 3);
+    }
+
+    return CheckResult("capture_engine_check");
+}
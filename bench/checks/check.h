@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// ============================================================================
+// Minimal assertions for the focused checks next to the benchmark
+//
+// Each check is its own executable registered with ctest. A failed CHECK
+// prints where and what and the check carries on, so one run reports every
+// broken expectation; main returns CheckResult() for ctest to read.
+// ============================================================================
+
+inline int& CheckFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                           \
+    do {                                                                           \
+        if (!(condition)) {                                                        \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            CheckFailures()++;                                                     \
+        }                                                                          \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                    \
+    do {                                                                           \
+        double checkActual_ = static_cast<double>(actual);                         \
+        double checkExpected_ = static_cast<double>(expected);                     \
+        if (!(std::fabs(checkActual_ - checkExpected_) <= (tolerance))) {          \
+            std::fprintf(stderr, "%s:%d: %s = %g, expected %g +- %g\n", __FILE__, __LINE__, #actual, \
+                         checkActual_, checkExpected_, static_cast<double>(tolerance)); \
+            CheckFailures()++;                                                     \
+        }                                                                          \
+    } while (0)
+
+inline int CheckResult(const char* name) {
+    if (CheckFailures() == 0) {
+        std::printf("%s: all checks passed\n", name);
+        return 0;
+    }
+    std::printf("%s: %d check(s) failed\n", name, CheckFailures());
+    return 1;
+}
@@ -0,0 +1,204 @@
+// ============================================================================
+// echo_canceller_check - EchoCanceller convergence on a synthetic echo
+//
+// The reference is amplitude-modulated coloured noise; the microphone hears
+// it through a fixed delay and a decaying room response, over a faint noise
+// floor. Checks the echo return loss enhancement once the filter has
+// converged, the settled delay estimate, that near-end speech during double
+// talk comes through while the filter holds, that the filter recovers after
+// it, and that the microphone passes untouched while the speakers are silent.
+// ============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "check.h"
+#include "echo_canceller.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kRate = 16000;
+constexpr size_t kBlock = 256;
+
+struct Random {
+    uint32_t state;
+
+    // Uniform in [-1, 1)
+    double Next() {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<double>(state >> 8) / (1u << 23) - 1.0;
+    }
+};
+
+// Speech-like far end: low-passed noise with a 3 Hz envelope
+std::vector<float> Reference(size_t frames, uint32_t seed) {
+    Random random{seed};
+    std::vector<float> samples(frames);
+    double smooth = 0;
+    for (size_t i = 0; i < frames; i++) {
+        smooth = 0.9 * smooth + 0.1 * random.Next() * 5;
+        double envelope = 0.5 + 0.5 * std::sin(2 * kPi * 3 * i / kRate);
+        samples[i] = static_cast<float>(0.3 * smooth * envelope);
+    }
+    return samples;
+}
+
+// The reference through `delay` frames and a 40 ms room, plus a noise floor
+std::vector<float> Echo(const std::vector<float>& reference, size_t delay, uint32_t seed) {
+    Random random{seed};
+    std::vector<double> room(static_cast<size_t>(kRate * 0.04));
+    for (size_t k = 0; k < room.size(); k++) {
+        room[k] = 0.1 * std::exp(-static_cast<double>(k) / (kRate * 0.008)) * random.Next();
+    }
+    room[0] = 0.5;
+
+    std::vector<float> mic(reference.size());
+    for (size_t i = 0; i < mic.size(); i++) {
+        double acc = 0;
+        for (size_t k = 0; k < room.size() && k + delay <= i; k++) {
+            acc += room[k] * reference[i - delay - k];
+        }
+        mic[i] = static_cast<float>(acc + 1e-4 * random.Next());
+    }
+    return mic;
+}
+
+// Near-end talker: a modulated 300 Hz tone
+float NearEnd(size_t i) {
+    double envelope = 0.5 + 0.5 * std::sin(2 * kPi * 4 * i / kRate);
+    return static_cast<float>(0.2 * std::sin(2 * kPi * 300 * i / kRate) * envelope);
+}
+
+double Db(double ratio) {
+    return 10 * std::log10(ratio);
+}
+
+// Energy of the echo, and of what is left of it, over [from, to) seconds
+struct Residual {
+    double echo = 0;
+    double left = 0;
+    double near = 0;
+
+    double Erle() const { return Db(echo / (left + 1e-20)); }
+};
+
+Residual Measure(const std::vector<float>& mic, const std::vector<float>& out, const std::vector<float>& near,
+                 double from, double to) {
+    Residual residual;
+    size_t end = std::min(static_cast<size_t>(to * kRate), out.size());
+    for (size_t i = static_cast<size_t>(from * kRate); i < end; i++) {
+        double echo = mic[i] - near[i];
+        double left = out[i] - near[i];
+        residual.echo += echo * echo;
+        residual.left += left * left;
+        residual.near += static_cast<double>(near[i]) * near[i];
+    }
+    return residual;
+}
+
+// Runs whole blocks through the canceller, in place
+void Cancel(EchoCanceller& canceller, std::vector<float>& mic, const std::vector<float>& reference) {
+    for (size_t offset = 0; offset + kBlock <= mic.size(); offset += kBlock) {
+        canceller.Process(&mic[offset], &reference[offset], &mic[offset]);
+    }
+}
+
+void CheckConvergence() {
+    const size_t frames = static_cast<size_t>(kRate * 12);
+    const size_t delay = static_cast<size_t>(kRate * 0.06);
+    std::vector<float> reference = Reference(frames, 1);
+    std::vector<float> mic = Echo(reference, delay, 2);
+
+    // Near-end speech for two seconds once the filter has converged
+    std::vector<float> near(frames, 0.0f);
+    for (size_t i = static_cast<size_t>(kRate * 6); i < static_cast<size_t>(kRate * 8); i++) {
+        near[i] = NearEnd(i);
+        mic[i] += near[i];
+    }
+
+    EchoCanceller canceller(kRate, kBlock, 1, EchoCanceller::kDefaultTailMs);
+    std::vector<float> out = mic;
+    Cancel(canceller, out, reference);
+
+    // Settled within a couple of blocks of the true delay
+    CHECK(canceller.DelayFrames() + 2 * kBlock >= delay && canceller.DelayFrames() <= delay + 2 * kBlock);
+
+    Residual converged = Measure(mic, out, near, 4, 6);
+    CHECK(converged.Erle() > 30);
+
+    // The talker comes through well above what is left of the echo and any
+    // damage adaptation did to it, and the filter is intact afterwards
+    Residual doubleTalk = Measure(mic, out, near, 6, 8);
+    CHECK(Db(doubleTalk.near / doubleTalk.left) > 10);
+    Residual after = Measure(mic, out, near, 9, 12);
+    CHECK(after.Erle() > 30);
+}
+
+// Two microphones in different rooms against a stereo reference
+void CheckStereo() {
+    const size_t frames = static_cast<size_t>(kRate * 8);
+    const size_t delay = static_cast<size_t>(kRate * 0.03);
+    std::vector<float> mono = Reference(frames, 3);
+    std::vector<float> left = Echo(mono, delay, 4);
+    std::vector<float> right = Echo(mono, delay, 5);
+
+    std::vector<float> reference(frames * 2);
+    std::vector<float> mic(frames * 2);
+    for (size_t i = 0; i < frames; i++) {
+        reference[i * 2] = mono[i];
+        reference[i * 2 + 1] = mono[i];
+        mic[i * 2] = left[i];
+        mic[i * 2 + 1] = right[i];
+    }
+
+    EchoCanceller canceller(kRate, kBlock, 2, EchoCanceller::kDefaultTailMs);
+    std::vector<float> out(mic.size());
+    for (size_t offset = 0; offset + kBlock <= frames; offset += kBlock) {
+        canceller.Process(&mic[offset * 2], &reference[offset * 2], &out[offset * 2]);
+    }
+
+    std::vector<float> none(frames, 0.0f);
+    for (size_t c = 0; c < 2; c++) {
+        std::vector<float> micChannel(frames);
+        std::vector<float> outChannel(frames);
+        for (size_t i = 0; i < frames; i++) {
+            micChannel[i] = mic[i * 2 + c];
+            outChannel[i] = out[i * 2 + c];
+        }
+        CHECK(Measure(micChannel, outChannel, none, 5, 8).Erle() > 30);
+    }
+}
+
+// With nothing playing, the microphone is left alone
+void CheckSilentReference() {
+    const size_t frames = static_cast<size_t>(kRate * 2);
+    std::vector<float> reference(frames, 0.0f);
+    std::vector<float> mic(frames);
+    for (size_t i = 0; i < frames; i++) mic[i] = NearEnd(i);
+
+    EchoCanceller canceller(kRate, kBlock, 1, EchoCanceller::kDefaultTailMs);
+    std::vector<float> out = mic;
+    Cancel(canceller, out, reference);
+
+    double worst = 0;
+    for (size_t i = 0; i < frames; i++) worst = std::max(worst, std::fabs(static_cast<double>(out[i]) - mic[i]));
+    CHECK_NEAR(worst, 0, 1e-6);
+    CHECK(canceller.DelayFrames() == 0);
+}
+
+}  // namespace
+
+int main() {
+    CHECK(EchoCanceller::SupportsBlock(kBlock));
+    CHECK(!EchoCanceller::SupportsBlock(160));
+    CHECK(!EchoCanceller::SupportsBlock(16));
+
+    CheckConvergence();
+    CheckStereo();
+    CheckSilentReference();
+    return CheckResult("echo_canceller_check");
+}
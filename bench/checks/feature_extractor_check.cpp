@@ -0,0 +1,281 @@
+// ============================================================================
+// feature_extractor_check - FeatureExtractor framing and log-mel values
+//
+// Each frame is compared against a direct transcription of the definition:
+// a periodic Hann window, a plain DFT in double precision and HTK triangles
+// in mel. Also checks the frame positions and host times across chunk sizes,
+// that a sine lands in the filter around its frequency, the floor on
+// silence, 16-bit stereo input mixed to mono, and a hop longer than the
+// window.
+// ============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+#include "feature_extractor.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kRate = 16000;
+constexpr uint64_t kStartNs = 2000000000ull;
+
+struct Frames {
+    std::vector<float> values;          // frame by frame
+    std::vector<uint64_t> positions;
+    std::vector<uint64_t> hostTimes;
+    uint32_t bins = 0;
+    uint32_t hopFrames = 0;
+    size_t maxBlockFrames = 0;
+};
+
+void Collect(const FeatureBlock& block, void* context) {
+    Frames* frames = static_cast<Frames*>(context);
+    frames->values.insert(frames->values.end(), block.values, block.values + block.frames * block.bins);
+    for (uint32_t f = 0; f < block.frames; f++) {
+        frames->positions.push_back(block.framePosition + f * block.hopFrames);
+        frames->hostTimes.push_back(f == 0 ? block.hostTimeNs : 0);
+    }
+    frames->bins = block.bins;
+    frames->hopFrames = block.hopFrames;
+    frames->maxBlockFrames = std::max<size_t>(frames->maxBlockFrames, block.frames);
+}
+
+uint64_t HostTimeOf(uint64_t frame) {
+    return kStartNs + static_cast<uint64_t>(std::llround(frame * 1e9 / kRate));
+}
+
+// Feeds interleaved `pcm` in chunks of chunkFrames, timed on a steady clock
+Frames Run(FeatureExtractor& extractor, const uint8_t* pcm, size_t frames, size_t frameBytes, size_t chunkFrames) {
+    Frames result;
+    for (size_t offset = 0; offset < frames; offset += chunkFrames) {
+        size_t take = std::min(chunkFrames, frames - offset);
+        AudioChunkInfo info = {};
+        info.framePosition = offset;
+        info.hostTimeNs = HostTimeOf(offset);
+        extractor.Process(pcm + offset * frameBytes, take * frameBytes, info, &Collect, &result);
+    }
+    return result;
+}
+
+// A 1 kHz sine over quiet noise, so every filter has energy well above the floor
+std::vector<float> Signal(size_t frames) {
+    std::vector<float> samples(frames);
+    uint32_t seed = 7;
+    for (size_t i = 0; i < frames; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        double noise = (static_cast<double>(seed >> 8) / (1u << 24) - 0.5) * 0.02;
+        samples[i] = static_cast<float>(0.5 * std::sin(2 * kPi * 1000 * i / kRate) + noise);
+    }
+    return samples;
+}
+
+double Mel(double hz) {
+    return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+// Log-mel frame of mono[start, start + window) by the definition
+std::vector<double> Reference(const std::vector<float>& mono, size_t start, size_t window, size_t fftSize,
+                              uint32_t melBins) {
+    const size_t bins = fftSize / 2 + 1;
+    std::vector<double> power(bins);
+    for (size_t k = 0; k < bins; k++) {
+        double re = 0;
+        double im = 0;
+        for (size_t n = 0; n < window; n++) {
+            double x = mono[start + n] * (0.5 - 0.5 * std::cos(2 * kPi * n / window));
+            re += x * std::cos(2 * kPi * k * n / fftSize);
+            im -= x * std::sin(2 * kPi * k * n / fftSize);
+        }
+        power[k] = re * re + im * im;
+    }
+
+    const double step = Mel(kRate / 2) / (melBins + 1);
+    std::vector<double> out(melBins);
+    for (uint32_t m = 0; m < melBins; m++) {
+        double left = m * step;
+        double center = left + step;
+        double right = center + step;
+        double energy = 0;
+        for (size_t k = 0; k < bins; k++) {
+            double mel = Mel(k * kRate / fftSize);
+            if (mel > left && mel < right) {
+                energy += power[k] * (mel <= center ? mel - left : right - mel) / step;
+            }
+        }
+        out[m] = std::log(std::max(energy, 1e-10));
+    }
+    return out;
+}
+
+void CheckSupports() {
+    PcmFormat format;
+    format.sampleRate = kRate;
+    FeatureOptions options;
+    CHECK(FeatureExtractor::Supports(options, format));
+
+    PcmFormat s24 = format;
+    s24.bitsPerChannel = 24;
+    s24.isFloat = false;
+    CHECK(!FeatureExtractor::Supports(options, s24));
+
+    FeatureOptions wide = options;
+    wide.melBins = FeatureExtractor::kMaxMelBins + 1;
+    CHECK(!FeatureExtractor::Supports(wide, format));
+
+    FeatureOptions high = options;
+    high.maxHz = kRate;
+    CHECK(!FeatureExtractor::Supports(high, format));
+
+    FeatureOptions small = options;
+    small.fftSize = 256;                // Shorter than a 400-frame window
+    CHECK(!FeatureExtractor::Supports(small, format));
+}
+
+// Defaults at 16 kHz: 400-frame windows every 160 frames, 512-point FFT
+void CheckValuesAndFraming() {
+    PcmFormat format;
+    format.sampleRate = kRate;
+    FeatureOptions options;
+
+    const size_t frames = 16000;
+    const size_t expected = (frames - 400) / 160 + 1;
+    std::vector<float> mono = Signal(frames);
+    const uint8_t* pcm = reinterpret_cast<const uint8_t*>(mono.data());
+
+    FeatureExtractor whole(options, format, frames);
+    CHECK(whole.Bins() == 80);
+    Frames reference = Run(whole, pcm, frames, sizeof(float), frames);
+    CHECK(reference.positions.size() == expected);
+    CHECK(reference.bins == 80 && reference.hopFrames == 160);
+    if (reference.positions.size() != expected) return;
+
+    double worst = 0;
+    for (size_t f = 0; f < expected; f += 7) {
+        std::vector<double> want = Reference(mono, f * 160, 400, 512, 80);
+        for (uint32_t m = 0; m < 80; m++) {
+            worst = std::max(worst, std::fabs(reference.values[f * 80 + m] - want[m]));
+        }
+    }
+    CHECK_NEAR(worst, 0, 1e-3);
+
+    // Uneven chunks give the same frames, positions and times; windows that
+    // began in an earlier chunk are timed from the clock anchor
+    for (size_t chunkFrames : {1, 160, 333, 4096}) {
+        FeatureExtractor extractor(options, format, chunkFrames);
+        Frames chunked = Run(extractor, pcm, frames, sizeof(float), chunkFrames);
+        CHECK(chunked.values == reference.values);
+        CHECK(chunked.maxBlockFrames <= extractor.MaxBlockFrames());
+        CHECK(chunked.positions.size() == expected);
+        for (size_t f = 0; f < chunked.positions.size(); f++) {
+            CHECK(chunked.positions[f] == f * 160);
+            if (chunked.hostTimes[f] != 0) {
+                CHECK_NEAR(chunked.hostTimes[f], HostTimeOf(f * 160), 1);
+            }
+        }
+    }
+
+    // The 1 kHz tone peaks in the filter centred nearest 1 kHz
+    const double step = Mel(kRate / 2) / 81;
+    const uint32_t nearest = static_cast<uint32_t>(std::lround(Mel(1000) / step)) - 1;
+    for (size_t f = 0; f < expected; f++) {
+        const float* frame = reference.values.data() + f * 80;
+        uint32_t peak = static_cast<uint32_t>(std::max_element(frame, frame + 80) - frame);
+        CHECK(peak + 1 >= nearest && peak <= nearest + 1);
+    }
+}
+
+void CheckSilence() {
+    PcmFormat format;
+    format.sampleRate = kRate;
+    FeatureOptions options;
+    options.melBins = 40;
+
+    std::vector<float> silence(4000, 0.0f);
+    FeatureExtractor extractor(options, format, 1000);
+    Frames result = Run(extractor, reinterpret_cast<const uint8_t*>(silence.data()), silence.size(), sizeof(float),
+                        1000);
+    CHECK(result.positions.size() == (4000 - 400) / 160 + 1);
+    for (float value : result.values) CHECK(value == std::log(1e-10f));
+}
+
+// The same tone on both channels of 16-bit stereo reads as the float mono
+// signal, up to 16-bit rounding
+void CheckStereoInt16() {
+    const size_t frames = 8000;
+    std::vector<float> mono = Signal(frames);
+    std::vector<int16_t> stereo(frames * 2);
+    std::vector<float> rounded(frames);
+    for (size_t i = 0; i < frames; i++) {
+        int16_t v = static_cast<int16_t>(std::lround(mono[i] * 32768.0f));
+        stereo[i * 2] = v;
+        stereo[i * 2 + 1] = v;
+        rounded[i] = v / 32768.0f;
+    }
+
+    PcmFormat format;
+    format.sampleRate = kRate;
+    format.channels = 2;
+    format.bitsPerChannel = 16;
+    format.isFloat = false;
+    FeatureOptions options;
+    CHECK(FeatureExtractor::Supports(options, format));
+
+    FeatureExtractor extractor(options, format, 441);
+    Frames result = Run(extractor, reinterpret_cast<const uint8_t*>(stereo.data()), frames, 2 * sizeof(int16_t), 441);
+    const size_t expected = (frames - 400) / 160 + 1;
+    CHECK(result.positions.size() == expected);
+    if (result.positions.size() != expected) return;
+
+    double worst = 0;
+    for (size_t f = 0; f < expected; f += 5) {
+        std::vector<double> want = Reference(rounded, f * 160, 400, 512, 80);
+        for (uint32_t m = 0; m < 80; m++) {
+            worst = std::max(worst, std::fabs(result.values[f * 80 + m] - want[m]));
+        }
+    }
+    CHECK_NEAR(worst, 0, 1e-3);
+}
+
+// A 40 ms hop over 25 ms windows skips the samples in between
+void CheckLongHop() {
+    PcmFormat format;
+    format.sampleRate = kRate;
+    FeatureOptions options;
+    options.hopMs = 40;
+
+    const size_t frames = 10000;
+    std::vector<float> mono = Signal(frames);
+    FeatureExtractor extractor(options, format, 700);
+    Frames result = Run(extractor, reinterpret_cast<const uint8_t*>(mono.data()), frames, sizeof(float), 700);
+    const size_t expected = (frames - 400) / 640 + 1;
+    CHECK(result.positions.size() == expected);
+    CHECK(result.hopFrames == 640);
+    if (result.positions.size() != expected) return;
+
+    double worst = 0;
+    for (size_t f = 0; f < expected; f++) {
+        CHECK(result.positions[f] == f * 640);
+        std::vector<double> want = Reference(mono, f * 640, 400, 512, 80);
+        for (uint32_t m = 0; m < 80; m++) {
+            worst = std::max(worst, std::fabs(result.values[f * 80 + m] - want[m]));
+        }
+    }
+    CHECK_NEAR(worst, 0, 1e-3);
+}
+
+}  // namespace
+
+int main() {
+    CheckSupports();
+    CheckValuesAndFraming();
+    CheckSilence();
+    CheckStereoInt16();
+    CheckLongHop();
+    return CheckResult("feature_extractor_check");
+}
@@ -0,0 +1,295 @@
+// ============================================================================
+// file_sink_check - FileSink containers and the header patching on close
+//
+// Writes real files next to the check binary and reads them back: the WAV
+// RIFF and data sizes and the CAF data size patched on close, the format
+// fields, the audio bytes themselves across several write blocks, trimming of
+// preallocated space, a format change ending the data, and Ogg pages with
+// valid CRCs ending on an end-of-stream page.
+// ============================================================================
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "file_sink.h"
+
+namespace {
+
+uint64_t GetLE(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | in[i];
+    return value;
+}
+
+uint64_t GetBE(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) value = (value << 8) | in[i];
+    return value;
+}
+
+std::vector<uint8_t> ReadFile(const std::string& path) {
+    std::vector<uint8_t> bytes;
+    if (FILE* file = fopen(path.c_str(), "rb")) {
+        uint8_t buffer[65536];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) bytes.insert(bytes.end(), buffer, buffer + n);
+        fclose(file);
+    }
+    return bytes;
+}
+
+// Deterministic bytes standing in for audio
+std::vector<uint8_t> Payload(size_t size, uint32_t seed) {
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        bytes[i] = static_cast<uint8_t>(seed >> 24);
+    }
+    return bytes;
+}
+
+std::unique_ptr<FileSink> OpenSink(const std::string& path, FileContainer container, uint64_t preallocate = 0) {
+    FileSinkOptions options;
+    options.path = path;
+    options.container = container;
+    options.preallocateBytes = preallocate;
+    std::string error;
+    std::unique_ptr<FileSink> sink = FileSink::Open(options, &error);
+    if (!sink) std::fprintf(stderr, "%s\n", error.c_str());
+    CHECK(sink != nullptr);
+    return sink;
+}
+
+// Writes `payload` in uneven chunks; the ring is large enough that none drop
+void WriteAll(FileSink& sink, const std::vector<uint8_t>& payload, size_t chunk) {
+    for (size_t offset = 0; offset < payload.size(); offset += chunk) {
+        size_t take = std::min(chunk, payload.size() - offset);
+        CHECK(sink.Write(payload.data() + offset, take));
+    }
+}
+
+void CloseSink(FileSink& sink) {
+    std::string error;
+    bool closed = sink.Close(&error);
+    if (!closed) std::fprintf(stderr, "%s\n", error.c_str());
+    CHECK(closed);
+}
+
+uint32_t OggCrc(const uint8_t* data, size_t size, uint32_t crc) {
+    for (size_t i = 0; i < size; i++) {
+        crc ^= static_cast<uint32_t>(data[i]) << 24;
+        for (int b = 0; b < 8; b++) crc = crc & 0x80000000u ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+    }
+    return crc;
+}
+
+void CheckWav() {
+    // Float stereo, written across several of the sink's 256 KiB blocks
+    {
+        const std::string path = "file_sink_check_f32.wav";
+        std::unique_ptr<FileSink> sink = OpenSink(path, FileContainer::Wav, 8 * 1024 * 1024);
+        if (!sink) return;
+
+        FileSinkFormat format;
+        format.sampleRate = 48000;
+        format.channels = 2;
+        CHECK(sink->Begin(format));
+        std::vector<uint8_t> payload = Payload(3 * 1000 * 1000 + 8, 1);
+        WriteAll(*sink, payload, 3840);
+        CloseSink(*sink);
+        CHECK(sink->BytesWritten() == payload.size());
+        CHECK(sink->BytesDropped() == 0);
+
+        // Preallocated space is trimmed back to the data
+        std::vector<uint8_t> file = ReadFile(path);
+        CHECK(file.size() == 44 + payload.size());
+        if (file.size() < 44) return;
+        CHECK(memcmp(file.data(), "RIFF", 4) == 0 && memcmp(file.data() + 8, "WAVEfmt ", 8) == 0);
+        CHECK(GetLE(file.data() + 4, 4) == 36 + payload.size());
+        CHECK(GetLE(file.data() + 16, 4) == 16);
+        CHECK(GetLE(file.data() + 20, 2) == 3);            // IEEE float
+        CHECK(GetLE(file.data() + 22, 2) == 2);
+        CHECK(GetLE(file.data() + 24, 4) == 48000);
+        CHECK(GetLE(file.data() + 28, 4) == 48000 * 8);
+        CHECK(GetLE(file.data() + 32, 2) == 8);
+        CHECK(GetLE(file.data() + 34, 2) == 32);
+        CHECK(memcmp(file.data() + 36, "data", 4) == 0);
+        CHECK(GetLE(file.data() + 40, 4) == payload.size());
+        CHECK(std::equal(payload.begin(), payload.end(), file.begin() + 44));
+        std::remove(path.c_str());
+    }
+
+    // 16-bit mono; a format change ends the data where it happened
+    {
+        const std::string path = "file_sink_check_s16.wav";
+        std::unique_ptr<FileSink> sink = OpenSink(path, FileContainer::Wav);
+        if (!sink) return;
+
+        FileSinkFormat format;
+        format.sampleRate = 16000;
+        format.channels = 1;
+        format.bitsPerChannel = 16;
+        format.isFloat = false;
+        CHECK(sink->Begin(format));
+        CHECK(sink->Begin(format));                         // Same format: carries on
+        std::vector<uint8_t> payload = Payload(32000, 2);
+        WriteAll(*sink, payload, 640);
+
+        FileSinkFormat changed = format;
+        changed.sampleRate = 48000;
+        CHECK(!sink->Begin(changed));
+        WriteAll(*sink, Payload(6400, 3), 640);             // Ignored
+        CloseSink(*sink);
+
+        std::vector<uint8_t> file = ReadFile(path);
+        CHECK(file.size() == 44 + payload.size());
+        if (file.size() < 44) return;
+        CHECK(GetLE(file.data() + 4, 4) == 36 + payload.size());
+        CHECK(GetLE(file.data() + 20, 2) == 1);            // Integer PCM
+        CHECK(GetLE(file.data() + 24, 4) == 16000);
+        CHECK(GetLE(file.data() + 28, 4) == 32000);
+        CHECK(GetLE(file.data() + 32, 2) == 2);
+        CHECK(GetLE(file.data() + 34, 2) == 16);
+        CHECK(GetLE(file.data() + 40, 4) == payload.size());
+        CHECK(std::equal(payload.begin(), payload.end(), file.begin() + 44));
+        std::remove(path.c_str());
+    }
+
+    // Closed before any format: no header to patch, and no failure
+    {
+        const std::string path = "file_sink_check_empty.wav";
+        std::unique_ptr<FileSink> sink = OpenSink(path, FileContainer::Wav);
+        if (!sink) return;
+        CloseSink(*sink);
+        CHECK(ReadFile(path).empty());
+        std::remove(path.c_str());
+    }
+}
+
+void CheckCaf() {
+    const std::string path = "file_sink_check.caf";
+    std::unique_ptr<FileSink> sink = OpenSink(path, FileContainer::Caf);
+    if (!sink) return;
+
+    FileSinkFormat format;
+    format.sampleRate = 44100;
+    format.channels = 2;
+    CHECK(sink->Begin(format));
+    std::vector<uint8_t> payload = Payload(700000, 4);
+    WriteAll(*sink, payload, 3528);
+    CloseSink(*sink);
+
+    std::vector<uint8_t> file = ReadFile(path);
+    CHECK(file.size() == 68 + payload.size());
+    if (file.size() < 68) return;
+    CHECK(memcmp(file.data(), "caff", 4) == 0);
+    CHECK(GetBE(file.data() + 4, 2) == 1);
+    CHECK(memcmp(file.data() + 8, "desc", 4) == 0);
+    CHECK(GetBE(file.data() + 12, 8) == 32);
+
+    uint64_t rateBits = GetBE(file.data() + 20, 8);
+    double rate;
+    memcpy(&rate, &rateBits, sizeof(rate));
+    CHECK(rate == 44100.0);
+    CHECK(memcmp(file.data() + 28, "lpcm", 4) == 0);
+    CHECK(GetBE(file.data() + 32, 4) == 3);                 // Float, little endian
+    CHECK(GetBE(file.data() + 36, 4) == 8);
+    CHECK(GetBE(file.data() + 40, 4) == 1);
+    CHECK(GetBE(file.data() + 44, 4) == 2);
+    CHECK(GetBE(file.data() + 48, 4) == 32);
+
+    // Written as -1 (to the end of the file), patched to the real size,
+    // which counts the edit count ahead of the audio
+    CHECK(memcmp(file.data() + 52, "data", 4) == 0);
+    CHECK(GetBE(file.data() + 56, 8) == payload.size() + 4);
+    CHECK(GetBE(file.data() + 64, 4) == 0);
+    CHECK(std::equal(payload.begin(), payload.end(), file.begin() + 68));
+    std::remove(path.c_str());
+}
+
+void CheckOgg() {
+    const std::string path = "file_sink_check.ogg";
+    std::unique_ptr<FileSink> sink = OpenSink(path, FileContainer::Ogg);
+    if (!sink) return;
+
+    FileSinkFormat format;
+    format.sampleRate = 48000;
+    format.channels = 1;
+    CHECK(sink->Begin(format));
+
+    // Stand-ins for 20 ms Opus packets, one longer than a lacing segment
+    const size_t packets = 120;
+    std::vector<std::vector<uint8_t>> written;
+    for (size_t i = 0; i < packets; i++) {
+        written.push_back(Payload(i == 7 ? 600 : 40 + i % 90, static_cast<uint32_t>(10 + i)));
+        CHECK(sink->Write(written.back().data(), written.back().size()));
+    }
+    CloseSink(*sink);
+
+    std::vector<uint8_t> file = ReadFile(path);
+    size_t offset = 0;
+    uint32_t sequence = 0;
+    uint8_t lastFlags = 0;
+    uint64_t lastGranule = 0;
+    std::vector<std::vector<uint8_t>> read;
+    std::vector<uint8_t> partial;
+    while (offset + 27 <= file.size()) {
+        const uint8_t* page = file.data() + offset;
+        CHECK(memcmp(page, "OggS", 4) == 0);
+        size_t segments = page[26];
+        size_t bodyBytes = 0;
+        for (size_t s = 0; s < segments; s++) bodyBytes += page[27 + s];
+        size_t pageBytes = 27 + segments + bodyBytes;
+        if (offset + pageBytes > file.size()) break;
+
+        // The CRC covers the page with its own field zeroed
+        const uint8_t zeros[4] = {};
+        uint32_t crc = OggCrc(page, 22, 0);
+        crc = OggCrc(zeros, 4, crc);
+        crc = OggCrc(page + 26, pageBytes - 26, crc);
+        CHECK(crc == GetLE(page + 22, 4));
+        CHECK(GetLE(page + 18, 4) == sequence);
+
+        // Undo the lacing; the two header pages hold OpusHead and OpusTags
+        const uint8_t* body = page + 27 + segments;
+        for (size_t s = 0; s < segments; s++) {
+            partial.insert(partial.end(), body, body + page[27 + s]);
+            body += page[27 + s];
+            if (page[27 + s] < 255) {
+                read.push_back(partial);
+                partial.clear();
+            }
+        }
+
+        lastFlags = page[5];
+        lastGranule = GetLE(page + 6, 8);
+        offset += pageBytes;
+        sequence++;
+    }
+
+    CHECK(offset == file.size());
+    CHECK(lastFlags == 0x04);
+    CHECK(lastGranule == packets * 960);
+    CHECK(read.size() == packets + 2);
+    if (read.size() == packets + 2) {
+        CHECK(read[0].size() == 19 && memcmp(read[0].data(), "OpusHead", 8) == 0);
+        CHECK(memcmp(read[1].data(), "OpusTags", 8) == 0);
+        for (size_t i = 0; i < packets; i++) CHECK(read[i + 2] == written[i]);
+    }
+    std::remove(path.c_str());
+}
+
+}  // namespace
+
+int main() {
+    CheckWav();
+    CheckCaf();
+    CheckOgg();
+    return CheckResult("file_sink_check");
+}
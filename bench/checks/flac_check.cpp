@@ -0,0 +1,364 @@
+// ============================================================================
+// flac_check - FlacEncoder output decodes back to its input, CRCs intact
+//
+// Encodes 16-bit PCM (so there is no dither and the round trip must be
+// exact), then parses the stream with a small decoder written from the FLAC
+// format spec rather than from the encoder: STREAMINFO, frame headers with
+// their CRC-8, constant, verbatim and fixed subframes, Rice partitions,
+// stereo decorrelation and the frame CRC-16.
+// ============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "check.h"
+#include "flac_encoder.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+struct Stream {
+    std::vector<std::vector<uint8_t>> packets;
+};
+
+void Collect(const uint8_t* data, size_t size, void* context) {
+    static_cast<Stream*>(context)->packets.emplace_back(data, data + size);
+}
+
+// CRC-8 (x^8 + x^2 + x + 1) and CRC-16 (x^16 + x^15 + x^2 + 1), bit by bit
+uint8_t Crc8(const uint8_t* data, size_t size) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = static_cast<uint8_t>(crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+    return crc;
+}
+
+uint16_t Crc16(const uint8_t* data, size_t size) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= static_cast<uint16_t>(data[i] << 8);
+        for (int b = 0; b < 8; b++) crc = static_cast<uint16_t>(crc & 0x8000 ? (crc << 1) ^ 0x8005 : crc << 1);
+    }
+    return crc;
+}
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    uint32_t Read(uint32_t bits) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits; i++) {
+            value = (value << 1) | Bit();
+        }
+        return value;
+    }
+
+    int32_t ReadSigned(uint32_t bits) {
+        uint32_t value = Read(bits);
+        if (bits > 0 && bits < 32 && (value & (1u << (bits - 1)))) value |= ~0u << bits;
+        return static_cast<int32_t>(value);
+    }
+
+    uint32_t ReadUnary() {
+        uint32_t zeros = 0;
+        while (!Bit() && !overrun_) zeros++;
+        return zeros;
+    }
+
+    void AlignToByte() { bit_ = (bit_ + 7) & ~static_cast<size_t>(7); }
+    size_t BytePosition() const { return bit_ / 8; }
+    bool Overrun() const { return overrun_; }
+
+private:
+    uint32_t Bit() {
+        if (bit_ >= size_ * 8) {
+            overrun_ = true;
+            return 0;
+        }
+        uint32_t value = (data_[bit_ / 8] >> (7 - bit_ % 8)) & 1;
+        bit_++;
+        return value;
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t bit_ = 0;
+    bool overrun_ = false;
+};
+
+struct StreamInfo {
+    uint32_t minBlock = 0;
+    uint32_t maxBlock = 0;
+    uint32_t sampleRate = 0;
+    uint32_t channels = 0;
+    uint32_t bitsPerSample = 0;
+};
+
+bool ParseHeader(const std::vector<uint8_t>& packet, StreamInfo* info) {
+    BitReader reader(packet.data(), packet.size());
+    if (reader.Read(32) != 0x664C6143u) return false;   // "fLaC"
+
+    bool last = reader.Read(1) != 0;
+    uint32_t type = reader.Read(7);
+    uint32_t length = reader.Read(24);
+    if (!last || type != 0 || length != 34 || packet.size() != 8 + 34) return false;
+
+    info->minBlock = reader.Read(16);
+    info->maxBlock = reader.Read(16);
+    reader.Read(24);
+    reader.Read(24);
+    info->sampleRate = reader.Read(20);
+    info->channels = reader.Read(3) + 1;
+    info->bitsPerSample = reader.Read(5) + 1;
+    return !reader.Overrun();
+}
+
+uint32_t BlockSize(uint32_t code, BitReader& reader) {
+    if (code == 1) return 192;
+    if (code >= 2 && code <= 5) return 576u << (code - 2);
+    if (code == 6) return reader.Read(8) + 1;
+    if (code == 7) return reader.Read(16) + 1;
+    if (code >= 8) return 256u << (code - 8);
+    return 0;
+}
+
+uint64_t ReadUtf8Number(BitReader& reader) {
+    uint32_t lead = reader.Read(8);
+    uint32_t continuation = 0;
+    while (continuation < 7 && (lead & (0x80u >> continuation))) continuation++;
+    if (continuation == 0) return lead;
+
+    uint64_t value = lead & (0x7Fu >> continuation);
+    for (uint32_t i = 1; i < continuation; i++) {
+        value = (value << 6) | (reader.Read(8) & 0x3F);
+    }
+    return value;
+}
+
+bool DecodeSubframe(BitReader& reader, uint32_t bps, uint32_t count, std::vector<int32_t>* out) {
+    out->assign(count, 0);
+    if (reader.Read(1) != 0) return false;
+    uint32_t type = reader.Read(6);
+    if (reader.Read(1) != 0) return false;     // Wasted bits: never written
+
+    if (type == 0) {
+        int32_t value = reader.ReadSigned(bps);
+        for (uint32_t i = 0; i < count; i++) (*out)[i] = value;
+        return true;
+    }
+    if (type == 1) {
+        for (uint32_t i = 0; i < count; i++) (*out)[i] = reader.ReadSigned(bps);
+        return true;
+    }
+    if (type < 8 || type > 12) return false;   // Only fixed predictors are written
+
+    uint32_t order = type - 8;
+    for (uint32_t i = 0; i < order; i++) (*out)[i] = reader.ReadSigned(bps);
+
+    if (reader.Read(2) != 0) return false;     // 4-bit Rice parameters
+    uint32_t partitionOrder = reader.Read(4);
+    uint32_t partitionSize = count >> partitionOrder;
+    uint32_t n = order;
+    for (uint32_t p = 0; p < (1u << partitionOrder); p++) {
+        uint32_t k = reader.Read(4);
+        if (k == 15) return false;             // Escape code: never written
+        uint32_t samples = p == 0 ? partitionSize - order : partitionSize;
+        for (uint32_t i = 0; i < samples; i++) {
+            uint32_t u = (reader.ReadUnary() << k) | reader.Read(k);
+            (*out)[n++] = static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1);
+        }
+    }
+
+    int32_t* x = out->data();
+    for (uint32_t i = order; i < count; i++) {
+        switch (order) {
+            case 0: break;
+            case 1: x[i] += x[i - 1]; break;
+            case 2: x[i] += 2 * x[i - 1] - x[i - 2]; break;
+            case 3: x[i] += 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3]; break;
+            default: x[i] += 4 * x[i - 1] - 6 * x[i - 2] + 4 * x[i - 3] - x[i - 4]; break;
+        }
+    }
+    return !reader.Overrun();
+}
+
+// Decodes one frame packet, appending interleaved samples to *pcm
+bool DecodeFrame(const std::vector<uint8_t>& packet, const StreamInfo& info, uint64_t expectedNumber,
+                 std::vector<int16_t>* pcm, uint32_t* assignmentOut) {
+    BitReader reader(packet.data(), packet.size());
+    if (reader.Read(16) != 0xFFF8) return false;   // Sync, fixed blocksize
+
+    uint32_t blockCode = reader.Read(4);
+    uint32_t rateCode = reader.Read(4);
+    uint32_t assignment = reader.Read(4);
+    uint32_t sizeCode = reader.Read(3);
+    if (reader.Read(1) != 0 || sizeCode != 4) return false;
+
+    uint64_t number = ReadUtf8Number(reader);
+    CHECK(number == expectedNumber);
+
+    uint32_t frames = BlockSize(blockCode, reader);
+    if (rateCode == 12) reader.Read(8);
+    if (rateCode == 13 || rateCode == 14) reader.Read(16);
+
+    size_t headerBytes = reader.BytePosition();
+    uint32_t crc8 = reader.Read(8);
+    CHECK(crc8 == Crc8(packet.data(), headerBytes));
+
+    uint32_t channels = assignment <= 7 ? assignment + 1 : 2;
+    if (channels != info.channels || frames == 0 || frames > info.maxBlock) return false;
+
+    std::vector<int32_t> planes[8];
+    for (uint32_t c = 0; c < channels; c++) {
+        // The side channel of a stereo decorrelation carries one extra bit
+        bool side = (assignment == 8 && c == 1) || (assignment == 9 && c == 0) || (assignment == 10 && c == 1);
+        if (!DecodeSubframe(reader, info.bitsPerSample + (side ? 1 : 0), frames, &planes[c])) return false;
+    }
+
+    reader.AlignToByte();
+    size_t bodyBytes = reader.BytePosition();
+    uint32_t crc16 = reader.Read(16);
+    CHECK(crc16 == Crc16(packet.data(), bodyBytes));
+    CHECK(reader.BytePosition() == packet.size());
+
+    for (uint32_t i = 0; i < frames; i++) {
+        int32_t a = planes[0][i];
+        int32_t b = channels > 1 ? planes[1][i] : 0;
+        int32_t left = a;
+        int32_t right = b;
+        if (assignment == 8) {
+            right = a - b;
+        } else if (assignment == 9) {
+            left = a + b;
+        } else if (assignment == 10) {
+            int32_t mid = (a << 1) | (b & 1);
+            left = (mid + b) >> 1;
+            right = (mid - b) >> 1;
+        }
+        pcm->push_back(static_cast<int16_t>(left));
+        if (channels > 1) pcm->push_back(static_cast<int16_t>(right));
+        for (uint32_t c = 2; c < channels; c++) pcm->push_back(static_cast<int16_t>(planes[c][i]));
+    }
+
+    *assignmentOut = assignment;
+    return !reader.Overrun();
+}
+
+// Feeds `input` in uneven chunks, decodes the stream and compares
+void RoundTrip(const char* name, const std::vector<int16_t>& input, uint32_t channels, uint32_t sampleRate,
+               uint32_t* assignments) {
+    PcmFormat format;
+    format.sampleRate = sampleRate;
+    format.channels = channels;
+    format.bitsPerChannel = 16;
+    format.isFloat = false;
+
+    CHECK(FlacEncoder::Supports(format));
+    const size_t chunkFrames = 1000;
+    FlacEncoder encoder(format, chunkFrames);
+
+    Stream stream;
+    size_t frames = input.size() / channels;
+    for (size_t offset = 0; offset < frames; offset += chunkFrames) {
+        size_t take = std::min(chunkFrames, frames - offset);
+        encoder.Encode(reinterpret_cast<const uint8_t*>(&input[offset * channels]), take * channels * sizeof(int16_t),
+                       &Collect, &stream);
+    }
+    encoder.Flush(&Collect, &stream);
+
+    StreamInfo info;
+    CHECK(!stream.packets.empty() && ParseHeader(stream.packets[0], &info));
+    CHECK(info.sampleRate == sampleRate);
+    CHECK(info.channels == channels);
+    CHECK(info.bitsPerSample == 16);
+    CHECK(info.maxBlock == FlacEncoder::kBlockSize);
+
+    std::vector<int16_t> decoded;
+    size_t expectedFrames = (frames + FlacEncoder::kBlockSize - 1) / FlacEncoder::kBlockSize;
+    CHECK(stream.packets.size() == expectedFrames + 1);
+    for (size_t i = 1; i < stream.packets.size(); i++) {
+        uint32_t assignment = 0;
+        if (!DecodeFrame(stream.packets[i], info, i - 1, &decoded, &assignment)) {
+            std::fprintf(stderr, "%s: frame %zu failed to decode\n", name, i - 1);
+            CheckFailures()++;
+            return;
+        }
+        if (assignments) assignments[assignment]++;
+    }
+
+    CHECK(decoded == input);
+}
+
+int16_t Clamp16(double value) {
+    return static_cast<int16_t>(std::lround(std::max(-32768.0, std::min(32767.0, value))));
+}
+
+}  // namespace
+
+int main() {
+    uint32_t seed = 12345;
+    auto noise = [&seed] {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<double>(seed >> 8) / 8388608.0 - 1.0;
+    };
+
+    // Mono: tone with a little noise, a stretch of digital silence (constant
+    // subframes) and full-scale noise (verbatim), ending in a short frame
+    {
+        const uint32_t rate = 16000;
+        std::vector<int16_t> pcm;
+        for (size_t i = 0; i < 3 * 4096; i++) {
+            pcm.push_back(Clamp16(12000 * std::sin(2 * kPi * 440 * i / rate) + 200 * noise()));
+        }
+        pcm.insert(pcm.end(), 4096, 0);
+        for (size_t i = 0; i < 4096; i++) pcm.push_back(Clamp16(32767 * noise()));
+        for (size_t i = 0; i < 1234; i++) pcm.push_back(Clamp16(8000 * std::sin(2 * kPi * 97 * i / rate)));
+        RoundTrip("mono", pcm, 1, rate, nullptr);
+    }
+
+    // Stereo: identical channels (mid/side), one silent channel (left or
+    // right/side) and unrelated channels (independent), over enough frames
+    // for multi-byte frame numbers
+    {
+        const uint32_t rate = 48000;
+        std::vector<int16_t> pcm;
+        for (size_t i = 0; i < 200 * 4096 + 77; i++) {
+            double t = static_cast<double>(i) / rate;
+            double tone = 10000 * std::sin(2 * kPi * 330 * t);
+            int16_t left;
+            int16_t right;
+            switch ((i / 4096) % 4) {
+                case 0: left = right = Clamp16(tone + 50 * noise()); break;
+                case 1: left = Clamp16(tone); right = 0; break;
+                case 2: left = Clamp16(tone); right = Clamp16(tone * 0.9 + 300 * noise()); break;
+                default: left = Clamp16(20000 * noise()); right = Clamp16(-20000 * noise()); break;
+            }
+            pcm.push_back(left);
+            pcm.push_back(right);
+        }
+
+        uint32_t assignments[16] = {};
+        RoundTrip("stereo", pcm, 2, rate, assignments);
+
+        // The stereo content should have exercised at least one decorrelation
+        CHECK(assignments[8] + assignments[9] + assignments[10] > 0);
+        CHECK(assignments[1] > 0);
+    }
+
+    // An odd rate goes in the frame header explicitly
+    {
+        const uint32_t rate = 11025;
+        std::vector<int16_t> pcm;
+        for (size_t i = 0; i < 5000; i++) pcm.push_back(Clamp16(5000 * std::sin(2 * kPi * 1000 * i / rate)));
+        RoundTrip("11025 Hz", pcm, 1, rate, nullptr);
+    }
+
+    return CheckResult("flac_check");
+}
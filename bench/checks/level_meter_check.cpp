@@ -0,0 +1,187 @@
+// ============================================================================
+// level_meter_check - LevelMeter readings on known sine input
+//
+// A sine of amplitude A has RMS A / sqrt(2) and peak A over whole periods, so
+// each reading can be checked against closed-form values, along with window
+// framing and timing across chunk boundaries, 16-bit and unaligned input,
+// the final partial window and the band split.
+// ============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+#include "level_meter.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kSqrtHalf = 0.70710678118654752440;
+
+struct Readings {
+    struct Reading {
+        uint64_t framePosition;
+        uint64_t hostTimeNs;
+        uint32_t frames;
+        std::vector<float> rms;
+        std::vector<float> peak;
+        std::vector<float> bands;
+    };
+    std::vector<Reading> list;
+};
+
+void Collect(const LevelReading& reading, void* context) {
+    Readings::Reading copy;
+    copy.framePosition = reading.framePosition;
+    copy.hostTimeNs = reading.hostTimeNs;
+    copy.frames = reading.frames;
+    copy.rms.assign(reading.rms, reading.rms + reading.channels);
+    copy.peak.assign(reading.peak, reading.peak + reading.channels);
+    copy.bands.assign(reading.bands, reading.bands + reading.bandCount);
+    static_cast<Readings*>(context)->list.push_back(copy);
+}
+
+// Interleaved sines, one frequency and amplitude per channel
+std::vector<float> Sines(size_t frames, double rate, const std::vector<double>& hz,
+                         const std::vector<double>& amplitude) {
+    size_t channels = hz.size();
+    std::vector<float> samples(frames * channels);
+    for (size_t i = 0; i < frames; i++) {
+        for (size_t c = 0; c < channels; c++) {
+            samples[i * channels + c] = static_cast<float>(amplitude[c] * std::sin(2 * kPi * hz[c] * i / rate));
+        }
+    }
+    return samples;
+}
+
+// Feeds `pcm` in chunks of chunkFrames, with timing continuing across chunks
+Readings Run(LevelMeter& meter, const uint8_t* pcm, size_t frames, size_t frameBytes, size_t chunkFrames,
+             uint64_t startNs, double rate) {
+    Readings readings;
+    for (size_t offset = 0; offset < frames; offset += chunkFrames) {
+        size_t take = std::min(chunkFrames, frames - offset);
+        AudioChunkInfo info = {};
+        info.framePosition = offset;
+        info.hostTimeNs = startNs + static_cast<uint64_t>(std::llround(offset * 1e9 / rate));
+        meter.Process(pcm + offset * frameBytes, take * frameBytes, info, &Collect, &readings);
+    }
+    meter.Finish(&Collect, &readings);
+    return readings;
+}
+
+}  // namespace
+
+int main() {
+    const double rate = 48000;
+    const uint64_t startNs = 5000000000ull;
+
+    // Stereo float: 1 kHz at 0.5 left, 3 kHz at 0.25 right. 20 ms windows
+    // hold whole periods of both; chunks of 1000 frames straddle windows.
+    {
+        PcmFormat format;
+        format.sampleRate = rate;
+        format.channels = 2;
+        LevelMeterOptions options;
+        options.intervalMs = 20;
+        CHECK(LevelMeter::Supports(format));
+
+        const size_t frames = 960 * 10 + 480;
+        std::vector<float> pcm = Sines(frames, rate, {1000, 3000}, {0.5, 0.25});
+
+        LevelMeter meter(options, format);
+        Readings readings = Run(meter, reinterpret_cast<const uint8_t*>(pcm.data()), frames, 2 * sizeof(float), 1000,
+                                startNs, rate);
+
+        CHECK(readings.list.size() == 11);
+        for (size_t r = 0; r < readings.list.size(); r++) {
+            const Readings::Reading& reading = readings.list[r];
+            CHECK(reading.framePosition == r * 960);
+            CHECK(reading.frames == (r < 10 ? 960u : 480u));
+            CHECK_NEAR(reading.hostTimeNs, startNs + r * 20000000ull, 1);
+            CHECK(reading.bands.empty());
+            CHECK_NEAR(reading.rms[0], 0.5 * kSqrtHalf, 1e-4);
+            CHECK_NEAR(reading.rms[1], 0.25 * kSqrtHalf, 1e-4);
+            CHECK_NEAR(reading.peak[0], 0.5, 1e-4);
+            CHECK_NEAR(reading.peak[1], 0.25, 1e-3);
+        }
+
+        // The same samples one byte off alignment read the same
+        std::vector<uint8_t> shifted(pcm.size() * sizeof(float) + 1);
+        memcpy(shifted.data() + 1, pcm.data(), pcm.size() * sizeof(float));
+        LevelMeter unaligned(options, format);
+        Readings again = Run(unaligned, shifted.data() + 1, frames, 2 * sizeof(float), 1000, startNs, rate);
+        CHECK(again.list.size() == readings.list.size());
+        for (size_t r = 0; r < again.list.size() && r < readings.list.size(); r++) {
+            CHECK(again.list[r].rms == readings.list[r].rms);
+            CHECK(again.list[r].peak == readings.list[r].peak);
+        }
+    }
+
+    // Mono 16-bit at half scale, and digital silence
+    {
+        PcmFormat format;
+        format.sampleRate = rate;
+        format.channels = 1;
+        format.bitsPerChannel = 16;
+        format.isFloat = false;
+        LevelMeterOptions options;
+        options.intervalMs = 10;
+        CHECK(LevelMeter::Supports(format));
+
+        const size_t frames = 480 * 4;
+        std::vector<int16_t> pcm(frames * 2, 0);
+        for (size_t i = 0; i < frames; i++) {
+            pcm[i] = static_cast<int16_t>(std::lround(16384 * std::sin(2 * kPi * 500 * i / rate)));
+        }
+
+        LevelMeter meter(options, format);
+        Readings readings = Run(meter, reinterpret_cast<const uint8_t*>(pcm.data()), frames * 2, sizeof(int16_t),
+                                333, startNs, rate);
+        CHECK(readings.list.size() == 8);
+        for (size_t r = 0; r < readings.list.size(); r++) {
+            const Readings::Reading& reading = readings.list[r];
+            CHECK(reading.frames == 480);
+            CHECK_NEAR(reading.rms[0], r < 4 ? 0.5 * kSqrtHalf : 0.0, 1e-4);
+            CHECK_NEAR(reading.peak[0], r < 4 ? 0.5 : 0.0, 1e-4);
+        }
+    }
+
+    // Band levels: a low tone lands in the low band, a high one in the high
+    // band. The first reading is skipped while the filters settle.
+    {
+        PcmFormat format;
+        format.sampleRate = rate;
+        format.channels = 1;
+        LevelMeterOptions options;
+        options.intervalMs = 50;
+        options.bands = true;
+
+        const double tones[] = {100, 1000, 10000};
+        for (int band = 0; band < 3; band++) {
+            const size_t frames = 2400 * 6;
+            std::vector<float> pcm = Sines(frames, rate, {tones[band]}, {0.5});
+
+            LevelMeter meter(options, format);
+            Readings readings = Run(meter, reinterpret_cast<const uint8_t*>(pcm.data()), frames, sizeof(float), 512,
+                                    startNs, rate);
+            CHECK(readings.list.size() == 6);
+            for (size_t r = 1; r < readings.list.size(); r++) {
+                const std::vector<float>& bands = readings.list[r].bands;
+                CHECK(bands.size() == LevelMeter::kBands);
+                if (bands.size() != LevelMeter::kBands) break;
+
+                // The tone's own band carries close to the full level, well
+                // above the others
+                CHECK_NEAR(bands[band], 0.5 * kSqrtHalf, 0.05);
+                for (int other = 0; other < 3; other++) {
+                    if (other != band) CHECK(bands[other] < bands[band] * 0.3f);
+                }
+            }
+        }
+    }
+
+    return CheckResult("level_meter_check");
+}
@@ -0,0 +1,174 @@
+// ============================================================================
+// pre_roll_check - PreRollBuffer history, commit and flush ordering
+//
+// Every sample carries its own frame index, so a flush can be checked for
+// exactly which frames come out, in what order, and with what frame position
+// and host time: the newest history once the buffer has wrapped, a partial
+// flush of only the last frames, a gap that drops stale history, and the
+// live chunk following a commit at the position the flush ended on.
+// ============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "check.h"
+#include "pre_roll_buffer.h"
+
+namespace {
+
+constexpr double kRate = 16000;
+constexpr uint64_t kStartNs = 1000000000ull;
+
+struct Delivered {
+    std::vector<float> samples;
+    std::vector<AudioChunkInfo> chunks;
+    size_t maxChunkFrames = 0;
+};
+
+void Collect(const uint8_t* data, size_t size, const AudioChunkInfo& info, void* context) {
+    Delivered* delivered = static_cast<Delivered*>(context);
+    size_t count = size / sizeof(float);
+    size_t start = delivered->samples.size();
+    delivered->samples.resize(start + count);
+    memcpy(&delivered->samples[start], data, size);
+    delivered->chunks.push_back(info);
+    delivered->maxChunkFrames = std::max(delivered->maxChunkFrames, count);
+}
+
+uint64_t HostTimeOf(uint64_t frame) {
+    return kStartNs + static_cast<uint64_t>(std::llround(frame * 1e9 / kRate));
+}
+
+// Mono float chunk whose samples are their frame positions, scaled to fit
+// 16 bits exactly when `scale` is 1/32768
+void PushRange(PreRollBuffer& buffer, uint64_t first, size_t frames, float scale) {
+    std::vector<float> samples(frames);
+    for (size_t i = 0; i < frames; i++) {
+        samples[i] = static_cast<float>((first + i) % 32768) * scale;
+    }
+    AudioChunkInfo info = {};
+    info.framePosition = first;
+    info.hostTimeNs = HostTimeOf(first);
+    buffer.Push(reinterpret_cast<const uint8_t*>(samples.data()), frames * sizeof(float), info);
+}
+
+// The delivered samples are frames [first, first + count), contiguous in
+// position and time across chunks
+void CheckRange(const Delivered& delivered, uint64_t first, uint64_t count, float scale, size_t chunkFrames) {
+    CHECK(delivered.samples.size() == count);
+    for (size_t i = 0; i < delivered.samples.size(); i++) {
+        if (delivered.samples[i] != static_cast<float>((first + i) % 32768) * scale) {
+            std::fprintf(stderr, "sample %zu is %g, expected frame %llu\n", i, delivered.samples[i],
+                         static_cast<unsigned long long>(first + i));
+            CheckFailures()++;
+            break;
+        }
+    }
+
+    uint64_t position = first;
+    for (const AudioChunkInfo& info : delivered.chunks) {
+        CHECK(info.framePosition == position);
+        CHECK_NEAR(info.hostTimeNs, HostTimeOf(position), 1000);
+        position += chunkFrames;
+    }
+    CHECK(delivered.maxChunkFrames <= chunkFrames);
+}
+
+}  // namespace
+
+int main() {
+    PcmFormat format;
+    format.sampleRate = kRate;
+    format.channels = 1;
+    CHECK(PreRollBuffer::Supports(format));
+
+    const size_t chunkFrames = 160;            // What Flush delivers per chunk
+    PreRollOptions options;
+    options.durationMs = 500;                  // 8000 frames of history
+
+    // Armed for 2 s in 10 ms chunks: only the newest 500 ms survive, and a
+    // commit with the whole pre-roll flushes exactly those, oldest first
+    {
+        PreRollBuffer buffer(options, format, chunkFrames);
+        CHECK(buffer.FramesFor(options.durationMs) == 8000);
+        for (uint64_t frame = 0; frame < 32000; frame += 160) {
+            PushRange(buffer, frame, 160, 1.0f);
+        }
+        CHECK(buffer.BufferedFrames() == 8000);
+
+        Delivered delivered;
+        buffer.Flush(buffer.FramesFor(options.durationMs), &Collect, &delivered);
+        CheckRange(delivered, 24000, 8000, 1.0f, chunkFrames);
+        CHECK(buffer.BufferedFrames() == 0);
+
+        // Flushed history ends where the first live chunk begins
+        CHECK(!delivered.chunks.empty() && delivered.chunks.back().framePosition + chunkFrames == 32000);
+
+        // Nothing is delivered twice
+        Delivered again;
+        buffer.Flush(8000, &Collect, &again);
+        CHECK(again.chunks.empty());
+    }
+
+    // A shorter pre-roll than the history takes only the last frames, even
+    // when the chunks that filled it were uneven and wrapped the storage
+    {
+        PreRollBuffer buffer(options, format, chunkFrames);
+        uint64_t frame = 0;
+        for (size_t size : {1000, 7, 4000, 333, 2500, 1, 999}) {
+            PushRange(buffer, frame, size, 1.0f);
+            frame += size;
+        }
+        Delivered delivered;
+        buffer.Flush(buffer.FramesFor(100), &Collect, &delivered);
+        CheckRange(delivered, frame - 1600, 1600, 1.0f, chunkFrames);
+    }
+
+    // A gap in positions drops the history before it
+    {
+        PreRollBuffer buffer(options, format, chunkFrames);
+        PushRange(buffer, 0, 3000, 1.0f);
+        PushRange(buffer, 5000, 1000, 1.0f);
+        CHECK(buffer.BufferedFrames() == 1000);
+
+        Delivered delivered;
+        buffer.Flush(8000, &Collect, &delivered);
+        CheckRange(delivered, 5000, 1000, 1.0f, chunkFrames);
+    }
+
+    // A commit still pending when the recording stops flushes its history;
+    // the buffer then starts over and holds only what it captures next
+    {
+        PreRollBuffer buffer(options, format, chunkFrames);
+        PushRange(buffer, 0, 4000, 1.0f);
+        Delivered atStop;
+        buffer.Flush(buffer.FramesFor(200), &Collect, &atStop);
+        CheckRange(atStop, 800, 3200, 1.0f, chunkFrames);
+
+        PushRange(buffer, 4000, 500, 1.0f);
+        CHECK(buffer.BufferedFrames() == 500);
+        Delivered next;
+        buffer.Flush(8000, &Collect, &next);
+        CheckRange(next, 4000, 500, 1.0f, chunkFrames);
+    }
+
+    // 16-bit storage gives back float samples that were exact at 16 bits
+    {
+        PreRollOptions narrow = options;
+        narrow.int16 = true;
+        PreRollBuffer buffer(narrow, format, chunkFrames);
+        const float scale = 1.0f / 32768.0f;
+        for (uint64_t frame = 0; frame < 12000; frame += 480) {
+            PushRange(buffer, frame, 480, scale);
+        }
+        Delivered delivered;
+        buffer.Flush(8000, &Collect, &delivered);
+        CheckRange(delivered, 4000, 8000, scale, chunkFrames);
+    }
+
+    return CheckResult("pre_roll_check");
+}
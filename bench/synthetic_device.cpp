@@ -0,0 +1,334 @@
+#include "synthetic_device.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "audio_bridge.h"
+#include "audio_dsp.h"
+#include "capture_stats.h"
+#include "chunk_accumulator.h"
+#include "chunk_clock.h"
+#include "resampler.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+std::mutex gConfigMutex;
+SyntheticDeviceConfig gConfig;
+
+SyntheticDeviceConfig CurrentConfig() {
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    return gConfig;
+}
+
+class SyntheticSession {
+public:
+    SyntheticSession(AudioDataCallback dataCallback, AudioEventCallback eventCallback,
+                     AudioMetadataCallback metadataCallback, void* context)
+        : dataCallback_(dataCallback),
+          eventCallback_(eventCallback),
+          metadataCallback_(metadataCallback),
+          context_(context) {}
+
+    ~SyntheticSession() { Stop(); }
+
+    int32_t Start(double sampleRate, double chunkDurationMs, bool isMono, double gain, bool microphone) {
+        if (running_) return -2;
+
+        device_ = CurrentConfig();
+        if (device_.sampleRate <= 0 || device_.channels == 0 || device_.packetFrames == 0) return -1;
+
+        // Like a WASAPI device that refuses the lower-latency modes, warn and
+        // go on at the packet size
+        if (microphone && latencyMode_ != 0 && eventCallback_) {
+            eventCallback_(3, "The synthetic device has no lower latency mode; using its packet size", context_);
+        }
+
+        outputRate_ = sampleRate > 0 ? sampleRate : device_.sampleRate;
+        outputChannels_ = isMono ? 1 : device_.channels;
+        isMono_ = isMono;
+        gain_ = static_cast<float>(gain);
+
+        size_t packet = device_.packetFrames;
+        if (!resampler_.Configure(device_.sampleRate, outputRate_, outputChannels_, quality_, packet)) return -1;
+
+        double chunkMs = chunkDurationMs > 0 ? chunkDurationMs : 200;
+        size_t chunkFrames = std::max<size_t>(static_cast<size_t>(outputRate_ * chunkMs / 1000.0), 1);
+        size_t maxResampled = resampler_.MaxOutputFrames(packet) * outputChannels_;
+
+        gainBuffer_.assign(packet * device_.channels, 0.0f);
+        monoBuffer_.assign(packet, 0.0f);
+        resampleBuffer_.assign(maxResampled, 0.0f);
+        chunks_.Reset(chunkFrames * outputChannels_, maxResampled);
+        clock_.Reset(outputRate_, device_.sampleRate);
+        pushedFrames_ = 0;
+        stats_.Reset();
+        GenerateSignal();
+
+        if (metadataCallback_) {
+            metadataCallback_(outputRate_, outputChannels_, 32, true, "pcm_f32le", context_);
+        }
+
+        stopRequested_ = false;
+        running_ = true;
+        thread_ = std::thread(&SyntheticSession::Run, this);
+
+        if (eventCallback_) {
+            eventCallback_(0, nullptr, context_);
+        }
+        return 0;
+    }
+
+    int32_t Stop() {
+        if (!running_) return 0;
+
+        stopRequested_ = true;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        running_ = false;
+
+        if (eventCallback_) {
+            eventCallback_(1, nullptr, context_);
+        }
+        return 0;
+    }
+
+    bool IsRunning() const { return running_; }
+
+    int32_t SetResamplerQuality(ResamplerQuality quality) {
+        if (running_) return -2;
+        quality_ = quality;
+        return 0;
+    }
+
+    int32_t SetLatencyMode(int32_t mode) {
+        if (running_) return -2;
+        latencyMode_ = mode;
+        return 0;
+    }
+
+    void GetStats(AudioStatsSnapshot* stats) const { stats_.Snapshot(stats); }
+
+private:
+    // One second of signal, plus a packet so every packet is contiguous.
+    // Generated up front so the benchmark doesn't time sin().
+    void GenerateSignal() {
+        size_t period = static_cast<size_t>(device_.sampleRate);
+        size_t frames = period + device_.packetFrames;
+        uint32_t channels = device_.channels;
+        signal_.assign(frames * channels, 0.0f);
+
+        uint32_t state = device_.seed ? device_.seed : 1;
+        for (size_t i = 0; i < frames; i++) {
+            size_t n = i % period;
+            for (uint32_t c = 0; c < channels; c++) {
+                // Whole-Hz tones repeat exactly every second
+                double hz = 220.0 * (c + 1);
+                state = state * 1664525u + 1013904223u;
+                float noise = static_cast<float>(static_cast<int32_t>(state) / 2147483648.0);
+                signal_[i * channels + c] =
+                    0.25f * static_cast<float>(std::sin(2.0 * kPi * hz * n / device_.sampleRate)) + 0.01f * noise;
+            }
+        }
+        signalFrames_ = period;
+    }
+
+    void Run() {
+        const double nsPerFrame = 1e9 / device_.sampleRate;
+        const size_t packet = device_.packetFrames;
+        const uint64_t startNs = audio_stats_now_ns();
+        uint64_t deviceFrames = 0;
+        size_t offset = 0;
+
+        while (!stopRequested_.load(std::memory_order_relaxed)) {
+            uint64_t hostTimeNs;
+            if (device_.realtime) {
+                // A packet is delivered once its last frame has been captured
+                hostTimeNs = startNs + static_cast<uint64_t>(deviceFrames * nsPerFrame);
+                uint64_t readyNs = startNs + static_cast<uint64_t>((deviceFrames + packet) * nsPerFrame);
+                uint64_t now = audio_stats_now_ns();
+                if (readyNs > now) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(readyNs - now));
+                }
+            } else {
+                hostTimeNs = audio_stats_now_ns();
+            }
+
+            StatsTimer timer;
+            clock_.AnchorDevice(deviceFrames, static_cast<double>(pushedFrames_));
+            ProcessAudioData(&signal_[offset * device_.channels], packet, hostTimeNs);
+            stats_.RecordCallback(timer.ElapsedNs(), packet);
+
+            deviceFrames += packet;
+            offset = (offset + packet) % signalFrames_;
+        }
+    }
+
+    // Mirrors WasapiCapture::ProcessAudioData for a single client
+    void ProcessAudioData(const float* input, size_t frames, uint64_t hostTimeNs) {
+        auto emitChunk = [this](const float* chunk, size_t samples) { EmitChunk(chunk, samples); };
+
+        clock_.Anchor(hostTimeNs, static_cast<double>(pushedFrames_));
+
+        const float* floatData = input;
+        size_t numChannels = device_.channels;
+        size_t totalSamples = frames * numChannels;
+
+        if (gain_ != 1.0f) {
+            audio_dsp_apply_gain(floatData, gainBuffer_.data(), totalSamples, gain_, false);
+            floatData = gainBuffer_.data();
+        }
+
+        if (isMono_ && numChannels > 1) {
+            audio_dsp_downmix_mono(floatData, monoBuffer_.data(), frames, static_cast<uint32_t>(numChannels));
+            floatData = monoBuffer_.data();
+            numChannels = 1;
+            totalSamples = frames;
+        }
+
+        if (!resampler_.IsPassthrough()) {
+            StatsTimer timer;
+            totalSamples = resampler_.Process(floatData, frames, resampleBuffer_.data()) * numChannels;
+            floatData = resampleBuffer_.data();
+            stats_.RecordConversion(timer.ElapsedNs());
+        }
+
+        pushedFrames_ += totalSamples / numChannels;
+        chunks_.Push(floatData, totalSamples, emitChunk);
+    }
+
+    void EmitChunk(const float* samples, size_t count) {
+        AudioChunkInfo info = clock_.Next(count / outputChannels_);
+        stats_.AddEmitted(count / outputChannels_);
+        if (dataCallback_) {
+            dataCallback_(reinterpret_cast<const uint8_t*>(samples), static_cast<int32_t>(count * sizeof(float)),
+                          &info, context_);
+        }
+    }
+
+    AudioDataCallback dataCallback_;
+    AudioEventCallback eventCallback_;
+    AudioMetadataCallback metadataCallback_;
+    void* context_;
+
+    SyntheticDeviceConfig device_;
+    ResamplerQuality quality_ = ResamplerQuality::Balanced;
+    int32_t latencyMode_ = 0;
+    double outputRate_ = 0;
+    uint32_t outputChannels_ = 1;
+    bool isMono_ = true;
+    float gain_ = 1.0f;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopRequested_{false};
+    std::thread thread_;
+
+    // Owned by the capture thread while running
+    std::vector<float> signal_;
+    size_t signalFrames_ = 0;
+    std::vector<float> gainBuffer_;
+    std::vector<float> monoBuffer_;
+    std::vector<float> resampleBuffer_;
+    Resampler resampler_;
+    ChunkAccumulator<float> chunks_;
+    ChunkClock clock_;
+    uint64_t pushedFrames_ = 0;
+    AudioStats stats_;
+};
+
+}  // namespace
+
+void synthetic_device_configure(const SyntheticDeviceConfig& config) {
+    std::lock_guard<std::mutex> lock(gConfigMutex);
+    gConfig = config;
+}
+
+// ============================================================================
+// audio_bridge.h, recorder functions only
+// ============================================================================
+
+extern "C" {
+
+AudioRecorderHandle audio_create(AudioDataCallback dataCallback, AudioEventCallback eventCallback,
+                                 AudioMetadataCallback metadataCallback, void* userContext) {
+    return new SyntheticSession(dataCallback, eventCallback, metadataCallback, userContext);
+}
+
+int32_t audio_start_system_audio(AudioRecorderHandle handle, double sampleRate, double chunkDurationMs, bool mute,
+                                 bool isMono, bool emitSilence, const int32_t* includeProcesses,
+                                 int32_t includeProcessCount, const int32_t* excludeProcesses,
+                                 int32_t excludeProcessCount) {
+    // Every process is the synthetic one, and it never goes quiet
+    (void)mute;
+    (void)emitSilence;
+    (void)includeProcesses;
+    (void)includeProcessCount;
+    (void)excludeProcesses;
+    (void)excludeProcessCount;
+    if (!handle) return -1;
+    return static_cast<SyntheticSession*>(handle)->Start(sampleRate, chunkDurationMs, isMono, 1.0, false);
+}
+
+int32_t audio_start_microphone(AudioRecorderHandle handle, double sampleRate, double chunkDurationMs, bool isMono,
+                               bool emitSilence, const char* deviceUID, double gain) {
+    (void)emitSilence;
+    (void)deviceUID;
+    if (!handle) return -1;
+    return static_cast<SyntheticSession*>(handle)->Start(sampleRate, chunkDurationMs, isMono, gain, true);
+}
+
+int32_t audio_stop(AudioRecorderHandle handle) {
+    if (!handle) return -1;
+    return static_cast<SyntheticSession*>(handle)->Stop();
+}
+
+void audio_destroy(AudioRecorderHandle handle) {
+    delete static_cast<SyntheticSession*>(handle);
+}
+
+bool audio_is_running(AudioRecorderHandle handle) {
+    return handle && static_cast<SyntheticSession*>(handle)->IsRunning();
+}
+
+// The device buffer is always the configured packet size
+int32_t audio_set_buffer_duration(AudioRecorderHandle handle, double bufferDurationMs) {
+    (void)bufferDurationMs;
+    if (!handle) return -1;
+    return static_cast<SyntheticSession*>(handle)->IsRunning() ? -2 : 0;
+}
+
+int32_t audio_set_resampler_quality(AudioRecorderHandle handle, int32_t quality) {
+    if (!handle) return -1;
+    if (quality < 0 || quality > 2) return -3;
+    return static_cast<SyntheticSession*>(handle)->SetResamplerQuality(static_cast<ResamplerQuality>(quality));
+}
+
+// Nothing is torn down on stop, so there is nothing to keep
+int32_t audio_set_tap_cache_ttl(AudioRecorderHandle handle, double ttlMs) {
+    (void)ttlMs;
+    if (!handle) return -1;
+    return static_cast<SyntheticSession*>(handle)->IsRunning() ? -2 : 0;
+}
+
+// The synthetic device has no latency to shorten: microphone starts asking
+// for less fall back to the default, with a warning
+int32_t audio_set_latency_mode(AudioRecorderHandle handle, int32_t mode) {
+    if (!handle) return -1;
+    if (mode < 0 || mode > 2) return -3;
+    return static_cast<SyntheticSession*>(handle)->SetLatencyMode(mode);
+}
+
+int32_t audio_get_stats(AudioRecorderHandle handle, AudioStatsSnapshot* stats) {
+    if (!handle || !stats) return -1;
+    static_cast<SyntheticSession*>(handle)->GetStats(stats);
+    return 0;
+}
+
+}  // extern "C"
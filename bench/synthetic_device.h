@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+// ============================================================================
+// Synthetic capture device for the benchmark
+//
+// Implements the recorder half of audio_bridge.h without any audio hardware.
+// Every session plays back deterministic PCM (one sine per channel plus seeded
+// noise) in packets of a fixed size, and runs each packet through the same
+// steps as the WASAPI capture's ProcessAudioData: gain, downmix, resampling,
+// chunking and chunk timing. The shared capture engine, combined capture and
+// event queue on top of it therefore do the same work as on a real device.
+// ============================================================================
+
+struct SyntheticDeviceConfig {
+    double sampleRate = 48000;
+    uint32_t channels = 2;
+    uint32_t packetFrames = 480;    // Device buffer per callback; 10 ms at 48 kHz
+    bool realtime = true;           // Pace packets on the host clock, otherwise run flat out
+    uint32_t seed = 1;
+};
+
+// Applies to sessions started afterwards
+void synthetic_device_configure(const SyntheticDeviceConfig& config);
@@ -0,0 +1,171 @@
+#include "audio_dsp_kernels.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+#include <intrin.h>
+#endif
+
+using namespace audio_dsp;
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+namespace {
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
+bool CpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+
+    // The OS must save YMM state across context switches
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+const Kernels* SelectKernels() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
+    if (Avx2Kernels() && CpuHasAvx2()) return Avx2Kernels();
+    if (Sse2Kernels()) return Sse2Kernels();  // Baseline on x86-64
+#endif
+    if (NeonKernels()) return NeonKernels();  // Baseline on arm64
+    return ScalarKernels();
+}
+
+const Kernels kScalar = {
+    "scalar",
+    ScalarApplyGain,
+    ScalarDownmixMono,
+    ScalarDownmixStereo,
+    ScalarMixChannels,
+    ScalarFloatToInt16,
+    ScalarInterleave,
+    ScalarDeinterleave,
+    ScalarDot,
+    ScalarChannelLevels,
+    ScalarFftStage,
+};
+
+}  // namespace
+
+const Kernels& audio_dsp::ActiveKernels() {
+    static const Kernels* kernels = SelectKernels();
+    return *kernels;
+}
+
+const Kernels* audio_dsp::ScalarKernels() {
+    return &kScalar;
+}
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" {
+
+const char* audio_dsp_isa(void) {
+    return ActiveKernels().name;
+}
+
+void audio_dsp_apply_gain(const float* in, float* out, size_t count, float gain, bool clamp) {
+    ActiveKernels().applyGain(in, out, count, gain, clamp);
+}
+
+void audio_dsp_downmix_mono(const float* in, float* out, size_t frames, uint32_t channels) {
+    ActiveKernels().downmixMono(in, out, frames, channels);
+}
+
+void audio_dsp_downmix_stereo(const float* in, float* out, size_t frames, uint32_t channels) {
+    ActiveKernels().downmixStereo(in, out, frames, channels);
+}
+
+void audio_dsp_mix_channels(const float* in, float* out, size_t frames, uint32_t inChannels, const float* matrix,
+                            uint32_t outChannels) {
+    ActiveKernels().mixChannels(in, out, frames, inChannels, matrix, outChannels);
+}
+
+// Only needed for the odd device whose shared-mode format isn't float, so
+// there is no vector version
+void audio_dsp_int_to_float(const void* in, float* out, size_t count, uint32_t bitsPerSample) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(in);
+    switch (bitsPerSample) {
+        case 16:
+            for (size_t i = 0; i < count; i++) {
+                int16_t sample;
+                memcpy(&sample, bytes + i * 2, sizeof(sample));
+                out[i] = static_cast<float>(sample) * (1.0f / 32768.0f);
+            }
+            break;
+        case 24:
+            for (size_t i = 0; i < count; i++) {
+                const uint8_t* p = bytes + i * 3;
+                int32_t sample = static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 8 |
+                                                      static_cast<uint32_t>(p[1]) << 16 |
+                                                      static_cast<uint32_t>(p[2]) << 24);
+                out[i] = static_cast<float>(sample) * (1.0f / 2147483648.0f);
+            }
+            break;
+        case 32:
+            for (size_t i = 0; i < count; i++) {
+                int32_t sample;
+                memcpy(&sample, bytes + i * 4, sizeof(sample));
+                out[i] = static_cast<float>(sample) * (1.0f / 2147483648.0f);
+            }
+            break;
+        default:
+            memset(out, 0, count * sizeof(float));
+            break;
+    }
+}
+
+void audio_dsp_float_to_int16(const float* in, int16_t* out, size_t count, AudioDspDitherState* dither) {
+    ActiveKernels().floatToInt16(in, out, count, dither);
+}
+
+void audio_dsp_dither_init(AudioDspDitherState* dither, uint32_t seed) {
+    // splitmix32-style scramble so neighbouring seeds give unrelated lanes;
+    // xorshift has a fixed point at zero, so never leave a lane there
+    for (size_t i = 0; i < kDitherLanes; i++) {
+        uint32_t z = seed + 0x9E3779B9u * static_cast<uint32_t>(i + 1);
+        z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+        z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+        z ^= z >> 16;
+        dither->lanes[i] = z ? z : 0x6D2B79F5u;
+    }
+}
+
+float audio_dsp_dot(const float* a, const float* b, size_t count) {
+    return ActiveKernels().dot(a, b, count);
+}
+
+void audio_dsp_channel_levels(const float* in, size_t frames, uint32_t channels, float* sumSquares, float* peaks) {
+    ActiveKernels().channelLevels(in, frames, channels, sumSquares, peaks);
+}
+
+void audio_dsp_interleave(const float* const* planes, float* out, size_t frames, uint32_t channels) {
+    ActiveKernels().interleave(planes, out, frames, channels);
+}
+
+void audio_dsp_deinterleave(const float* in, float* const* planes, size_t frames, uint32_t channels) {
+    ActiveKernels().deinterleave(in, planes, frames, channels);
+}
+
+void audio_dsp_fft_stage(float* re, float* im, size_t n, size_t half, const float* twiddleRe,
+                         const float* twiddleIm) {
+    ActiveKernels().fftStage(re, im, n, half, twiddleRe, twiddleIm);
+}
+
+}  // extern "C"
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "audio_dsp.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// ============================================================================
+// Kernel tables behind audio_dsp.h
+//
+// Each ISA translation unit fills a table; audio_dsp.cpp picks one at first
+// use. The scalar kernels live here so SIMD kernels can reuse them for tails
+// and for channel layouts they don't specialise.
+// ============================================================================
+
+namespace audio_dsp {
+
+struct Kernels {
+    const char* name;
+    void (*applyGain)(const float* in, float* out, size_t count, float gain, bool clamp);
+    void (*downmixMono)(const float* in, float* out, size_t frames, uint32_t channels);
+    void (*downmixStereo)(const float* in, float* out, size_t frames, uint32_t channels);
+    void (*mixChannels)(const float* in, float* out, size_t frames, uint32_t inChannels, const float* matrix,
+                        uint32_t outChannels);
+    void (*floatToInt16)(const float* in, int16_t* out, size_t count, AudioDspDitherState* dither);
+    void (*interleave)(const float* const* planes, float* out, size_t frames, uint32_t channels);
+    void (*deinterleave)(const float* in, float* const* planes, size_t frames, uint32_t channels);
+    float (*dot)(const float* a, const float* b, size_t count);
+    void (*channelLevels)(const float* in, size_t frames, uint32_t channels, float* sumSquares, float* peaks);
+    void (*fftStage)(float* re, float* im, size_t n, size_t half, const float* twiddleRe, const float* twiddleIm);
+};
+
+// Table selected for this CPU. C++ callers in tight loops can cache the
+// function pointers instead of going through the C entry points.
+const Kernels& ActiveKernels();
+
+// Tables for the ISAs this build targets; nullptr when not compiled in
+const Kernels* ScalarKernels();
+const Kernels* Sse2Kernels();
+const Kernels* Avx2Kernels();
+const Kernels* NeonKernels();
+
+static constexpr size_t kDitherLanes = 8;
+static constexpr float kInt16Scale = 32767.0f;
+static constexpr float kTpdfScale = 1.0f / 65536.0f;
+
+// xorshift32; each dither lane is an independent generator. Sample i of a
+// call uses lane i % 8, so vector kernels consume the same sequence.
+inline uint32_t DitherNext(uint32_t x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+// Sum of two 16-bit uniforms: triangular in [-1, 1) LSB
+inline float DitherTpdf(uint32_t r) {
+    return static_cast<float>(static_cast<int32_t>((r >> 16) + (r & 0xFFFF))) * kTpdfScale - 1.0f;
+}
+
+// ----------------------------------------------------------------------------
+// Scalar kernels
+// ----------------------------------------------------------------------------
+
+inline void ScalarApplyGain(const float* in, float* out, size_t count, float gain, bool clamp) {
+    if (clamp) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = std::max(-1.0f, std::min(1.0f, in[i] * gain));
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = in[i] * gain;
+        }
+    }
+}
+
+inline void ScalarDownmixMono(const float* in, float* out, size_t frames, uint32_t channels) {
+    if (channels == 0) return;
+    float scale = 1.0f / static_cast<float>(channels);
+    for (size_t i = 0; i < frames; i++) {
+        const float* frame = in + i * channels;
+        float sum = 0.0f;
+        for (uint32_t c = 0; c < channels; c++) {
+            sum += frame[c];
+        }
+        out[i] = sum * scale;
+    }
+}
+
+inline void ScalarDownmixStereo(const float* in, float* out, size_t frames, uint32_t channels) {
+    if (channels == 0) return;
+    if (channels == 1) {
+        for (size_t i = 0; i < frames; i++) {
+            out[2 * i] = in[i];
+            out[2 * i + 1] = in[i];
+        }
+        return;
+    }
+    if (channels == 2) {
+        if (in != out && frames > 0) memmove(out, in, frames * 2 * sizeof(float));
+        return;
+    }
+
+    float leftScale = 1.0f / static_cast<float>((channels + 1) / 2);
+    float rightScale = 1.0f / static_cast<float>(channels / 2);
+    for (size_t i = 0; i < frames; i++) {
+        const float* frame = in + i * channels;
+        float left = 0.0f;
+        float right = 0.0f;
+        for (uint32_t c = 0; c + 1 < channels; c += 2) {
+            left += frame[c];
+            right += frame[c + 1];
+        }
+        if (channels & 1) left += frame[channels - 1];
+        out[2 * i] = left * leftScale;
+        out[2 * i + 1] = right * rightScale;
+    }
+}
+
+// Row by row, over the nonzero taps only. Channel maps mostly select or sum
+// a few channels, so this does far less work than the full product.
+inline void ScalarMixChannels(const float* in, float* out, size_t frames, uint32_t inChannels, const float* matrix,
+                              uint32_t outChannels) {
+    if (inChannels > AUDIO_DSP_MAX_CHANNELS) return;
+    uint32_t taps[AUDIO_DSP_MAX_CHANNELS];
+    float weights[AUDIO_DSP_MAX_CHANNELS];
+
+    for (uint32_t o = 0; o < outChannels; o++) {
+        const float* row = matrix + static_cast<size_t>(o) * inChannels;
+        uint32_t count = 0;
+        for (uint32_t c = 0; c < inChannels; c++) {
+            if (row[c] != 0.0f) {
+                taps[count] = c;
+                weights[count++] = row[c];
+            }
+        }
+
+        float* dst = out + o;
+        if (count == 0) {
+            for (size_t i = 0; i < frames; i++) {
+                dst[i * outChannels] = 0.0f;
+            }
+        } else if (count == 1 && weights[0] == 1.0f) {
+            const float* src = in + taps[0];
+            for (size_t i = 0; i < frames; i++) {
+                dst[i * outChannels] = src[i * inChannels];
+            }
+        } else {
+            for (size_t i = 0; i < frames; i++) {
+                const float* frame = in + i * inChannels;
+                float sum = 0.0f;
+                for (uint32_t t = 0; t < count; t++) {
+                    sum += frame[taps[t]] * weights[t];
+                }
+                dst[i * outChannels] = sum;
+            }
+        }
+    }
+}
+
+inline int16_t ScalarToInt16(float scaled) {
+    scaled = std::max(-32768.0f, std::min(32767.0f, scaled));
+    return static_cast<int16_t>(std::lrintf(scaled));
+}
+
+inline void ScalarFloatToInt16(const float* in, int16_t* out, size_t count, AudioDspDitherState* dither) {
+    if (!dither) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = ScalarToInt16(in[i] * kInt16Scale);
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        uint32_t& lane = dither->lanes[i % kDitherLanes];
+        lane = DitherNext(lane);
+        out[i] = ScalarToInt16(in[i] * kInt16Scale + DitherTpdf(lane));
+    }
+}
+
+inline void ScalarInterleave(const float* const* planes, float* out, size_t frames, uint32_t channels) {
+    for (size_t i = 0; i < frames; i++) {
+        for (uint32_t c = 0; c < channels; c++) {
+            out[i * channels + c] = planes[c][i];
+        }
+    }
+}
+
+inline void ScalarDeinterleave(const float* in, float* const* planes, size_t frames, uint32_t channels) {
+    for (size_t i = 0; i < frames; i++) {
+        for (uint32_t c = 0; c < channels; c++) {
+            planes[c][i] = in[i * channels + c];
+        }
+    }
+}
+
+inline float ScalarDot(const float* a, const float* b, size_t count) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Adds to sumSquares and raises peaks; SIMD kernels finish their tails with it
+inline void ScalarAccumulateLevels(const float* in, size_t frames, uint32_t channels, float* sumSquares,
+                                   float* peaks) {
+    for (size_t i = 0; i < frames; i++) {
+        const float* frame = in + i * channels;
+        for (uint32_t c = 0; c < channels; c++) {
+            sumSquares[c] += frame[c] * frame[c];
+            peaks[c] = std::max(peaks[c], std::fabs(frame[c]));
+        }
+    }
+}
+
+inline void ScalarChannelLevels(const float* in, size_t frames, uint32_t channels, float* sumSquares,
+                                float* peaks) {
+    for (uint32_t c = 0; c < channels; c++) {
+        sumSquares[c] = 0.0f;
+        peaks[c] = 0.0f;
+    }
+    ScalarAccumulateLevels(in, frames, channels, sumSquares, peaks);
+}
+
+// Fold vector lanes into channels: lane l holds channel l % channels
+inline void FoldLevelLanes(const float* laneSquares, const float* lanePeaks, size_t lanes, uint32_t channels,
+                           float* sumSquares, float* peaks) {
+    for (uint32_t c = 0; c < channels; c++) {
+        sumSquares[c] = 0.0f;
+        peaks[c] = 0.0f;
+    }
+    for (size_t l = 0; l < lanes; l++) {
+        sumSquares[l % channels] += laneSquares[l];
+        peaks[l % channels] = std::max(peaks[l % channels], lanePeaks[l]);
+    }
+}
+
+// Stages are powers of two, so a SIMD kernel either covers every butterfly
+// of a stage or hands it over here whole
+inline void ScalarFftStage(float* re, float* im, size_t n, size_t half, const float* twiddleRe,
+                           const float* twiddleIm) {
+    for (size_t base = 0; base < n; base += 2 * half) {
+        for (size_t k = 0; k < half; k++) {
+            size_t i = base + k;
+            size_t j = i + half;
+            float tr = re[j] * twiddleRe[k] - im[j] * twiddleIm[k];
+            float ti = re[j] * twiddleIm[k] + im[j] * twiddleRe[k];
+            re[j] = re[i] - tr;
+            im[j] = im[i] - ti;
+            re[i] += tr;
+            im[i] += ti;
+        }
+    }
+}
+
+}  // namespace audio_dsp
@@ -0,0 +1,255 @@
+#include "audio_dsp_kernels.h"
+
+// ============================================================================
+// NEON kernels (arm64, where NEON is always available)
+// ============================================================================
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+using namespace audio_dsp;
+
+namespace {
+
+// Sum of the channels of one frame, four lanes wide (channels % 4 == 0)
+inline float32x4_t FrameSum(const float* frame, uint32_t channels) {
+    float32x4_t sum = vld1q_f32(frame);
+    for (uint32_t c = 4; c < channels; c += 4) {
+        sum = vaddq_f32(sum, vld1q_f32(frame + c));
+    }
+    return sum;
+}
+
+void NeonApplyGain(const float* in, float* out, size_t count, float gain, bool clamp) {
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+
+    size_t i = 0;
+    if (clamp) {
+        for (; i + 4 <= count; i += 4) {
+            float32x4_t v = vmulq_n_f32(vld1q_f32(in + i), gain);
+            vst1q_f32(out + i, vminq_f32(vmaxq_f32(v, lo), hi));
+        }
+    } else {
+        for (; i + 4 <= count; i += 4) {
+            vst1q_f32(out + i, vmulq_n_f32(vld1q_f32(in + i), gain));
+        }
+    }
+    ScalarApplyGain(in + i, out + i, count - i, gain, clamp);
+}
+
+void NeonDownmixMono(const float* in, float* out, size_t frames, uint32_t channels) {
+    if (channels == 2) {
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            float32x4x2_t lr = vld2q_f32(in + 2 * i);
+            vst1q_f32(out + i, vmulq_n_f32(vaddq_f32(lr.val[0], lr.val[1]), 0.5f));
+        }
+        ScalarDownmixMono(in + 2 * i, out + i, frames - i, channels);
+        return;
+    }
+
+    if (channels >= 4 && channels % 4 == 0) {
+        float scale = 1.0f / static_cast<float>(channels);
+        for (size_t i = 0; i < frames; i++) {
+            out[i] = vaddvq_f32(FrameSum(in + i * channels, channels)) * scale;
+        }
+        return;
+    }
+
+    ScalarDownmixMono(in, out, frames, channels);
+}
+
+void NeonDownmixStereo(const float* in, float* out, size_t frames, uint32_t channels) {
+    if (channels == 1) {
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            float32x4_t v = vld1q_f32(in + i);
+            float32x4x2_t lr = {{v, v}};
+            vst2q_f32(out + 2 * i, lr);
+        }
+        ScalarDownmixStereo(in + i, out + 2 * i, frames - i, channels);
+        return;
+    }
+
+    if (channels >= 4 && channels % 4 == 0) {
+        // Lanes hold channels c = 0,1,2,3 (mod 4): left is lanes 0+2, right 1+3
+        float scale = 2.0f / static_cast<float>(channels);
+        for (size_t i = 0; i < frames; i++) {
+            float32x4_t v = FrameSum(in + i * channels, channels);
+            float32x2_t lr = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+            vst1_f32(out + 2 * i, vmul_n_f32(lr, scale));
+        }
+        return;
+    }
+
+    ScalarDownmixStereo(in, out, frames, channels);
+}
+
+// Advance four dither lanes and return their TPDF values
+inline float32x4_t DitherStep(uint32x4_t& x) {
+    x = veorq_u32(x, vshlq_n_u32(x, 13));
+    x = veorq_u32(x, vshrq_n_u32(x, 17));
+    x = veorq_u32(x, vshlq_n_u32(x, 5));
+
+    uint32x4_t sum = vaddq_u32(vshrq_n_u32(x, 16), vandq_u32(x, vdupq_n_u32(0xFFFF)));
+    return vsubq_f32(vmulq_n_f32(vcvtq_f32_u32(sum), kTpdfScale), vdupq_n_f32(1.0f));
+}
+
+inline int32x4_t ToInt32(float32x4_t scaled) {
+    scaled = vmaxq_f32(scaled, vdupq_n_f32(-32768.0f));
+    scaled = vminq_f32(scaled, vdupq_n_f32(32767.0f));
+    return vcvtnq_s32_f32(scaled);
+}
+
+void NeonFloatToInt16(const float* in, int16_t* out, size_t count, AudioDspDitherState* dither) {
+    size_t i = 0;
+
+    if (dither) {
+        uint32x4_t lanesLo = vld1q_u32(dither->lanes);
+        uint32x4_t lanesHi = vld1q_u32(dither->lanes + 4);
+        for (; i + 8 <= count; i += 8) {
+            float32x4_t a = vaddq_f32(vmulq_n_f32(vld1q_f32(in + i), kInt16Scale), DitherStep(lanesLo));
+            float32x4_t b = vaddq_f32(vmulq_n_f32(vld1q_f32(in + i + 4), kInt16Scale), DitherStep(lanesHi));
+            vst1q_s16(out + i, vcombine_s16(vqmovn_s32(ToInt32(a)), vqmovn_s32(ToInt32(b))));
+        }
+        vst1q_u32(dither->lanes, lanesLo);
+        vst1q_u32(dither->lanes + 4, lanesHi);
+    } else {
+        for (; i + 8 <= count; i += 8) {
+            float32x4_t a = vmulq_n_f32(vld1q_f32(in + i), kInt16Scale);
+            float32x4_t b = vmulq_n_f32(vld1q_f32(in + i + 4), kInt16Scale);
+            vst1q_s16(out + i, vcombine_s16(vqmovn_s32(ToInt32(a)), vqmovn_s32(ToInt32(b))));
+        }
+    }
+
+    // Whole groups of eight were consumed, so the tail starts back at lane 0
+    ScalarFloatToInt16(in + i, out + i, count - i, dither);
+}
+
+void NeonInterleave(const float* const* planes, float* out, size_t frames, uint32_t channels) {
+    if (channels != 2) {
+        ScalarInterleave(planes, out, frames, channels);
+        return;
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t lr = {{vld1q_f32(planes[0] + i), vld1q_f32(planes[1] + i)}};
+        vst2q_f32(out + 2 * i, lr);
+    }
+    const float* tail[2] = {planes[0] + i, planes[1] + i};
+    ScalarInterleave(tail, out + 2 * i, frames - i, channels);
+}
+
+void NeonDeinterleave(const float* in, float* const* planes, size_t frames, uint32_t channels) {
+    if (channels != 2) {
+        ScalarDeinterleave(in, planes, frames, channels);
+        return;
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t lr = vld2q_f32(in + 2 * i);
+        vst1q_f32(planes[0] + i, lr.val[0]);
+        vst1q_f32(planes[1] + i, lr.val[1]);
+    }
+    float* tail[2] = {planes[0] + i, planes[1] + i};
+    ScalarDeinterleave(in + 2 * i, tail, frames - i, channels);
+}
+
+float NeonDot(const float* a, const float* b, size_t count) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1)) + ScalarDot(a + i, b + i, count - i);
+}
+
+// Layouts whose frames tile a vector (1, 2 or 4 channels) run four lanes at a
+// time; others fall back to scalar
+void NeonChannelLevels(const float* in, size_t frames, uint32_t channels, float* sumSquares, float* peaks) {
+    if (channels == 0 || 4 % channels != 0) {
+        ScalarChannelLevels(in, frames, channels, sumSquares, peaks);
+        return;
+    }
+
+    float32x4_t squares = vdupq_n_f32(0.0f);
+    float32x4_t peak = vdupq_n_f32(0.0f);
+    size_t count = frames * channels;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v = vld1q_f32(in + i);
+        squares = vfmaq_f32(squares, v, v);
+        peak = vmaxq_f32(peak, vabsq_f32(v));
+    }
+
+    float laneSquares[4];
+    float lanePeaks[4];
+    vst1q_f32(laneSquares, squares);
+    vst1q_f32(lanePeaks, peak);
+    FoldLevelLanes(laneSquares, lanePeaks, 4, channels, sumSquares, peaks);
+    ScalarAccumulateLevels(in + i, (count - i) / channels, channels, sumSquares, peaks);
+}
+
+// Four butterflies at a time; stages of one and two butterflies per group
+// have no four-wide run and go scalar
+void NeonFftStage(float* re, float* im, size_t n, size_t half, const float* twiddleRe, const float* twiddleIm) {
+    if (half < 4) {
+        ScalarFftStage(re, im, n, half, twiddleRe, twiddleIm);
+        return;
+    }
+
+    for (size_t base = 0; base < n; base += 2 * half) {
+        float* re0 = re + base;
+        float* im0 = im + base;
+        float* re1 = re0 + half;
+        float* im1 = im0 + half;
+        for (size_t k = 0; k + 4 <= half; k += 4) {
+            float32x4_t wr = vld1q_f32(twiddleRe + k);
+            float32x4_t wi = vld1q_f32(twiddleIm + k);
+            float32x4_t br = vld1q_f32(re1 + k);
+            float32x4_t bi = vld1q_f32(im1 + k);
+            float32x4_t tr = vfmsq_f32(vmulq_f32(br, wr), bi, wi);
+            float32x4_t ti = vfmaq_f32(vmulq_f32(br, wi), bi, wr);
+            float32x4_t ar = vld1q_f32(re0 + k);
+            float32x4_t ai = vld1q_f32(im0 + k);
+            vst1q_f32(re1 + k, vsubq_f32(ar, tr));
+            vst1q_f32(im1 + k, vsubq_f32(ai, ti));
+            vst1q_f32(re0 + k, vaddq_f32(ar, tr));
+            vst1q_f32(im0 + k, vaddq_f32(ai, ti));
+        }
+    }
+}
+
+const Kernels kNeon = {
+    "neon",
+    NeonApplyGain,
+    NeonDownmixMono,
+    NeonDownmixStereo,
+    ScalarMixChannels,
+    NeonFloatToInt16,
+    NeonInterleave,
+    NeonDeinterleave,
+    NeonDot,
+    NeonChannelLevels,
+    NeonFftStage,
+};
+
+}  // namespace
+
+const Kernels* audio_dsp::NeonKernels() {
+    return &kNeon;
+}
+
+#else
+
+const audio_dsp::Kernels* audio_dsp::NeonKernels() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,465 @@
+#include "audio_dsp_kernels.h"
+
+// ============================================================================
+// SSE2 and AVX2 kernels (x86-64)
+//
+// SSE2 is part of the x86-64 baseline. The AVX2 functions are compiled with a
+// per-function target attribute, so the rest of the addon keeps running on
+// CPUs without AVX2; audio_dsp.cpp only selects them after checking CPUID.
+// ============================================================================
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AUDIO_DSP_AVX2
+#else
+#define AUDIO_DSP_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace audio_dsp;
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// SSE2
+// ----------------------------------------------------------------------------
+
+inline float HorizontalSum(__m128 v) {
+    __m128 t = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    t = _mm_add_ss(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(t);
+}
+
+// Sum of the channels of one frame, four lanes wide (channels % 4 == 0)
+inline __m128 FrameSum(const float* frame, uint32_t channels) {
+    __m128 sum = _mm_loadu_ps(frame);
+    for (uint32_t c = 4; c < channels; c += 4) {
+        sum = _mm_add_ps(sum, _mm_loadu_ps(frame + c));
+    }
+    return sum;
+}
+
+void Sse2ApplyGain(const float* in, float* out, size_t count, float gain, bool clamp) {
+    const __m128 g = _mm_set1_ps(gain);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+
+    size_t i = 0;
+    if (clamp) {
+        for (; i + 4 <= count; i += 4) {
+            __m128 v = _mm_mul_ps(_mm_loadu_ps(in + i), g);
+            _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(v, lo), hi));
+        }
+    } else {
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), g));
+        }
+    }
+    ScalarApplyGain(in + i, out + i, count - i, gain, clamp);
+}
+
+void Sse2DownmixMono(const float* in, float* out, size_t frames, uint32_t channels) {
+    if (channels == 2) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            __m128 a = _mm_loadu_ps(in + 2 * i);
+            __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+            __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+        }
+        ScalarDownmixMono(in + 2 * i, out + i, frames - i, channels);
+        return;
+    }
+
+    if (channels >= 4 && channels % 4 == 0) {
+        float scale = 1.0f / static_cast<float>(channels);
+        for (size_t i = 0; i < frames; i++) {
+            out[i] = HorizontalSum(FrameSum(in + i * channels, channels)) * scale;
+        }
+        return;
+    }
+
+    ScalarDownmixMono(in, out, frames, channels);
+}
+
+void Sse2DownmixStereo(const float* in, float* out, size_t frames, uint32_t channels) {
+    if (channels == 1) {
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            __m128 v = _mm_loadu_ps(in + i);
+            _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(v, v));
+            _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(v, v));
+        }
+        ScalarDownmixStereo(in + i, out + 2 * i, frames - i, channels);
+        return;
+    }
+
+    if (channels >= 4 && channels % 4 == 0) {
+        // Lanes hold channels c = 0,1,2,3 (mod 4): left is lanes 0+2, right 1+3
+        const __m128 scale = _mm_set1_ps(2.0f / static_cast<float>(channels));
+        for (size_t i = 0; i < frames; i++) {
+            __m128 v = FrameSum(in + i * channels, channels);
+            v = _mm_mul_ps(_mm_add_ps(v, _mm_movehl_ps(v, v)), scale);
+            _mm_storel_pi(reinterpret_cast<__m64*>(out + 2 * i), v);
+        }
+        return;
+    }
+
+    ScalarDownmixStereo(in, out, frames, channels);
+}
+
+// Advance four dither lanes and return their TPDF values
+inline __m128 DitherStep(__m128i& x) {
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+
+    __m128i sum = _mm_add_epi32(_mm_srli_epi32(x, 16), _mm_and_si128(x, _mm_set1_epi32(0xFFFF)));
+    return _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps(kTpdfScale)), _mm_set1_ps(1.0f));
+}
+
+inline __m128i ToInt32(__m128 scaled) {
+    scaled = _mm_max_ps(scaled, _mm_set1_ps(-32768.0f));
+    scaled = _mm_min_ps(scaled, _mm_set1_ps(32767.0f));
+    return _mm_cvtps_epi32(scaled);
+}
+
+void Sse2FloatToInt16(const float* in, int16_t* out, size_t count, AudioDspDitherState* dither) {
+    const __m128 scale = _mm_set1_ps(kInt16Scale);
+    size_t i = 0;
+
+    if (dither) {
+        __m128i lanesLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes));
+        __m128i lanesHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes + 4));
+        for (; i + 8 <= count; i += 8) {
+            __m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), DitherStep(lanesLo));
+            __m128 b = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), DitherStep(lanesHi));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(ToInt32(a), ToInt32(b)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->lanes), lanesLo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->lanes + 4), lanesHi);
+    } else {
+        for (; i + 8 <= count; i += 8) {
+            __m128 a = _mm_mul_ps(_mm_loadu_ps(in + i), scale);
+            __m128 b = _mm_mul_ps(_mm_loadu_ps(in + i + 4), scale);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(ToInt32(a), ToInt32(b)));
+        }
+    }
+
+    // Whole groups of eight were consumed, so the tail starts back at lane 0
+    ScalarFloatToInt16(in + i, out + i, count - i, dither);
+}
+
+void Sse2Interleave(const float* const* planes, float* out, size_t frames, uint32_t channels) {
+    if (channels != 2) {
+        ScalarInterleave(planes, out, frames, channels);
+        return;
+    }
+
+    const float* left = planes[0];
+    const float* right = planes[1];
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 l = _mm_loadu_ps(left + i);
+        __m128 r = _mm_loadu_ps(right + i);
+        _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+    }
+    const float* tail[2] = {left + i, right + i};
+    ScalarInterleave(tail, out + 2 * i, frames - i, channels);
+}
+
+void Sse2Deinterleave(const float* in, float* const* planes, size_t frames, uint32_t channels) {
+    if (channels != 2) {
+        ScalarDeinterleave(in, planes, frames, channels);
+        return;
+    }
+
+    float* left = planes[0];
+    float* right = planes[1];
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 a = _mm_loadu_ps(in + 2 * i);
+        __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+        _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    float* tail[2] = {left + i, right + i};
+    ScalarDeinterleave(in + 2 * i, tail, frames - i, channels);
+}
+
+float Sse2Dot(const float* a, const float* b, size_t count) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    return HorizontalSum(_mm_add_ps(acc0, acc1)) + ScalarDot(a + i, b + i, count - i);
+}
+
+// Layouts whose frames tile a vector (1, 2 or 4 channels) run four lanes at a
+// time; others fall back to scalar
+void Sse2ChannelLevels(const float* in, size_t frames, uint32_t channels, float* sumSquares, float* peaks) {
+    if (channels == 0 || 4 % channels != 0) {
+        ScalarChannelLevels(in, frames, channels, sumSquares, peaks);
+        return;
+    }
+
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 squares = _mm_setzero_ps();
+    __m128 peak = _mm_setzero_ps();
+    size_t count = frames * channels;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(in + i);
+        squares = _mm_add_ps(squares, _mm_mul_ps(v, v));
+        peak = _mm_max_ps(peak, _mm_and_ps(v, absMask));
+    }
+
+    float laneSquares[4];
+    float lanePeaks[4];
+    _mm_storeu_ps(laneSquares, squares);
+    _mm_storeu_ps(lanePeaks, peak);
+    FoldLevelLanes(laneSquares, lanePeaks, 4, channels, sumSquares, peaks);
+    ScalarAccumulateLevels(in + i, (count - i) / channels, channels, sumSquares, peaks);
+}
+
+// Four butterflies at a time; stages of one and two butterflies per group
+// have no four-wide run and go scalar
+void Sse2FftStage(float* re, float* im, size_t n, size_t half, const float* twiddleRe, const float* twiddleIm) {
+    if (half < 4) {
+        ScalarFftStage(re, im, n, half, twiddleRe, twiddleIm);
+        return;
+    }
+
+    for (size_t base = 0; base < n; base += 2 * half) {
+        float* re0 = re + base;
+        float* im0 = im + base;
+        float* re1 = re0 + half;
+        float* im1 = im0 + half;
+        for (size_t k = 0; k + 4 <= half; k += 4) {
+            __m128 wr = _mm_loadu_ps(twiddleRe + k);
+            __m128 wi = _mm_loadu_ps(twiddleIm + k);
+            __m128 br = _mm_loadu_ps(re1 + k);
+            __m128 bi = _mm_loadu_ps(im1 + k);
+            __m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+            __m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+            __m128 ar = _mm_loadu_ps(re0 + k);
+            __m128 ai = _mm_loadu_ps(im0 + k);
+            _mm_storeu_ps(re1 + k, _mm_sub_ps(ar, tr));
+            _mm_storeu_ps(im1 + k, _mm_sub_ps(ai, ti));
+            _mm_storeu_ps(re0 + k, _mm_add_ps(ar, tr));
+            _mm_storeu_ps(im0 + k, _mm_add_ps(ai, ti));
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// AVX2 (interleave and stereo downmix reuse the SSE2 kernels)
+// ----------------------------------------------------------------------------
+
+AUDIO_DSP_AVX2 void Avx2ApplyGain(const float* in, float* out, size_t count, float gain, bool clamp) {
+    const __m256 g = _mm256_set1_ps(gain);
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    const __m256 hi = _mm256_set1_ps(1.0f);
+
+    size_t i = 0;
+    if (clamp) {
+        for (; i + 8 <= count; i += 8) {
+            __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in + i), g);
+            _mm256_storeu_ps(out + i, _mm256_min_ps(_mm256_max_ps(v, lo), hi));
+        }
+    } else {
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(in + i), g));
+        }
+    }
+    ScalarApplyGain(in + i, out + i, count - i, gain, clamp);
+}
+
+AUDIO_DSP_AVX2 void Avx2DownmixMono(const float* in, float* out, size_t frames, uint32_t channels) {
+    if (channels == 2) {
+        const __m256 half = _mm256_set1_ps(0.5f);
+        size_t i = 0;
+        for (; i + 8 <= frames; i += 8) {
+            // hadd pairs within 128-bit halves; the permute restores frame order
+            __m256 sum = _mm256_hadd_ps(_mm256_loadu_ps(in + 2 * i), _mm256_loadu_ps(in + 2 * i + 8));
+            sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(sum, half));
+        }
+        Sse2DownmixMono(in + 2 * i, out + i, frames - i, channels);
+        return;
+    }
+
+    if (channels >= 8 && channels % 8 == 0) {
+        float scale = 1.0f / static_cast<float>(channels);
+        for (size_t i = 0; i < frames; i++) {
+            const float* frame = in + i * channels;
+            __m256 sum = _mm256_loadu_ps(frame);
+            for (uint32_t c = 8; c < channels; c += 8) {
+                sum = _mm256_add_ps(sum, _mm256_loadu_ps(frame + c));
+            }
+            __m128 folded = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+            out[i] = HorizontalSum(folded) * scale;
+        }
+        return;
+    }
+
+    Sse2DownmixMono(in, out, frames, channels);
+}
+
+AUDIO_DSP_AVX2 void Avx2FloatToInt16(const float* in, int16_t* out, size_t count, AudioDspDitherState* dither) {
+    const __m256 scale = _mm256_set1_ps(kInt16Scale);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    size_t i = 0;
+
+    __m256i lanes = dither ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither->lanes))
+                           : _mm256_setzero_si256();
+    const __m256i mask = _mm256_set1_epi32(0xFFFF);
+    const __m256 tpdfScale = _mm256_set1_ps(kTpdfScale);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in + i), scale);
+        if (dither) {
+            lanes = _mm256_xor_si256(lanes, _mm256_slli_epi32(lanes, 13));
+            lanes = _mm256_xor_si256(lanes, _mm256_srli_epi32(lanes, 17));
+            lanes = _mm256_xor_si256(lanes, _mm256_slli_epi32(lanes, 5));
+            __m256i sum = _mm256_add_epi32(_mm256_srli_epi32(lanes, 16), _mm256_and_si256(lanes, mask));
+            v = _mm256_add_ps(v, _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(sum), tpdfScale), one));
+        }
+        __m256i ints = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, lo), hi));
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(ints), _mm256_extracti128_si256(ints, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+
+    if (dither) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dither->lanes), lanes);
+    }
+    ScalarFloatToInt16(in + i, out + i, count - i, dither);
+}
+
+AUDIO_DSP_AVX2 float Avx2Dot(const float* a, const float* b, size_t count) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 folded = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    return HorizontalSum(folded) + Sse2Dot(a + i, b + i, count - i);
+}
+
+AUDIO_DSP_AVX2 void Avx2ChannelLevels(const float* in, size_t frames, uint32_t channels, float* sumSquares,
+                                     float* peaks) {
+    if (channels == 0 || 8 % channels != 0) {
+        ScalarChannelLevels(in, frames, channels, sumSquares, peaks);
+        return;
+    }
+
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 squares = _mm256_setzero_ps();
+    __m256 peak = _mm256_setzero_ps();
+    size_t count = frames * channels;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(in + i);
+        squares = _mm256_add_ps(squares, _mm256_mul_ps(v, v));
+        peak = _mm256_max_ps(peak, _mm256_and_ps(v, absMask));
+    }
+
+    float laneSquares[8];
+    float lanePeaks[8];
+    _mm256_storeu_ps(laneSquares, squares);
+    _mm256_storeu_ps(lanePeaks, peak);
+    FoldLevelLanes(laneSquares, lanePeaks, 8, channels, sumSquares, peaks);
+    ScalarAccumulateLevels(in + i, (count - i) / channels, channels, sumSquares, peaks);
+}
+
+AUDIO_DSP_AVX2 void Avx2FftStage(float* re, float* im, size_t n, size_t half, const float* twiddleRe,
+                                const float* twiddleIm) {
+    if (half < 8) {
+        Sse2FftStage(re, im, n, half, twiddleRe, twiddleIm);
+        return;
+    }
+
+    for (size_t base = 0; base < n; base += 2 * half) {
+        float* re0 = re + base;
+        float* im0 = im + base;
+        float* re1 = re0 + half;
+        float* im1 = im0 + half;
+        for (size_t k = 0; k + 8 <= half; k += 8) {
+            __m256 wr = _mm256_loadu_ps(twiddleRe + k);
+            __m256 wi = _mm256_loadu_ps(twiddleIm + k);
+            __m256 br = _mm256_loadu_ps(re1 + k);
+            __m256 bi = _mm256_loadu_ps(im1 + k);
+            __m256 tr = _mm256_sub_ps(_mm256_mul_ps(br, wr), _mm256_mul_ps(bi, wi));
+            __m256 ti = _mm256_add_ps(_mm256_mul_ps(br, wi), _mm256_mul_ps(bi, wr));
+            __m256 ar = _mm256_loadu_ps(re0 + k);
+            __m256 ai = _mm256_loadu_ps(im0 + k);
+            _mm256_storeu_ps(re1 + k, _mm256_sub_ps(ar, tr));
+            _mm256_storeu_ps(im1 + k, _mm256_sub_ps(ai, ti));
+            _mm256_storeu_ps(re0 + k, _mm256_add_ps(ar, tr));
+            _mm256_storeu_ps(im0 + k, _mm256_add_ps(ai, ti));
+        }
+    }
+}
+
+const Kernels kSse2 = {
+    "sse2",
+    Sse2ApplyGain,
+    Sse2DownmixMono,
+    Sse2DownmixStereo,
+    ScalarMixChannels,
+    Sse2FloatToInt16,
+    Sse2Interleave,
+    Sse2Deinterleave,
+    Sse2Dot,
+    Sse2ChannelLevels,
+    Sse2FftStage,
+};
+
+const Kernels kAvx2 = {
+    "avx2",
+    Avx2ApplyGain,
+    Avx2DownmixMono,
+    Sse2DownmixStereo,
+    ScalarMixChannels,
+    Avx2FloatToInt16,
+    Sse2Interleave,
+    Sse2Deinterleave,
+    Avx2Dot,
+    Avx2ChannelLevels,
+    Avx2FftStage,
+};
+
+}  // namespace
+
+const Kernels* audio_dsp::Sse2Kernels() {
+    return &kSse2;
+}
+
+const Kernels* audio_dsp::Avx2Kernels() {
+    return &kAvx2;
+}
+
+#else
+
+const audio_dsp::Kernels* audio_dsp::Sse2Kernels() {
+    return nullptr;
+}
+
+const audio_dsp::Kernels* audio_dsp::Avx2Kernels() {
+    return nullptr;
+}
+
+#endif
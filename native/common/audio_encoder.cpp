@@ -0,0 +1,239 @@
+#include "audio_encoder.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "audio_dsp.h"
+#include "flac_encoder.h"
+
+#ifdef NATIVE_AUDIO_HAVE_OPUS
+#include <opus.h>
+#endif
+
+namespace {
+
+// ============================================================================
+// PCM conversions
+// ============================================================================
+
+class PcmS16Encoder : public AudioEncoder {
+public:
+    explicit PcmS16Encoder(size_t maxSamples) : output_(maxSamples) {
+        audio_dsp_dither_init(&dither_, 0x53313600u);
+    }
+
+    const char* Name() const override { return "pcm_s16le"; }
+    uint32_t BitsPerChannel() const override { return 16; }
+
+    void Encode(const uint8_t* pcm, size_t bytes, PacketCallback emit, void* context) override {
+        size_t count = bytes / sizeof(float);
+        if (count == 0) return;
+        if (output_.size() < count) output_.resize(count);
+        audio_dsp_float_to_int16(reinterpret_cast<const float*>(pcm), output_.data(), count, &dither_);
+        emit(reinterpret_cast<const uint8_t*>(output_.data()), count * sizeof(int16_t), context);
+    }
+
+private:
+    std::vector<int16_t> output_;
+    AudioDspDitherState dither_;
+};
+
+class PcmF32Encoder : public AudioEncoder {
+public:
+    explicit PcmF32Encoder(size_t maxSamples) : output_(maxSamples) {}
+
+    const char* Name() const override { return "pcm_f32le"; }
+    uint32_t BitsPerChannel() const override { return 32; }
+    bool IsFloat() const override { return true; }
+
+    void Encode(const uint8_t* pcm, size_t bytes, PacketCallback emit, void* context) override {
+        size_t count = bytes / sizeof(int16_t);
+        if (count == 0) return;
+        if (output_.size() < count) output_.resize(count);
+        const int16_t* in = reinterpret_cast<const int16_t*>(pcm);
+        for (size_t i = 0; i < count; i++) {
+            output_[i] = in[i] * (1.0f / 32768.0f);
+        }
+        emit(reinterpret_cast<const uint8_t*>(output_.data()), count * sizeof(float), context);
+    }
+
+private:
+    std::vector<float> output_;
+};
+
+// ============================================================================
+// Opus
+// ============================================================================
+
+#ifdef NATIVE_AUDIO_HAVE_OPUS
+
+// Buffers input into 20 ms frames; every frame becomes one packet (and so
+// one data event), which keeps packet boundaries intact for the decoder
+class OpusPacketEncoder : public AudioEncoder {
+public:
+    static std::unique_ptr<AudioEncoder> Create(const PcmFormat& input, const AudioEncoderOptions& options,
+                                                std::string* error) {
+        int32_t rate = static_cast<int32_t>(input.sampleRate);
+        bool rateSupported = rate == 8000 || rate == 12000 || rate == 16000 || rate == 24000 || rate == 48000;
+        if (!rateSupported || static_cast<double>(rate) != input.sampleRate) {
+            *error = "Opus requires a sample rate of 8000, 12000, 16000, 24000 or 48000 Hz";
+            return nullptr;
+        }
+        if (input.channels < 1 || input.channels > 2) {
+            *error = "Opus encoding supports mono or stereo only";
+            return nullptr;
+        }
+
+        int status = OPUS_OK;
+        OpusEncoder* encoder = opus_encoder_create(rate, static_cast<int>(input.channels),
+                                                   OPUS_APPLICATION_AUDIO, &status);
+        if (!encoder || status != OPUS_OK) {
+            *error = std::string("Failed to create Opus encoder: ") + opus_strerror(status);
+            return nullptr;
+        }
+        if (options.bitrate > 0) {
+            opus_encoder_ctl(encoder, OPUS_SET_BITRATE(options.bitrate));
+        }
+
+        return std::unique_ptr<AudioEncoder>(new OpusPacketEncoder(encoder, input));
+    }
+
+    ~OpusPacketEncoder() override { opus_encoder_destroy(encoder_); }
+
+    const char* Name() const override { return "opus"; }
+    uint32_t BitsPerChannel() const override { return 0; }    // Compressed
+
+    void Encode(const uint8_t* pcm, size_t bytes, PacketCallback emit, void* context) override {
+        const size_t frameSamples = frame_.size();
+        if (input_.isFloat) {
+            const float* in = reinterpret_cast<const float*>(pcm);
+            size_t count = bytes / sizeof(float);
+            while (count > 0) {
+                size_t take = std::min(count, frameSamples - fill_);
+                std::copy(in, in + take, frame_.begin() + fill_);
+                in += take;
+                count -= take;
+                fill_ += take;
+                if (fill_ == frameSamples) EncodeFrame(emit, context);
+            }
+        } else {
+            const int16_t* in = reinterpret_cast<const int16_t*>(pcm);
+            size_t count = bytes / sizeof(int16_t);
+            while (count > 0) {
+                size_t take = std::min(count, frameSamples - fill_);
+                for (size_t i = 0; i < take; i++) {
+                    frame_[fill_ + i] = in[i] * (1.0f / 32768.0f);
+                }
+                in += take;
+                count -= take;
+                fill_ += take;
+                if (fill_ == frameSamples) EncodeFrame(emit, context);
+            }
+        }
+    }
+
+    void Flush(PacketCallback emit, void* context) override {
+        // Pad the partial frame with silence so the tail isn't lost
+        if (fill_ == 0) return;
+        std::fill(frame_.begin() + fill_, frame_.end(), 0.0f);
+        EncodeFrame(emit, context);
+    }
+
+private:
+    // Largest packet opus_encode can produce for a single frame
+    static constexpr size_t kMaxPacketBytes = 4000;
+
+    OpusPacketEncoder(OpusEncoder* encoder, const PcmFormat& input)
+        : encoder_(encoder),
+          input_(input),
+          frameFrames_(static_cast<int>(input.sampleRate) / 50),
+          frame_(static_cast<size_t>(frameFrames_) * input.channels),
+          packet_(kMaxPacketBytes) {}
+
+    void EncodeFrame(PacketCallback emit, void* context) {
+        fill_ = 0;
+        opus_int32 size = opus_encode_float(encoder_, frame_.data(), frameFrames_, packet_.data(),
+                                            static_cast<opus_int32>(packet_.size()));
+        if (size > 0) {
+            emit(packet_.data(), static_cast<size_t>(size), context);
+        }
+    }
+
+    OpusEncoder* encoder_;
+    PcmFormat input_;
+    int frameFrames_;
+    std::vector<float> frame_;
+    std::vector<uint8_t> packet_;
+    size_t fill_ = 0;
+};
+
+#endif  // NATIVE_AUDIO_HAVE_OPUS
+
+}  // namespace
+
+bool ParseAudioEncoding(const std::string& name, AudioEncoding* encoding) {
+    if (name == "pcm_s16le") {
+        *encoding = AudioEncoding::PcmS16;
+    } else if (name == "pcm_f32le") {
+        *encoding = AudioEncoding::PcmF32;
+    } else if (name == "flac") {
+        *encoding = AudioEncoding::Flac;
+    } else if (name == "opus") {
+        *encoding = AudioEncoding::Opus;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool IsAudioEncodingAvailable(AudioEncoding encoding) {
+#ifndef NATIVE_AUDIO_HAVE_OPUS
+    if (encoding == AudioEncoding::Opus) return false;
+#endif
+    (void)encoding;
+    return true;
+}
+
+std::unique_ptr<AudioEncoder> CreateAudioEncoder(AudioEncoding encoding, const PcmFormat& input,
+                                                 const AudioEncoderOptions& options, std::string* error) {
+    error->clear();
+    if (encoding == AudioEncoding::Native) return nullptr;
+
+    bool isF32 = input.isFloat && input.bitsPerChannel == 32;
+    bool isS16 = !input.isFloat && input.bitsPerChannel == 16;
+    if ((!isF32 && !isS16) || input.channels == 0) {
+        *error = "Unsupported capture format for encoding";
+        return nullptr;
+    }
+
+    size_t maxSamples = std::max<size_t>(options.maxChunkFrames, 1) * input.channels;
+
+    switch (encoding) {
+        case AudioEncoding::PcmS16:
+            if (isS16) return nullptr;
+            return std::unique_ptr<AudioEncoder>(new PcmS16Encoder(maxSamples));
+
+        case AudioEncoding::PcmF32:
+            if (isF32) return nullptr;
+            return std::unique_ptr<AudioEncoder>(new PcmF32Encoder(maxSamples));
+
+        case AudioEncoding::Flac:
+            if (!FlacEncoder::Supports(input)) {
+                *error = "FLAC encoding needs 1-8 channels at an integer sample rate";
+                return nullptr;
+            }
+            return std::unique_ptr<AudioEncoder>(new FlacEncoder(input, options.maxChunkFrames));
+
+        case AudioEncoding::Opus:
+#ifdef NATIVE_AUDIO_HAVE_OPUS
+            return OpusPacketEncoder::Create(input, options, error);
+#else
+            *error = "Opus encoding is not available in this build (libopus was not found)";
+            return nullptr;
+#endif
+
+        case AudioEncoding::Native:
+            break;
+    }
+    return nullptr;
+}
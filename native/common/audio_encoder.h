@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// ============================================================================
+// AudioEncoder - per-session output encoding stage
+//
+// Sits between the platform capture layer and the event queue: each PCM chunk
+// the capture layer delivers is handed to Encode(), which emits zero or more
+// encoded packets through a plain callback. Encoders are created once the
+// stream format is known (the metadata callback) and run on whichever thread
+// delivers chunks. Buffers are sized up front from the expected chunk size, so
+// Encode() only allocates if a chunk turns out larger than announced.
+// ============================================================================
+
+enum class AudioEncoding : int32_t {
+    Native = 0,     // Whatever the capture layer produces; no encoder
+    PcmS16 = 1,     // pcm_s16le, dithered from float input
+    PcmF32 = 2,     // pcm_f32le
+    Flac = 3,       // Native FLAC stream; the first packet carries the stream header
+    Opus = 4,       // One Opus packet per data event (requires libopus)
+};
+
+// PCM layout of the chunks handed to Encode()
+struct PcmFormat {
+    double sampleRate = 0;
+    uint32_t channels = 1;
+    uint32_t bitsPerChannel = 32;
+    bool isFloat = true;
+};
+
+struct AudioEncoderOptions {
+    int32_t bitrate = 0;            // Bits per second for lossy codecs; 0 = codec default
+    size_t maxChunkFrames = 0;      // Expected upper bound on frames per Encode() call
+};
+
+class AudioEncoder {
+public:
+    typedef void (*PacketCallback)(const uint8_t* data, size_t size, void* context);
+
+    virtual ~AudioEncoder() = default;
+
+    // Output format as reported through the metadata callback
+    virtual const char* Name() const = 0;
+    virtual uint32_t BitsPerChannel() const = 0;
+    virtual bool IsFloat() const { return false; }
+
+    // Consume one interleaved PCM chunk in the input format
+    virtual void Encode(const uint8_t* pcm, size_t bytes, PacketCallback emit, void* context) = 0;
+
+    // End of stream: emit anything still buffered
+    virtual void Flush(PacketCallback emit, void* context) { (void)emit; (void)context; }
+};
+
+// Parse an encoding name ("pcm_s16le", "pcm_f32le", "flac", "opus"); false if unknown
+bool ParseAudioEncoding(const std::string& name, AudioEncoding* encoding);
+
+// Whether this build can produce the encoding at all (Opus needs libopus)
+bool IsAudioEncodingAvailable(AudioEncoding encoding);
+
+// Returns nullptr with an empty error when the input already matches the
+// requested encoding, and nullptr with a message when it cannot be encoded
+std::unique_ptr<AudioEncoder> CreateAudioEncoder(AudioEncoding encoding, const PcmFormat& input,
+                                                 const AudioEncoderOptions& options, std::string* error);
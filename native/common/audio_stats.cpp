@@ -0,0 +1,71 @@
+#include "audio_stats.h"
+#include "capture_stats.h"
+
+#include <chrono>
+#include <new>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <time.h>
+#endif
+
+extern "C" {
+
+AudioStats* audio_stats_create(void) {
+    return new (std::nothrow) AudioStats();
+}
+
+void audio_stats_destroy(AudioStats* stats) {
+    delete stats;
+}
+
+void audio_stats_reset(AudioStats* stats) {
+    stats->Reset();
+}
+
+uint64_t audio_stats_now_ns(void) {
+#if defined(_WIN32)
+    static const LONGLONG frequency = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return f.QuadPart;
+    }();
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // Split so counter * 1e9 can't overflow
+    uint64_t seconds = static_cast<uint64_t>(counter.QuadPart / frequency);
+    uint64_t remainder = static_cast<uint64_t>(counter.QuadPart % frequency);
+    return seconds * 1000000000ull + remainder * 1000000000ull / static_cast<uint64_t>(frequency);
+#elif defined(__APPLE__)
+    // mach_absolute_time in nanoseconds
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+void audio_stats_record_callback(AudioStats* stats, uint64_t durationNs, uint64_t frames) {
+    stats->RecordCallback(durationNs, frames);
+}
+
+void audio_stats_record_conversion(AudioStats* stats, uint64_t durationNs) {
+    stats->RecordConversion(durationNs);
+}
+
+void audio_stats_add_emitted(AudioStats* stats, uint64_t frames) {
+    stats->AddEmitted(frames);
+}
+
+void audio_stats_add_dropped(AudioStats* stats, uint64_t frames) {
+    stats->AddDropped(frames);
+}
+
+void audio_stats_snapshot(const AudioStats* stats, AudioStatsSnapshot* snapshot) {
+    stats->Snapshot(snapshot);
+}
+
+}  // extern "C"
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+// ============================================================================
+// Biquad - second-order IIR section for the analysis stages
+//
+// RBJ cookbook high- and low-pass designs at Q = 1/sqrt(2), run in transposed
+// direct form II. Cutoffs are clamped below Nyquist so a band edge above a low
+// sample rate still gives a stable filter.
+// ============================================================================
+
+struct Biquad {
+    float b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    float z1 = 0, z2 = 0;
+
+    static Biquad HighPass(double cutoffHz, double sampleRate) {
+        Design d(cutoffHz, sampleRate);
+        return d.Make((1.0 + d.cosw) / 2.0, -(1.0 + d.cosw));
+    }
+
+    static Biquad LowPass(double cutoffHz, double sampleRate) {
+        Design d(cutoffHz, sampleRate);
+        return d.Make((1.0 - d.cosw) / 2.0, 1.0 - d.cosw);
+    }
+
+    float Process(float x) {
+        float y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        return y;
+    }
+
+private:
+    struct Design {
+        double cosw;
+        double alpha;
+
+        Design(double cutoffHz, double sampleRate) {
+            const double pi = 3.14159265358979323846;
+            double w = 2.0 * pi * std::min(cutoffHz, sampleRate * 0.45) / sampleRate;
+            cosw = std::cos(w);
+            alpha = std::sin(w) / std::sqrt(2.0);
+        }
+
+        // b0 == b2 for both designs
+        Biquad Make(double b0, double b1) const {
+            double a0 = 1.0 + alpha;
+            Biquad q;
+            q.b0 = static_cast<float>(b0 / a0);
+            q.b1 = static_cast<float>(b1 / a0);
+            q.b2 = q.b0;
+            q.a1 = static_cast<float>(-2.0 * cosw / a0);
+            q.a2 = static_cast<float>((1.0 - alpha) / a0);
+            return q;
+        }
+    };
+};
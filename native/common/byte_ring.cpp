@@ -0,0 +1,41 @@
+#include "audio_ring.h"
+#include "byte_ring.h"
+
+#include <new>
+
+struct AudioByteRing {
+    explicit AudioByteRing(size_t capacityBytes) : ring(capacityBytes) {}
+    ByteRing ring;
+};
+
+extern "C" {
+
+AudioByteRing* audio_ring_create(size_t capacityBytes) {
+    try {
+        return new AudioByteRing(capacityBytes);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void audio_ring_destroy(AudioByteRing* ring) {
+    delete ring;
+}
+
+bool audio_ring_write(AudioByteRing* ring, const void* data, size_t bytes) {
+    return ring->ring.Write(data, bytes);
+}
+
+size_t audio_ring_read(AudioByteRing* ring, void* dest, size_t maxBytes) {
+    return ring->ring.Read(dest, maxBytes);
+}
+
+size_t audio_ring_readable(const AudioByteRing* ring) {
+    return ring->ring.Readable();
+}
+
+void audio_ring_reset(AudioByteRing* ring) {
+    ring->ring.Reset();
+}
+
+}  // extern "C"
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ============================================================================
+// ByteRing - single-producer single-consumer lock-free byte FIFO
+//
+// Meant for handing raw samples from a real-time callback to a worker thread:
+// Write() is a bounds check plus at most two memcpys, never blocks and never
+// allocates. Writes are all-or-nothing so frames are never split by overflow.
+// ============================================================================
+
+class ByteRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit ByteRing(size_t capacityBytes)
+        : capacity_(RoundUpPow2(capacityBytes < 64 ? 64 : capacityBytes)),
+          mask_(capacity_ - 1),
+          storage_(capacity_) {}
+
+    ByteRing(const ByteRing&) = delete;
+    ByteRing& operator=(const ByteRing&) = delete;
+
+    size_t Capacity() const { return capacity_; }
+
+    size_t Readable() const {
+        return static_cast<size_t>(write_.load(std::memory_order_acquire) - read_.load(std::memory_order_acquire));
+    }
+
+    // Producer: room for Write() right now; only grows until the producer writes
+    size_t Writable() const {
+        return capacity_ - static_cast<size_t>(write_.load(std::memory_order_relaxed) -
+                                               read_.load(std::memory_order_acquire));
+    }
+
+    // Producer: copy all of `bytes` in, or nothing if it doesn't fit
+    bool Write(const void* data, size_t bytes) {
+        uint64_t w = write_.load(std::memory_order_relaxed);
+        uint64_t r = read_.load(std::memory_order_acquire);
+        if (bytes > capacity_ - static_cast<size_t>(w - r)) {
+            return false;
+        }
+
+        size_t offset = static_cast<size_t>(w & mask_);
+        size_t first = bytes < capacity_ - offset ? bytes : capacity_ - offset;
+        memcpy(&storage_[offset], data, first);
+        memcpy(&storage_[0], static_cast<const uint8_t*>(data) + first, bytes - first);
+
+        write_.store(w + bytes, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: copy up to maxBytes out; returns the number copied
+    size_t Read(void* dest, size_t maxBytes) {
+        uint64_t r = read_.load(std::memory_order_relaxed);
+        uint64_t w = write_.load(std::memory_order_acquire);
+        size_t bytes = static_cast<size_t>(w - r);
+        if (bytes > maxBytes) bytes = maxBytes;
+
+        size_t offset = static_cast<size_t>(r & mask_);
+        size_t first = bytes < capacity_ - offset ? bytes : capacity_ - offset;
+        memcpy(dest, &storage_[offset], first);
+        memcpy(static_cast<uint8_t*>(dest) + first, &storage_[0], bytes - first);
+
+        read_.store(r + bytes, std::memory_order_release);
+        return bytes;
+    }
+
+    // Discard everything; only valid while neither side is active
+    void Reset() {
+        read_.store(0, std::memory_order_relaxed);
+        write_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static size_t RoundUpPow2(size_t v) {
+        size_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::vector<uint8_t> storage_;
+
+    alignas(64) std::atomic<uint64_t> write_{0};
+    alignas(64) std::atomic<uint64_t> read_{0};
+};
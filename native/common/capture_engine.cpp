@@ -0,0 +1,488 @@
+#include "capture_engine.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+#include "audio_dsp.h"
+
+namespace {
+
+// Engine chunks are only the hand-off unit to subscribers, so keep them short
+constexpr double kEngineChunkMs = 10;
+
+// Per-subscriber backlog: a few seconds of 48 kHz stereo float
+constexpr size_t kSubscriberRingBytes = 2 * 1024 * 1024;
+
+// Frames converted per pass on a subscriber worker
+constexpr size_t kSliceFrames = 4096;
+
+std::mutex& RegistryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<std::string, std::weak_ptr<CaptureEngine>>& Registry() {
+    static std::map<std::string, std::weak_ptr<CaptureEngine>> registry;
+    return registry;
+}
+
+void AppendList(std::string& key, const char* name, std::vector<int32_t> values) {
+    std::sort(values.begin(), values.end());
+    key += name;
+    for (int32_t value : values) {
+        key += std::to_string(value);
+        key += ',';
+    }
+}
+
+}  // namespace
+
+std::string CaptureSource::Key() const {
+    std::string key = microphone ? "mic|" + deviceUID : std::string("system|") + (mute ? "mute" : "");
+    if (microphone) {
+        key += "|latency:" + std::to_string(latencyMode);
+    } else {
+        AppendList(key, "|include:", includeProcesses);
+        AppendList(key, "|exclude:", excludeProcesses);
+    }
+    key += emitSilence ? "|silence" : "";
+    key += "|buffer:" + std::to_string(bufferDurationMs);
+    return key;
+}
+
+// ============================================================================
+// CaptureEngine
+// ============================================================================
+
+std::unique_ptr<CaptureSubscription> CaptureEngine::Subscribe(const CaptureSource& source,
+                                                              const SubscriberFormat& format,
+                                                              AudioDataCallback dataCallback,
+                                                              AudioEventCallback eventCallback,
+                                                              AudioMetadataCallback metadataCallback, void* context,
+                                                              int32_t* result) {
+    std::unique_ptr<CaptureSubscription> subscription(
+        new CaptureSubscription(format, dataCallback, eventCallback, metadataCallback, context));
+
+    std::string key = source.Key();
+    std::shared_ptr<CaptureEngine> engine;
+    {
+        std::lock_guard<std::mutex> lock(RegistryMutex());
+        engine = Registry()[key].lock();
+        if (!engine) {
+            engine.reset(new CaptureEngine());
+            Registry()[key] = engine;
+        }
+    }
+
+    // A platform start can take a while (device negotiation, permission
+    // prompts); only sessions subscribing to this source wait for it
+    int32_t status = engine->Start(source);
+    if (status != 0) {
+        std::lock_guard<std::mutex> lock(RegistryMutex());
+        auto it = Registry().find(key);
+        if (it != Registry().end() && it->second.lock() == engine) {
+            Registry().erase(it);
+        }
+        *result = status;
+        return nullptr;
+    }
+
+    subscription->engine_ = engine;
+    subscription->worker_ = std::thread(&CaptureSubscription::WorkerLoop, subscription.get());
+
+    // Start goes out before Add so it precedes this subscriber's metadata and
+    // the warnings replayed from the platform start
+    if (eventCallback) {
+        eventCallback(0, nullptr, context);
+    }
+    engine->Add(subscription.get());
+
+    *result = 0;
+    return subscription;
+}
+
+CaptureEngine::~CaptureEngine() {
+    if (handle_) {
+        if (audio_is_running(handle_)) {
+            audio_stop(handle_);
+        }
+        audio_destroy(handle_);
+    }
+    delete active_.load();
+}
+
+int32_t CaptureEngine::Start(const CaptureSource& source) {
+    std::lock_guard<std::mutex> lock(startMutex_);
+    if (!startAttempted_) {
+        startAttempted_ = true;
+        {
+            std::lock_guard<std::mutex> subscribersLock(mutex_);
+            starting_ = true;
+        }
+        startStatus_ = StartPlatform(source);
+        {
+            std::lock_guard<std::mutex> subscribersLock(mutex_);
+            starting_ = false;
+        }
+    }
+    return startStatus_;
+}
+
+int32_t CaptureEngine::StartPlatform(const CaptureSource& source) {
+    handle_ = audio_create(&CaptureEngine::OnData, &CaptureEngine::OnEvent, &CaptureEngine::OnMetadata, this);
+    if (!handle_) return -1;
+
+    audio_set_buffer_duration(handle_, source.bufferDurationMs);
+    audio_set_tap_cache_ttl(handle_, source.tapCacheTtlMs);
+    audio_set_latency_mode(handle_, source.latencyMode);
+
+    // Native rate and channel layout; subscribers convert from there
+    if (source.microphone) {
+        return audio_start_microphone(handle_, 0, kEngineChunkMs, false, source.emitSilence,
+                                      source.deviceUID.empty() ? nullptr : source.deviceUID.c_str(), 1.0);
+    }
+
+    return audio_start_system_audio(
+        handle_, 0, kEngineChunkMs, source.mute, false, source.emitSilence,
+        source.includeProcesses.empty() ? nullptr : source.includeProcesses.data(),
+        static_cast<int32_t>(source.includeProcesses.size()),
+        source.excludeProcesses.empty() ? nullptr : source.excludeProcesses.data(),
+        static_cast<int32_t>(source.excludeProcesses.size()));
+}
+
+void CaptureEngine::Add(CaptureSubscription* subscriber) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_.push_back(subscriber);
+    if (hasFormat_) {
+        subscriber->SetSourceFormat(format_);
+    }
+    for (const auto& event : startEvents_) {
+        subscriber->Report(event.first, event.second.c_str());
+    }
+    Publish();
+}
+
+void CaptureEngine::Remove(CaptureSubscription* subscriber) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_.erase(std::remove(subscribers_.begin(), subscribers_.end(), subscriber), subscribers_.end());
+    Publish();
+}
+
+// Called with mutex_ held. Once this returns the capture thread no longer
+// sees the previous list, so a removed subscriber can be torn down.
+void CaptureEngine::Publish() {
+    const std::vector<CaptureSubscription*>* previous =
+        active_.exchange(new std::vector<CaptureSubscription*>(subscribers_));
+
+    // Callbacks are serialized, so this waits out at most the one in flight
+    while (readers_.load() != 0) {
+        std::this_thread::yield();
+    }
+    delete previous;
+}
+
+void CaptureEngine::OnData(const uint8_t* data, int32_t length, const AudioChunkInfo* info, void* context) {
+    CaptureEngine* self = static_cast<CaptureEngine*>(context);
+    if (length <= 0) return;
+
+    // Sequentially consistent with Publish(): either it sees this reader, or
+    // this reader sees the new list
+    self->readers_.fetch_add(1);
+    if (const std::vector<CaptureSubscription*>* subscribers = self->active_.load()) {
+        for (CaptureSubscription* subscriber : *subscribers) {
+            subscriber->Push(data, static_cast<size_t>(length), *info);
+        }
+    }
+    self->readers_.fetch_sub(1);
+}
+
+void CaptureEngine::OnEvent(int32_t eventType, const char* message, void* context) {
+    CaptureEngine* self = static_cast<CaptureEngine*>(context);
+
+    // Start and stop are per subscriber; only errors and warnings are shared
+    if (eventType != 2 && eventType != 3) return;
+
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    if (self->starting_) {
+        self->startEvents_.emplace_back(eventType, message ? message : "");
+    }
+    for (CaptureSubscription* subscriber : self->subscribers_) {
+        subscriber->Report(eventType, message);
+    }
+}
+
+void CaptureEngine::OnMetadata(double sampleRate, uint32_t channelsPerFrame, uint32_t bitsPerChannel, bool isFloat,
+                               const char* encoding, void* context) {
+    CaptureEngine* self = static_cast<CaptureEngine*>(context);
+    (void)encoding;
+
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    self->format_.sampleRate = sampleRate;
+    self->format_.channels = channelsPerFrame;
+    self->format_.bitsPerChannel = bitsPerChannel;
+    self->format_.isFloat = isFloat;
+    self->hasFormat_ = true;
+
+    for (CaptureSubscription* subscriber : self->subscribers_) {
+        subscriber->SetSourceFormat(self->format_);
+    }
+}
+
+// ============================================================================
+// CaptureSubscription
+// ============================================================================
+
+CaptureSubscription::CaptureSubscription(const SubscriberFormat& format, AudioDataCallback dataCallback,
+                                         AudioEventCallback eventCallback, AudioMetadataCallback metadataCallback,
+                                         void* context)
+    : format_(format),
+      dataCallback_(dataCallback),
+      eventCallback_(eventCallback),
+      metadataCallback_(metadataCallback),
+      context_(context),
+      ring_(kSubscriberRingBytes) {}
+
+CaptureSubscription::~CaptureSubscription() {
+    // Never attached (the capture failed to start): nothing to tear down
+    if (!engine_) return;
+
+    engine_->Remove(this);
+    StopWorker();
+
+    if (eventCallback_) {
+        eventCallback_(1, nullptr, context_);
+    }
+
+    // The last subscriber to leave stops the capture. Unlist the engine under
+    // the registry lock so a concurrent Subscribe can't pick it up, but stop
+    // the platform capture outside it.
+    std::shared_ptr<CaptureEngine> engine = std::move(engine_);
+    {
+        std::lock_guard<std::mutex> lock(RegistryMutex());
+        bool last = engine.use_count() == 1;
+        for (auto it = Registry().begin(); it != Registry().end();) {
+            bool unlist = it->second.expired() || (last && it->second.lock() == engine);
+            it = unlist ? Registry().erase(it) : std::next(it);
+        }
+    }
+}
+
+void CaptureSubscription::SetSourceFormat(const SourceFormat& format) {
+    {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        pendingFormat_ = format;
+    }
+    pushFrameBytes_.store(format.channels * (format.bitsPerChannel / 8), std::memory_order_relaxed);
+    formatPending_.store(true, std::memory_order_release);
+    wake_.Notify();
+}
+
+// The chunk's timing travels in the ring ahead of its bytes, so the worker
+// anchors each chunk at exactly the frame it starts on
+void CaptureSubscription::Push(const uint8_t* data, size_t bytes, const AudioChunkInfo& info) {
+    PushHeader header{bytes, info, gapPending_};
+    if (ring_.Writable() < sizeof(header) + bytes) {
+        overrunBytes_.fetch_add(bytes, std::memory_order_relaxed);
+        size_t frameBytes = pushFrameBytes_.load(std::memory_order_relaxed);
+        if (frameBytes > 0) {
+            stats_.AddDropped(bytes / frameBytes);
+        }
+        gapPending_ = true;
+        return;
+    }
+
+    // Free space only grows while the capture thread isn't writing, so both fit
+    ring_.Write(&header, sizeof(header));
+    ring_.Write(data, bytes);
+    gapPending_ = false;
+    wake_.Notify();
+}
+
+void CaptureSubscription::GetStats(AudioStatsSnapshot* stats) const {
+    // Capture and callback timing belong to the shared platform session;
+    // conversion and delivery are this subscriber's own
+    *stats = {};
+    if (engine_ && engine_->handle_) {
+        audio_get_stats(engine_->handle_, stats);
+    }
+
+    AudioStatsSnapshot own;
+    stats_.Snapshot(&own);
+    stats->framesEmitted = own.framesEmitted;
+    stats->framesDropped += own.framesDropped;
+    stats->conversionNs = own.conversionNs;
+}
+
+void CaptureSubscription::Report(int32_t eventType, const char* message) {
+    if (eventCallback_) {
+        eventCallback_(eventType, message, context_);
+    }
+}
+
+double CaptureSubscription::OutputFrameOf(uint64_t sourceFrame) const {
+    double frames = static_cast<double>(sourceFrame) - static_cast<double>(formatStartFrame_);
+    return frames * outputFramesPerSourceFrame_;
+}
+
+void CaptureSubscription::StopWorker() {
+    stopRequested_.store(true, std::memory_order_release);
+    wake_.Notify();
+
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void CaptureSubscription::WorkerLoop() {
+    for (;;) {
+        wake_.Wait();
+        bool stop = stopRequested_.load(std::memory_order_acquire);
+
+        // Metadata always precedes the chunks that use it; finish the old
+        // format's samples before switching
+        if (formatPending_.exchange(false, std::memory_order_acq_rel)) {
+            SourceFormat format;
+            {
+                std::lock_guard<std::mutex> lock(formatMutex_);
+                format = pendingFormat_;
+            }
+            if (configured_) {
+                Drain();
+                chunks_.Flush([this](const float* samples, size_t count) { EmitChunk(samples, count); });
+            }
+            ApplyFormat(format);
+        }
+
+        Drain();
+        if (stop) break;
+    }
+
+    if (configured_) {
+        chunks_.Flush([this](const float* samples, size_t count) { EmitChunk(samples, count); });
+    }
+}
+
+void CaptureSubscription::ApplyFormat(const SourceFormat& format) {
+    source_ = format;
+    bool supported = (format.isFloat && format.bitsPerChannel == 32) || (!format.isFloat && format.bitsPerChannel == 16);
+    configured_ = supported && format.channels > 0 && format.sampleRate > 0;
+    if (!configured_) {
+        Report(2, "Unsupported shared capture format");
+        return;
+    }
+
+    channelMatrix_.clear();
+    if (!format_.channels.Empty() && !format_.channels.ForDevice(format.channels, &channelMatrix_)) {
+        configured_ = false;
+        Report(2, "The device has fewer channels than the channel map reads");
+        return;
+    }
+
+    double outputRate = format_.sampleRate > 0 ? format_.sampleRate : format.sampleRate;
+    outputChannels_ = !channelMatrix_.empty() ? format_.channels.outputChannels : format_.mono ? 1 : format.channels;
+    sliceFrames_ = kSliceFrames;
+
+    readBuffer_.assign(sliceFrames_ * format.channels * (format.bitsPerChannel / 8), 0);
+    floatBuffer_.assign(sliceFrames_ * format.channels, 0.0f);
+    layoutBuffer_.assign(sliceFrames_ * outputChannels_, 0.0f);
+
+    // Resample after downmixing, so the filter runs on as few channels as possible
+    resampler_.Configure(format.sampleRate, outputRate, outputChannels_, format_.quality, sliceFrames_);
+    size_t maxResampledSamples = resampler_.MaxOutputFrames(sliceFrames_) * outputChannels_;
+    resampleBuffer_.assign(maxResampledSamples, 0.0f);
+
+    size_t chunkFrames = std::max<size_t>(1, static_cast<size_t>(format_.chunkDurationMs / 1000.0 * outputRate));
+    chunks_.Reset(chunkFrames * outputChannels_, maxResampledSamples);
+
+    // Chunk timestamps restart with the format, from the next source frame.
+    // The engine captures at the device rate, so that is the device counter's rate.
+    clock_.Reset(outputRate, format.sampleRate);
+    formatStartFrame_ = drainedFrames_;
+    outputFramesPerSourceFrame_ = outputRate / format.sampleRate;
+
+    if (metadataCallback_) {
+        metadataCallback_(outputRate, outputChannels_, 32, true, "pcm_f32le", context_);
+    }
+}
+
+void CaptureSubscription::Drain() {
+    if (!configured_) return;
+
+    // The engine writes whole frames and reads are whole frames too, so the
+    // ring never splits one
+    size_t frameBytes = source_.channels * (source_.bitsPerChannel / 8);
+    for (;;) {
+        if (chunkRemaining_ == 0) {
+            // A header is published in one write, and its bytes right after it
+            PushHeader header;
+            if (ring_.Readable() < sizeof(header)) break;
+            ring_.Read(&header, sizeof(header));
+            BeginChunk(header);
+            continue;
+        }
+
+        size_t want = static_cast<size_t>(std::min<uint64_t>(chunkRemaining_, readBuffer_.size()));
+        size_t bytes = ring_.Read(readBuffer_.data(), want);
+        if (bytes == 0) break;
+        chunkRemaining_ -= bytes;
+        Process(readBuffer_.data(), bytes / frameBytes);
+        drainedFrames_ += bytes / frameBytes;
+    }
+}
+
+void CaptureSubscription::BeginChunk(const PushHeader& header) {
+    chunkRemaining_ = header.bytes;
+
+    double frame = OutputFrameOf(drainedFrames_);
+    const AudioChunkInfo& info = header.info;
+    clock_.Anchor(info.hostTimeNs, frame);
+    if (info.flags & AUDIO_CHUNK_DEVICE_POSITION) {
+        clock_.AnchorDevice(info.devicePosition, frame);
+    }
+    if (header.gap || (info.flags & AUDIO_CHUNK_DISCONTINUITY)) {
+        clock_.MarkDiscontinuity(frame);
+    }
+}
+
+void CaptureSubscription::Process(const uint8_t* data, size_t frames) {
+    StatsTimer timer;
+    const uint32_t channels = source_.channels;
+    const size_t count = frames * channels;
+
+    const float* samples = floatBuffer_.data();
+    if (!source_.isFloat) {
+        const int16_t* in = reinterpret_cast<const int16_t*>(data);
+        float scale = format_.gain / 32768.0f;
+        for (size_t i = 0; i < count; i++) {
+            floatBuffer_[i] = in[i] * scale;
+        }
+    } else if (format_.gain != 1.0f) {
+        audio_dsp_apply_gain(reinterpret_cast<const float*>(data), floatBuffer_.data(), count, format_.gain, false);
+    } else {
+        samples = reinterpret_cast<const float*>(data);
+    }
+
+    if (!channelMatrix_.empty()) {
+        audio_dsp_mix_channels(samples, layoutBuffer_.data(), frames, channels, channelMatrix_.data(), outputChannels_);
+        samples = layoutBuffer_.data();
+    } else if (format_.mono && channels > 1) {
+        audio_dsp_downmix_mono(samples, layoutBuffer_.data(), frames, channels);
+        samples = layoutBuffer_.data();
+    }
+
+    size_t outputFrames = resampler_.Process(samples, frames, resampleBuffer_.data());
+    stats_.RecordConversion(timer.ElapsedNs());
+
+    chunks_.Push(resampleBuffer_.data(), outputFrames * outputChannels_,
+                 [this](const float* chunk, size_t n) { EmitChunk(chunk, n); });
+}
+
+void CaptureSubscription::EmitChunk(const float* samples, size_t count) {
+    if (dataCallback_ && count > 0) {
+        AudioChunkInfo info = clock_.Next(count / outputChannels_);
+        stats_.AddEmitted(count / outputChannels_);
+        dataCallback_(reinterpret_cast<const uint8_t*>(samples), static_cast<int32_t>(count * sizeof(float)),
+                      &info, context_);
+    }
+}
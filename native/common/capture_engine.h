@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "audio_bridge.h"
+#include "byte_ring.h"
+#include "capture_stats.h"
+#include "channel_map.h"
+#include "chunk_accumulator.h"
+#include "chunk_clock.h"
+#include "resampler.h"
+#include "wake_signal.h"
+
+// ============================================================================
+// CaptureEngine - one platform capture shared by every session on a source
+//
+// Sessions that opt into sharing subscribe by source: system audio with a
+// given process filter, or one microphone. The first subscriber starts a
+// capture at the device's native rate and channel count, later ones attach to
+// it, and the last one to leave stops it. The capture thread only copies each
+// chunk, with its timing, into every subscriber's lock-free ring and wakes that
+// subscriber's worker; it takes no lock and allocates nothing. The worker then
+// applies that subscriber's gain, channel layout, resampling and chunk size, so the
+// subscribers convert in parallel and a slow one can't stall the capture or
+// its siblings. Platform starts and stops happen outside the registry lock, so
+// a slow device only holds up the sessions waiting on that source.
+//
+// Subscribers see the same callbacks as an unshared session: start, metadata
+// (always pcm_f32le), data chunks, and stop once they unsubscribe. Errors and
+// warnings the platform raised while starting (a latency mode falling back)
+// are kept and replayed to every subscriber as it attaches.
+// ============================================================================
+
+// Everything that changes what the platform captures. Sessions whose sources
+// compare equal share one capture; the first one's settings win for anything
+// not listed here.
+struct CaptureSource {
+    bool microphone = false;
+
+    // System audio
+    bool mute = false;
+    std::vector<int32_t> includeProcesses;
+    std::vector<int32_t> excludeProcesses;
+    double tapCacheTtlMs = 0;      // Not part of the key; the first session's wins
+
+    // Microphone; empty selects the default device
+    std::string deviceUID;
+    int32_t latencyMode = 0;        // See audio_set_latency_mode
+
+    bool emitSilence = true;
+    double bufferDurationMs = 0;
+
+    std::string Key() const;
+};
+
+// Per-subscriber output shape
+struct SubscriberFormat {
+    double sampleRate = 0;          // 0 keeps the source rate
+    double chunkDurationMs = 200;
+    bool mono = true;               // Otherwise the source's channel layout
+    ChannelMap channels;            // Replaces the mono choice when set
+    float gain = 1.0f;
+    ResamplerQuality quality = ResamplerQuality::Balanced;
+};
+
+class CaptureEngine;
+
+class CaptureSubscription {
+public:
+    // Unsubscribes: drains what the worker has already received, delivers the
+    // final partial chunk and reports stop
+    ~CaptureSubscription();
+
+    CaptureSubscription(const CaptureSubscription&) = delete;
+    CaptureSubscription& operator=(const CaptureSubscription&) = delete;
+
+    // Source bytes dropped because this subscriber's ring was full
+    uint64_t OverrunBytes() const { return overrunBytes_.load(std::memory_order_relaxed); }
+
+    // The shared capture's counters, with this subscriber's conversion and delivery
+    void GetStats(AudioStatsSnapshot* stats) const;
+
+private:
+    friend class CaptureEngine;
+
+    struct SourceFormat {
+        double sampleRate = 0;
+        uint32_t channels = 0;
+        uint32_t bitsPerChannel = 0;
+        bool isFloat = true;
+    };
+
+    CaptureSubscription(const SubscriberFormat& format, AudioDataCallback dataCallback,
+                        AudioEventCallback eventCallback, AudioMetadataCallback metadataCallback, void* context);
+
+    // Precedes each chunk's bytes in the ring
+    struct PushHeader {
+        uint64_t bytes;
+        AudioChunkInfo info;
+        bool gap;           // Chunks were dropped just before this one
+    };
+
+    // Engine side. SetSourceFormat and Report run with the engine's subscriber
+    // lock held; Push runs on the capture thread and is its only producer.
+    void SetSourceFormat(const SourceFormat& format);
+    void Push(const uint8_t* data, size_t bytes, const AudioChunkInfo& info);
+    void Report(int32_t eventType, const char* message);  // An error or warning event
+
+    // Worker side
+    void WorkerLoop();
+    void ApplyFormat(const SourceFormat& format);
+    void Drain();
+    void BeginChunk(const PushHeader& header);
+    void Process(const uint8_t* data, size_t frames);
+    void EmitChunk(const float* samples, size_t count);
+    double OutputFrameOf(uint64_t sourceFrame) const;
+    void StopWorker();
+
+    SubscriberFormat format_;
+    AudioDataCallback dataCallback_;
+    AudioEventCallback eventCallback_;
+    AudioMetadataCallback metadataCallback_;
+    void* context_;
+
+    std::shared_ptr<CaptureEngine> engine_;
+    ByteRing ring_;
+    std::atomic<uint64_t> overrunBytes_{0};
+    AudioStats stats_;
+
+    WakeSignal wake_;
+    std::atomic<bool> stopRequested_{false};
+    std::atomic<bool> formatPending_{false};
+    std::mutex formatMutex_;            // Guards pendingFormat_; format changes are rare
+    SourceFormat pendingFormat_;
+    std::thread worker_;
+
+    // Owned by the capture thread
+    std::atomic<size_t> pushFrameBytes_{0};
+    bool gapPending_ = false;
+
+    // Owned by the worker thread
+    bool configured_ = false;
+    SourceFormat source_;
+    uint32_t outputChannels_ = 1;
+    size_t sliceFrames_ = 0;
+    uint64_t chunkRemaining_ = 0;       // Bytes of the current chunk still in the ring
+    std::vector<uint8_t> readBuffer_;
+    std::vector<float> floatBuffer_;
+    std::vector<float> layoutBuffer_;       // Downmixed or channel-mapped
+    std::vector<float> channelMatrix_;      // format_.channels for the source's channels
+    std::vector<float> resampleBuffer_;
+    Resampler resampler_;
+    ChunkAccumulator<float> chunks_;
+    ChunkClock clock_;
+    uint64_t drainedFrames_ = 0;        // Source frames processed so far
+    uint64_t formatStartFrame_ = 0;     // drainedFrames_ when the current format began
+    double outputFramesPerSourceFrame_ = 1;
+};
+
+class CaptureEngine {
+public:
+    // Attach to the capture for `source`, starting it if nobody else is
+    // capturing it. Returns nullptr with the platform's error code in *result
+    // if the capture could not be started.
+    static std::unique_ptr<CaptureSubscription> Subscribe(const CaptureSource& source, const SubscriberFormat& format,
+                                                          AudioDataCallback dataCallback,
+                                                          AudioEventCallback eventCallback,
+                                                          AudioMetadataCallback metadataCallback, void* context,
+                                                          int32_t* result);
+
+    ~CaptureEngine();
+
+    CaptureEngine(const CaptureEngine&) = delete;
+    CaptureEngine& operator=(const CaptureEngine&) = delete;
+
+private:
+    friend class CaptureSubscription;
+
+    CaptureEngine() = default;
+
+    // Start the platform capture once; later callers wait for that attempt
+    // and get its result
+    int32_t Start(const CaptureSource& source);
+    int32_t StartPlatform(const CaptureSource& source);
+    void Add(CaptureSubscription* subscriber);
+    void Remove(CaptureSubscription* subscriber);
+    void Publish();
+
+    static void OnData(const uint8_t* data, int32_t length, const AudioChunkInfo* info, void* context);
+    static void OnEvent(int32_t eventType, const char* message, void* context);
+    static void OnMetadata(double sampleRate, uint32_t channelsPerFrame, uint32_t bitsPerChannel, bool isFloat,
+                           const char* encoding, void* context);
+
+    AudioRecorderHandle handle_ = nullptr;
+    std::mutex startMutex_;
+    bool startAttempted_ = false;
+    int32_t startStatus_ = 0;
+
+    std::mutex mutex_;      // Guards subscribers_, format_ and the start events
+    std::vector<CaptureSubscription*> subscribers_;
+
+    // Errors and warnings raised inside StartPlatform, before anyone is
+    // subscribed to hear them
+    bool starting_ = false;
+    std::vector<std::pair<int32_t, std::string>> startEvents_;
+
+    // The capture thread's copy of subscribers_, replaced whole by Publish().
+    // readers_ counts callbacks using it, so a replaced list can be freed.
+    std::atomic<const std::vector<CaptureSubscription*>*> active_{nullptr};
+    std::atomic<uint32_t> readers_{0};
+    bool hasFormat_ = false;
+    CaptureSubscription::SourceFormat format_;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "audio_stats.h"
+#include "duration_histogram.h"
+
+// ============================================================================
+// AudioStats - the counters behind audio_stats.h
+//
+// One per capture session (and per shared-capture subscriber or combined
+// capture), written by whichever threads capture and convert, read at any
+// time by getStats(). Everything is relaxed atomics; a snapshot may straddle
+// an update, which is fine for monitoring.
+// ============================================================================
+
+struct AudioStats {
+    std::atomic<uint64_t> framesCaptured{0};
+    std::atomic<uint64_t> framesEmitted{0};
+    std::atomic<uint64_t> framesDropped{0};
+    std::atomic<uint64_t> conversionNs{0};
+    DurationHistogram callbacks;
+
+    void RecordCallback(uint64_t durationNs, uint64_t frames) {
+        callbacks.Record(durationNs);
+        framesCaptured.fetch_add(frames, std::memory_order_relaxed);
+    }
+
+    void RecordConversion(uint64_t durationNs) { conversionNs.fetch_add(durationNs, std::memory_order_relaxed); }
+    void AddEmitted(uint64_t frames) { framesEmitted.fetch_add(frames, std::memory_order_relaxed); }
+    void AddDropped(uint64_t frames) { framesDropped.fetch_add(frames, std::memory_order_relaxed); }
+
+    void Reset() {
+        framesCaptured.store(0, std::memory_order_relaxed);
+        framesEmitted.store(0, std::memory_order_relaxed);
+        framesDropped.store(0, std::memory_order_relaxed);
+        conversionNs.store(0, std::memory_order_relaxed);
+        callbacks.Reset();
+    }
+
+    void Snapshot(AudioStatsSnapshot* snapshot) const {
+        snapshot->framesCaptured = framesCaptured.load(std::memory_order_relaxed);
+        snapshot->framesEmitted = framesEmitted.load(std::memory_order_relaxed);
+        snapshot->framesDropped = framesDropped.load(std::memory_order_relaxed);
+        snapshot->callbackCount = callbacks.Count();
+        snapshot->callbackP50Ns = callbacks.Percentile(0.50);
+        snapshot->callbackP99Ns = callbacks.Percentile(0.99);
+        snapshot->callbackMaxNs = callbacks.Max();
+        snapshot->conversionNs = conversionNs.load(std::memory_order_relaxed);
+    }
+};
+
+// Times a scope on the host clock
+class StatsTimer {
+public:
+    StatsTimer() : start_(audio_stats_now_ns()) {}
+    uint64_t ElapsedNs() const { return audio_stats_now_ns() - start_; }
+
+private:
+    uint64_t start_;
+};
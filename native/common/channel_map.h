@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "audio_dsp.h"
+
+// ============================================================================
+// ChannelMap - which device channels a session keeps, and how
+//
+// A row-major outputChannels x inputChannels matrix of weights, applied to
+// each frame before resampling and chunking. inputChannels is how many of
+// the device's channels the map reads; a device with more has the rest
+// ignored, one with fewer cannot be captured with the map. Selecting
+// channels 3 and 4 of a 16-channel interface is a 2 x 4 matrix with a single
+// 1 in each row.
+// ============================================================================
+
+struct ChannelMap {
+    uint32_t inputChannels = 0;
+    uint32_t outputChannels = 0;
+    std::vector<float> matrix;
+
+    // No map: the session's mono/stereo choice applies
+    bool Empty() const { return outputChannels == 0; }
+
+    // Copies the weights; a null matrix or zero outputs clear the map.
+    // Returns false, leaving the map as it was, if either side is out of
+    // range.
+    bool Assign(const float* weights, uint32_t outputs, uint32_t inputs) {
+        if (!weights || outputs == 0) {
+            *this = ChannelMap();
+            return true;
+        }
+        if (inputs == 0 || inputs > AUDIO_DSP_MAX_CHANNELS || outputs > AUDIO_DSP_MAX_CHANNELS) {
+            return false;
+        }
+        inputChannels = inputs;
+        outputChannels = outputs;
+        matrix.assign(weights, weights + static_cast<size_t>(outputs) * inputs);
+        return true;
+    }
+
+    // The matrix widened with zero weights to a device's channel count, as
+    // audio_dsp_mix_channels takes it. False if the device has too few
+    // channels for the map.
+    bool ForDevice(uint32_t deviceChannels, std::vector<float>* out) const {
+        if (deviceChannels < inputChannels || deviceChannels > AUDIO_DSP_MAX_CHANNELS) {
+            return false;
+        }
+        out->assign(static_cast<size_t>(outputChannels) * deviceChannels, 0.0f);
+        for (uint32_t o = 0; o < outputChannels; o++) {
+            for (uint32_t i = 0; i < inputChannels; i++) {
+                (*out)[o * deviceChannels + i] = matrix[o * inputChannels + i];
+            }
+        }
+        return true;
+    }
+};
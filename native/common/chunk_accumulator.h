@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// ============================================================================
+// ChunkAccumulator - circular buffer that cuts a sample stream into chunks
+//
+// Capture callbacks deliver packets of arbitrary size; consumers want fixed
+// chunks. Samples are appended into a ring sized once in Reset(), and every
+// complete chunk is handed to the emit callback: in place when it is
+// contiguous, via a preallocated scratch buffer when it wraps. Push() never
+// allocates, whatever the packet size.
+// ============================================================================
+
+template <typename T>
+class ChunkAccumulator {
+public:
+    // Allocate storage for chunks of chunkSamples, accepting writes of up to
+    // maxWriteSamples at a time without an intermediate drain
+    void Reset(size_t chunkSamples, size_t maxWriteSamples) {
+        chunkSamples_ = std::max<size_t>(chunkSamples, 1);
+        buffer_.assign(chunkSamples_ + std::max<size_t>(maxWriteSamples, 1), T());
+        scratch_.assign(chunkSamples_, T());
+        readIndex_ = 0;
+        writeIndex_ = 0;
+        available_ = 0;
+    }
+
+    // Drop buffered samples, keeping the allocation
+    void Clear() {
+        readIndex_ = 0;
+        writeIndex_ = 0;
+        available_ = 0;
+    }
+
+    size_t ChunkSamples() const { return chunkSamples_; }
+    size_t Available() const { return available_; }
+
+    // Append samples and emit every complete chunk as emit(const T*, size_t).
+    // The pointer is only valid for the duration of the call.
+    template <typename Emit>
+    void Push(const T* samples, size_t count, Emit&& emit) {
+        while (count > 0) {
+            size_t space = buffer_.size() - available_;
+            size_t n = std::min(count, space);
+
+            Write(samples, n);
+            samples += n;
+            count -= n;
+
+            Drain(emit);
+        }
+    }
+
+    // Emit what would otherwise be lost at end of stream, as one short chunk
+    template <typename Emit>
+    void Flush(Emit&& emit) {
+        Drain(emit);
+        if (available_ == 0) return;
+
+        size_t n = available_;
+        Read(scratch_.data(), n);
+        emit(static_cast<const T*>(scratch_.data()), n);
+    }
+
+private:
+    void Write(const T* samples, size_t n) {
+        size_t first = std::min(n, buffer_.size() - writeIndex_);
+        memcpy(&buffer_[writeIndex_], samples, first * sizeof(T));
+        memcpy(&buffer_[0], samples + first, (n - first) * sizeof(T));
+        writeIndex_ = (writeIndex_ + n) % buffer_.size();
+        available_ += n;
+    }
+
+    void Read(T* dest, size_t n) {
+        size_t first = std::min(n, buffer_.size() - readIndex_);
+        memcpy(dest, &buffer_[readIndex_], first * sizeof(T));
+        memcpy(dest + first, &buffer_[0], (n - first) * sizeof(T));
+        readIndex_ = (readIndex_ + n) % buffer_.size();
+        available_ -= n;
+    }
+
+    template <typename Emit>
+    void Drain(Emit& emit) {
+        while (available_ >= chunkSamples_) {
+            if (readIndex_ + chunkSamples_ <= buffer_.size()) {
+                emit(static_cast<const T*>(&buffer_[readIndex_]), chunkSamples_);
+                readIndex_ = (readIndex_ + chunkSamples_) % buffer_.size();
+                available_ -= chunkSamples_;
+            } else {
+                Read(scratch_.data(), chunkSamples_);
+                emit(static_cast<const T*>(scratch_.data()), chunkSamples_);
+            }
+        }
+    }
+
+    std::vector<T> buffer_;
+    std::vector<T> scratch_;
+    size_t chunkSamples_ = 1;
+    size_t readIndex_ = 0;
+    size_t writeIndex_ = 0;
+    size_t available_ = 0;
+};
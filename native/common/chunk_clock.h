@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "audio_chunk_info.h"
+
+// ============================================================================
+// ChunkClock - host timestamps for a stream of output frames
+//
+// Capture callbacks know the host time of the packet they are handling, but
+// chunks are cut later, after conversion, and rarely start on a packet
+// boundary. The clock keeps the most recent (host time, output frame) pair
+// and extrapolates from it at the output rate, so every chunk can be stamped
+// with the time of its first frame without tracking packets individually.
+// Device sample positions and discontinuities are carried over the same way.
+// ============================================================================
+
+class ChunkClock {
+public:
+    // deviceSampleRate is the rate of the device's sample counter; 0 means the
+    // output rate
+    void Reset(double sampleRate, double deviceSampleRate = 0) {
+        nsPerFrame_ = sampleRate > 0 ? 1e9 / sampleRate : 0;
+        deviceFramesPerFrame_ = sampleRate > 0 && deviceSampleRate > 0 ? deviceSampleRate / sampleRate : 1;
+        anchorHostNs_ = 0;
+        anchorFrame_ = 0;
+        anchored_ = false;
+        anchorDevicePosition_ = 0;
+        anchorDeviceFrame_ = 0;
+        deviceAnchored_ = false;
+        discontinuityPending_ = false;
+        discontinuityFrame_ = 0;
+        position_ = 0;
+    }
+
+    // Output frame `frame` (fractional after resampling) was captured at hostTimeNs
+    void Anchor(uint64_t hostTimeNs, double frame) {
+        if (hostTimeNs == 0) return;
+        anchorHostNs_ = hostTimeNs;
+        anchorFrame_ = frame;
+        anchored_ = true;
+    }
+
+    // Output frame `frame` is at devicePosition on the device's sample counter
+    void AnchorDevice(uint64_t devicePosition, double frame) {
+        anchorDevicePosition_ = devicePosition;
+        anchorDeviceFrame_ = frame;
+        deviceAnchored_ = true;
+    }
+
+    // The device counter no longer follows the output, e.g. across synthesized silence
+    void ForgetDevice() { deviceAnchored_ = false; }
+
+    // Audio before output frame `frame` was lost; flags the chunk holding it
+    void MarkDiscontinuity(double frame) {
+        if (!discontinuityPending_ || frame < discontinuityFrame_) {
+            discontinuityFrame_ = frame;
+        }
+        discontinuityPending_ = true;
+    }
+
+    // Host time of an output frame; 0 until the first anchor
+    uint64_t TimeAt(double frame) const {
+        if (!anchored_) return 0;
+        double ns = static_cast<double>(anchorHostNs_) + (frame - anchorFrame_) * nsPerFrame_;
+        return ns > 0 ? static_cast<uint64_t>(std::llround(ns)) : 0;
+    }
+
+    // Frames handed out so far
+    uint64_t Position() const { return position_; }
+
+    // Describe the next chunk of `frames` output frames and advance past it
+    AudioChunkInfo Next(size_t frames) {
+        AudioChunkInfo info = {};
+        info.hostTimeNs = TimeAt(static_cast<double>(position_));
+        info.framePosition = position_;
+
+        if (deviceAnchored_) {
+            double device = static_cast<double>(anchorDevicePosition_) +
+                            (static_cast<double>(position_) - anchorDeviceFrame_) * deviceFramesPerFrame_;
+            if (device >= 0) {
+                info.devicePosition = static_cast<uint64_t>(std::llround(device));
+                info.flags |= AUDIO_CHUNK_DEVICE_POSITION;
+            }
+        }
+
+        // A discontinuity ahead of this chunk's end belongs to it
+        if (discontinuityPending_ && discontinuityFrame_ < static_cast<double>(position_ + frames)) {
+            info.flags |= AUDIO_CHUNK_DISCONTINUITY;
+            discontinuityPending_ = false;
+        }
+
+        position_ += frames;
+        return info;
+    }
+
+private:
+    double nsPerFrame_ = 0;
+    double deviceFramesPerFrame_ = 1;
+    uint64_t anchorHostNs_ = 0;
+    double anchorFrame_ = 0;
+    bool anchored_ = false;
+    uint64_t anchorDevicePosition_ = 0;
+    double anchorDeviceFrame_ = 0;
+    bool deviceAnchored_ = false;
+    bool discontinuityPending_ = false;
+    double discontinuityFrame_ = 0;
+    uint64_t position_ = 0;
+};
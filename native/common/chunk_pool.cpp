@@ -0,0 +1,79 @@
+#include "chunk_pool.h"
+
+#include <algorithm>
+
+static constexpr size_t kSlabAlignment = 64;  // Keep slabs on separate cache lines
+
+std::shared_ptr<ChunkPool> ChunkPool::Create(size_t slabBytes, size_t slabCount) {
+    if (slabBytes == 0 || slabCount == 0) return nullptr;
+    return std::shared_ptr<ChunkPool>(new ChunkPool(slabBytes, slabCount));
+}
+
+ChunkPool::ChunkPool(size_t slabBytes, size_t slabCount)
+    : slabBytes_((slabBytes + kSlabAlignment - 1) / kSlabAlignment * kSlabAlignment),
+      storage_(slabBytes_ * slabCount + kSlabAlignment),
+      slabs_(slabCount) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(storage_.data());
+    uintptr_t aligned = (base + kSlabAlignment - 1) & ~(uintptr_t)(kSlabAlignment - 1);
+    uint8_t* cursor = storage_.data() + (aligned - base);
+
+    for (size_t i = 0; i < slabCount; i++) {
+        slabs_[i].data = cursor + i * slabBytes_;
+        slabs_[i].capacity = slabBytes_;
+        slabs_[i].index = static_cast<uint32_t>(i);
+        Push(&slabs_[i]);
+    }
+}
+
+ChunkPool::Slab* ChunkPool::Acquire(size_t bytes) {
+    if (bytes > slabBytes_) return nullptr;
+
+    uint64_t head = freeHead_.load(std::memory_order_acquire);
+    Slab* slab = nullptr;
+    for (;;) {
+        uint32_t index = static_cast<uint32_t>(head);
+        if (index == kNoSlab) return nullptr;
+
+        slab = &slabs_[index];
+        uint64_t tag = (head >> 32) + 1;
+        uint64_t next = (tag << 32) | slab->next.load(std::memory_order_relaxed);
+        if (freeHead_.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            break;
+        }
+    }
+
+    slab->size = bytes;
+    slab->owner = shared_from_this();
+    return slab;
+}
+
+void ChunkPool::Release(Slab* slab) {
+    if (!slab) return;
+
+    // Hold the pool until the slab is back on its free list; this may be the
+    // last reference, in which case the pool is freed on return
+    std::shared_ptr<ChunkPool> pool = std::move(slab->owner);
+    if (pool) {
+        pool->Push(slab);
+    }
+}
+
+void ChunkPool::Push(Slab* slab) {
+    slab->size = 0;
+
+    uint64_t head = freeHead_.load(std::memory_order_acquire);
+    for (;;) {
+        slab->next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        uint64_t tag = (head >> 32) + 1;
+        uint64_t next = (tag << 32) | slab->index;
+        if (freeHead_.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_acquire)) {
+            return;
+        }
+    }
+}
+
+size_t ChunkPoolSlabCountFor(double chunkDurationMs) {
+    double ms = chunkDurationMs > 0 ? chunkDurationMs : 10.0;
+    size_t count = static_cast<size_t>(2000.0 / ms);
+    return std::clamp<size_t>(count, 16, 256);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// ============================================================================
+// ChunkPool - preallocated slabs for zero-copy chunk handoff
+//
+// The capture thread writes each chunk straight into a slab, the slab travels
+// through the event queue, and JS receives it as an external Buffer. When the
+// Buffer is garbage collected its finalizer returns the slab to the pool.
+//
+// A slab keeps its pool alive while it is outstanding, so Buffers may outlive
+// the recorder (and the pool may be replaced when the format changes).
+// ============================================================================
+
+class ChunkPool : public std::enable_shared_from_this<ChunkPool> {
+public:
+    struct Slab {
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+        size_t size = 0;
+        std::shared_ptr<ChunkPool> owner;  // Set while the slab is checked out
+        uint32_t index = 0;
+        std::atomic<uint32_t> next{0};      // Free-list link
+    };
+
+    static std::shared_ptr<ChunkPool> Create(size_t slabBytes, size_t slabCount);
+
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    // Returns nullptr if no slab is free or the chunk doesn't fit; callers fall
+    // back to copying. Lock-free and never allocates, so it is safe to call
+    // from the real-time capture thread.
+    Slab* Acquire(size_t bytes);
+
+    // Return a slab to the pool it came from. Safe to call from any thread.
+    static void Release(Slab* slab);
+
+    size_t SlabBytes() const { return slabBytes_; }
+    size_t SlabCount() const { return slabs_.size(); }
+
+private:
+    ChunkPool(size_t slabBytes, size_t slabCount);
+
+    void Push(Slab* slab);
+
+    size_t slabBytes_;
+    std::vector<uint8_t> storage_;
+    std::vector<Slab> slabs_;
+
+    // Treiber stack of free slab indices. The upper 32 bits are a tag bumped
+    // on every update so a concurrent pop/push pair can't cause ABA.
+    static constexpr uint32_t kNoSlab = 0xFFFFFFFFu;
+    std::atomic<uint64_t> freeHead_{kNoSlab};
+};
+
+// Owning handle for a checked-out slab; returns it to the pool on destruction
+struct ChunkSlabDeleter {
+    void operator()(ChunkPool::Slab* slab) const { ChunkPool::Release(slab); }
+};
+using ChunkSlabPtr = std::unique_ptr<ChunkPool::Slab, ChunkSlabDeleter>;
+
+// Pick a slab count that covers roughly two seconds of outstanding chunks, so
+// JS can hold on to buffers until the next GC without exhausting the pool.
+size_t ChunkPoolSlabCountFor(double chunkDurationMs);
@@ -0,0 +1,601 @@
+#include "combined_capture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "audio_dsp.h"
+
+namespace {
+
+// Platform chunks are only the hand-off unit here, so keep them short
+constexpr double kSourceChunkMs = 10;
+
+// Alignment works in blocks of this length; with echo cancellation, of the
+// longest power of two that fits
+constexpr double kBlockMs = 10;
+
+// How long the leading source may run ahead before a lagging one is treated
+// as silent for the block
+constexpr double kMaxWaitNs = 100e6;
+
+// Offsets below this are timestamp jitter and left alone; offsets up to
+// kJumpNs are drift and corrected one frame per block; anything larger is a
+// gap or a late start and is closed at once
+constexpr double kToleranceNs = 1e6;
+constexpr double kJumpNs = 20e6;
+
+// Weight of each new timestamp in a source's estimated stream position
+constexpr double kTimestampSmoothing = 1.0 / 16.0;
+
+// Converted audio a source may hold while it waits to be aligned
+constexpr double kFifoSeconds = 2;
+
+size_t EchoBlockFrames(double sampleRate) {
+    size_t limit = static_cast<size_t>(sampleRate * kBlockMs / 1000.0);
+    size_t frames = 1;
+    while (frames * 2 <= limit) {
+        frames *= 2;
+    }
+    return frames;
+}
+
+}  // namespace
+
+bool CombinedCapture::SupportsEchoCancellation(double sampleRate) {
+    return sampleRate > 0 && EchoCanceller::SupportsBlock(EchoBlockFrames(sampleRate));
+}
+
+std::unique_ptr<CombinedCapture> CombinedCapture::Start(const CombinedCaptureOptions& options,
+                                                        AudioDataCallback dataCallback,
+                                                        AudioEventCallback eventCallback,
+                                                        AudioMetadataCallback metadataCallback, void* context,
+                                                        int32_t* result) {
+    std::unique_ptr<CombinedCapture> capture(
+        new CombinedCapture(options, dataCallback, eventCallback, metadataCallback, context));
+
+    Source* sources[] = {&capture->microphone_, &capture->system_};
+    for (Source* source : sources) {
+        source->handle = audio_create(&CombinedCapture::OnData, &CombinedCapture::OnEvent,
+                                      &CombinedCapture::OnMetadata, source);
+        if (!source->handle) {
+            *result = -1;
+            return nullptr;
+        }
+        audio_set_buffer_duration(source->handle, options.bufferDurationMs);
+        audio_set_resampler_quality(source->handle, static_cast<int32_t>(options.quality));
+    }
+    audio_set_tap_cache_ttl(capture->system_.handle, options.tapCacheTtlMs);
+    audio_set_latency_mode(capture->microphone_.handle, options.latencyMode);
+
+    // Both sources emit silence rather than nothing, so quiet stretches keep
+    // their timestamps flowing
+    const double sampleRate = capture->options_.sampleRate;
+    int32_t status = audio_start_microphone(capture->microphone_.handle, sampleRate, kSourceChunkMs, options.mono,
+                                            true, options.deviceUID.empty() ? nullptr : options.deviceUID.c_str(),
+                                            options.gain);
+    if (status == 0) {
+        status = audio_start_system_audio(
+            capture->system_.handle, sampleRate, kSourceChunkMs, options.mute, options.mono, true,
+            options.includeProcesses.empty() ? nullptr : options.includeProcesses.data(),
+            static_cast<int32_t>(options.includeProcesses.size()),
+            options.excludeProcesses.empty() ? nullptr : options.excludeProcesses.data(),
+            static_cast<int32_t>(options.excludeProcesses.size()));
+    }
+    if (status != 0) {
+        *result = status;
+        return nullptr;
+    }
+
+    // Samples that arrived while starting wait in the rings and are aligned
+    // once the worker starts, after metadata and start have gone out
+    if (metadataCallback) {
+        metadataCallback(capture->options_.sampleRate, capture->outputChannels_, 32, true, "pcm_f32le", context);
+    }
+    if (eventCallback) {
+        eventCallback(0, nullptr, context);
+    }
+    capture->running_ = true;
+    capture->worker_ = std::thread(&CombinedCapture::WorkerLoop, capture.get());
+
+    *result = 0;
+    return capture;
+}
+
+CombinedCapture::CombinedCapture(const CombinedCaptureOptions& options, AudioDataCallback dataCallback,
+                                 AudioEventCallback eventCallback, AudioMetadataCallback metadataCallback,
+                                 void* context)
+    : options_(options),
+      dataCallback_(dataCallback),
+      eventCallback_(eventCallback),
+      metadataCallback_(metadataCallback),
+      context_(context) {
+    if (options_.sampleRate <= 0) options_.sampleRate = 48000;
+
+    sourceChannels_ = options_.mono ? 1 : 2;
+    outputChannels_ = options_.layout == CombinedLayout::Interleaved ? sourceChannels_ * 2 : sourceChannels_;
+    blockFrames_ = std::max<size_t>(1, static_cast<size_t>(options_.sampleRate * kBlockMs / 1000.0));
+    if (options_.layout == CombinedLayout::EchoCancelled && SupportsEchoCancellation(options_.sampleRate)) {
+        blockFrames_ = EchoBlockFrames(options_.sampleRate);
+        echoCanceller_ = std::make_unique<EchoCanceller>(options_.sampleRate, blockFrames_, sourceChannels_,
+                                                         options_.echoTailMs);
+    }
+    nsPerFrame_ = 1e9 / options_.sampleRate;
+
+    microphone_.owner = this;
+    microphone_.name = "Microphone";
+    system_.owner = this;
+    system_.name = "System audio";
+
+    size_t fifoSamples = static_cast<size_t>(options_.sampleRate * kFifoSeconds) * sourceChannels_;
+    microphone_.fifo.assign(fifoSamples, 0.0f);
+    system_.fifo.assign(fifoSamples, 0.0f);
+
+    micBlock_.assign(blockFrames_ * sourceChannels_, 0.0f);
+    systemBlock_.assign(blockFrames_ * sourceChannels_, 0.0f);
+    outputBlock_.assign(blockFrames_ * outputChannels_, 0.0f);
+
+    size_t chunkFrames = static_cast<size_t>(options_.chunkDurationMs / 1000.0 * options_.sampleRate);
+    chunkFrames = std::max<size_t>(chunkFrames, 1);
+    chunks_.Reset(chunkFrames * outputChannels_, outputBlock_.size());
+    clock_.Reset(options_.sampleRate);
+}
+
+CombinedCapture::~CombinedCapture() {
+    // Stopping flushes each source's last partial chunk through OnData
+    Source* sources[] = {&microphone_, &system_};
+    for (Source* source : sources) {
+        if (source->handle && audio_is_running(source->handle)) {
+            audio_stop(source->handle);
+        }
+    }
+
+    // The worker drains what the sources delivered, finishes the last blocks
+    // and flushes the partial chunk before it exits
+    if (worker_.joinable()) {
+        stopRequested_.store(true, std::memory_order_release);
+        wake_.Notify();
+        worker_.join();
+    }
+
+    if (running_) {
+        if (eventCallback_) {
+            eventCallback_(1, nullptr, context_);
+        }
+        running_ = false;
+    }
+
+    for (Source* source : sources) {
+        if (source->handle) {
+            audio_destroy(source->handle);
+        }
+    }
+}
+
+void CombinedCapture::GetStats(AudioStatsSnapshot* stats) const {
+    // Callback timing here is the hand-off to the worker; frames the
+    // platforms had to drop are added to the ones dropped here
+    stats_.Snapshot(stats);
+
+    const Source* sources[] = {&microphone_, &system_};
+    for (const Source* source : sources) {
+        AudioStatsSnapshot platform = {};
+        if (source->handle && audio_get_stats(source->handle, &platform) == 0) {
+            stats->framesDropped += platform.framesDropped;
+        }
+    }
+}
+
+// ============================================================================
+// Platform callbacks
+// ============================================================================
+
+void CombinedCapture::OnData(const uint8_t* data, int32_t length, const AudioChunkInfo* info, void* context) {
+    Source* source = static_cast<Source*>(context);
+    CombinedCapture* self = source->owner;
+    if (length <= 0) return;
+
+    StatsTimer timer;
+    size_t bytes = static_cast<size_t>(length);
+    size_t frameBytes = source->frameBytes.load(std::memory_order_relaxed);
+    size_t frames = frameBytes > 0 ? bytes / frameBytes : 0;
+
+    // The chunk's timing travels in the ring ahead of its bytes. Free space
+    // only grows while this thread isn't writing, so both writes fit.
+    PushHeader header{bytes, *info, source->gapPending};
+    if (source->ring.Writable() < sizeof(header) + bytes) {
+        // The worker has fallen a ring behind; the gap is marked on the next chunk
+        source->gapPending = true;
+        self->stats_.AddDropped(frames);
+    } else {
+        source->ring.Write(&header, sizeof(header));
+        source->ring.Write(data, bytes);
+        source->gapPending = false;
+        self->wake_.Notify();
+    }
+    self->stats_.RecordCallback(timer.ElapsedNs(), frames);
+}
+
+void CombinedCapture::OnEvent(int32_t eventType, const char* message, void* context) {
+    Source* source = static_cast<Source*>(context);
+    CombinedCapture* self = source->owner;
+
+    // Start and stop belong to the combined session; only errors and warnings
+    // pass through
+    if ((eventType != 2 && eventType != 3) || !self->eventCallback_) return;
+
+    std::string text = std::string(source->name) + ": " + (message ? message : "Unknown error");
+    self->eventCallback_(eventType, text.c_str(), self->context_);
+}
+
+void CombinedCapture::OnMetadata(double sampleRate, uint32_t channelsPerFrame, uint32_t bitsPerChannel,
+                                 bool isFloat, const char* encoding, void* context) {
+    Source* source = static_cast<Source*>(context);
+    CombinedCapture* self = source->owner;
+    (void)encoding;
+
+    {
+        std::lock_guard<std::mutex> lock(self->formatMutex_);
+        source->pendingFormat = Format{sampleRate, channelsPerFrame, bitsPerChannel, isFloat};
+    }
+    source->frameBytes.store(channelsPerFrame * (bitsPerChannel / 8), std::memory_order_relaxed);
+    source->formatPending.store(true, std::memory_order_release);
+    self->wake_.Notify();
+}
+
+// ============================================================================
+// Worker
+// ============================================================================
+
+void CombinedCapture::WorkerLoop() {
+    Source* sources[] = {&microphone_, &system_};
+    for (;;) {
+        wake_.Wait();
+        bool stop = stopRequested_.load(std::memory_order_acquire);
+
+        // Metadata always precedes the chunks that use it; finish the old
+        // format's samples before switching
+        for (Source* source : sources) {
+            if (source->formatPending.exchange(false, std::memory_order_acq_rel)) {
+                if (source->hasFormat) {
+                    Drain(*source);
+                }
+                ApplyFormat(*source);
+            }
+            Drain(*source);
+        }
+
+        // When stopping, finish every block that still has audio in it
+        Align(stop);
+        if (stop) break;
+    }
+
+    chunks_.Flush([this](const float* samples, size_t count) { EmitChunk(samples, count); });
+}
+
+void CombinedCapture::Drain(Source& source) {
+    for (;;) {
+        if (!source.headerRead) {
+            if (source.ring.Readable() < sizeof(PushHeader)) return;
+            source.ring.Read(&source.header, sizeof(PushHeader));
+            source.headerRead = true;
+        }
+
+        // The bytes are published by a second write, just after the header
+        size_t bytes = static_cast<size_t>(source.header.bytes);
+        if (source.ring.Readable() < bytes) return;
+        if (source.readBuffer.size() < bytes) {
+            source.readBuffer.resize(bytes);
+        }
+        source.ring.Read(source.readBuffer.data(), bytes);
+        source.headerRead = false;
+
+        if (source.header.gap) {
+            source.discontinuity = true;
+        }
+        if (source.hasFormat) {
+            size_t frameBytes = source.channels * (source.bitsPerChannel / 8);
+            Append(source, source.readBuffer.data(), bytes / frameBytes, source.header.info);
+        }
+    }
+}
+
+void CombinedCapture::ApplyFormat(Source& source) {
+    Format format;
+    {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        format = source.pendingFormat;
+    }
+    source.sampleRate = format.sampleRate;
+    source.channels = format.channels;
+    source.bitsPerChannel = format.bitsPerChannel;
+    source.isFloat = format.isFloat;
+
+    bool supported = (format.isFloat && format.bitsPerChannel == 32) || (!format.isFloat && format.bitsPerChannel == 16);
+    source.hasFormat = supported && format.channels > 0 && format.sampleRate > 0;
+    if (!source.hasFormat) {
+        if (eventCallback_) {
+            std::string text = std::string(source.name) + ": unsupported capture format";
+            eventCallback_(2, text.c_str(), context_);
+        }
+        return;
+    }
+
+    ConfigureSource(source);
+}
+
+// ============================================================================
+// Conversion
+// ============================================================================
+
+void CombinedCapture::ConfigureSource(Source& source) {
+    // Sized for a platform chunk with headroom; Drain and Append grow them if
+    // a platform ever delivers more at once
+    size_t frames = static_cast<size_t>(source.sampleRate * kSourceChunkMs / 1000.0) * 2 + 64;
+
+    source.readBuffer.assign(frames * source.channels * (source.bitsPerChannel / 8), 0);
+    source.floatBuffer.assign(frames * source.channels, 0.0f);
+    source.remapBuffer.assign(frames * sourceChannels_, 0.0f);
+
+    // The platform normally converts to the common rate already
+    source.resampler.Configure(source.sampleRate, options_.sampleRate, sourceChannels_, options_.quality, frames);
+    source.resampleBuffer.assign(source.resampler.MaxOutputFrames(frames) * sourceChannels_, 0.0f);
+}
+
+void CombinedCapture::Append(Source& source, const uint8_t* data, size_t frames, const AudioChunkInfo& info) {
+    if (frames == 0) return;
+
+    if (info.flags & AUDIO_CHUNK_DISCONTINUITY) {
+        source.discontinuity = true;
+    }
+
+    StatsTimer conversion;
+    if (source.remapBuffer.size() < frames * sourceChannels_) {
+        source.floatBuffer.resize(frames * source.channels);
+        source.remapBuffer.resize(frames * sourceChannels_);
+        source.resampleBuffer.resize(source.resampler.MaxOutputFrames(frames) * sourceChannels_);
+    }
+
+    const size_t count = frames * source.channels;
+    const float* samples = reinterpret_cast<const float*>(data);
+    if (!source.isFloat) {
+        const int16_t* in = reinterpret_cast<const int16_t*>(data);
+        for (size_t i = 0; i < count; i++) {
+            source.floatBuffer[i] = in[i] * (1.0f / 32768.0f);
+        }
+        samples = source.floatBuffer.data();
+    }
+
+    // Bring the source to this session's channel count
+    if (source.channels != sourceChannels_) {
+        float* out = source.remapBuffer.data();
+        if (sourceChannels_ == 1) {
+            audio_dsp_downmix_mono(samples, out, frames, source.channels);
+        } else if (source.channels == 1) {
+            for (size_t i = 0; i < frames; i++) {
+                out[i * 2] = samples[i];
+                out[i * 2 + 1] = samples[i];
+            }
+        } else {
+            audio_dsp_downmix_stereo(samples, out, frames, source.channels);
+        }
+        samples = out;
+    }
+
+    size_t outputFrames = frames;
+    if (!source.resampler.IsPassthrough()) {
+        outputFrames = source.resampler.Process(samples, frames, source.resampleBuffer.data());
+        samples = source.resampleBuffer.data();
+    }
+    stats_.RecordConversion(conversion.ElapsedNs());
+
+    // Without a device timestamp, fall back to arrival time on the same clock
+    double chunkNs = static_cast<double>(info.hostTimeNs);
+    if (info.hostTimeNs == 0) {
+        chunkNs = static_cast<double>(audio_stats_now_ns()) - static_cast<double>(frames) * 1e9 / source.sampleRate;
+    }
+
+    size_t waiting = source.Frames(sourceChannels_);
+    if (!source.started || waiting == 0) {
+        // Nothing queued: the chunk's own timestamp is the stream position
+        source.headNs = chunkNs;
+        source.started = true;
+    } else {
+        double error = chunkNs - (source.headNs + static_cast<double>(waiting) * nsPerFrame_);
+        if (error > kJumpNs) {
+            // The source skipped ahead; keep its timing by filling the gap
+            size_t gap = static_cast<size_t>(std::llround(error / nsPerFrame_));
+            AppendFrames(source, nullptr, std::min(gap, source.fifo.size() / sourceChannels_));
+            source.discontinuity = true;
+        } else if (error < -kJumpNs) {
+            // Queued audio is later than the device says; trust the device
+            source.headNs += error;
+        } else {
+            // Track the device clock through its timestamp jitter
+            source.headNs += error * kTimestampSmoothing;
+        }
+    }
+
+    AppendFrames(source, samples, outputFrames);
+}
+
+void CombinedCapture::AppendFrames(Source& source, const float* samples, size_t frames) {
+    const size_t capacityFrames = source.fifo.size() / sourceChannels_;
+
+    // More than the ring holds: only the newest of it can be kept
+    if (frames > capacityFrames) {
+        size_t skipped = frames - capacityFrames;
+        ReadFrames(source, nullptr, source.Frames(sourceChannels_));
+        source.headNs += static_cast<double>(skipped) * nsPerFrame_;
+        source.discontinuity = true;
+        if (samples) samples += skipped * sourceChannels_;
+        frames = capacityFrames;
+    }
+
+    // Full: alignment has stalled, so drop the oldest audio
+    size_t waiting = source.Frames(sourceChannels_);
+    if (waiting + frames > capacityFrames) {
+        ReadFrames(source, nullptr, waiting + frames - capacityFrames);
+        source.discontinuity = true;
+    }
+
+    const size_t capacity = source.fifo.size();
+    const size_t count = frames * sourceChannels_;
+    size_t tail = (source.fifoHead + source.fifoCount) % capacity;
+    size_t first = std::min(count, capacity - tail);
+    if (samples) {
+        std::copy(samples, samples + first, source.fifo.begin() + static_cast<std::ptrdiff_t>(tail));
+        std::copy(samples + first, samples + count, source.fifo.begin());
+    } else {
+        std::fill_n(source.fifo.begin() + static_cast<std::ptrdiff_t>(tail), first, 0.0f);
+        std::fill_n(source.fifo.begin(), count - first, 0.0f);
+    }
+    source.fifoCount += count;
+}
+
+void CombinedCapture::ReadFrames(Source& source, float* out, size_t frames) {
+    const size_t capacity = source.fifo.size();
+    const size_t count = frames * sourceChannels_;
+    if (out) {
+        size_t first = std::min(count, capacity - source.fifoHead);
+        const float* fifo = source.fifo.data();
+        std::copy(fifo + source.fifoHead, fifo + source.fifoHead + first, out);
+        std::copy(fifo, fifo + count - first, out + first);
+    }
+
+    source.fifoHead = (source.fifoHead + count) % capacity;
+    source.fifoCount -= count;
+    source.headNs += static_cast<double>(frames) * nsPerFrame_;
+}
+
+// ============================================================================
+// Alignment
+// ============================================================================
+
+void CombinedCapture::Align(bool draining) {
+    if (!running_) return;
+
+    Source* sources[] = {&microphone_, &system_};
+    const double blockNs = static_cast<double>(blockFrames_) * nsPerFrame_;
+
+    for (;;) {
+        // The timeline starts with whichever source delivered first; the
+        // other one is padded until its own first frame
+        if (!timelineStarted_) {
+            double start = std::numeric_limits<double>::infinity();
+            for (Source* source : sources) {
+                if (source->started && source->Frames(sourceChannels_) > 0) {
+                    start = std::min(start, source->headNs);
+                }
+            }
+            if (std::isinf(start)) return;
+            timelineStartNs_ = start;
+            timelineStarted_ = true;
+        }
+
+        double blockStart = timelineStartNs_ + static_cast<double>(blocksEmitted_) * blockNs;
+        double blockEnd = blockStart + blockNs;
+
+        bool covered = true;
+        double lead = -std::numeric_limits<double>::infinity();
+        for (Source* source : sources) {
+            double end = source->started
+                             ? source->headNs + static_cast<double>(source->Frames(sourceChannels_)) * nsPerFrame_
+                             : -std::numeric_limits<double>::infinity();
+            covered = covered && end >= blockEnd;
+            lead = std::max(lead, end);
+        }
+
+        // Wait for the lagging source, up to a point; when draining, finish
+        // every block that still has audio in it
+        if (!covered) {
+            if (draining ? lead <= blockStart : lead < blockEnd + kMaxWaitNs) return;
+        }
+
+        ReadBlock(microphone_, blockStart, micBlock_.data());
+        ReadBlock(system_, blockStart, systemBlock_.data());
+        EmitBlock();
+    }
+}
+
+void CombinedCapture::ReadBlock(Source& source, double blockStartNs, float* out) {
+    const uint32_t channels = sourceChannels_;
+    std::fill(out, out + blockFrames_ * channels, 0.0f);
+    if (!source.started) return;
+
+    // How far the source's stream position is from where the block wants it,
+    // in frames: positive means queued audio is already stale
+    double offsetNs = blockStartNs - source.headNs;
+    long long offset = 0;
+    if (std::fabs(offsetNs) > kJumpNs) {
+        offset = std::llround(offsetNs / nsPerFrame_);
+        source.discontinuity = source.discontinuity || source.aligned;     // Not the late start
+    } else if (std::fabs(offsetNs) > kToleranceNs) {
+        offset = offsetNs > 0 ? 1 : -1;     // Drift: one frame per block
+    }
+
+    if (offset > 0) {
+        ReadFrames(source, nullptr, std::min(static_cast<size_t>(offset), source.Frames(channels)));
+    }
+
+    size_t lead = offset < 0 ? std::min(static_cast<size_t>(-offset), blockFrames_) : 0;
+    size_t take = std::min(blockFrames_ - lead, source.Frames(channels));
+
+    // A one-frame slip repeats the first frame instead of inserting a zero.
+    // Frames never wrap: the ring holds a whole number of them.
+    if (offset == -1 && take > 0) {
+        const float* first = source.fifo.data() + source.fifoHead;
+        std::copy(first, first + channels, out);
+    }
+    ReadFrames(source, out + lead * channels, take);
+    source.aligned = source.aligned || take > 0;
+}
+
+void CombinedCapture::EmitBlock() {
+    const uint32_t channels = sourceChannels_;
+
+    if (options_.layout == CombinedLayout::Interleaved) {
+        for (size_t i = 0; i < blockFrames_; i++) {
+            float* frame = &outputBlock_[i * outputChannels_];
+            std::copy(&micBlock_[i * channels], &micBlock_[i * channels] + channels, frame);
+            std::copy(&systemBlock_[i * channels], &systemBlock_[i * channels] + channels, frame + channels);
+        }
+    } else if (options_.layout == CombinedLayout::Mix) {
+        // Unclamped; float output has headroom
+        for (size_t i = 0; i < outputBlock_.size(); i++) {
+            outputBlock_[i] = micBlock_[i] + systemBlock_[i];
+        }
+    } else if (echoCanceller_) {
+        echoCanceller_->Process(micBlock_.data(), systemBlock_.data(), outputBlock_.data());
+    } else {
+        std::copy(micBlock_.begin(), micBlock_.end(), outputBlock_.begin());
+    }
+
+    // Blocks sit exactly on the timeline, so every block re-anchors the clock
+    double blockFrame = static_cast<double>(blocksEmitted_ * blockFrames_);
+    double blockStart = timelineStartNs_ + blockFrame * nsPerFrame_;
+    clock_.Anchor(static_cast<uint64_t>(blockStart), blockFrame);
+
+    // A gap in either source is a gap in the combined stream. Frame slips
+    // are not reported; they are how the stream stays continuous.
+    if (microphone_.discontinuity || system_.discontinuity) {
+        clock_.MarkDiscontinuity(blockFrame);
+        microphone_.discontinuity = false;
+        system_.discontinuity = false;
+    }
+    blocksEmitted_++;
+
+    chunks_.Push(outputBlock_.data(), outputBlock_.size(),
+                 [this](const float* samples, size_t count) { EmitChunk(samples, count); });
+}
+
+void CombinedCapture::EmitChunk(const float* samples, size_t count) {
+    if (dataCallback_ && count > 0) {
+        AudioChunkInfo info = clock_.Next(count / outputChannels_);
+        stats_.AddEmitted(count / outputChannels_);
+        dataCallback_(reinterpret_cast<const uint8_t*>(samples), static_cast<int32_t>(count * sizeof(float)),
+                      &info, context_);
+    }
+}
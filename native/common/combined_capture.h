@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_bridge.h"
+#include "byte_ring.h"
+#include "capture_stats.h"
+#include "chunk_accumulator.h"
+#include "chunk_clock.h"
+#include "echo_canceller.h"
+#include "resampler.h"
+#include "wake_signal.h"
+
+// ============================================================================
+// CombinedCapture - microphone and system audio aligned in one stream
+//
+// Starts one platform capture per source at a common sample rate and lines
+// their samples up on the host clock using the timestamps every chunk carries.
+// Each source's stream position is tracked against its timestamps; when a
+// device clock drifts from the host clock, the source is nudged back by
+// dropping or repeating one frame per block, and a gap (a source that went
+// quiet or started late) is filled with silence. The aligned blocks are then
+// either interleaved (microphone channels first) or summed, or the system
+// audio is used as the echo reference to clean the microphone, and cut into
+// chunks stamped with the host time of their first frame.
+//
+// The platform callbacks only copy each chunk, with its timing, into that
+// source's lock-free ring and wake a worker thread; conversion, alignment
+// and echo cancellation all run on the worker, so the device threads never
+// block on each other or wait out an echo canceller block.
+//
+// Callbacks look like a single session: start, metadata (pcm_f32le), data,
+// errors from either source, and stop once the capture is destroyed.
+// ============================================================================
+
+enum class CombinedLayout {
+    Interleaved,    // Microphone channels, then system audio channels
+    Mix,            // Both sources summed into one set of channels
+    EchoCancelled,  // The microphone with what the speakers played removed
+};
+
+struct CombinedCaptureOptions {
+    double sampleRate = 48000;
+    double chunkDurationMs = 200;
+    bool mono = true;               // Per source: one channel, otherwise stereo
+    CombinedLayout layout = CombinedLayout::Interleaved;
+    double echoTailMs = EchoCanceller::kDefaultTailMs;     // EchoCancelled: room reverberation to model
+    double bufferDurationMs = 0;
+    ResamplerQuality quality = ResamplerQuality::Balanced;
+
+    // Microphone; empty selects the default device
+    std::string deviceUID;
+    double gain = 1.0;
+    int32_t latencyMode = 0;        // See audio_set_latency_mode
+
+    // System audio
+    bool mute = false;
+    std::vector<int32_t> includeProcesses;
+    std::vector<int32_t> excludeProcesses;
+    double tapCacheTtlMs = 0;
+};
+
+class CombinedCapture {
+public:
+    // Start both sources. Returns nullptr with the failing platform's error
+    // code in *result if either could not be started.
+    static std::unique_ptr<CombinedCapture> Start(const CombinedCaptureOptions& options,
+                                                  AudioDataCallback dataCallback, AudioEventCallback eventCallback,
+                                                  AudioMetadataCallback metadataCallback, void* context,
+                                                  int32_t* result);
+
+    // Stops both sources, delivers what they already captured and reports stop
+    ~CombinedCapture();
+
+    // The echo canceller needs blocks of a power-of-two length, which low
+    // rates cannot fit in an alignment block
+    static bool SupportsEchoCancellation(double sampleRate);
+
+    CombinedCapture(const CombinedCapture&) = delete;
+    CombinedCapture& operator=(const CombinedCapture&) = delete;
+
+    // Frames received from both sources and the combined output's counters
+    void GetStats(AudioStatsSnapshot* stats) const;
+
+private:
+    // A few seconds of 48 kHz stereo float per source
+    static constexpr size_t kSourceRingBytes = 1024 * 1024;
+
+    struct Format {
+        double sampleRate = 0;
+        uint32_t channels = 0;
+        uint32_t bitsPerChannel = 0;
+        bool isFloat = true;
+    };
+
+    // Precedes each chunk's bytes in a source's ring
+    struct PushHeader {
+        uint64_t bytes;
+        AudioChunkInfo info;
+        bool gap;           // Chunks were dropped just before this one
+    };
+
+    struct Source {
+        CombinedCapture* owner = nullptr;
+        const char* name = "";
+        AudioRecorderHandle handle = nullptr;
+
+        // Platform thread to worker
+        ByteRing ring{kSourceRingBytes};
+        std::atomic<bool> formatPending{false};
+        Format pendingFormat;                   // Guarded by formatMutex_
+        std::atomic<size_t> frameBytes{0};
+        bool gapPending = false;                // Platform thread only
+
+        // Everything below is owned by the worker.
+        // Platform format, from its metadata
+        bool hasFormat = false;
+        double sampleRate = 0;
+        uint32_t channels = 0;
+        uint32_t bitsPerChannel = 0;
+        bool isFloat = true;
+
+        // Ring reads, and conversion to the common rate and this source's output channels
+        bool headerRead = false;    // header is read, its bytes are not yet
+        PushHeader header = {};
+        std::vector<uint8_t> readBuffer;
+        std::vector<float> floatBuffer;
+        std::vector<float> remapBuffer;
+        std::vector<float> resampleBuffer;
+        Resampler resampler;
+
+        // Converted frames waiting to be aligned, in a ring allocated up front:
+        // fifoCount samples starting at fifo[fifoHead]
+        std::vector<float> fifo;
+        size_t fifoHead = 0;
+        size_t fifoCount = 0;
+        bool started = false;
+        double headNs = 0;          // Host time of the first waiting frame
+        bool discontinuity = false; // Audio lost or skipped since the last block
+        bool aligned = false;       // Has contributed frames to a block
+
+        size_t Frames(uint32_t channels) const { return fifoCount / channels; }
+    };
+
+    CombinedCapture(const CombinedCaptureOptions& options, AudioDataCallback dataCallback,
+                    AudioEventCallback eventCallback, AudioMetadataCallback metadataCallback, void* context);
+
+    static void OnData(const uint8_t* data, int32_t length, const AudioChunkInfo* info, void* context);
+    static void OnEvent(int32_t eventType, const char* message, void* context);
+    static void OnMetadata(double sampleRate, uint32_t channelsPerFrame, uint32_t bitsPerChannel, bool isFloat,
+                           const char* encoding, void* context);
+
+    // Worker side
+    void WorkerLoop();
+    void Drain(Source& source);
+    void ApplyFormat(Source& source);
+    void ConfigureSource(Source& source);
+    void Append(Source& source, const uint8_t* data, size_t frames, const AudioChunkInfo& info);
+    void AppendFrames(Source& source, const float* samples, size_t frames);  // nullptr appends silence
+    void ReadFrames(Source& source, float* out, size_t frames);            // nullptr discards
+    void Align(bool draining);
+    void ReadBlock(Source& source, double blockStartNs, float* out);
+    void EmitBlock();
+    void EmitChunk(const float* samples, size_t count);
+
+    CombinedCaptureOptions options_;
+    AudioDataCallback dataCallback_;
+    AudioEventCallback eventCallback_;
+    AudioMetadataCallback metadataCallback_;
+    void* context_;
+
+    uint32_t sourceChannels_;       // Channels of each source after conversion
+    uint32_t outputChannels_;
+    size_t blockFrames_;
+    double nsPerFrame_;
+
+    Source microphone_;
+    Source system_;
+    bool running_ = false;          // Start reported; cleared once stop is
+    std::mutex formatMutex_;        // Format changes are rare; data never waits on this
+    WakeSignal wake_;
+    std::atomic<bool> stopRequested_{false};
+    std::thread worker_;
+
+    // Output timeline: block n starts at timelineStartNs_ + n * blockFrames_ frames
+    bool timelineStarted_ = false;
+    double timelineStartNs_ = 0;
+    uint64_t blocksEmitted_ = 0;
+    std::vector<float> micBlock_;
+    std::vector<float> systemBlock_;
+    std::vector<float> outputBlock_;
+    std::unique_ptr<EchoCanceller> echoCanceller_;
+    ChunkAccumulator<float> chunks_;
+    ChunkClock clock_;
+    AudioStats stats_;
+};
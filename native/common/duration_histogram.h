@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// DurationHistogram - lock-free log-linear histogram of nanosecond durations
+//
+// Each power of two is split into eight buckets, so a percentile is accurate
+// to within about 6% whatever the scale, from nanoseconds to minutes. Record()
+// is two relaxed increments and, rarely, a CAS on the maximum, so it can run
+// on a real-time thread; readers scan the buckets without stopping writers.
+// ============================================================================
+
+class DurationHistogram {
+public:
+    DurationHistogram() { Reset(); }
+
+    DurationHistogram(const DurationHistogram&) = delete;
+    DurationHistogram& operator=(const DurationHistogram&) = delete;
+
+    void Record(uint64_t ns) {
+        buckets_[Index(ns)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (ns > max && !max_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+
+    // Approximate value below which `fraction` of the recorded durations fall
+    uint64_t Percentile(double fraction) const {
+        uint64_t total = 0;
+        for (const auto& bucket : buckets_) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        if (total == 0) return 0;
+
+        uint64_t target = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+        target = std::max<uint64_t>(target, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; i++) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= target) return std::min(Midpoint(i), Max());
+        }
+        return Max();
+    }
+
+    // Only while nothing is recording
+    void Reset() {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int kSubBits = 3;
+    static constexpr uint64_t kSubBuckets = 1u << kSubBits;
+    static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+    // Values below kSubBuckets get a bucket each; above that, the top bit
+    // picks the octave and the next kSubBits bits the bucket within it
+    static size_t Index(uint64_t ns) {
+        if (ns < kSubBuckets) return static_cast<size_t>(ns);
+        int msb = kSubBits;
+        while (msb < 63 && (ns >> (msb + 1)) != 0) msb++;
+        uint64_t sub = (ns >> (msb - kSubBits)) - kSubBuckets;
+        return static_cast<size_t>((msb - kSubBits + 1) * kSubBuckets + sub);
+    }
+
+    static uint64_t Midpoint(size_t index) {
+        if (index < kSubBuckets) return index;
+        int msb = static_cast<int>(index / kSubBuckets) + kSubBits - 1;
+        uint64_t sub = index % kSubBuckets;
+        uint64_t width = uint64_t(1) << (msb - kSubBits);
+        return (kSubBuckets + sub) * width + width / 2;
+    }
+
+    std::atomic<uint64_t> buckets_[kBuckets];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> max_;
+};
@@ -0,0 +1,355 @@
+#include "echo_canceller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "audio_dsp.h"
+
+namespace {
+
+// Normalised step size of the filter update
+constexpr float kStepSize = 0.5f;
+
+// Weight of each new block in the per-bin reference power
+constexpr float kPowerSmoothing = 0.1f;
+
+// Mean square below which a block counts as silent (-60 dBFS)
+constexpr float kActivePower = 1e-6f;
+
+// Near-end speech is assumed once the microphone peaks above the reference
+// over the filter's span, or once the residual jumps this far above its
+// running level, and adaptation stays off this long afterwards. While the
+// speakers play and adaptation is off, the running level is let up, doubling
+// every kResidualDoublingMs, so that a changed echo path is eventually taken
+// for what it is.
+constexpr double kHangoverMs = 50;
+constexpr float kResidualJump = 8.0f;
+constexpr float kResidualFloor = 1e-4f;
+constexpr float kResidualSmoothing = 1.0f / 16.0f;
+constexpr double kResidualDoublingMs = 500;
+
+// Output louder than the microphone means the filter is off. Past this
+// factor it stops adapting; sustained for this long, it is cleared.
+constexpr float kDivergedRatio = 4.0f;
+constexpr double kDivergedMs = 500;
+
+// Delay estimation: bands of the binary spectra between these frequencies,
+// the weight of each block in a band's running mean and in the bit error
+// per delay, and how long a new minimum must hold, clearly below the rest,
+// before the filter is moved
+constexpr size_t kBands = 32;
+constexpr double kBandLowHz = 200;
+constexpr double kBandHighHz = 4000;
+constexpr float kMeanSmoothing = 1.0f / 32.0f;
+constexpr float kCostSmoothing = 1.0f / 64.0f;
+constexpr double kSettleMs = 500;
+constexpr float kSettledCostRatio = 0.75f;
+
+size_t BlocksFor(double ms, double sampleRate, size_t blockFrames) {
+    double blocks = std::ceil(ms / 1000.0 * sampleRate / static_cast<double>(blockFrames));
+    return std::max<size_t>(1, static_cast<size_t>(blocks));
+}
+
+uint32_t Popcount(uint32_t bits) {
+    bits = bits - ((bits >> 1) & 0x55555555u);
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    return (((bits + (bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+float MeanSquare(const float* samples, size_t count) {
+    return count > 0 ? audio_dsp_dot(samples, samples, count) / static_cast<float>(count) : 0.0f;
+}
+
+}  // namespace
+
+bool EchoCanceller::SupportsBlock(size_t blockFrames) {
+    return blockFrames >= kBands && RealFft::Supports(blockFrames * 2);
+}
+
+EchoCanceller::EchoCanceller(double sampleRate, size_t blockFrames, uint32_t channels, double tailMs)
+    : blockFrames_(blockFrames),
+      bins_(blockFrames + 1),
+      channels_(std::max<uint32_t>(1, channels)),
+      partitions_(BlocksFor(std::min(tailMs > 0 ? tailMs : kDefaultTailMs, kMaxTailMs), sampleRate, blockFrames)),
+      maxDelayBlocks_(BlocksFor(kMaxDelayMs, sampleRate, blockFrames)),
+      ringBlocks_(maxDelayBlocks_ + partitions_),
+      hangoverBlocks_(BlocksFor(kHangoverMs, sampleRate, blockFrames)),
+      stableBlocks_(BlocksFor(kSettleMs, sampleRate, blockFrames)),
+      divergedLimit_(BlocksFor(kDivergedMs, sampleRate, blockFrames)),
+      residualRelease_(static_cast<float>(
+          std::exp2(static_cast<double>(blockFrames) / sampleRate * 1000.0 / kResidualDoublingMs))),
+      regularisation_(static_cast<float>(partitions_ * blockFrames * 2) * kActivePower),
+      fft_(std::make_unique<RealFft>(blockFrames * 2)),
+      referenceWindow_(blockFrames * 2, 0.0f),
+      spectraRe_(ringBlocks_ * bins_, 0.0f),
+      spectraIm_(ringBlocks_ * bins_, 0.0f),
+      peaks_(ringBlocks_, 0.0f),
+      referenceBits_(ringBlocks_, 0),
+      referencePower_(bins_, 0.0f),
+      perChannel_(channels_),
+      referenceMeans_(kBands, 0.0f),
+      micMeans_(kBands, 0.0f),
+      delayCost_(maxDelayBlocks_, kBands / 2.0f),
+      mono_(blockFrames, 0.0f),
+      micMono_(blockFrames, 0.0f),
+      micWindow_(blockFrames * 2, 0.0f),
+      timeBuffer_(blockFrames * 2, 0.0f),
+      estimateRe_(bins_, 0.0f),
+      estimateIm_(bins_, 0.0f),
+      errorRe_(bins_, 0.0f),
+      errorIm_(bins_, 0.0f),
+      error_(blockFrames, 0.0f) {
+    for (Channel& channel : perChannel_) {
+        channel.weightRe.assign(partitions_ * bins_, 0.0f);
+        channel.weightIm.assign(partitions_ * bins_, 0.0f);
+    }
+
+    // Bands of equal width between the two edges, as far as the bins allow
+    const double hzPerBin = sampleRate / static_cast<double>(blockFrames * 2);
+    size_t low = std::max<size_t>(1, static_cast<size_t>(kBandLowHz / hzPerBin));
+    size_t high = std::min(blockFrames, static_cast<size_t>(kBandHighHz / hzPerBin));
+    bandBins_ = std::max<size_t>(1, high > low ? (high - low) / kBands : 1);
+    bandFirst_ = std::min(low, bins_ - kBands * bandBins_);
+}
+
+EchoCanceller::~EchoCanceller() = default;
+
+void EchoCanceller::Process(const float* mic, const float* reference, float* out) {
+    const size_t frames = blockFrames_;
+    const uint32_t channels = channels_;
+
+    // Mono mixes of both sides
+    if (channels == 1) {
+        memcpy(mono_.data(), reference, frames * sizeof(float));
+        memcpy(micMono_.data(), mic, frames * sizeof(float));
+    } else {
+        audio_dsp_downmix_mono(reference, mono_.data(), frames, channels);
+        audio_dsp_downmix_mono(mic, micMono_.data(), frames, channels);
+    }
+    const bool referenceActive = MeanSquare(mono_.data(), frames) > kActivePower;
+    const bool micActive = MeanSquare(micMono_.data(), frames) > kActivePower;
+
+    PushReference(mono_.data());
+    EstimateDelay(micMono_.data(), referenceActive && micActive);
+
+    // Geigel: the microphone louder than anything the speakers played over
+    // the filter's span can only be the near end
+    float referencePeak = 0.0f;
+    for (size_t p = 0; p < partitions_; p++) {
+        referencePeak = std::max(referencePeak, peaks_[RingIndex(offset_ + p)]);
+    }
+    float micPeak = 0.0f;
+    for (size_t i = 0; i < frames * channels; i++) {
+        micPeak = std::max(micPeak, std::fabs(mic[i]));
+    }
+    if (micPeak > referencePeak && micActive) {
+        doubleTalkHold_ = hangoverBlocks_;
+    } else if (doubleTalkHold_ > 0) {
+        doubleTalkHold_--;
+    }
+    const bool adapt = referenceActive && doubleTalkHold_ == 0;
+
+    // Normalisation follows the reference entering the filter
+    const float* nearestRe = &spectraRe_[RingIndex(offset_) * bins_];
+    const float* nearestIm = &spectraIm_[RingIndex(offset_) * bins_];
+    for (size_t k = 0; k < bins_; k++) {
+        float power = nearestRe[k] * nearestRe[k] + nearestIm[k] * nearestIm[k];
+        referencePower_[k] += (power - referencePower_[k]) * kPowerSmoothing;
+    }
+
+    for (uint32_t c = 0; c < channels; c++) {
+        Channel& channel = perChannel_[c];
+
+        // Echo estimate: the sum over partitions of weights times the
+        // reference of their age, the last block of its inverse
+        std::fill(estimateRe_.begin(), estimateRe_.end(), 0.0f);
+        std::fill(estimateIm_.begin(), estimateIm_.end(), 0.0f);
+        for (size_t p = 0; p < partitions_; p++) {
+            const float* wr = &channel.weightRe[p * bins_];
+            const float* wi = &channel.weightIm[p * bins_];
+            const float* xr = &spectraRe_[RingIndex(offset_ + p) * bins_];
+            const float* xi = &spectraIm_[RingIndex(offset_ + p) * bins_];
+            for (size_t k = 0; k < bins_; k++) {
+                estimateRe_[k] += wr[k] * xr[k] - wi[k] * xi[k];
+                estimateIm_[k] += wr[k] * xi[k] + wi[k] * xr[k];
+            }
+        }
+        fft_->Inverse(estimateRe_.data(), estimateIm_.data(), timeBuffer_.data());
+
+        float micEnergy = 0.0f;
+        float errorEnergy = 0.0f;
+        for (size_t i = 0; i < frames; i++) {
+            float d = mic[i * channels + c];
+            error_[i] = d - timeBuffer_[frames + i];
+            micEnergy += d * d;
+            errorEnergy += error_[i] * error_[i];
+        }
+
+        // A block the filter makes louder goes out unprocessed; a filter that
+        // keeps doing so, or blows up, is cleared
+        const float floor = kActivePower * static_cast<float>(frames);
+        const bool louder = !(errorEnergy <= micEnergy + floor);
+        if (!std::isfinite(errorEnergy)) {
+            ResetFilter(channel);
+        } else if (louder && ++channel.divergedBlocks > divergedLimit_) {
+            ResetFilter(channel);
+        } else if (!louder) {
+            channel.divergedBlocks = 0;
+        }
+
+        // Near end: the share of the microphone the filter leaves behind
+        // rising at once, rather than over many blocks
+        bool nearEnd = false;
+        if (micEnergy > floor) {
+            float residual = errorEnergy / micEnergy;
+            nearEnd = residual > kResidualJump * std::max(channel.residual, kResidualFloor);
+            residual = std::min(residual, 1.0f);
+            if (adapt && !nearEnd) {
+                channel.residual += (residual - channel.residual) * kResidualSmoothing;
+            } else if (referenceActive && residual > channel.residual) {
+                channel.residual = std::min(channel.residual * residualRelease_, residual);
+            }
+            if (nearEnd) {
+                doubleTalkHold_ = hangoverBlocks_;
+            }
+        }
+
+        if (adapt && !nearEnd && errorEnergy <= micEnergy * kDivergedRatio + floor) {
+            // Error spectrum of the block, zero-padded in front as overlap-save
+            // requires, then W += mu conj(X) E / (P |X|^2 + delta)
+            std::fill(timeBuffer_.begin(), timeBuffer_.begin() + static_cast<std::ptrdiff_t>(frames), 0.0f);
+            memcpy(timeBuffer_.data() + frames, error_.data(), frames * sizeof(float));
+            fft_->Forward(timeBuffer_.data(), errorRe_.data(), errorIm_.data());
+            for (size_t k = 0; k < bins_; k++) {
+                float gain = kStepSize / (static_cast<float>(partitions_) * referencePower_[k] + regularisation_);
+                errorRe_[k] *= gain;
+                errorIm_[k] *= gain;
+            }
+
+            for (size_t p = 0; p < partitions_; p++) {
+                float* wr = &channel.weightRe[p * bins_];
+                float* wi = &channel.weightIm[p * bins_];
+                const float* xr = &spectraRe_[RingIndex(offset_ + p) * bins_];
+                const float* xi = &spectraIm_[RingIndex(offset_ + p) * bins_];
+                for (size_t k = 0; k < bins_; k++) {
+                    wr[k] += xr[k] * errorRe_[k] + xi[k] * errorIm_[k];
+                    wi[k] += xr[k] * errorIm_[k] - xi[k] * errorRe_[k];
+                }
+            }
+
+            // Keeping every partition a causal block-long filter costs two
+            // transforms each; one per block is enough to stay converged
+            Constrain(channel, constrainNext_);
+        }
+
+        for (size_t i = 0; i < frames; i++) {
+            out[i * channels + c] = louder ? mic[i * channels + c] : error_[i];
+        }
+    }
+    constrainNext_ = (constrainNext_ + 1) % partitions_;
+}
+
+void EchoCanceller::PushReference(const float* mono) {
+    const size_t frames = blockFrames_;
+    memmove(referenceWindow_.data(), referenceWindow_.data() + frames, frames * sizeof(float));
+    memcpy(referenceWindow_.data() + frames, mono, frames * sizeof(float));
+
+    head_ = (head_ + 1) % ringBlocks_;
+    float* re = &spectraRe_[head_ * bins_];
+    float* im = &spectraIm_[head_ * bins_];
+    fft_->Forward(referenceWindow_.data(), re, im);
+
+    float peak = 0.0f;
+    for (size_t i = 0; i < frames; i++) {
+        peak = std::max(peak, std::fabs(mono[i]));
+    }
+    peaks_[head_] = peak;
+    referenceBits_[head_] = BinarySpectrum(re, im, referenceMeans_);
+}
+
+void EchoCanceller::EstimateDelay(const float* micMono, bool active) {
+    const size_t frames = blockFrames_;
+    memmove(micWindow_.data(), micWindow_.data() + frames, frames * sizeof(float));
+    memcpy(micWindow_.data() + frames, micMono, frames * sizeof(float));
+    fft_->Forward(micWindow_.data(), errorRe_.data(), errorIm_.data());
+    const uint32_t micBits = BinarySpectrum(errorRe_.data(), errorIm_.data(), micMeans_);
+
+    // Only blocks where both sides carry sound say anything about the delay
+    if (!active) return;
+
+    size_t best = 0;
+    float total = 0.0f;
+    for (size_t d = 0; d < maxDelayBlocks_; d++) {
+        float errors = static_cast<float>(Popcount(micBits ^ referenceBits_[RingIndex(d)]));
+        delayCost_[d] += (errors - delayCost_[d]) * kCostSmoothing;
+        total += delayCost_[d];
+        if (delayCost_[d] < delayCost_[best]) best = d;
+    }
+
+    if (best != candidate_) {
+        candidate_ = best;
+        candidateBlocks_ = 0;
+        return;
+    }
+    if (++candidateBlocks_ < stableBlocks_ || best == settledDelay_) return;
+    if (delayCost_[best] > kSettledCostRatio * total / static_cast<float>(maxDelayBlocks_)) return;
+
+    // Start the filter a block early, so an estimate one block late still
+    // covers the direct path
+    settledDelay_ = best;
+    MoveFilter(std::min(best > 0 ? best - 1 : 0, ringBlocks_ - partitions_));
+}
+
+void EchoCanceller::MoveFilter(size_t offset) {
+    if (offset == offset_) return;
+
+    // Partitions keep modelling the same lags where the new window still
+    // covers them
+    const long long shift = static_cast<long long>(offset) - static_cast<long long>(offset_);
+    const long long count = static_cast<long long>(partitions_);
+    for (Channel& channel : perChannel_) {
+        for (long long n = 0; n < count; n++) {
+            long long p = shift > 0 ? n : count - 1 - n;
+            long long from = p + shift;
+            float* wr = &channel.weightRe[static_cast<size_t>(p) * bins_];
+            float* wi = &channel.weightIm[static_cast<size_t>(p) * bins_];
+            if (from >= 0 && from < count) {
+                memcpy(wr, &channel.weightRe[static_cast<size_t>(from) * bins_], bins_ * sizeof(float));
+                memcpy(wi, &channel.weightIm[static_cast<size_t>(from) * bins_], bins_ * sizeof(float));
+            } else {
+                std::fill(wr, wr + bins_, 0.0f);
+                std::fill(wi, wi + bins_, 0.0f);
+            }
+        }
+    }
+    offset_ = offset;
+}
+
+void EchoCanceller::ResetFilter(Channel& channel) {
+    std::fill(channel.weightRe.begin(), channel.weightRe.end(), 0.0f);
+    std::fill(channel.weightIm.begin(), channel.weightIm.end(), 0.0f);
+    channel.divergedBlocks = 0;
+    channel.residual = 1.0f;
+}
+
+void EchoCanceller::Constrain(Channel& channel, size_t partition) {
+    float* wr = &channel.weightRe[partition * bins_];
+    float* wi = &channel.weightIm[partition * bins_];
+    fft_->Inverse(wr, wi, timeBuffer_.data());
+    std::fill(timeBuffer_.begin() + static_cast<std::ptrdiff_t>(blockFrames_), timeBuffer_.end(), 0.0f);
+    fft_->Forward(timeBuffer_.data(), wr, wi);
+}
+
+// One bit per band: set while the band is above its running mean
+uint32_t EchoCanceller::BinarySpectrum(const float* re, const float* im, std::vector<float>& means) {
+    uint32_t bits = 0;
+    for (size_t b = 0; b < kBands; b++) {
+        size_t first = bandFirst_ + b * bandBins_;
+        float energy =
+            audio_dsp_dot(re + first, re + first, bandBins_) + audio_dsp_dot(im + first, im + first, bandBins_);
+        if (energy > means[b]) bits |= 1u << b;
+        means[b] += (energy - means[b]) * kMeanSmoothing;
+    }
+    return bits;
+}
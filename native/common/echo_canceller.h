@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "real_fft.h"
+
+// ============================================================================
+// EchoCanceller - removes what the speakers played from the microphone
+//
+// The system audio of a combined capture is the signal the speakers were fed,
+// lined up with the microphone on the host clock, so it serves as the echo
+// reference. Each microphone channel gets a partitioned-block frequency-domain
+// adaptive filter (overlap-save, normalised per bin) modelling the room from
+// the reference's mono mix, and the filter's echo estimate is subtracted.
+//
+// The path from the reference to the microphone is longer than the room: the
+// output and input latencies come first. A delay estimator compares binary
+// band spectra of the two signals and, once it settles, moves the filter's
+// window along the reference history to start just before the echo, so the
+// filter only spans the room's tail. Adaptation stops while the near end
+// talks (a Geigel detector, and a jump in the share of the microphone left
+// after cancellation), while the speakers are silent, and while the output
+// is far louder than the microphone; any block the filter would make louder
+// goes out unprocessed.
+//
+// Works in blocks of a power-of-two length; Process() never allocates.
+// ============================================================================
+
+class EchoCanceller {
+public:
+    static constexpr double kDefaultTailMs = 128;
+    static constexpr double kMaxTailMs = 500;
+    static constexpr double kMaxDelayMs = 500;      // Reference to microphone, before the tail
+
+    // blockFrames must be a power of two of at least 32 frames
+    static bool SupportsBlock(size_t blockFrames);
+
+    EchoCanceller(double sampleRate, size_t blockFrames, uint32_t channels, double tailMs);
+    ~EchoCanceller();
+
+    EchoCanceller(const EchoCanceller&) = delete;
+    EchoCanceller& operator=(const EchoCanceller&) = delete;
+
+    // One block of interleaved microphone and reference frames, both of
+    // `channels`, into out (which may alias mic)
+    void Process(const float* mic, const float* reference, float* out);
+
+    // Estimated reference to microphone delay in frames, 0 until one settles
+    size_t DelayFrames() const { return settledDelay_ * blockFrames_; }
+
+private:
+    struct Channel {
+        std::vector<float> weightRe;    // [partitions * bins], partition 0 first
+        std::vector<float> weightIm;
+        float residual = 1.0f;          // Smoothed error to microphone energy
+        size_t divergedBlocks = 0;
+    };
+
+    size_t RingIndex(size_t age) const { return (head_ + ringBlocks_ - age) % ringBlocks_; }
+
+    void PushReference(const float* mono);
+    void EstimateDelay(const float* micMono, bool active);
+    void MoveFilter(size_t offset);
+    void ResetFilter(Channel& channel);
+    void Constrain(Channel& channel, size_t partition);
+    uint32_t BinarySpectrum(const float* re, const float* im, std::vector<float>& means);
+
+    size_t blockFrames_;
+    size_t bins_;
+    uint32_t channels_;
+    size_t partitions_;
+    size_t maxDelayBlocks_;
+    size_t ringBlocks_;
+    size_t hangoverBlocks_;
+    size_t stableBlocks_;
+    size_t divergedLimit_;
+    float residualRelease_;         // Growth per block of a held residual level
+    float regularisation_;
+
+    std::unique_ptr<RealFft> fft_;
+
+    // Reference history: the last two blocks of the mono mix, and per block,
+    // its spectrum, peak and binary band spectrum; head_ is the newest
+    std::vector<float> referenceWindow_;
+    std::vector<float> spectraRe_;      // [ringBlocks_ * bins_]
+    std::vector<float> spectraIm_;
+    std::vector<float> peaks_;
+    std::vector<uint32_t> referenceBits_;
+    size_t head_ = 0;
+    std::vector<float> referencePower_; // Per bin, smoothed, at the filter's offset
+
+    // Filter window: partition p reads the reference spectrum of age
+    // offset_ + p
+    size_t offset_ = 0;
+    size_t constrainNext_ = 0;
+    size_t doubleTalkHold_ = 0;
+    std::vector<Channel> perChannel_;
+
+    // Delay estimation
+    size_t bandFirst_ = 0;
+    size_t bandBins_ = 1;
+    std::vector<float> referenceMeans_;
+    std::vector<float> micMeans_;
+    std::vector<float> delayCost_;      // [maxDelayBlocks_], smoothed bit errors
+    size_t candidate_ = 0;
+    size_t candidateBlocks_ = 0;
+    size_t settledDelay_ = 0;
+
+    // Scratch, sized up front
+    std::vector<float> mono_;
+    std::vector<float> micMono_;
+    std::vector<float> micWindow_;
+    std::vector<float> timeBuffer_;
+    std::vector<float> estimateRe_;
+    std::vector<float> estimateIm_;
+    std::vector<float> errorRe_;
+    std::vector<float> errorIm_;
+    std::vector<float> error_;
+};
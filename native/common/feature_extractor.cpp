@@ -0,0 +1,219 @@
+#include "feature_extractor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "audio_dsp.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr float kLogFloor = 1e-10f;
+
+// Frames converted and mixed per pass: bounds the scratch buffers
+constexpr size_t kBlockFrames = 256;
+
+double HzToMel(double hz) {
+    return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+size_t WindowFrames(const FeatureOptions& options, double sampleRate) {
+    return static_cast<size_t>(std::max<long long>(std::llround(sampleRate * options.windowMs / 1000.0), 0));
+}
+
+size_t FftSizeFor(const FeatureOptions& options, size_t windowFrames) {
+    if (options.fftSize != 0) return options.fftSize;
+    size_t size = RealFft::kMinSize;
+    while (size < windowFrames && size < RealFft::kMaxSize) {
+        size *= 2;
+    }
+    return size;
+}
+
+double MaxHzFor(const FeatureOptions& options, double sampleRate) {
+    return options.maxHz > 0 ? options.maxHz : sampleRate / 2;
+}
+
+}  // namespace
+
+bool FeatureExtractor::Supports(const FeatureOptions& options, const PcmFormat& format) {
+    bool pcm = (format.isFloat && format.bitsPerChannel == 32) || (!format.isFloat && format.bitsPerChannel == 16);
+    if (!pcm || format.channels == 0 || format.sampleRate <= 0) return false;
+
+    size_t windowFrames = WindowFrames(options, format.sampleRate);
+    size_t fftSize = FftSizeFor(options, windowFrames);
+    double maxHz = MaxHzFor(options, format.sampleRate);
+    return windowFrames >= 2 && RealFft::Supports(fftSize) && windowFrames <= fftSize &&
+           std::llround(format.sampleRate * options.hopMs / 1000.0) >= 1 && options.melBins >= 1 &&
+           options.melBins <= kMaxMelBins && options.minHz >= 0 && options.minHz < maxHz &&
+           maxHz <= format.sampleRate / 2;
+}
+
+FeatureExtractor::FeatureExtractor(const FeatureOptions& options, const PcmFormat& format, size_t maxChunkFrames)
+    : options_(options),
+      format_(format),
+      frameBytes_(static_cast<size_t>(format.channels) * (format.bitsPerChannel / 8)),
+      nsPerFrame_(1e9 / format.sampleRate),
+      windowFrames_(WindowFrames(options, format.sampleRate)),
+      hopFrames_(static_cast<size_t>(std::llround(format.sampleRate * options.hopMs / 1000.0))),
+      maxBlockFrames_(maxChunkFrames / hopFrames_ + 2),
+      fft_(std::make_unique<RealFft>(FftSizeFor(options, windowFrames_))),
+      hann_(windowFrames_, 0.0f),
+      window_(windowFrames_, 0.0f),
+      block_(maxBlockFrames_ * options.melBins, 0.0f),
+      converted_(kBlockFrames * format.channels, 0.0f),
+      mono_(kBlockFrames, 0.0f),
+      fftInput_(fft_->Size(), 0.0f),
+      power_(fft_->Bins(), 0.0f) {
+    // Periodic Hann
+    for (size_t i = 0; i < windowFrames_; i++) {
+        hann_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * kPi * static_cast<double>(i) / windowFrames_));
+    }
+
+    // Triangles between melBins + 2 points evenly spaced in mel, each kept as
+    // the run of FFT bins it covers
+    const double melLow = HzToMel(options.minHz);
+    const double melHigh = HzToMel(MaxHzFor(options, format.sampleRate));
+    const double melStep = (melHigh - melLow) / (options.melBins + 1);
+    const double hzPerBin = format.sampleRate / static_cast<double>(fft_->Size());
+
+    filters_.resize(options.melBins);
+    for (uint32_t m = 0; m < options.melBins; m++) {
+        double left = melLow + m * melStep;
+        double center = left + melStep;
+        double right = center + melStep;
+
+        MelFilter& filter = filters_[m];
+        filter.firstBin = 0;
+        filter.binCount = 0;
+        filter.weightOffset = static_cast<uint32_t>(weights_.size());
+        for (size_t k = 0; k < fft_->Bins(); k++) {
+            double mel = HzToMel(k * hzPerBin);
+            if (mel <= left || mel >= right) {
+                if (filter.binCount > 0) break;
+                continue;
+            }
+            if (filter.binCount == 0) {
+                filter.firstBin = static_cast<uint32_t>(k);
+            }
+            double weight = mel <= center ? (mel - left) / melStep : (right - mel) / melStep;
+            weights_.push_back(static_cast<float>(weight));
+            filter.binCount++;
+        }
+    }
+}
+
+void FeatureExtractor::Process(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info,
+                               BlockCallback callback, void* context) {
+    const size_t frames = bytes / frameBytes_;
+    const uint32_t channels = format_.channels;
+    const bool aligned = reinterpret_cast<uintptr_t>(pcm) % alignof(float) == 0;
+
+    if (!started_) {
+        started_ = true;
+        windowStart_ = info.framePosition;
+    }
+    if (info.hostTimeNs != 0) {
+        anchorPosition_ = info.framePosition;
+        anchorHostTimeNs_ = info.hostTimeNs;
+    }
+
+    size_t done = 0;
+    while (done < frames) {
+        size_t n = std::min(frames - done, kBlockFrames);
+        const uint8_t* src = pcm + done * frameBytes_;
+        const float* samples = converted_.data();
+        if (format_.isFloat && aligned) {
+            samples = reinterpret_cast<const float*>(src);
+        } else if (format_.isFloat) {
+            memcpy(converted_.data(), src, n * frameBytes_);
+        } else {
+            for (size_t i = 0; i < n * channels; i++) {
+                int16_t v;
+                memcpy(&v, src + i * sizeof(int16_t), sizeof(v));
+                converted_[i] = v * (1.0f / 32768.0f);
+            }
+        }
+
+        const float* mono = samples;
+        if (channels > 1) {
+            audio_dsp_downmix_mono(samples, mono_.data(), n, channels);
+            mono = mono_.data();
+        }
+
+        size_t used = 0;
+        while (used < n) {
+            if (skip_ > 0) {
+                size_t skipped = std::min(skip_, n - used);
+                skip_ -= skipped;
+                windowStart_ += skipped;
+                used += skipped;
+                continue;
+            }
+
+            size_t take = std::min(windowFrames_ - windowFill_, n - used);
+            memcpy(window_.data() + windowFill_, mono + used, take * sizeof(float));
+            windowFill_ += take;
+            used += take;
+            if (windowFill_ < windowFrames_) continue;
+
+            if (blockFrames_ == 0) {
+                blockStart_ = windowStart_;
+            }
+            AnalyseWindow();
+            if (blockFrames_ == maxBlockFrames_) {
+                Report(callback, context);
+            }
+
+            if (hopFrames_ < windowFrames_) {
+                memmove(window_.data(), window_.data() + hopFrames_, (windowFrames_ - hopFrames_) * sizeof(float));
+                windowFill_ = windowFrames_ - hopFrames_;
+                windowStart_ += hopFrames_;
+            } else {
+                windowFill_ = 0;
+                windowStart_ += windowFrames_;
+                skip_ = hopFrames_ - windowFrames_;
+            }
+        }
+        done += n;
+    }
+
+    if (blockFrames_ > 0) {
+        Report(callback, context);
+    }
+}
+
+void FeatureExtractor::AnalyseWindow() {
+    // The zero padding past the window is never written
+    for (size_t i = 0; i < windowFrames_; i++) {
+        fftInput_[i] = window_[i] * hann_[i];
+    }
+    fft_->Power(fftInput_.data(), power_.data());
+
+    float* out = block_.data() + blockFrames_ * options_.melBins;
+    for (uint32_t m = 0; m < options_.melBins; m++) {
+        const MelFilter& filter = filters_[m];
+        float energy = audio_dsp_dot(power_.data() + filter.firstBin, weights_.data() + filter.weightOffset,
+                                     filter.binCount);
+        out[m] = std::log(std::max(energy, kLogFloor));
+    }
+    blockFrames_++;
+}
+
+void FeatureExtractor::Report(BlockCallback callback, void* context) {
+    FeatureBlock block;
+    block.framePosition = blockStart_;
+    block.hostTimeNs = 0;
+    if (anchorHostTimeNs_ != 0) {
+        double offsetNs = static_cast<double>(static_cast<int64_t>(blockStart_ - anchorPosition_)) * nsPerFrame_;
+        block.hostTimeNs = anchorHostTimeNs_ + static_cast<int64_t>(std::llround(offsetNs));
+    }
+    block.frames = static_cast<uint32_t>(blockFrames_);
+    block.bins = options_.melBins;
+    block.hopFrames = static_cast<uint32_t>(hopFrames_);
+    block.values = block_.data();
+    blockFrames_ = 0;
+
+    callback(block, context);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "audio_chunk_info.h"
+#include "audio_encoder.h"
+#include "real_fft.h"
+
+// ============================================================================
+// FeatureExtractor - log-mel filterbank frames for speech recognition
+//
+// Runs on whichever thread delivers chunks, right after the level meter, so
+// it sees the output rate and the capture format, ahead of the voice
+// activity gate and the encoder. The mono mix is cut into Hann-windowed
+// frames of windowMs every hopMs, regardless of chunk size; each frame is
+// the natural log of the power spectrum through melBins triangular filters
+// spaced on the HTK mel scale, floored at 1e-10. Frames completed by a
+// chunk are reported together, as one block.
+// ============================================================================
+
+struct FeatureOptions {
+    double windowMs = 25;       // Frame length
+    double hopMs = 10;          // Frame step
+    uint32_t melBins = 80;
+    uint32_t fftSize = 0;       // 0: the smallest power of two that fits a window
+    double minHz = 0;           // Lowest filter edge
+    double maxHz = 0;           // Highest filter edge; 0 for half the sample rate
+    bool pcm = true;            // Keep delivering chunks; otherwise only features
+};
+
+struct FeatureBlock {
+    uint64_t framePosition;     // First sample of the first frame's window
+    uint64_t hostTimeNs;        // Host time of that sample, 0 if unknown
+    uint32_t frames;
+    uint32_t bins;
+    uint32_t hopFrames;         // Samples between the starts of consecutive frames
+    const float* values;        // [frames * bins], frame by frame
+};
+
+class FeatureExtractor {
+public:
+    static constexpr uint32_t kMaxMelBins = 256;
+
+    typedef void (*BlockCallback)(const FeatureBlock& block, void* context);
+
+    // 32-bit float and 16-bit integer PCM, at a rate the options fit: a
+    // window the FFT can hold and filters below the Nyquist frequency
+    static bool Supports(const FeatureOptions& options, const PcmFormat& format);
+
+    // Blocks hold up to the frames completed by a chunk of maxChunkFrames
+    FeatureExtractor(const FeatureOptions& options, const PcmFormat& format, size_t maxChunkFrames);
+
+    // Frames in the biggest block Process() can report
+    size_t MaxBlockFrames() const { return maxBlockFrames_; }
+    uint32_t Bins() const { return options_.melBins; }
+
+    // Analyse one interleaved chunk, reporting the frames it completes. A
+    // partial window is carried into the next chunk.
+    void Process(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info, BlockCallback callback,
+                 void* context);
+
+private:
+    struct MelFilter {
+        uint32_t firstBin;
+        uint32_t binCount;
+        uint32_t weightOffset;
+    };
+
+    void AnalyseWindow();
+    void Report(BlockCallback callback, void* context);
+
+    FeatureOptions options_;
+    PcmFormat format_;
+    size_t frameBytes_;
+    double nsPerFrame_;
+    size_t windowFrames_;
+    size_t hopFrames_;
+    size_t maxBlockFrames_;
+
+    std::unique_ptr<RealFft> fft_;
+    std::vector<float> hann_;
+    std::vector<MelFilter> filters_;
+    std::vector<float> weights_;
+
+    // The window being filled, its first sample's position, and samples
+    // still to skip when the hop is longer than the window
+    std::vector<float> window_;
+    size_t windowFill_ = 0;
+    uint64_t windowStart_ = 0;
+    size_t skip_ = 0;
+    bool started_ = false;
+
+    // Host time of a known position, to time windows that began in an
+    // earlier chunk
+    uint64_t anchorPosition_ = 0;
+    uint64_t anchorHostTimeNs_ = 0;
+
+    // Block being filled
+    std::vector<float> block_;
+    size_t blockFrames_ = 0;
+    uint64_t blockStart_ = 0;
+
+    // Scratch, sized up front: converted input, its mono mix, and the
+    // windowed frame and its spectrum
+    std::vector<float> converted_;
+    std::vector<float> mono_;
+    std::vector<float> fftInput_;
+    std::vector<float> power_;
+};
@@ -0,0 +1,505 @@
+#include "file_sink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Opus packets from the encoder are 20 ms; Ogg Opus counts 48 kHz samples
+constexpr uint64_t kOpusPacketSamples = 960;
+// Encoder delay at 48 kHz for libopus' default application, skipped by decoders
+constexpr uint16_t kOpusPreSkip = 312;
+// Pages are also closed after this many packets (1 s), so that a reader of a
+// growing file sees audio without waiting for a full page
+constexpr size_t kPacketsPerPage = 50;
+
+void PutLE(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void PutBE(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = static_cast<uint8_t>(value >> (8 * (bytes - 1 - i)));
+    }
+}
+
+// CRC-32 as Ogg uses it: polynomial 0x04C11DB7, unreflected, no final xor
+uint32_t OggCrc(const uint8_t* data, size_t size, uint32_t crc) {
+    static const auto table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t r = i << 24;
+            for (int bit = 0; bit < 8; bit++) {
+                r = (r & 0x80000000u) ? (r << 1) ^ 0x04C11DB7u : r << 1;
+            }
+            t[i] = r;
+        }
+        return t;
+    }();
+
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc << 8) ^ table[((crc >> 24) ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+FILE* OpenForWriting(const std::string& path) {
+#if defined(_WIN32)
+    // The path is UTF-8; fopen would read it in the ANSI code page
+    int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (length <= 0) return nullptr;
+    std::wstring wide(static_cast<size_t>(length), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], length);
+    return _wfopen(wide.c_str(), L"w+b");
+#else
+    return fopen(path.c_str(), "w+b");
+#endif
+}
+
+// Reserve space without moving the end of the file; best effort
+void Preallocate(FILE* file, uint64_t bytes) {
+#if defined(_WIN32)
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    FILE_ALLOCATION_INFO info = {};
+    info.AllocationSize.QuadPart = static_cast<LONGLONG>(bytes);
+    SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info));
+#elif defined(__APPLE__)
+    fstore_t store = {F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>(bytes), 0};
+    if (fcntl(fileno(file), F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        fcntl(fileno(file), F_PREALLOCATE, &store);
+    }
+#elif defined(__linux__)
+    fallocate(fileno(file), FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+#else
+    (void)file;
+    (void)bytes;
+#endif
+}
+
+// Give back reserved space past the end of the file
+void TrimTo(FILE* file, uint64_t bytes) {
+#if defined(_WIN32)
+    // Allocation past the end is released when the handle closes
+    (void)file;
+    (void)bytes;
+#else
+    // On failure the space stays reserved; the file itself is intact
+    int result = ftruncate(fileno(file), static_cast<off_t>(bytes));
+    (void)result;
+#endif
+}
+
+bool SeekTo(FILE* file, uint64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+}  // namespace
+
+bool FileSink::ParseContainer(const std::string& name, FileContainer* container) {
+    if (name == "wav") {
+        *container = FileContainer::Wav;
+    } else if (name == "caf") {
+        *container = FileContainer::Caf;
+    } else if (name == "ogg") {
+        *container = FileContainer::Ogg;
+    } else if (name == "flac") {
+        *container = FileContainer::Flac;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool FileSink::Accepts(FileContainer container, AudioEncoding encoding) {
+    return ContainerFor(encoding) == container ||
+           (container == FileContainer::Caf && ContainerFor(encoding) == FileContainer::Wav);
+}
+
+FileContainer FileSink::ContainerFor(AudioEncoding encoding) {
+    switch (encoding) {
+        case AudioEncoding::Flac:
+            return FileContainer::Flac;
+        case AudioEncoding::Opus:
+            return FileContainer::Ogg;
+        case AudioEncoding::Native:
+        case AudioEncoding::PcmS16:
+        case AudioEncoding::PcmF32:
+            break;
+    }
+    return FileContainer::Wav;
+}
+
+std::unique_ptr<FileSink> FileSink::Open(const FileSinkOptions& options, std::string* error) {
+    FILE* file = OpenForWriting(options.path);
+    if (!file) {
+        *error = "Cannot create " + options.path + ": " + strerror(errno);
+        return nullptr;
+    }
+
+    // Writes are already whole blocks; stdio buffering would only copy them again
+    setvbuf(file, nullptr, _IONBF, 0);
+    if (options.preallocateBytes > 0) {
+        Preallocate(file, options.preallocateBytes);
+    }
+
+    std::unique_ptr<FileSink> sink(new FileSink(options, file));
+    sink->writer_ = std::thread(&FileSink::WriterLoop, sink.get());
+    return sink;
+}
+
+FileSink::FileSink(const FileSinkOptions& options, FILE* file)
+    : options_(options),
+      file_(file),
+      ring_(options.bufferBytes),
+      storage_(kBlockBytes * 2),
+      readBuffer_(std::max(kBlockBytes, kMaxPacketBytes)) {
+    void* aligned = storage_.data();
+    size_t space = storage_.size();
+    block_ = static_cast<uint8_t*>(std::align(kBlockBytes, kBlockBytes, aligned, space));
+
+    if (options.container == FileContainer::Ogg) {
+        record_.resize(sizeof(uint32_t) + kMaxPacketBytes);
+        page_.reserve(255 * 255);
+        segments_.reserve(255);
+        serial_ = static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+}
+
+FileSink::~FileSink() {
+    std::string ignored;
+    Close(&ignored);
+}
+
+bool FileSink::Begin(const FileSinkFormat& format) {
+    if (ended_) return false;
+    if (begun_) {
+        bool same = format.sampleRate == format_.sampleRate && format.channels == format_.channels &&
+                    format.bitsPerChannel == format_.bitsPerChannel && format.isFloat == format_.isFloat;
+        if (!same) ended_ = true;
+        return same;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    format_ = format;
+    formatPending_ = true;
+    begun_ = true;
+    return true;
+}
+
+bool FileSink::Write(const uint8_t* data, size_t size) {
+    if (!begun_ || ended_ || size == 0) return true;
+
+    bool written;
+    if (options_.container == FileContainer::Ogg) {
+        // Length and packet go in together, so a packet is never half there
+        written = size <= kMaxPacketBytes;
+        if (written) {
+            uint32_t length = static_cast<uint32_t>(size);
+            memcpy(record_.data(), &length, sizeof(length));
+            memcpy(record_.data() + sizeof(length), data, size);
+            written = ring_.Write(record_.data(), sizeof(length) + size);
+        }
+    } else {
+        written = ring_.Write(data, size);
+    }
+
+    if (!written) {
+        bytesDropped_.fetch_add(size, std::memory_order_relaxed);
+    }
+    return written;
+}
+
+bool FileSink::Close(std::string* error) {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+
+    if (failed_) {
+        *error = error_;
+        return false;
+    }
+    return true;
+}
+
+void FileSink::WriterLoop() {
+    for (;;) {
+        bool closing;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait_for(lock, std::chrono::milliseconds(100), [this] { return closing_; });
+            closing = closing_;
+        }
+
+        Drain();
+        if (closing) {
+            Finish();
+            return;
+        }
+    }
+}
+
+void FileSink::Drain() {
+    // Everything readable now was written after Begin, so its header is
+    // pending (or written) by the time the lock below is taken
+    size_t available = ring_.Readable();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (formatPending_) {
+            formatPending_ = false;
+            WriteHeader();
+        }
+    }
+
+    if (options_.container == FileContainer::Ogg) {
+        while (available >= sizeof(uint32_t)) {
+            uint32_t length = 0;
+            ring_.Read(&length, sizeof(length));
+            ring_.Read(readBuffer_.data(), length);
+            available -= sizeof(length) + length;
+            AppendPacket(readBuffer_.data(), length);
+        }
+    } else {
+        while (available > 0) {
+            size_t bytes = ring_.Read(readBuffer_.data(), std::min(available, readBuffer_.size()));
+            available -= bytes;
+            Emit(readBuffer_.data(), bytes);
+            dataBytes_ += bytes;
+        }
+    }
+
+    bytesWritten_.store(dataBytes_, std::memory_order_relaxed);
+}
+
+void FileSink::WriteHeader() {
+    if (headerWritten_) return;
+    headerWritten_ = true;
+
+    const FileSinkFormat& f = format_;
+    uint32_t frameBytes = f.channels * (f.bitsPerChannel / 8);
+
+    switch (options_.container) {
+        case FileContainer::Wav: {
+            // Sizes are zero until Finish patches them
+            uint8_t header[44] = {};
+            memcpy(header, "RIFF", 4);
+            memcpy(header + 8, "WAVE", 4);
+            memcpy(header + 12, "fmt ", 4);
+            PutLE(header + 16, 16, 4);
+            PutLE(header + 20, f.isFloat ? 3 : 1, 2);     // IEEE float or integer PCM
+            PutLE(header + 22, f.channels, 2);
+            PutLE(header + 24, static_cast<uint32_t>(f.sampleRate), 4);
+            PutLE(header + 28, static_cast<uint32_t>(f.sampleRate) * frameBytes, 4);
+            PutLE(header + 32, frameBytes, 2);
+            PutLE(header + 34, f.bitsPerChannel, 2);
+            memcpy(header + 36, "data", 4);
+            Emit(header, sizeof(header));
+            break;
+        }
+
+        case FileContainer::Caf: {
+            uint8_t header[68] = {};
+            memcpy(header, "caff", 4);
+            PutBE(header + 4, 1, 2);                        // Version
+
+            memcpy(header + 8, "desc", 4);
+            PutBE(header + 12, 32, 8);
+            uint64_t rateBits;
+            memcpy(&rateBits, &f.sampleRate, sizeof(rateBits));
+            PutBE(header + 20, rateBits, 8);
+            memcpy(header + 28, "lpcm", 4);
+            PutBE(header + 32, (f.isFloat ? 1 : 0) | 2, 4); // Float, little endian
+            PutBE(header + 36, frameBytes, 4);
+            PutBE(header + 40, 1, 4);                       // Frames per packet
+            PutBE(header + 44, f.channels, 4);
+            PutBE(header + 48, f.bitsPerChannel, 4);
+
+            // A size of -1 reads as "up to the end of the file", which keeps
+            // the file playable if it is never closed
+            memcpy(header + 52, "data", 4);
+            PutBE(header + 56, UINT64_MAX, 8);
+            PutBE(header + 64, 0, 4);                       // Edit count
+            Emit(header, sizeof(header));
+            break;
+        }
+
+        case FileContainer::Ogg: {
+            uint8_t head[19] = {};
+            memcpy(head, "OpusHead", 8);
+            head[8] = 1;                                    // Version
+            head[9] = static_cast<uint8_t>(f.channels);
+            PutLE(head + 10, kOpusPreSkip, 2);
+            PutLE(head + 12, static_cast<uint32_t>(f.sampleRate), 4);
+            // Output gain and channel mapping family 0 stay zero
+            uint8_t headSegment = sizeof(head);
+            WriteOggPage(head, &headSegment, 1, sizeof(head), 0x02, 0);
+
+            static const char kVendor[] = "native-audio-node";
+            uint8_t tags[8 + 4 + sizeof(kVendor) - 1 + 4] = {};
+            memcpy(tags, "OpusTags", 8);
+            PutLE(tags + 8, sizeof(kVendor) - 1, 4);
+            memcpy(tags + 12, kVendor, sizeof(kVendor) - 1);
+            // No user comments
+            uint8_t tagsSegment = sizeof(tags);
+            WriteOggPage(tags, &tagsSegment, 1, sizeof(tags), 0x00, 0);
+            break;
+        }
+
+        case FileContainer::Flac:
+            // The encoder's first packet is the stream header
+            break;
+    }
+
+    dataStart_ = fileBytes_;
+}
+
+void FileSink::Finish() {
+    if (options_.container == FileContainer::Ogg && headerWritten_) {
+        FlushPage(true);
+    }
+    FlushBuffer();
+
+    if (headerWritten_ && !failed_) {
+        uint8_t size[8];
+        switch (options_.container) {
+            case FileContainer::Wav: {
+                // Past 4 GiB the sizes saturate; most readers then go by the file size
+                uint64_t riff = std::min<uint64_t>(36 + dataBytes_, UINT32_MAX);
+                PutLE(size, riff, 4);
+                Put(4, size, 4);
+                PutLE(size, std::min<uint64_t>(dataBytes_, UINT32_MAX), 4);
+                Put(40, size, 4);
+                break;
+            }
+
+            case FileContainer::Caf:
+                PutBE(size, dataBytes_ + 4, 8);     // Includes the edit count
+                Put(56, size, 8);
+                break;
+
+            case FileContainer::Ogg:
+            case FileContainer::Flac:
+                break;
+        }
+    }
+
+    if (options_.preallocateBytes > 0) {
+        fflush(file_);
+        TrimTo(file_, fileBytes_);
+    }
+    if (fclose(file_) != 0 && !failed_) {
+        failed_ = true;
+        error_ = std::string("Failed to close the file: ") + strerror(errno);
+    }
+    file_ = nullptr;
+}
+
+void FileSink::AppendPacket(const uint8_t* packet, size_t size) {
+    size_t segmentCount = size / 255 + 1;
+    if (segments_.size() + segmentCount > 255) {
+        FlushPage(false);
+    }
+
+    // Lacing: 255 for every full segment, then the remainder (possibly 0)
+    for (size_t i = 0; i + 1 < segmentCount; i++) {
+        segments_.push_back(255);
+    }
+    segments_.push_back(static_cast<uint8_t>(size % 255));
+    page_.insert(page_.end(), packet, packet + size);
+    granule_ += kOpusPacketSamples;
+    dataBytes_ += size;
+
+    if (++pagePackets_ >= kPacketsPerPage) {
+        FlushPage(false);
+    }
+}
+
+void FileSink::FlushPage(bool last) {
+    // The stream always ends on a page flagged end-of-stream, empty if need be
+    if (segments_.empty() && !last) return;
+
+    WriteOggPage(page_.data(), segments_.data(), segments_.size(), page_.size(), last ? 0x04 : 0x00, granule_);
+    page_.clear();
+    segments_.clear();
+    pagePackets_ = 0;
+}
+
+void FileSink::WriteOggPage(const uint8_t* body, const uint8_t* segments, size_t segmentCount, size_t bodyBytes,
+                            uint8_t flags, uint64_t granule) {
+    uint8_t header[27 + 255];
+    memcpy(header, "OggS", 4);
+    header[4] = 0;                                  // Version
+    header[5] = flags;
+    PutLE(header + 6, granule, 8);
+    PutLE(header + 14, serial_, 4);
+    PutLE(header + 18, pageSequence_++, 4);
+    PutLE(header + 22, 0, 4);                       // CRC, filled in below
+    header[26] = static_cast<uint8_t>(segmentCount);
+    memcpy(header + 27, segments, segmentCount);
+
+    size_t headerBytes = 27 + segmentCount;
+    uint32_t crc = OggCrc(header, headerBytes, 0);
+    crc = OggCrc(body, bodyBytes, crc);
+    PutLE(header + 22, crc, 4);
+
+    Emit(header, headerBytes);
+    Emit(body, bodyBytes);
+}
+
+void FileSink::Emit(const void* data, size_t size) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        size_t take = std::min(size, kBlockBytes - blockFill_);
+        memcpy(block_ + blockFill_, in, take);
+        blockFill_ += take;
+        in += take;
+        size -= take;
+        if (blockFill_ == kBlockBytes) {
+            FlushBuffer();
+        }
+    }
+}
+
+void FileSink::FlushBuffer() {
+    if (blockFill_ == 0) return;
+
+    // After a failure the rest is discarded, but still counted so that the
+    // header offsets stay consistent
+    if (!failed_ && fwrite(block_, 1, blockFill_, file_) != blockFill_) {
+        failed_ = true;
+        error_ = std::string("Failed to write the file: ") + strerror(errno);
+    }
+    fileBytes_ += blockFill_;
+    blockFill_ = 0;
+}
+
+void FileSink::Put(uint64_t offset, const void* data, size_t size) {
+    if (failed_) return;
+    if (!SeekTo(file_, offset) || fwrite(data, 1, size, file_) != size) {
+        failed_ = true;
+        error_ = std::string("Failed to update the file header: ") + strerror(errno);
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_encoder.h"
+#include "byte_ring.h"
+
+// ============================================================================
+// FileSink - writes a session's output straight to a file
+//
+// The thread delivering chunks only copies each one into a ring; a writer
+// thread of the sink's own drains it into a block-aligned buffer and writes
+// whole blocks, so the file is written in a few large writes rather than one
+// per chunk, and disk stalls never reach the capture. If the writer falls so
+// far behind that the ring fills, chunks are dropped from the file and
+// counted.
+//
+// Containers:
+//   wav   PCM (16-bit integer or 32-bit float); sizes are patched on close
+//   caf   PCM in Core Audio Format; the data size is patched on close
+//   ogg   Ogg Opus, one stream of the Opus encoder's packets
+//   flac  The FLAC encoder's stream, as is
+// ============================================================================
+
+enum class FileContainer : int32_t {
+    Wav = 0,
+    Caf = 1,
+    Ogg = 2,
+    Flac = 3,
+};
+
+struct FileSinkOptions {
+    std::string path;
+    FileContainer container = FileContainer::Wav;
+    uint64_t preallocateBytes = 0;      // Reserved up front, trimmed on close; 0 = none
+    size_t bufferBytes = 4 * 1024 * 1024;   // Ring between the chunk thread and the writer
+};
+
+// Format of what the sink is given, as reported by the metadata callback
+struct FileSinkFormat {
+    double sampleRate = 0;
+    uint32_t channels = 1;
+    uint32_t bitsPerChannel = 32;
+    bool isFloat = true;
+};
+
+class FileSink {
+public:
+    // Parse a container name ("wav", "caf", "ogg", "flac"); false if unknown
+    static bool ParseContainer(const std::string& name, FileContainer* container);
+
+    // Whether the container can hold a session's output in this encoding;
+    // Native is PCM
+    static bool Accepts(FileContainer container, AudioEncoding encoding);
+
+    // The container for an encoding when none is asked for
+    static FileContainer ContainerFor(AudioEncoding encoding);
+
+    // Creates (truncates) the file, reserves space and starts the writer.
+    // Returns nullptr with a message if the file cannot be created.
+    static std::unique_ptr<FileSink> Open(const FileSinkOptions& options, std::string* error);
+
+    // Closes without reporting errors
+    ~FileSink();
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    // Chunk thread: the stream's format, ahead of its first chunk. A later
+    // call with a different format ends the file's data, since no container
+    // here can change format midway; returns false when that happens.
+    bool Begin(const FileSinkFormat& format);
+
+    // Chunk thread: append one chunk, or for ogg one Opus packet. Never
+    // blocks, locks or allocates; false if it was dropped for lack of room.
+    // Chunks after the data has ended are ignored.
+    bool Write(const uint8_t* data, size_t size);
+
+    // Writes what is left, patches the header and closes the file. Returns
+    // false with a message if any write failed; later calls report the same.
+    bool Close(std::string* error);
+
+    uint64_t BytesWritten() const { return bytesWritten_.load(std::memory_order_relaxed); }
+    uint64_t BytesDropped() const { return bytesDropped_.load(std::memory_order_relaxed); }
+
+private:
+    // Write granularity; the buffer is aligned to it
+    static constexpr size_t kBlockBytes = 256 * 1024;
+    static constexpr size_t kMaxPacketBytes = 4000;     // Largest Opus packet
+
+    FileSink(const FileSinkOptions& options, FILE* file);
+
+    void WriterLoop();
+    void Drain();
+    void WriteHeader();
+    void Finish();
+
+    // Ogg pages
+    void AppendPacket(const uint8_t* packet, size_t size);
+    void FlushPage(bool last);
+    void WriteOggPage(const uint8_t* body, const uint8_t* segments, size_t segmentCount, size_t bodyBytes,
+                      uint8_t flags, uint64_t granule);
+
+    // Buffered output; Emit writes through the block buffer, Put at an
+    // absolute offset (headers only, once the buffer is flushed)
+    void Emit(const void* data, size_t size);
+    void FlushBuffer();
+    void Put(uint64_t offset, const void* data, size_t size);
+
+    FileSinkOptions options_;
+    FILE* file_;
+    ByteRing ring_;
+    std::thread writer_;
+
+    // The writer polls the ring, so that the chunk thread never has to lock
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool closing_ = false;
+    bool formatPending_ = false;       // Begin was called, the header is not yet written
+    FileSinkFormat format_;
+
+    // Chunk thread only
+    bool begun_ = false;
+    bool ended_ = false;
+    std::vector<uint8_t> record_;      // Length-prefixed packet for ogg
+
+    std::atomic<uint64_t> bytesWritten_{0};     // Audio bytes handed to the file
+    std::atomic<uint64_t> bytesDropped_{0};
+
+    // Writer thread only
+    bool headerWritten_ = false;
+    bool failed_ = false;
+    std::string error_;
+    std::vector<uint8_t> storage_;
+    uint8_t* block_ = nullptr;         // kBlockBytes, aligned within storage_
+    size_t blockFill_ = 0;
+    std::vector<uint8_t> readBuffer_;
+    uint64_t fileBytes_ = 0;           // Everything emitted, headers included
+    uint64_t dataStart_ = 0;           // File offset of the first audio byte
+    uint64_t dataBytes_ = 0;
+
+    // Ogg state; packets wait in page_ until a page is full
+    uint32_t serial_ = 0;
+    uint32_t pageSequence_ = 0;
+    uint64_t granule_ = 0;             // 48 kHz samples in the packets so far
+    std::vector<uint8_t> page_;
+    std::vector<uint8_t> segments_;
+    size_t pagePackets_ = 0;
+};
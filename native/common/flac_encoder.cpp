@@ -0,0 +1,473 @@
+#include "flac_encoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t kMaxFixedOrder = 4;
+constexpr uint32_t kMaxPartitionOrder = 8;
+constexpr uint32_t kMaxRiceParameter = 14;   // 15 is the escape code in 4-bit parameters
+
+struct CrcTables {
+    uint8_t crc8[256];
+    uint16_t crc16[256];
+
+    CrcTables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c8 = i;
+            uint32_t c16 = i << 8;
+            for (int bit = 0; bit < 8; bit++) {
+                c8 = (c8 & 0x80) ? ((c8 << 1) ^ 0x07) : (c8 << 1);
+                c16 = (c16 & 0x8000) ? ((c16 << 1) ^ 0x8005) : (c16 << 1);
+            }
+            crc8[i] = static_cast<uint8_t>(c8);
+            crc16[i] = static_cast<uint16_t>(c16);
+        }
+    }
+};
+
+const CrcTables& Crc() {
+    static const CrcTables tables;
+    return tables;
+}
+
+uint8_t Crc8(const uint8_t* data, size_t size) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; i++) crc = Crc().crc8[crc ^ data[i]];
+    return crc;
+}
+
+uint16_t Crc16(const uint8_t* data, size_t size) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ Crc().crc16[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+inline uint32_t Mask(uint32_t bits) {
+    return bits >= 32 ? 0xFFFFFFFFu : ((1u << bits) - 1);
+}
+
+inline uint32_t ZigZag(int32_t r) {
+    return (static_cast<uint32_t>(r) << 1) ^ static_cast<uint32_t>(r >> 31);
+}
+
+// Rice parameter for a partition: floor(log2(mean))
+inline uint32_t RiceParameter(uint64_t sum, size_t count) {
+    uint32_t k = 0;
+    while (k < kMaxRiceParameter && (static_cast<uint64_t>(count) << (k + 1)) <= sum) k++;
+    return k;
+}
+
+// Fixed-predictor residual of the given order, zigzag-mapped; returns the sum
+uint64_t ComputeResidual(const int32_t* x, size_t count, uint32_t order, uint32_t* out) {
+    uint64_t sum = 0;
+    size_t n = 0;
+    for (size_t i = order; i < count; i++) {
+        int32_t r;
+        switch (order) {
+            case 0: r = x[i]; break;
+            case 1: r = x[i] - x[i - 1]; break;
+            case 2: r = x[i] - 2 * x[i - 1] + x[i - 2]; break;
+            case 3: r = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]; break;
+            default: r = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+        }
+        uint32_t u = ZigZag(r);
+        out[n++] = u;
+        sum += u;
+    }
+    return sum;
+}
+
+// Frame header block size code and any trailing explicit value
+uint32_t BlockSizeCode(size_t frames, uint32_t* extraBits) {
+    *extraBits = 0;
+    if (frames == 192) return 1;
+    for (uint32_t k = 2; k <= 5; k++) {
+        if (frames == (576u << (k - 2))) return k;
+    }
+    for (uint32_t k = 8; k <= 15; k++) {
+        if (frames == (256u << (k - 8))) return k;
+    }
+    *extraBits = frames <= 256 ? 8 : 16;
+    return frames <= 256 ? 6 : 7;
+}
+
+// Frame header sample rate code; 0 defers to STREAMINFO
+uint32_t SampleRateCode(uint32_t rate, uint32_t* extraBits, uint32_t* extraValue) {
+    *extraBits = 0;
+    *extraValue = 0;
+    switch (rate) {
+        case 88200: return 1;
+        case 176400: return 2;
+        case 192000: return 3;
+        case 8000: return 4;
+        case 16000: return 5;
+        case 22050: return 6;
+        case 24000: return 7;
+        case 32000: return 8;
+        case 44100: return 9;
+        case 48000: return 10;
+        case 96000: return 11;
+        default: break;
+    }
+    if (rate % 1000 == 0 && rate / 1000 <= 255) {
+        *extraBits = 8;
+        *extraValue = rate / 1000;
+        return 12;
+    }
+    if (rate <= 65535) {
+        *extraBits = 16;
+        *extraValue = rate;
+        return 13;
+    }
+    if (rate % 10 == 0 && rate / 10 <= 65535) {
+        *extraBits = 16;
+        *extraValue = rate / 10;
+        return 14;
+    }
+    return 0;
+}
+
+}  // namespace
+
+// ============================================================================
+// BitWriter
+// ============================================================================
+
+void FlacEncoder::BitWriter::Write(uint32_t value, uint32_t bits) {
+    if (bits == 0) return;
+    accumulator_ = (accumulator_ << bits) | (value & Mask(bits));
+    pending_ += bits;
+    while (pending_ >= 8) {
+        pending_ -= 8;
+        bytes_.push_back(static_cast<uint8_t>(accumulator_ >> pending_));
+    }
+}
+
+void FlacEncoder::BitWriter::WriteUnary(uint32_t zeros) {
+    while (zeros >= 32) {
+        Write(0, 32);
+        zeros -= 32;
+    }
+    Write(1, zeros + 1);
+}
+
+void FlacEncoder::BitWriter::AlignToByte() {
+    if (pending_) Write(0, 8 - pending_);
+}
+
+// ============================================================================
+// Encoder
+// ============================================================================
+
+bool FlacEncoder::Supports(const PcmFormat& input) {
+    uint32_t rate = static_cast<uint32_t>(input.sampleRate);
+    return input.channels >= 1 && input.channels <= 8 &&
+           rate > 0 && rate <= 655350 && static_cast<double>(rate) == input.sampleRate;
+}
+
+FlacEncoder::FlacEncoder(const PcmFormat& input, size_t maxChunkFrames)
+    : input_(input),
+      channels_(input.channels),
+      sampleRate_(static_cast<uint32_t>(input.sampleRate)),
+      block_(static_cast<size_t>(kBlockSize) * input.channels),
+      residual_(kBlockSize) {
+    if (channels_ == 2) {
+        mid_.resize(kBlockSize);
+        side_.resize(kBlockSize);
+    }
+    if (input_.isFloat) {
+        convertBuffer_.resize(std::max<size_t>(maxChunkFrames, kBlockSize) * channels_);
+    }
+    // Verbatim worst case is 17 bits per sample plus headers
+    writer_.Reserve(static_cast<size_t>(kBlockSize) * channels_ * 3 + 64);
+    audio_dsp_dither_init(&dither_, 0x464C4143u);
+}
+
+void FlacEncoder::Encode(const uint8_t* pcm, size_t bytes, PacketCallback emit, void* context) {
+    if (!headerSent_) EmitStreamHeader(emit, context);
+
+    if (input_.isFloat) {
+        size_t count = bytes / sizeof(float);
+        count -= count % channels_;
+        if (convertBuffer_.size() < count) convertBuffer_.resize(count);
+        audio_dsp_float_to_int16(reinterpret_cast<const float*>(pcm), convertBuffer_.data(), count, &dither_);
+        AppendFrames(convertBuffer_.data(), count / channels_, emit, context);
+    } else {
+        AppendFrames(reinterpret_cast<const int16_t*>(pcm), bytes / (sizeof(int16_t) * channels_), emit, context);
+    }
+}
+
+void FlacEncoder::Flush(PacketCallback emit, void* context) {
+    if (!headerSent_) EmitStreamHeader(emit, context);
+
+    // The last frame of a fixed-blocksize stream may be short
+    if (blockFill_ > 0) {
+        EncodeFrame(blockFill_, emit, context);
+        blockFill_ = 0;
+    }
+}
+
+void FlacEncoder::EmitStreamHeader(PacketCallback emit, void* context) {
+    writer_.Reset();
+    writer_.Write(0x664C6143u, 32);         // "fLaC"
+
+    // STREAMINFO, the only (so last) metadata block
+    writer_.Write(1, 1);
+    writer_.Write(0, 7);
+    writer_.Write(34, 24);
+    writer_.Write(kBlockSize, 16);          // Min block size
+    writer_.Write(kBlockSize, 16);          // Max block size
+    writer_.Write(0, 24);                   // Min frame size: unknown
+    writer_.Write(0, 24);                   // Max frame size: unknown
+    writer_.Write(sampleRate_, 20);
+    writer_.Write(channels_ - 1, 3);
+    writer_.Write(16 - 1, 5);
+    writer_.Write(0, 4);                    // Total samples: unknown while streaming
+    writer_.Write(0, 32);
+    for (int i = 0; i < 4; i++) {
+        writer_.Write(0, 32);               // MD5: not computed
+    }
+
+    emit(writer_.Data(), writer_.ByteCount(), context);
+    headerSent_ = true;
+}
+
+void FlacEncoder::AppendFrames(const int16_t* samples, size_t frames, PacketCallback emit, void* context) {
+    while (frames > 0) {
+        size_t take = std::min<size_t>(frames, kBlockSize - blockFill_);
+        for (uint32_t c = 0; c < channels_; c++) {
+            int32_t* plane = &block_[static_cast<size_t>(c) * kBlockSize + blockFill_];
+            for (size_t i = 0; i < take; i++) {
+                plane[i] = samples[i * channels_ + c];
+            }
+        }
+        samples += take * channels_;
+        frames -= take;
+        blockFill_ += take;
+
+        if (blockFill_ == kBlockSize) {
+            EncodeFrame(kBlockSize, emit, context);
+            blockFill_ = 0;
+        }
+    }
+}
+
+void FlacEncoder::EncodeFrame(size_t frames, PacketCallback emit, void* context) {
+    // Pick the channel layout: independent, or one of the three stereo
+    // decorrelations, whichever needs the fewest bits
+    struct Channel {
+        const int32_t* samples;
+        uint32_t bps;
+        SubframePlan plan;
+    };
+    Channel subframes[8];
+    uint32_t assignment = channels_ - 1;
+
+    for (uint32_t c = 0; c < channels_; c++) {
+        subframes[c].samples = &block_[static_cast<size_t>(c) * kBlockSize];
+        subframes[c].bps = 16;
+        subframes[c].plan = PlanSubframe(subframes[c].samples, frames, 16);
+    }
+
+    if (channels_ == 2) {
+        const int32_t* left = subframes[0].samples;
+        const int32_t* right = subframes[1].samples;
+        for (size_t i = 0; i < frames; i++) {
+            mid_[i] = (left[i] + right[i]) >> 1;
+            side_[i] = left[i] - right[i];
+        }
+        SubframePlan midPlan = PlanSubframe(mid_.data(), frames, 16);
+        SubframePlan sidePlan = PlanSubframe(side_.data(), frames, 17);
+
+        uint64_t leftBits = subframes[0].plan.bits;
+        uint64_t rightBits = subframes[1].plan.bits;
+        uint64_t independent = leftBits + rightBits;
+        uint64_t leftSide = leftBits + sidePlan.bits;
+        uint64_t rightSide = sidePlan.bits + rightBits;
+        uint64_t midSide = midPlan.bits + sidePlan.bits;
+        uint64_t best = std::min(std::min(independent, leftSide), std::min(rightSide, midSide));
+
+        Channel side{side_.data(), 17, sidePlan};
+        if (best == midSide) {
+            assignment = 10;
+            subframes[0] = Channel{mid_.data(), 16, midPlan};
+            subframes[1] = side;
+        } else if (best == leftSide) {
+            assignment = 8;
+            subframes[1] = side;
+        } else if (best == rightSide) {
+            assignment = 9;
+            subframes[0] = side;
+        }
+    }
+
+    writer_.Reset();
+
+    // Frame header
+    uint32_t blockExtraBits;
+    uint32_t blockCode = BlockSizeCode(frames, &blockExtraBits);
+    uint32_t rateExtraBits;
+    uint32_t rateExtraValue;
+    uint32_t rateCode = SampleRateCode(sampleRate_, &rateExtraBits, &rateExtraValue);
+
+    writer_.Write(0xFFF8, 16);              // Sync code, fixed blocksize
+    writer_.Write(blockCode, 4);
+    writer_.Write(rateCode, 4);
+    writer_.Write(assignment, 4);
+    writer_.Write(4, 3);                    // 16 bits per sample
+    writer_.Write(0, 1);
+
+    // Frame number, UTF-8 style
+    uint64_t number = frameNumber_;
+    if (number < 0x80) {
+        writer_.Write(static_cast<uint32_t>(number), 8);
+    } else {
+        uint32_t continuation = 1;
+        while (continuation < 6 && number >= (1ull << (6 - continuation + 6 * continuation))) {
+            continuation++;
+        }
+        uint32_t leadBits = 6 - continuation;
+        uint32_t lead = (0xFF00u >> (continuation + 1)) & 0xFF;
+        writer_.Write(lead | (static_cast<uint32_t>(number >> (6 * continuation)) & Mask(leadBits)), 8);
+        for (uint32_t i = continuation; i-- > 0;) {
+            writer_.Write(0x80 | static_cast<uint32_t>((number >> (6 * i)) & 0x3F), 8);
+        }
+    }
+
+    writer_.Write(static_cast<uint32_t>(frames - 1), blockExtraBits);
+    writer_.Write(rateExtraValue, rateExtraBits);
+    writer_.Write(Crc8(writer_.Data(), writer_.ByteCount()), 8);
+
+    for (uint32_t c = 0; c < channels_; c++) {
+        WriteSubframe(subframes[c].samples, frames, subframes[c].bps, subframes[c].plan);
+    }
+
+    writer_.AlignToByte();
+    writer_.Write(Crc16(writer_.Data(), writer_.ByteCount()), 16);
+
+    emit(writer_.Data(), writer_.ByteCount(), context);
+    frameNumber_++;
+}
+
+FlacEncoder::SubframePlan FlacEncoder::PlanSubframe(const int32_t* samples, size_t count, uint32_t bps) {
+    SubframePlan plan;
+
+    bool constant = true;
+    for (size_t i = 1; i < count && constant; i++) {
+        constant = samples[i] == samples[0];
+    }
+    if (constant) {
+        plan.type = SubframePlan::Constant;
+        plan.bits = 8 + bps;
+        return plan;
+    }
+
+    plan.type = SubframePlan::Verbatim;
+    plan.bits = 8 + static_cast<uint64_t>(count) * bps;
+
+    // The smallest residual magnitude is a good proxy for the cheapest order
+    uint32_t maxOrder = static_cast<uint32_t>(std::min<size_t>(kMaxFixedOrder, count - 1));
+    uint32_t bestOrder = 0;
+    uint64_t bestSum = UINT64_MAX;
+    for (uint32_t order = 0; order <= maxOrder; order++) {
+        uint64_t sum = ComputeResidual(samples, count, order, residual_.data());
+        if (sum < bestSum) {
+            bestSum = sum;
+            bestOrder = order;
+        }
+    }
+
+    ComputeResidual(samples, count, bestOrder, residual_.data());
+    uint32_t partitionOrder = 0;
+    uint64_t bits = 8 + static_cast<uint64_t>(bestOrder) * bps + PlanResidual(count, bestOrder, &partitionOrder);
+    if (bits < plan.bits) {
+        plan.type = SubframePlan::Fixed;
+        plan.order = bestOrder;
+        plan.partitionOrder = partitionOrder;
+        plan.bits = bits;
+    }
+    return plan;
+}
+
+// Estimated residual size for the best Rice partitioning of residual_
+uint64_t FlacEncoder::PlanResidual(size_t count, uint32_t order, uint32_t* partitionOrder) {
+    uint64_t bestBits = UINT64_MAX;
+    *partitionOrder = 0;
+
+    for (uint32_t p = 0; p <= kMaxPartitionOrder; p++) {
+        size_t partitionSize = count >> p;
+        if ((partitionSize << p) != count || partitionSize <= order) break;
+
+        uint64_t bits = 2 + 4;
+        const uint32_t* u = residual_.data();
+        for (size_t j = 0; j < (static_cast<size_t>(1) << p); j++) {
+            size_t n = j == 0 ? partitionSize - order : partitionSize;
+            uint64_t sum = 0;
+            for (size_t i = 0; i < n; i++) sum += u[i];
+            u += n;
+
+            uint32_t k = RiceParameter(sum, n);
+            bits += 4 + static_cast<uint64_t>(n) * (k + 1) + (sum >> k);
+        }
+
+        if (bits < bestBits) {
+            bestBits = bits;
+            *partitionOrder = p;
+        }
+    }
+    return bestBits;
+}
+
+void FlacEncoder::WriteSubframe(const int32_t* samples, size_t count, uint32_t bps, const SubframePlan& plan) {
+    writer_.Write(0, 1);
+
+    switch (plan.type) {
+        case SubframePlan::Constant:
+            writer_.Write(0, 6);
+            writer_.Write(0, 1);
+            writer_.Write(static_cast<uint32_t>(samples[0]), bps);
+            return;
+
+        case SubframePlan::Verbatim:
+            writer_.Write(1, 6);
+            writer_.Write(0, 1);
+            for (size_t i = 0; i < count; i++) {
+                writer_.Write(static_cast<uint32_t>(samples[i]), bps);
+            }
+            return;
+
+        case SubframePlan::Fixed:
+            break;
+    }
+
+    writer_.Write(8 | plan.order, 6);
+    writer_.Write(0, 1);
+    for (uint32_t i = 0; i < plan.order; i++) {
+        writer_.Write(static_cast<uint32_t>(samples[i]), bps);
+    }
+
+    ComputeResidual(samples, count, plan.order, residual_.data());
+
+    writer_.Write(0, 2);                    // Rice coding, 4-bit parameters
+    writer_.Write(plan.partitionOrder, 4);
+
+    size_t partitionSize = count >> plan.partitionOrder;
+    const uint32_t* u = residual_.data();
+    for (size_t j = 0; j < (static_cast<size_t>(1) << plan.partitionOrder); j++) {
+        size_t n = j == 0 ? partitionSize - plan.order : partitionSize;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; i++) sum += u[i];
+
+        uint32_t k = RiceParameter(sum, n);
+        writer_.Write(k, 4);
+        for (size_t i = 0; i < n; i++) {
+            writer_.WriteUnary(u[i] >> k);
+            writer_.Write(u[i], k);
+        }
+        u += n;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "audio_dsp.h"
+#include "audio_encoder.h"
+
+// ============================================================================
+// FlacEncoder - self-contained 16-bit FLAC stream encoder
+//
+// Produces a standard native FLAC stream: the first packet is the "fLaC"
+// marker plus STREAMINFO, every following packet is one complete frame.
+// Frames use fixed blocksize, fixed polynomial predictors (orders 0-4) with
+// partitioned Rice residuals, and stereo decorrelation chosen per frame. This
+// is what `flac -1`..`-2` does; LPC would buy another few percent at several
+// times the CPU cost. Float input is dithered to 16 bits.
+// ============================================================================
+
+class FlacEncoder : public AudioEncoder {
+public:
+    // Channels must be 1-8 and the rate a positive integer below 655350 Hz
+    static bool Supports(const PcmFormat& input);
+
+    FlacEncoder(const PcmFormat& input, size_t maxChunkFrames);
+
+    const char* Name() const override { return "flac"; }
+    uint32_t BitsPerChannel() const override { return 16; }
+
+    void Encode(const uint8_t* pcm, size_t bytes, PacketCallback emit, void* context) override;
+    void Flush(PacketCallback emit, void* context) override;
+
+    static constexpr uint32_t kBlockSize = 4096;
+
+private:
+    class BitWriter {
+    public:
+        void Reset() { bytes_.clear(); accumulator_ = 0; pending_ = 0; }
+        void Reserve(size_t bytes) { bytes_.reserve(bytes); }
+        void Write(uint32_t value, uint32_t bits);
+        void WriteUnary(uint32_t zeros);
+        void AlignToByte();
+        size_t ByteCount() const { return bytes_.size(); }
+        const uint8_t* Data() const { return bytes_.data(); }
+        uint8_t* Data() { return bytes_.data(); }
+
+    private:
+        std::vector<uint8_t> bytes_;
+        uint64_t accumulator_ = 0;
+        uint32_t pending_ = 0;      // Bits held in accumulator_
+    };
+
+    struct SubframePlan {
+        enum Type { Constant, Verbatim, Fixed } type = Verbatim;
+        uint32_t order = 0;
+        uint32_t partitionOrder = 0;
+        uint64_t bits = 0;
+    };
+
+    void EmitStreamHeader(PacketCallback emit, void* context);
+    void AppendFrames(const int16_t* samples, size_t frames, PacketCallback emit, void* context);
+    void EncodeFrame(size_t frames, PacketCallback emit, void* context);
+
+    SubframePlan PlanSubframe(const int32_t* samples, size_t count, uint32_t bps);
+    void WriteSubframe(const int32_t* samples, size_t count, uint32_t bps, const SubframePlan& plan);
+    uint64_t PlanResidual(size_t count, uint32_t order, uint32_t* partitionOrder);
+
+    PcmFormat input_;
+    uint32_t channels_;
+    uint32_t sampleRate_;
+    bool headerSent_ = false;
+    uint64_t frameNumber_ = 0;
+
+    // Planar block being filled; channel c starts at c * kBlockSize
+    std::vector<int32_t> block_;
+    size_t blockFill_ = 0;
+
+    // Mid/side candidates for stereo and the residual of the order being planned
+    std::vector<int32_t> mid_;
+    std::vector<int32_t> side_;
+    std::vector<uint32_t> residual_;
+
+    std::vector<int16_t> convertBuffer_;
+    AudioDspDitherState dither_;
+    BitWriter writer_;
+};
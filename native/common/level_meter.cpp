@@ -0,0 +1,143 @@
+#include "level_meter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "audio_dsp.h"
+
+namespace {
+
+constexpr double kLowBandHz = 250;
+constexpr double kHighBandHz = 4000;
+
+// Frames measured per kernel call: bounds the scratch buffers and keeps the
+// kernel's float sums short before they are folded into doubles
+constexpr size_t kBlockFrames = 256;
+
+}  // namespace
+
+bool LevelMeter::Supports(const PcmFormat& format) {
+    bool pcm = (format.isFloat && format.bitsPerChannel == 32) || (!format.isFloat && format.bitsPerChannel == 16);
+    return pcm && format.channels > 0 && format.sampleRate > 0;
+}
+
+LevelMeter::LevelMeter(const LevelMeterOptions& options, const PcmFormat& format)
+    : options_(options),
+      format_(format),
+      frameBytes_(static_cast<size_t>(format.channels) * (format.bitsPerChannel / 8)),
+      nsPerFrame_(1e9 / format.sampleRate),
+      windowFrames_(std::max<uint64_t>(std::llround(format.sampleRate * options.intervalMs / 1000.0), 1)),
+      sumSquares_(format.channels, 0.0),
+      peaks_(format.channels, 0.0f),
+      lowBand_(Biquad::LowPass(kLowBandHz, format.sampleRate)),
+      midHighPass_(Biquad::HighPass(kLowBandHz, format.sampleRate)),
+      midLowPass_(Biquad::LowPass(kHighBandHz, format.sampleRate)),
+      highBand_(Biquad::HighPass(kHighBandHz, format.sampleRate)),
+      block_(kBlockFrames * format.channels, 0.0f),
+      blockSquares_(format.channels, 0.0f),
+      blockPeaks_(format.channels, 0.0f),
+      rms_(format.channels, 0.0f),
+      peak_(format.channels, 0.0f) {}
+
+void LevelMeter::Process(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info, ReadingCallback callback,
+                         void* context) {
+    const size_t frames = bytes / frameBytes_;
+    const size_t channels = format_.channels;
+    const bool aligned = reinterpret_cast<uintptr_t>(pcm) % alignof(float) == 0;
+
+    size_t done = 0;
+    while (done < frames) {
+        if (windowCount_ == 0) {
+            windowStart_ = info.framePosition + done;
+            windowHostTimeNs_ = 0;
+            if (info.hostTimeNs != 0) {
+                windowHostTimeNs_ = info.hostTimeNs + static_cast<uint64_t>(std::llround(done * nsPerFrame_));
+            }
+        }
+
+        size_t n = std::min<size_t>({frames - done, static_cast<size_t>(windowFrames_ - windowCount_), kBlockFrames});
+        const uint8_t* src = pcm + done * frameBytes_;
+        const float* samples = block_.data();
+        if (format_.isFloat && aligned) {
+            samples = reinterpret_cast<const float*>(src);
+        } else if (format_.isFloat) {
+            memcpy(block_.data(), src, n * frameBytes_);
+        } else {
+            for (size_t i = 0; i < n * channels; i++) {
+                int16_t v;
+                memcpy(&v, src + i * sizeof(int16_t), sizeof(v));
+                block_[i] = v * (1.0f / 32768.0f);
+            }
+        }
+
+        Measure(samples, n);
+        windowCount_ += n;
+        done += n;
+        if (windowCount_ == windowFrames_) {
+            Report(callback, context);
+        }
+    }
+}
+
+void LevelMeter::Finish(ReadingCallback callback, void* context) {
+    if (windowCount_ > 0) {
+        Report(callback, context);
+    }
+}
+
+void LevelMeter::Measure(const float* samples, size_t frames) {
+    const uint32_t channels = format_.channels;
+    audio_dsp_channel_levels(samples, frames, channels, blockSquares_.data(), blockPeaks_.data());
+    for (uint32_t c = 0; c < channels; c++) {
+        sumSquares_[c] += blockSquares_[c];
+        peaks_[c] = std::max(peaks_[c], blockPeaks_[c]);
+    }
+
+    if (!options_.bands) return;
+
+    const float scale = 1.0f / static_cast<float>(channels);
+    for (size_t i = 0; i < frames; i++) {
+        const float* frame = samples + i * channels;
+        float mono = 0;
+        for (uint32_t c = 0; c < channels; c++) {
+            mono += frame[c];
+        }
+        mono *= scale;
+
+        float low = lowBand_.Process(mono);
+        float mid = midLowPass_.Process(midHighPass_.Process(mono));
+        float high = highBand_.Process(mono);
+        bandSquares_[0] += static_cast<double>(low) * low;
+        bandSquares_[1] += static_cast<double>(mid) * mid;
+        bandSquares_[2] += static_cast<double>(high) * high;
+    }
+}
+
+void LevelMeter::Report(ReadingCallback callback, void* context) {
+    const uint32_t channels = format_.channels;
+    const double count = static_cast<double>(windowCount_);
+    for (uint32_t c = 0; c < channels; c++) {
+        rms_[c] = static_cast<float>(std::sqrt(sumSquares_[c] / count));
+        peak_[c] = peaks_[c];
+        sumSquares_[c] = 0;
+        peaks_[c] = 0;
+    }
+    for (uint32_t b = 0; b < kBands; b++) {
+        bandRms_[b] = static_cast<float>(std::sqrt(bandSquares_[b] / count));
+        bandSquares_[b] = 0;
+    }
+
+    LevelReading reading;
+    reading.framePosition = windowStart_;
+    reading.hostTimeNs = windowHostTimeNs_;
+    reading.frames = static_cast<uint32_t>(windowCount_);
+    reading.channels = channels;
+    reading.bandCount = options_.bands ? kBands : 0;
+    reading.rms = rms_.data();
+    reading.peak = peak_.data();
+    reading.bands = bandRms_;
+    windowCount_ = 0;
+
+    callback(reading, context);
+}
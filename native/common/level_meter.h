@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "audio_chunk_info.h"
+#include "audio_encoder.h"
+#include "biquad.h"
+
+// ============================================================================
+// LevelMeter - per-channel RMS and peak levels at a fixed reporting rate
+//
+// Runs first on whichever thread delivers chunks, ahead of the voice activity
+// gate and the encoder, so it always measures the capture format. Chunks are
+// cut into windows of intervalMs regardless of chunk size; each completed
+// window produces one reading. Levels are linear, 1.0 being full scale.
+//
+// Optional band levels split the mono mix into low (below 250 Hz), mid
+// (250-4000 Hz) and high (above 4000 Hz) with biquads. They cost a few
+// multiplies per frame, so they are off unless asked for.
+// ============================================================================
+
+struct LevelMeterOptions {
+    double intervalMs = 33;     // Window per reading; about 30 readings a second
+    bool bands = false;         // Also report low/mid/high band levels
+    bool pcm = true;            // Keep delivering chunks; otherwise only readings
+};
+
+struct LevelReading {
+    uint64_t framePosition;     // First frame of the window
+    uint64_t hostTimeNs;        // Host time of that frame, 0 if unknown
+    uint32_t frames;            // Window length; short only for the final reading
+    uint32_t channels;
+    uint32_t bandCount;         // 0, or LevelMeter::kBands
+    const float* rms;           // [channels]
+    const float* peak;          // [channels]
+    const float* bands;         // [bandCount], RMS of each band of the mono mix
+};
+
+class LevelMeter {
+public:
+    static constexpr uint32_t kBands = 3;
+
+    typedef void (*ReadingCallback)(const LevelReading& reading, void* context);
+
+    // 32-bit float and 16-bit integer PCM
+    static bool Supports(const PcmFormat& format);
+
+    LevelMeter(const LevelMeterOptions& options, const PcmFormat& format);
+
+    // Measure one interleaved chunk, reporting every window it completes
+    void Process(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info, ReadingCallback callback,
+                 void* context);
+
+    // End of stream: report the partial window, if any
+    void Finish(ReadingCallback callback, void* context);
+
+private:
+    void Measure(const float* samples, size_t frames);
+    void Report(ReadingCallback callback, void* context);
+
+    LevelMeterOptions options_;
+    PcmFormat format_;
+    size_t frameBytes_;
+    double nsPerFrame_;
+    uint64_t windowFrames_;
+
+    // Current window
+    uint64_t windowStart_ = 0;
+    uint64_t windowHostTimeNs_ = 0;
+    uint64_t windowCount_ = 0;
+    std::vector<double> sumSquares_;
+    std::vector<float> peaks_;
+    double bandSquares_[kBands] = {};
+
+    // Band filters over the mono mix
+    Biquad lowBand_;
+    Biquad midHighPass_;
+    Biquad midLowPass_;
+    Biquad highBand_;
+
+    // Scratch, sized up front: block-wise conversion of 16-bit or unaligned
+    // input, the kernel's per-block results, and the reading handed out
+    std::vector<float> block_;
+    std::vector<float> blockSquares_;
+    std::vector<float> blockPeaks_;
+    std::vector<float> rms_;
+    std::vector<float> peak_;
+    float bandRms_[kBands] = {};
+};
@@ -0,0 +1,134 @@
+#include "pre_roll_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "audio_dsp.h"
+
+namespace {
+
+// Frames converted per audio_dsp call when narrowing float input
+constexpr size_t kBlockFrames = 256;
+
+}  // namespace
+
+bool PreRollBuffer::Supports(const PcmFormat& format) {
+    bool pcm = (format.isFloat && format.bitsPerChannel == 32) || (!format.isFloat && format.bitsPerChannel == 16);
+    return pcm && format.channels > 0 && format.sampleRate > 0;
+}
+
+PreRollBuffer::PreRollBuffer(const PreRollOptions& options, const PcmFormat& format, size_t chunkFrames)
+    : format_(format),
+      narrow_(format.isFloat && options.int16),
+      inputFrameBytes_(static_cast<size_t>(format.channels) * (format.bitsPerChannel / 8)),
+      storedFrameBytes_(narrow_ ? format.channels * sizeof(int16_t) : inputFrameBytes_),
+      nsPerFrame_(1e9 / format.sampleRate),
+      capacity_(std::max<uint64_t>(FramesFor(options.durationMs), 1)),
+      chunkFrames_(std::max<size_t>(chunkFrames, 1)) {
+    storage_.assign(capacity_ * storedFrameBytes_, 0);
+    chunk_.assign(chunkFrames_ * inputFrameBytes_, 0);
+    if (narrow_) {
+        block_.assign(kBlockFrames * format.channels, 0.0f);
+        narrowed_.assign(kBlockFrames * format.channels, 0);
+    }
+}
+
+uint64_t PreRollBuffer::FramesFor(double ms) const {
+    if (!(ms > 0)) return 0;
+    double frames = ms * format_.sampleRate / 1000.0;
+    return frames >= 1.8e19 ? UINT64_MAX : static_cast<uint64_t>(std::llround(frames));
+}
+
+void PreRollBuffer::Push(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info) {
+    size_t frames = bytes / inputFrameBytes_;
+    if (frames == 0) return;
+
+    if (count_ > 0 && info.framePosition != endFrame_) {
+        count_ = 0;
+    }
+
+    // Only the newest capacity_ frames of an oversized chunk can survive
+    if (frames > capacity_) {
+        pcm += (frames - capacity_) * inputFrameBytes_;
+        frames = static_cast<size_t>(capacity_);
+    }
+
+    Store(pcm, frames);
+    count_ = std::min(count_ + frames, capacity_);
+    endFrame_ = info.framePosition + bytes / inputFrameBytes_;
+    endHostTimeNs_ = 0;
+    if (info.hostTimeNs != 0) {
+        uint64_t duration = static_cast<uint64_t>(std::llround((bytes / inputFrameBytes_) * nsPerFrame_));
+        endHostTimeNs_ = info.hostTimeNs + duration;
+    }
+}
+
+void PreRollBuffer::Flush(uint64_t frames, ChunkCallback chunk, void* context) {
+    uint64_t remaining = std::min(frames, count_);
+    uint64_t index = (write_ + capacity_ - remaining) % capacity_;
+
+    while (remaining > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, chunkFrames_));
+        Load(index, n, chunk_.data());
+
+        AudioChunkInfo info = {};
+        info.framePosition = endFrame_ - remaining;
+        if (endHostTimeNs_ != 0) {
+            uint64_t back = static_cast<uint64_t>(std::llround(remaining * nsPerFrame_));
+            info.hostTimeNs = endHostTimeNs_ > back ? endHostTimeNs_ - back : 0;
+        }
+        chunk(chunk_.data(), n * inputFrameBytes_, info, context);
+
+        index = (index + n) % capacity_;
+        remaining -= n;
+    }
+    count_ = 0;
+}
+
+void PreRollBuffer::Store(const uint8_t* pcm, size_t frames) {
+    while (frames > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(frames, capacity_ - write_));
+        uint8_t* dest = storage_.data() + write_ * storedFrameBytes_;
+
+        if (!narrow_) {
+            memcpy(dest, pcm, n * storedFrameBytes_);
+        } else {
+            for (size_t done = 0; done < n;) {
+                size_t block = std::min(n - done, kBlockFrames);
+                size_t samples = block * format_.channels;
+                memcpy(block_.data(), pcm + done * inputFrameBytes_, block * inputFrameBytes_);
+                audio_dsp_float_to_int16(block_.data(), narrowed_.data(), samples, nullptr);
+                memcpy(dest + done * storedFrameBytes_, narrowed_.data(), samples * sizeof(int16_t));
+                done += block;
+            }
+        }
+
+        pcm += n * inputFrameBytes_;
+        frames -= n;
+        write_ = (write_ + n) % capacity_;
+    }
+}
+
+void PreRollBuffer::Load(uint64_t index, size_t frames, uint8_t* out) {
+    while (frames > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(frames, capacity_ - index));
+        const uint8_t* src = storage_.data() + index * storedFrameBytes_;
+
+        if (!narrow_) {
+            memcpy(out, src, n * storedFrameBytes_);
+        } else {
+            size_t samples = n * format_.channels;
+            for (size_t i = 0; i < samples; i++) {
+                int16_t v;
+                memcpy(&v, src + i * sizeof(int16_t), sizeof(v));
+                float f = v * (1.0f / 32768.0f);
+                memcpy(out + i * sizeof(float), &f, sizeof(f));
+            }
+        }
+
+        out += n * inputFrameBytes_;
+        frames -= n;
+        index = (index + n) % capacity_;
+    }
+}
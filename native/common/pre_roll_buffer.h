@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "audio_chunk_info.h"
+#include "audio_encoder.h"
+
+// ============================================================================
+// PreRollBuffer - bounded history of an armed recording
+//
+// While a recording is armed, its chunks are appended here instead of being
+// delivered; the oldest frames are overwritten once durationMs is full, so
+// memory stays fixed however long the recorder waits. Committing flushes the
+// most recent part of the history as ordinary chunks, carrying the frame
+// positions and host times they were captured with, and the stream goes live.
+//
+// Float input can be stored as 16-bit to halve the footprint; it is widened
+// back to float on the way out. All storage is allocated up front, so Push and
+// Flush are safe on the capture thread.
+// ============================================================================
+
+struct PreRollOptions {
+    double durationMs = 2000;   // History kept while armed
+    bool int16 = false;         // Store float input as 16-bit PCM
+};
+
+class PreRollBuffer {
+public:
+    typedef void (*ChunkCallback)(const uint8_t* data, size_t size, const AudioChunkInfo& info, void* context);
+
+    // 32-bit float and 16-bit integer PCM
+    static bool Supports(const PcmFormat& format);
+
+    // chunkFrames bounds the chunks Flush delivers
+    PreRollBuffer(const PreRollOptions& options, const PcmFormat& format, size_t chunkFrames);
+
+    // Append one interleaved chunk. A gap in frame positions drops the history
+    // before it, whose timing no longer lines up with what follows.
+    void Push(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info);
+
+    // Deliver the last `frames` frames held (or fewer), oldest first, in the
+    // input format; the buffer is empty afterwards
+    void Flush(uint64_t frames, ChunkCallback chunk, void* context);
+
+    uint64_t FramesFor(double ms) const;
+    uint64_t BufferedFrames() const { return count_; }
+
+private:
+    void Store(const uint8_t* pcm, size_t frames);
+    void Load(uint64_t index, size_t frames, uint8_t* out);
+
+    PcmFormat format_;
+    bool narrow_;               // Float input stored as int16
+    size_t inputFrameBytes_;
+    size_t storedFrameBytes_;
+    double nsPerFrame_;
+
+    std::vector<uint8_t> storage_;
+    uint64_t capacity_;         // Frames
+    uint64_t write_ = 0;        // Next frame slot
+    uint64_t count_ = 0;
+
+    uint64_t endFrame_ = 0;         // Position just past the newest frame
+    uint64_t endHostTimeNs_ = 0;    // Its host time, 0 if the chunks had none
+
+    size_t chunkFrames_;
+    std::vector<uint8_t> chunk_;    // One delivered chunk in the input format
+    std::vector<float> block_;      // Staging for the int16 conversion
+    std::vector<int16_t> narrowed_;
+};
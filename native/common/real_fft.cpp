@@ -0,0 +1,207 @@
+#include "real_fft.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifdef __APPLE__
+#include <Accelerate/Accelerate.h>
+#else
+#include "audio_dsp.h"
+#endif
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+size_t Log2(size_t size) {
+    size_t bits = 0;
+    while ((size_t(1) << bits) < size) {
+        bits++;
+    }
+    return bits;
+}
+
+}  // namespace
+
+bool RealFft::Supports(size_t size) {
+    return size >= kMinSize && size <= kMaxSize && (size & (size - 1)) == 0;
+}
+
+#ifdef __APPLE__
+
+RealFft::RealFft(size_t size)
+    : size_(size), half_(size / 2), re_(half_, 0.0f), im_(half_, 0.0f), log2Size_(Log2(size)) {
+    setup_ = vDSP_create_fftsetup(static_cast<vDSP_Length>(log2Size_), kFFTRadix2);
+}
+
+RealFft::~RealFft() {
+    if (setup_) {
+        vDSP_destroy_fftsetup(static_cast<FFTSetup>(setup_));
+    }
+}
+
+void RealFft::Power(const float* in, float* power) {
+    DSPSplitComplex split = {re_.data(), im_.data()};
+    vDSP_ctoz(reinterpret_cast<const DSPComplex*>(in), 2, &split, 1, half_);
+    vDSP_fft_zrip(static_cast<FFTSetup>(setup_), &split, 1, static_cast<vDSP_Length>(log2Size_), FFT_FORWARD);
+
+    // zrip leaves every bin doubled, with the Nyquist bin's real part in
+    // imagp[0]
+    const float dc = re_[0] * 0.5f;
+    const float nyquist = im_[0] * 0.5f;
+    DSPSplitComplex rest = {re_.data() + 1, im_.data() + 1};
+    vDSP_zvmags(&rest, 1, power + 1, 1, half_ - 1);
+    const float quarter = 0.25f;
+    vDSP_vsmul(power + 1, 1, &quarter, power + 1, 1, half_ - 1);
+    power[0] = dc * dc;
+    power[half_] = nyquist * nyquist;
+}
+
+void RealFft::Forward(const float* in, float* re, float* im) {
+    DSPSplitComplex split = {re_.data(), im_.data()};
+    vDSP_ctoz(reinterpret_cast<const DSPComplex*>(in), 2, &split, 1, half_);
+    vDSP_fft_zrip(static_cast<FFTSetup>(setup_), &split, 1, static_cast<vDSP_Length>(log2Size_), FFT_FORWARD);
+
+    const float half = 0.5f;
+    vDSP_vsmul(re_.data(), 1, &half, re, 1, half_);
+    vDSP_vsmul(im_.data(), 1, &half, im, 1, half_);
+    re[half_] = im[0];
+    im[0] = 0.0f;
+    im[half_] = 0.0f;
+}
+
+void RealFft::Inverse(const float* re, const float* im, float* out) {
+    memcpy(re_.data(), re, half_ * sizeof(float));
+    memcpy(im_.data(), im, half_ * sizeof(float));
+    im_[0] = re[half_];
+
+    // The inverse of a true spectrum comes out size times too large
+    DSPSplitComplex split = {re_.data(), im_.data()};
+    vDSP_fft_zrip(static_cast<FFTSetup>(setup_), &split, 1, static_cast<vDSP_Length>(log2Size_), FFT_INVERSE);
+    vDSP_ztoc(&split, 1, reinterpret_cast<DSPComplex*>(out), 2, half_);
+    const float scale = 1.0f / static_cast<float>(size_);
+    vDSP_vsmul(out, 1, &scale, out, 1, size_);
+}
+
+#else
+
+RealFft::RealFft(size_t size)
+    : size_(size),
+      half_(size / 2),
+      re_(half_, 0.0f),
+      im_(half_, 0.0f),
+      reversed_(half_, 0),
+      twiddleRe_(half_ - 1, 0.0f),
+      twiddleIm_(half_ - 1, 0.0f),
+      splitRe_(half_ + 1, 0.0f),
+      splitIm_(half_ + 1, 0.0f) {
+    const size_t bits = Log2(half_);
+    for (size_t k = 0; k < half_; k++) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++) {
+            r |= ((k >> b) & 1) << (bits - 1 - b);
+        }
+        reversed_[k] = static_cast<uint32_t>(r);
+    }
+
+    for (size_t half = 1; half < half_; half *= 2) {
+        for (size_t k = 0; k < half; k++) {
+            double angle = -kPi * static_cast<double>(k) / static_cast<double>(half);
+            twiddleRe_[half - 1 + k] = static_cast<float>(std::cos(angle));
+            twiddleIm_[half - 1 + k] = static_cast<float>(std::sin(angle));
+        }
+    }
+
+    for (size_t k = 0; k <= half_; k++) {
+        double angle = -2.0 * kPi * static_cast<double>(k) / static_cast<double>(size_);
+        splitRe_[k] = static_cast<float>(std::cos(angle));
+        splitIm_[k] = static_cast<float>(std::sin(angle));
+    }
+}
+
+RealFft::~RealFft() = default;
+
+void RealFft::Transform(const float* in) {
+    // Even samples as the real part, odd as the imaginary, in the
+    // bit-reversed order the stages expect
+    for (size_t k = 0; k < half_; k++) {
+        size_t source = 2 * static_cast<size_t>(reversed_[k]);
+        re_[k] = in[source];
+        im_[k] = in[source + 1];
+    }
+    for (size_t half = 1; half < half_; half *= 2) {
+        audio_dsp_fft_stage(re_.data(), im_.data(), half_, half, twiddleRe_.data() + half - 1,
+                            twiddleIm_.data() + half - 1);
+    }
+}
+
+// X[k] = E[k] + exp(-2 pi i k / size) O[k], with the transforms of the even
+// and odd samples recovered from Z[k] and conj(Z[half - k])
+void RealFft::Bin(size_t k, float* re, float* im) const {
+    size_t a = k % half_;
+    size_t b = (half_ - k) % half_;
+    float zr = re_[a];
+    float zi = im_[a];
+    float cr = re_[b];
+    float ci = -im_[b];
+
+    float evenRe = 0.5f * (zr + cr);
+    float evenIm = 0.5f * (zi + ci);
+    float oddRe = 0.5f * (zi - ci);
+    float oddIm = -0.5f * (zr - cr);
+
+    *re = evenRe + splitRe_[k] * oddRe - splitIm_[k] * oddIm;
+    *im = evenIm + splitRe_[k] * oddIm + splitIm_[k] * oddRe;
+}
+
+void RealFft::Power(const float* in, float* power) {
+    Transform(in);
+    for (size_t k = 0; k <= half_; k++) {
+        float xr, xi;
+        Bin(k, &xr, &xi);
+        power[k] = xr * xr + xi * xi;
+    }
+}
+
+void RealFft::Forward(const float* in, float* re, float* im) {
+    Transform(in);
+    for (size_t k = 0; k <= half_; k++) {
+        Bin(k, &re[k], &im[k]);
+    }
+    im[0] = 0.0f;
+    im[half_] = 0.0f;
+}
+
+void RealFft::Inverse(const float* re, const float* im, float* out) {
+    // Back to Z[k] = E[k] + i O[k], stored conjugated and bit-reversed so
+    // that the forward stages compute the inverse transform
+    for (size_t k = 0; k < half_; k++) {
+        float ar = re[k];
+        float ai = k == 0 ? 0.0f : im[k];
+        float br = re[half_ - k];
+        float bi = k == 0 ? 0.0f : -im[half_ - k];
+
+        float evenRe = 0.5f * (ar + br);
+        float evenIm = 0.5f * (ai + bi);
+        float dr = 0.5f * (ar - br);
+        float di = 0.5f * (ai - bi);
+        float oddRe = dr * splitRe_[k] + di * splitIm_[k];
+        float oddIm = di * splitRe_[k] - dr * splitIm_[k];
+
+        size_t slot = reversed_[k];
+        re_[slot] = evenRe - oddIm;
+        im_[slot] = -(evenIm + oddRe);
+    }
+    for (size_t half = 1; half < half_; half *= 2) {
+        audio_dsp_fft_stage(re_.data(), im_.data(), half_, half, twiddleRe_.data() + half - 1,
+                            twiddleIm_.data() + half - 1);
+    }
+
+    const float scale = 1.0f / static_cast<float>(half_);
+    for (size_t n = 0; n < half_; n++) {
+        out[2 * n] = re_[n] * scale;
+        out[2 * n + 1] = -im_[n] * scale;
+    }
+}
+
+#endif
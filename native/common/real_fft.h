@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// RealFft - spectrum of a block of real samples, and back
+//
+// A power-of-two real transform computed as a complex transform of half the
+// size. On macOS it runs on vDSP; elsewhere on the radix-2 stages of
+// audio_dsp_fft_stage, which take the SIMD path for all but the first two
+// passes. Spectra are the unscaled DFT bins 0 .. size / 2 as split re / im
+// arrays. Everything is allocated up front; transforms are allocation-free.
+// ============================================================================
+
+class RealFft {
+public:
+    static constexpr size_t kMinSize = 16;
+    static constexpr size_t kMaxSize = 8192;
+
+    // size must be a power of two in [kMinSize, kMaxSize]
+    static bool Supports(size_t size);
+
+    explicit RealFft(size_t size);
+    ~RealFft();
+
+    RealFft(const RealFft&) = delete;
+    RealFft& operator=(const RealFft&) = delete;
+
+    size_t Size() const { return size_; }
+    size_t Bins() const { return size_ / 2 + 1; }
+
+    // |X[k]|^2 for k = 0 .. size / 2 of in[size], unnormalised, into
+    // power[Bins()]
+    void Power(const float* in, float* power);
+
+    // X[k] of in[size] into re[Bins()] / im[Bins()]
+    void Forward(const float* in, float* re, float* im);
+
+    // The samples whose Forward() is re / im, into out[size]. The imaginary
+    // parts of bins 0 and size / 2 are ignored.
+    void Inverse(const float* re, const float* im, float* out);
+
+private:
+#ifndef __APPLE__
+    // Transform of the packed input into re_ / im_, and the bin k of the
+    // real spectrum recovered from it
+    void Transform(const float* in);
+    void Bin(size_t k, float* re, float* im) const;
+#endif
+
+    size_t size_;
+    size_t half_;
+
+    // Split complex working data, half_ points each
+    std::vector<float> re_;
+    std::vector<float> im_;
+
+#ifdef __APPLE__
+    void* setup_ = nullptr;     // FFTSetup
+    size_t log2Size_ = 0;
+#else
+    // Bit-reversal order of the half-size transform, the twiddles of every
+    // stage back to back (stage `half` starts at index half - 1), and
+    // exp(-2 pi i k / size) for splitting the result into the real spectrum
+    std::vector<uint32_t> reversed_;
+    std::vector<float> twiddleRe_;
+    std::vector<float> twiddleIm_;
+    std::vector<float> splitRe_;
+    std::vector<float> splitIm_;
+#endif
+};
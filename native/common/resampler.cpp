@@ -0,0 +1,274 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Ratios needing more phases than this are approximated; the rate error of
+// the closest fraction within the limit is a few ppm, on par with clock drift
+constexpr uint32_t kMaxPhases = 1024;
+
+struct QualityParams {
+    uint32_t zeroCrossings;     // Per side, at the lower of the two rates
+    double stopbandDb;
+};
+
+QualityParams ParamsFor(ResamplerQuality quality) {
+    switch (quality) {
+        case ResamplerQuality::Fast: return {16, 60.0};
+        case ResamplerQuality::High: return {64, 100.0};
+        case ResamplerQuality::Balanced:
+        default: return {32, 80.0};
+    }
+}
+
+uint32_t Gcd(uint32_t a, uint32_t b) {
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Closest fraction up/down to num/den with up <= maxUp (continued fractions)
+void ApproximateRatio(uint32_t num, uint32_t den, uint32_t maxUp, uint32_t& up, uint32_t& down) {
+    uint64_t h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+    uint64_t n = num, d = den;
+    up = 1;
+    down = std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(static_cast<double>(den) / num)));
+    while (d) {
+        uint64_t a = n / d;
+        uint64_t h2 = a * h1 + h0;
+        uint64_t k2 = a * k1 + k0;
+        if (h2 > maxUp) break;
+        up = static_cast<uint32_t>(h2);
+        down = static_cast<uint32_t>(k2);
+        h0 = h1; h1 = h2;
+        k0 = k1; k1 = k2;
+        uint64_t r = n % d;
+        n = d;
+        d = r;
+    }
+}
+
+// Zeroth-order modified Bessel function of the first kind
+double BesselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = x / 2.0;
+    for (int k = 1; k < 64; k++) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+}  // namespace
+
+// ============================================================================
+// Filter design
+// ============================================================================
+
+std::shared_ptr<const Resampler::FilterBank> Resampler::GetFilterBank(uint32_t up, uint32_t down,
+                                                                      ResamplerQuality quality) {
+    static std::mutex mutex;
+    static std::map<std::tuple<uint32_t, uint32_t, int32_t>, std::shared_ptr<const FilterBank>> cache;
+
+    auto key = std::make_tuple(up, down, static_cast<int32_t>(quality));
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(key);
+    if (it != cache.end()) return it->second;
+
+    auto bank = DesignFilterBank(up, down, quality);
+    cache.emplace(key, bank);
+    return bank;
+}
+
+std::shared_ptr<const Resampler::FilterBank> Resampler::DesignFilterBank(uint32_t up, uint32_t down,
+                                                                         ResamplerQuality quality) {
+    QualityParams params = ParamsFor(quality);
+    auto bank = std::make_shared<FilterBank>();
+    bank->up = up;
+    bank->down = down;
+
+    // Filter length in input samples: enough zero crossings at the lower rate
+    double decimation = std::max(1.0, static_cast<double>(down) / up);
+    uint32_t taps = static_cast<uint32_t>(std::ceil(2.0 * params.zeroCrossings * decimation));
+    taps = (taps + 3) & ~3u;  // Whole SIMD vectors
+    bank->taps = taps;
+
+    // Kaiser design: the transition band ends exactly at the lower Nyquist
+    double beta = 0.1102 * (params.stopbandDb - 8.7);
+    double transition = (params.stopbandDb - 8.0) / (2.285 * taps) / (2.0 * kPi);  // Cycles per input sample
+    double stopband = 0.5 * std::min(1.0, static_cast<double>(up) / down);
+    double cutoff = std::max(stopband - transition / 2.0, stopband * 0.5);
+
+    size_t length = static_cast<size_t>(taps) * up;
+    double center = (length - 1) / 2.0;
+    double i0Beta = BesselI0(beta);
+
+    std::vector<double> prototype(length);
+    for (size_t n = 0; n < length; n++) {
+        double t = (n - center) / up;  // In input samples
+        double x = 2.0 * cutoff * t;
+        double sinc = std::fabs(x) < 1e-12 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+        double r = (n - center) / center;
+        double window = BesselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0Beta;
+        prototype[n] = 2.0 * cutoff * sinc * window;
+    }
+
+    // Split into phases, reversed so each output is a forward dot product over
+    // the input window, and normalise every phase to unity DC gain
+    bank->coefficients.resize(length);
+    for (uint32_t p = 0; p < up; p++) {
+        float* phase = &bank->coefficients[static_cast<size_t>(p) * taps];
+        double sum = 0.0;
+        for (uint32_t k = 0; k < taps; k++) {
+            sum += prototype[p + static_cast<size_t>(k) * up];
+        }
+        double scale = sum != 0.0 ? 1.0 / sum : 1.0;
+        for (uint32_t k = 0; k < taps; k++) {
+            phase[taps - 1 - k] = static_cast<float>(prototype[p + static_cast<size_t>(k) * up] * scale);
+        }
+    }
+
+    return bank;
+}
+
+// ============================================================================
+// Streaming
+// ============================================================================
+
+bool Resampler::Configure(double inputRate, double outputRate, uint32_t channels,
+                          ResamplerQuality quality, size_t maxInputFrames) {
+    bank_ = nullptr;
+    channels_ = std::max<uint32_t>(channels, 1);
+    maxInputFrames_ = std::max<size_t>(maxInputFrames, 1);
+    history_.clear();
+
+    if (!(inputRate > 0) || !(outputRate > 0)) return false;
+
+    uint32_t in = static_cast<uint32_t>(std::lround(inputRate));
+    uint32_t out = static_cast<uint32_t>(std::lround(outputRate));
+    if (in == 0 || out == 0) return false;
+    if (in == out) return true;  // Passthrough
+
+    uint32_t g = Gcd(in, out);
+    uint32_t up = out / g;
+    uint32_t down = in / g;
+    if (up > kMaxPhases) {
+        ApproximateRatio(out, in, kMaxPhases, up, down);
+    }
+
+    bank_ = GetFilterBank(up, down, quality);
+    dot_ = audio_dsp::ActiveKernels().dot;
+
+    stride_ = bank_->taps - 1 + maxInputFrames_;
+    history_.assign(stride_ * channels_, 0.0f);
+    Reset();
+    return true;
+}
+
+void Resampler::Reset() {
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    position_ = bank_ ? bank_->taps - 1 : 0;
+    phase_ = 0;
+}
+
+size_t Resampler::MaxOutputFrames(size_t inputFrames) const {
+    if (!bank_) return inputFrames;
+    // Each slice may produce one frame more than its exact share
+    size_t slices = (inputFrames + maxInputFrames_ - 1) / maxInputFrames_;
+    return (inputFrames * bank_->up + bank_->down - 1) / bank_->down + slices + 1;
+}
+
+size_t Resampler::Process(const float* input, size_t inputFrames, float* output) {
+    if (!bank_) {
+        memcpy(output, input, inputFrames * channels_ * sizeof(float));
+        return inputFrames;
+    }
+
+    size_t written = 0;
+    while (inputFrames > 0) {
+        size_t frames = std::min(inputFrames, maxInputFrames_);
+        written += ProcessBlock(input, frames, output + written * channels_);
+        input += frames * channels_;
+        inputFrames -= frames;
+    }
+    return written;
+}
+
+size_t Resampler::ProcessBlock(const float* input, size_t inputFrames, float* output) {
+    const uint32_t taps = bank_->taps;
+    const uint32_t up = bank_->up;
+    const uint32_t down = bank_->down;
+    const float* coefficients = bank_->coefficients.data();
+    const size_t context = taps - 1;
+
+    // Append the block after each channel's history
+    if (channels_ == 1) {
+        memcpy(&history_[context], input, inputFrames * sizeof(float));
+    } else {
+        float* planes[8];
+        for (uint32_t c0 = 0; c0 < channels_; c0 += 8) {
+            uint32_t count = std::min<uint32_t>(8, channels_ - c0);
+            for (uint32_t c = 0; c < count; c++) {
+                planes[c] = &history_[(c0 + c) * stride_ + context];
+            }
+            if (count == channels_) {
+                audio_dsp::ActiveKernels().deinterleave(input, planes, inputFrames, channels_);
+            } else {
+                for (size_t i = 0; i < inputFrames; i++) {
+                    for (uint32_t c = 0; c < count; c++) {
+                        planes[c][i] = input[i * channels_ + c0 + c];
+                    }
+                }
+            }
+        }
+    }
+
+    const size_t end = context + inputFrames;
+    size_t written = 0;
+
+    if (up == 1) {
+        // Integer decimation: one phase, fixed step
+        while (position_ < end) {
+            for (uint32_t c = 0; c < channels_; c++) {
+                const float* window = &history_[c * stride_ + position_ - context];
+                output[written * channels_ + c] = dot_(window, coefficients, taps);
+            }
+            written++;
+            position_ += down;
+        }
+    } else {
+        while (position_ < end) {
+            const float* phase = coefficients + static_cast<size_t>(phase_) * taps;
+            for (uint32_t c = 0; c < channels_; c++) {
+                const float* window = &history_[c * stride_ + position_ - context];
+                output[written * channels_ + c] = dot_(window, phase, taps);
+            }
+            written++;
+            phase_ += down;
+            position_ += phase_ / up;
+            phase_ %= up;
+        }
+    }
+
+    // Keep the last taps-1 samples as context for the next block
+    position_ -= inputFrames;
+    for (uint32_t c = 0; c < channels_; c++) {
+        float* plane = &history_[c * stride_];
+        memmove(plane, plane + inputFrames, context * sizeof(float));
+    }
+
+    return written;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "audio_dsp_kernels.h"
+
+// ============================================================================
+// Resampler - streaming polyphase windowed-sinc sample rate converter
+//
+// The rate ratio is reduced to up/down integers and each output sample is one
+// FIR dot product against a precomputed phase of a Kaiser-windowed sinc bank.
+// Filter history is kept per channel across calls, so packet boundaries are
+// seamless and channels never bleed into each other. Integer decimation
+// (48k -> 16k, 48k -> 24k) uses a single-phase path without phase stepping.
+//
+// Filter banks are shared between sessions with the same ratio and quality.
+// Configure() allocates; Process() never does.
+// ============================================================================
+
+enum class ResamplerQuality : int32_t {
+    Fast = 0,       // 16 zero crossings, ~60 dB stopband
+    Balanced = 1,   // 32 zero crossings, ~80 dB stopband
+    High = 2,       // 64 zero crossings, ~100 dB stopband
+};
+
+class Resampler {
+public:
+    // Prepare for interleaved input of `channels` channels, in calls of up to
+    // maxInputFrames frames (larger calls are processed in slices). Returns
+    // false if either rate is invalid.
+    bool Configure(double inputRate, double outputRate, uint32_t channels,
+                   ResamplerQuality quality, size_t maxInputFrames);
+
+    // Clear filter history, e.g. after a discontinuity in the input
+    void Reset();
+
+    bool IsPassthrough() const { return bank_ == nullptr; }
+
+    // Upper bound on frames Process() writes for inputFrames of input
+    size_t MaxOutputFrames(size_t inputFrames) const;
+
+    // Consume interleaved input and write interleaved output; returns frames
+    // written. In passthrough mode the input is copied unchanged.
+    size_t Process(const float* input, size_t inputFrames, float* output);
+
+private:
+    struct FilterBank {
+        uint32_t up = 1;        // Phases
+        uint32_t down = 1;      // Input step per output, in phases
+        uint32_t taps = 0;      // Taps per phase
+        std::vector<float> coefficients;  // Phase-major, each phase reversed
+    };
+
+    static std::shared_ptr<const FilterBank> GetFilterBank(uint32_t up, uint32_t down, ResamplerQuality quality);
+    static std::shared_ptr<const FilterBank> DesignFilterBank(uint32_t up, uint32_t down, ResamplerQuality quality);
+
+    size_t ProcessBlock(const float* input, size_t inputFrames, float* output);
+
+    std::shared_ptr<const FilterBank> bank_;
+    float (*dot_)(const float* a, const float* b, size_t count) = nullptr;
+
+    uint32_t channels_ = 1;
+    size_t maxInputFrames_ = 0;
+
+    // Per-channel planar history: taps-1 samples of context, then the block
+    std::vector<float> history_;
+    size_t stride_ = 0;
+
+    size_t position_ = 0;   // Index of the newest input sample for the next output
+    uint32_t phase_ = 0;
+};
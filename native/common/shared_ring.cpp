@@ -0,0 +1,62 @@
+#include "shared_ring.h"
+
+#include <cmath>
+#include <cstring>
+
+bool SharedRingWriter::Attach(uint8_t* memory, size_t bytes, const char** error) {
+    memory_ = nullptr;
+    if (!memory || bytes < kHeaderBytes + kMinCapacity) {
+        *error = "sharedRing is too small";
+        return false;
+    }
+    if (reinterpret_cast<uintptr_t>(memory) % sizeof(int32_t) != 0) {
+        *error = "sharedRing must be 4-byte aligned";
+        return false;
+    }
+
+    memory_ = memory;
+    size_t capacity = static_cast<uint32_t>(Load(kCapacity));
+    if (capacity < kMinCapacity || capacity > kMaxCapacity || (capacity & (capacity - 1)) != 0 ||
+        capacity > bytes - kHeaderBytes) {
+        memory_ = nullptr;
+        *error = "sharedRing has no valid header; create it with createSharedAudioRing()";
+        return false;
+    }
+
+    data_ = memory + kHeaderBytes;
+    capacity_ = capacity;
+    return true;
+}
+
+void SharedRingWriter::Begin(const PcmFormat& format) {
+    // Odd while the fields are inconsistent; readers retry until it is even
+    int32_t sequence = Load(kFormatSequence) | 1;
+    Store(kFormatSequence, sequence);
+    Store(kFormatPosition, Load(kWritePosition));
+    Store(kSampleRate, static_cast<int32_t>(std::lround(format.sampleRate)));
+    Store(kChannels, static_cast<int32_t>(format.channels));
+    Store(kBitsPerChannel, static_cast<int32_t>(format.bitsPerChannel));
+    Store(kIsFloat, format.isFloat ? 1 : 0);
+    Store(kFormatSequence, sequence + 1);
+}
+
+bool SharedRingWriter::Write(const uint8_t* data, size_t size) {
+    uint32_t w = static_cast<uint32_t>(Load(kWritePosition));
+    uint32_t r = static_cast<uint32_t>(Load(kReadPosition));
+
+    // A read position ahead of the write position can only come from a
+    // misbehaving consumer; treat the ring as full rather than overwrite
+    size_t used = static_cast<uint32_t>(w - r);
+    if (used > capacity_ || size > capacity_ - used) {
+        SlotAt(kDroppedChunks)->fetch_add(1);
+        return false;
+    }
+
+    size_t offset = w & (capacity_ - 1);
+    size_t first = size < capacity_ - offset ? size : capacity_ - offset;
+    memcpy(data_ + offset, data, first);
+    memcpy(data_, data + first, size - first);
+
+    Store(kWritePosition, static_cast<int32_t>(w + static_cast<uint32_t>(size)));
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "audio_encoder.h"
+
+// ============================================================================
+// SharedRingWriter - writes PCM into a ring in memory shared with JavaScript
+//
+// The memory is a SharedArrayBuffer owned by JS: a header of 32-bit slots,
+// read and written with sequentially consistent atomics like JS's Atomics,
+// followed by the data area. Positions are byte counts that wrap at 2^32;
+// the data area is a power of two in size, so a position's offset is
+// position & (capacity - 1) and the bytes readable are (write - read) mod
+// 2^32. The chunk thread is the
+// only writer of the write position and the consumer the only writer of the
+// read position, so neither side ever waits for the other.
+//
+// Chunks are written whole or not at all, so the data stays frame-aligned:
+// one that does not fit is dropped and counted. The format is published with
+// the write position it takes effect at, under a sequence number that is odd
+// while it is being written.
+//
+// The layout is mirrored by src/shared-audio-ring.ts and must stay in step.
+// ============================================================================
+
+class SharedRingWriter {
+public:
+    enum Slot : size_t {
+        kWritePosition = 0,
+        kReadPosition = 1,
+        kDroppedChunks = 2,
+        kState = 3,              // SharedRingState
+        kFormatSequence = 4,
+        kFormatPosition = 5,     // Write position the format applies from
+        kSampleRate = 6,
+        kChannels = 7,
+        kBitsPerChannel = 8,
+        kIsFloat = 9,
+        kCapacity = 10,          // Bytes in the data area, set by the creator
+        kSlotCount = 16,
+    };
+
+    enum State : int32_t {
+        kIdle = 0,
+        kCapturing = 1,
+        kStopped = 2,
+    };
+
+    static constexpr size_t kHeaderBytes = kSlotCount * sizeof(int32_t);
+    static constexpr size_t kMinCapacity = 1024;
+    static constexpr size_t kMaxCapacity = size_t(1) << 30;
+
+    // Checks that the memory holds a header and a data area of the capacity
+    // the header records; returns false with a message otherwise. The memory
+    // must stay valid and 4-byte aligned while the writer is in use.
+    bool Attach(uint8_t* memory, size_t bytes, const char** error);
+    void Detach() { memory_ = nullptr; }
+    bool Attached() const { return memory_ != nullptr; }
+
+    // Chunk thread: the format of the chunks that follow
+    void Begin(const PcmFormat& format);
+
+    // Chunk thread: append one chunk, or nothing if it doesn't fit. Never
+    // blocks, locks or allocates.
+    bool Write(const uint8_t* data, size_t size);
+
+    void SetState(State state) { Store(kState, state); }
+
+private:
+    std::atomic<int32_t>* SlotAt(Slot slot) const {
+        return reinterpret_cast<std::atomic<int32_t>*>(memory_ + slot * sizeof(int32_t));
+    }
+    int32_t Load(Slot slot) const { return SlotAt(slot)->load(); }
+    void Store(Slot slot, int32_t value) { SlotAt(slot)->store(value); }
+
+    uint8_t* memory_ = nullptr;
+    uint8_t* data_ = nullptr;
+    size_t capacity_ = 0;
+};
+
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t) && std::atomic<int32_t>::is_always_lock_free,
+              "shared ring slots must be plain lock-free 32-bit words, as JS Atomics see them");
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ============================================================================
+// SpscRing - bounded lock-free byte ring of variable-size records
+//
+// One producer thread writes records and one consumer thread reads them; no
+// locks, no allocation after construction. Each record is a 16-byte header
+// followed by its payload, padded to 16 bytes. Records never wrap: if one
+// doesn't fit before the end of storage, the producer writes a padding record
+// and continues at offset 0, so payloads are always contiguous.
+//
+// To support drop-oldest overflow the producer may also discard the record at
+// the read position. Both sides claim a record with a CAS on the read index,
+// so whoever wins owns it. The consumer copies a payload out *before* claiming
+// it and retries if the producer dropped the record in the meantime.
+// ============================================================================
+
+class SpscRing {
+public:
+    struct RecordHeader {
+        uint32_t type;
+        uint32_t size;      // Payload bytes, excluding header and padding
+        uint64_t seq;
+    };
+
+    struct Record {
+        RecordHeader header;    // Copy taken at Peek time
+        const uint8_t* payload;
+        uint64_t position;      // Read index of the record
+        uint64_t next;          // Read index just past the record
+    };
+
+    static constexpr uint32_t kPaddingType = 0xFFFFFFFFu;
+    static constexpr size_t kAlignment = sizeof(RecordHeader);
+
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacityBytes)
+        : capacity_(CapacityFor(capacityBytes)),
+          mask_(capacity_ - 1),
+          storage_(capacity_) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t Capacity() const { return capacity_; }
+
+    // Actual capacity a ring constructed with capacityBytes would have
+    static size_t CapacityFor(size_t capacityBytes) {
+        return RoundUpPow2(capacityBytes < 1024 ? 1024 : capacityBytes);
+    }
+
+    // Largest payload that always fits in an empty ring
+    size_t MaxPayload() const { return capacity_ / 2 - sizeof(RecordHeader); }
+
+    // Bytes taken by queued records, padding included
+    size_t Used() const {
+        return static_cast<size_t>(write_.load(std::memory_order_acquire) - read_.load(std::memory_order_acquire));
+    }
+
+    bool Empty() const {
+        return read_.load(std::memory_order_acquire) == write_.load(std::memory_order_acquire);
+    }
+
+    // ------------------------------------------------------------------------
+    // Producer
+    // ------------------------------------------------------------------------
+
+    // Reserve space for a payload. Returns nullptr if the ring is full; the
+    // caller then applies its overflow policy and may try again.
+    uint8_t* BeginWrite(size_t payloadBytes) {
+        size_t need = RecordBytes(payloadBytes);
+        uint64_t w = write_.load(std::memory_order_relaxed);
+        uint64_t r = read_.load(std::memory_order_acquire);
+
+        size_t offset = static_cast<size_t>(w & mask_);
+        size_t tail = capacity_ - offset;
+        size_t padding = need > tail ? tail : 0;
+
+        if (w + padding + need - r > capacity_) {
+            return nullptr;
+        }
+
+        if (padding) {
+            RecordHeader pad{kPaddingType, static_cast<uint32_t>(tail - sizeof(RecordHeader)), 0};
+            memcpy(&storage_[offset], &pad, sizeof(pad));
+            w += padding;
+            write_.store(w, std::memory_order_release);
+            offset = 0;
+        }
+
+        pending_ = w;
+        return &storage_[offset + sizeof(RecordHeader)];
+    }
+
+    // Publish the record reserved by the last BeginWrite()
+    void CommitWrite(uint32_t type, uint32_t payloadBytes, uint64_t seq) {
+        RecordHeader header{type, payloadBytes, seq};
+        memcpy(&storage_[pending_ & mask_], &header, sizeof(header));
+        write_.store(pending_ + RecordBytes(payloadBytes), std::memory_order_release);
+    }
+
+    // Discard the oldest record to make room (drop-oldest policy). The caller
+    // owns the returned record; its payload stays readable until the next
+    // BeginWrite(). Returns false if the ring is empty.
+    bool DropOldest(Record* dropped) {
+        uint64_t w = write_.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t r = read_.load(std::memory_order_acquire);
+            if (r == w) return false;
+
+            Record record;
+            if (!ReadAt(r, w, &record)) continue;
+
+            if (read_.compare_exchange_weak(r, record.next, std::memory_order_acq_rel)) {
+                if (record.header.type == kPaddingType) continue;
+                *dropped = record;
+                return true;
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // Consumer
+    // ------------------------------------------------------------------------
+
+    // Look at the oldest record without consuming it. Padding is skipped.
+    bool Peek(Record* record) {
+        for (;;) {
+            uint64_t r = read_.load(std::memory_order_acquire);
+            uint64_t w = write_.load(std::memory_order_acquire);
+            if (r == w) return false;
+
+            if (!ReadAt(r, w, record)) continue;
+
+            if (record->header.type == kPaddingType) {
+                read_.compare_exchange_weak(r, record->next, std::memory_order_acq_rel);
+                continue;
+            }
+            return true;
+        }
+    }
+
+    // Consume a record returned by Peek(). Returns false if the producer
+    // dropped it first, in which case anything copied from it is stale.
+    bool Claim(const Record& record) {
+        uint64_t expected = record.position;
+        return read_.compare_exchange_strong(expected, record.next, std::memory_order_acq_rel);
+    }
+
+private:
+    static size_t RoundUpPow2(size_t v) {
+        size_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    static size_t RecordBytes(size_t payloadBytes) {
+        return (sizeof(RecordHeader) + payloadBytes + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    // Decode the record at read index r. Fails if the header is inconsistent,
+    // which only happens when the producer overwrote it after a drop.
+    bool ReadAt(uint64_t r, uint64_t w, Record* record) const {
+        size_t offset = static_cast<size_t>(r & mask_);
+        memcpy(&record->header, &storage_[offset], sizeof(RecordHeader));
+
+        size_t bytes = RecordBytes(record->header.size);
+        if (offset + bytes > capacity_ || r + bytes > w) {
+            return false;
+        }
+
+        record->payload = &storage_[offset + sizeof(RecordHeader)];
+        record->position = r;
+        record->next = r + bytes;
+        return true;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::vector<uint8_t> storage_;
+
+    alignas(64) std::atomic<uint64_t> write_{0};
+    alignas(64) std::atomic<uint64_t> read_{0};
+    uint64_t pending_ = 0;  // Producer-only
+};
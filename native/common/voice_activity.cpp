@@ -0,0 +1,233 @@
+#include "voice_activity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr double kAnalysisMs = 10;
+constexpr double kBandLowHz = 250;
+constexpr double kBandHighHz = 3500;
+
+// Frames quieter than this are never speech, whatever the noise floor
+constexpr double kAbsoluteFloorDb = -65;
+
+// Share of a voiced frame's energy that has to be in the speech band
+constexpr double kMinBandRatio = 0.35;
+
+// Noise floor tracking per 10 ms frame: follow quieter frames quickly, louder
+// ones over several seconds so that sustained speech doesn't become the floor
+constexpr double kFloorFall = 0.2;
+constexpr double kFloorRise = 0.002;
+
+// Transitions recorded per chunk before the rest are coalesced
+constexpr size_t kMaxTransitions = 16;
+
+double EnergyDb(double energy, size_t samples) {
+    return 10.0 * std::log10(energy / static_cast<double>(std::max<size_t>(samples, 1)) + 1e-12);
+}
+
+uint64_t MsToFrames(double ms, double sampleRate) {
+    return ms > 0 ? static_cast<uint64_t>(std::llround(ms * sampleRate / 1000.0)) : 0;
+}
+
+}  // namespace
+
+bool VoiceActivityGate::Supports(const PcmFormat& format) {
+    bool pcm = (format.isFloat && format.bitsPerChannel == 32) || (!format.isFloat && format.bitsPerChannel == 16);
+    return pcm && format.channels > 0 && format.sampleRate > 0;
+}
+
+VoiceActivityGate::VoiceActivityGate(const VoiceActivityOptions& options, const PcmFormat& format)
+    : options_(options),
+      format_(format),
+      frameBytes_(static_cast<size_t>(format.channels) * (format.bitsPerChannel / 8)),
+      nsPerFrame_(1e9 / format.sampleRate),
+      highPass_(Biquad::HighPass(kBandLowHz, format.sampleRate)),
+      lowPass_(Biquad::LowPass(kBandHighHz, format.sampleRate)),
+      analysisFrames_(std::max<size_t>(static_cast<size_t>(format.sampleRate * kAnalysisMs / 1000.0), 1)),
+      minSpeechFrames_(MsToFrames(options.minSpeechMs, format.sampleRate)),
+      hangoverFrames_(MsToFrames(options.hangoverMs, format.sampleRate)),
+      preRollFrames_(options.speechOnly ? MsToFrames(options.preRollMs, format.sampleRate) : 0) {
+    transitions_.reserve(kMaxTransitions);
+}
+
+void VoiceActivityGate::Process(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info, ChunkCallback chunk,
+                                SpeechCallback speech, void* context) {
+    size_t frames = bytes / frameBytes_;
+    const uint64_t chunkStart = info.framePosition;
+    bool spoke = speaking_;
+    bool startedHere = false;
+    uint64_t speechStart = 0;
+    transitions_.clear();
+
+    for (size_t i = 0; i < frames; i++) {
+        float x = MonoSample(pcm + i * frameBytes_);
+        float band = lowPass_.Process(highPass_.Process(x));
+        totalEnergy_ += static_cast<double>(x) * x;
+        bandEnergy_ += static_cast<double>(band) * band;
+
+        if (++analysisCount_ < analysisFrames_) continue;
+
+        uint64_t frameEnd = chunkStart + i + 1;
+        bool wasSpeaking = speaking_;
+        UpdateState(ClassifyFrame(), frameEnd - analysisFrames_, frameEnd, info);
+        if (speaking_ && !wasSpeaking && !spoke) {
+            startedHere = true;
+            speechStart = voicedRunStart_;
+        }
+        spoke = spoke || speaking_;
+    }
+
+    // Ends are reported after the chunk that carries the speech's tail;
+    // everything before the last transition is reported first
+    bool trailingEnd = !transitions_.empty() && !transitions_.back().speaking;
+    size_t leading = transitions_.size() - (trailingEnd ? 1 : 0);
+    for (size_t i = 0; i < leading; i++) {
+        speech(transitions_[i].speaking, transitions_[i].framePosition, transitions_[i].hostTimeNs, context);
+    }
+
+    if (!options_.speechOnly) {
+        chunk(pcm, bytes, info, context);
+    } else if (spoke) {
+        if (startedHere) {
+            uint64_t from = speechStart > preRollFrames_ ? speechStart - preRollFrames_ : 0;
+            ReleaseHeld(from, chunk, context);
+        }
+        chunk(pcm, bytes, info, context);
+    } else if (preRollFrames_ > 0) {
+        Hold(pcm, bytes, info, frames);
+    }
+
+    if (trailingEnd) {
+        const Transition& end = transitions_.back();
+        speech(false, end.framePosition, end.hostTimeNs, context);
+    }
+}
+
+void VoiceActivityGate::Finish(SpeechCallback speech, void* context) {
+    if (speaking_) {
+        speaking_ = false;
+        speech(false, lastVoicedEnd_, 0, context);
+    }
+    inVoicedRun_ = false;
+    heldStart_ = 0;
+    heldCount_ = 0;
+    heldFrames_ = 0;
+}
+
+float VoiceActivityGate::MonoSample(const uint8_t* frame) const {
+    float sum = 0;
+    if (format_.isFloat) {
+        for (uint32_t c = 0; c < format_.channels; c++) {
+            float v;
+            memcpy(&v, frame + c * sizeof(float), sizeof(v));
+            sum += v;
+        }
+    } else {
+        for (uint32_t c = 0; c < format_.channels; c++) {
+            int16_t v;
+            memcpy(&v, frame + c * sizeof(int16_t), sizeof(v));
+            sum += v * (1.0f / 32768.0f);
+        }
+    }
+    return sum / static_cast<float>(format_.channels);
+}
+
+bool VoiceActivityGate::ClassifyFrame() {
+    double bandDb = EnergyDb(bandEnergy_, analysisCount_);
+    double ratio = totalEnergy_ > 0 ? bandEnergy_ / totalEnergy_ : 0;
+    analysisCount_ = 0;
+    totalEnergy_ = 0;
+    bandEnergy_ = 0;
+
+    if (!hasNoiseFloor_) {
+        noiseFloorDb_ = bandDb;
+        hasNoiseFloor_ = true;
+    }
+    bool voiced = bandDb > noiseFloorDb_ + options_.thresholdDb && bandDb > kAbsoluteFloorDb &&
+                  ratio > kMinBandRatio;
+
+    noiseFloorDb_ += (bandDb - noiseFloorDb_) * (bandDb < noiseFloorDb_ ? kFloorFall : kFloorRise);
+    noiseFloorDb_ = std::max(noiseFloorDb_, -120.0);
+    return voiced;
+}
+
+void VoiceActivityGate::UpdateState(bool voiced, uint64_t frameStart, uint64_t frameEnd,
+                                    const AudioChunkInfo& info) {
+    if (voiced) {
+        if (!inVoicedRun_) {
+            inVoicedRun_ = true;
+            voicedRunStart_ = frameStart;
+        }
+        lastVoicedEnd_ = frameEnd;
+    } else {
+        inVoicedRun_ = false;
+    }
+
+    bool changed = false;
+    uint64_t at = 0;
+    if (!speaking_ && inVoicedRun_ && frameEnd - voicedRunStart_ >= minSpeechFrames_) {
+        speaking_ = true;
+        changed = true;
+        at = voicedRunStart_;
+    } else if (speaking_ && frameEnd - lastVoicedEnd_ >= std::max<uint64_t>(hangoverFrames_, 1)) {
+        speaking_ = false;
+        changed = true;
+        at = lastVoicedEnd_;
+    }
+    if (!changed) return;
+
+    Transition transition = {speaking_, at, HostTimeAt(at, info)};
+    if (transitions_.size() < kMaxTransitions) {
+        transitions_.push_back(transition);
+    } else {
+        transitions_.back() = transition;
+    }
+}
+
+uint64_t VoiceActivityGate::HostTimeAt(uint64_t framePosition, const AudioChunkInfo& info) const {
+    if (info.hostTimeNs == 0) return 0;
+    double ns = static_cast<double>(info.hostTimeNs) +
+                (static_cast<double>(framePosition) - static_cast<double>(info.framePosition)) * nsPerFrame_;
+    return ns > 0 ? static_cast<uint64_t>(std::llround(ns)) : 0;
+}
+
+void VoiceActivityGate::Hold(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info, uint64_t frames) {
+    // Drop the oldest chunk once the rest and this one still cover the
+    // pre-roll. Speech is only confirmed minSpeechMs after it began, so the
+    // pre-roll may reach back that much further.
+    const uint64_t keep = preRollFrames_ + minSpeechFrames_ + analysisFrames_;
+    while (heldCount_ > 0 && heldFrames_ - held_[heldStart_].frames + frames >= keep) {
+        heldFrames_ -= held_[heldStart_].frames;
+        heldStart_ = (heldStart_ + 1) % held_.size();
+        heldCount_--;
+    }
+
+    if (heldCount_ == held_.size()) {
+        // Grow while the pre-roll needs more chunks than it has held so far
+        std::rotate(held_.begin(), held_.begin() + heldStart_, held_.end());
+        held_.emplace_back();
+        heldStart_ = 0;
+    }
+
+    HeldChunk& slot = held_[(heldStart_ + heldCount_) % held_.size()];
+    slot.data.assign(pcm, pcm + bytes);
+    slot.info = info;
+    slot.frames = frames;
+    heldCount_++;
+    heldFrames_ += frames;
+}
+
+void VoiceActivityGate::ReleaseHeld(uint64_t fromFrame, ChunkCallback chunk, void* context) {
+    for (size_t i = 0; i < heldCount_; i++) {
+        const HeldChunk& held = held_[(heldStart_ + i) % held_.size()];
+        if (held.info.framePosition + held.frames > fromFrame) {
+            chunk(held.data.data(), held.data.size(), held.info, context);
+        }
+    }
+    heldStart_ = 0;
+    heldCount_ = 0;
+    heldFrames_ = 0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "audio_chunk_info.h"
+#include "audio_encoder.h"
+#include "biquad.h"
+
+// ============================================================================
+// VoiceActivityGate - speech detection stage with speech-only delivery
+//
+// Sits ahead of the encoder and, like it, runs on whichever thread delivers
+// chunks. Audio is analysed in 10 ms frames. A frame counts as voiced when its
+// energy in the speech band (250-3500 Hz) is thresholdDb above a tracked noise
+// floor and makes up most of the frame's energy; the second test rejects hum,
+// rumble and hiss that a plain level gate lets through. Speech starts after
+// minSpeechMs of voiced frames and ends after hangoverMs without one.
+//
+// In speech-only mode, chunks outside speech are held back rather than
+// delivered. When speech starts, the held chunks covering the last preRollMs
+// go out first, so the start of the first word isn't lost. Decisions are made
+// per chunk: a chunk is delivered whole if any part of it is speech.
+// ============================================================================
+
+struct VoiceActivityOptions {
+    bool speechOnly = true;         // Hold back chunks outside speech; otherwise only report events
+    double thresholdDb = 9;         // Speech band energy above the noise floor
+    double minSpeechMs = 60;        // Voiced audio needed to start speech
+    double hangoverMs = 400;        // Unvoiced audio needed to end speech
+    double preRollMs = 300;         // Audio delivered ahead of speech start
+};
+
+class VoiceActivityGate {
+public:
+    typedef void (*ChunkCallback)(const uint8_t* data, size_t size, const AudioChunkInfo& info, void* context);
+
+    // Speech started (speaking) or ended at framePosition; hostTimeNs is 0 if
+    // the chunk had no timestamp
+    typedef void (*SpeechCallback)(bool speaking, uint64_t framePosition, uint64_t hostTimeNs, void* context);
+
+    // 32-bit float and 16-bit integer PCM; other formats pass through unanalysed
+    static bool Supports(const PcmFormat& format);
+
+    VoiceActivityGate(const VoiceActivityOptions& options, const PcmFormat& format);
+
+    // Analyse one interleaved chunk, report speech transitions, and deliver
+    // whatever should be delivered: held pre-roll, then the chunk itself
+    void Process(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info, ChunkCallback chunk,
+                 SpeechCallback speech, void* context);
+
+    // End of stream: report the end of speech still in progress
+    void Finish(SpeechCallback speech, void* context);
+
+    bool Speaking() const { return speaking_; }
+
+private:
+    struct Transition {
+        bool speaking;
+        uint64_t framePosition;
+        uint64_t hostTimeNs;
+    };
+
+    struct HeldChunk {
+        std::vector<uint8_t> data;
+        AudioChunkInfo info;
+        uint64_t frames;
+    };
+
+    float MonoSample(const uint8_t* frame) const;
+    bool ClassifyFrame();
+    void UpdateState(bool voiced, uint64_t frameStart, uint64_t frameEnd, const AudioChunkInfo& info);
+    uint64_t HostTimeAt(uint64_t framePosition, const AudioChunkInfo& info) const;
+
+    void Hold(const uint8_t* pcm, size_t bytes, const AudioChunkInfo& info, uint64_t frames);
+    void ReleaseHeld(uint64_t fromFrame, ChunkCallback chunk, void* context);
+
+    VoiceActivityOptions options_;
+    PcmFormat format_;
+    size_t frameBytes_;
+    double nsPerFrame_;
+
+    // Analysis
+    Biquad highPass_;
+    Biquad lowPass_;
+    size_t analysisFrames_;         // Samples per 10 ms frame
+    size_t analysisCount_ = 0;
+    double totalEnergy_ = 0;
+    double bandEnergy_ = 0;
+    bool hasNoiseFloor_ = false;
+    double noiseFloorDb_ = 0;
+
+    // Decision
+    uint64_t minSpeechFrames_;
+    uint64_t hangoverFrames_;
+    bool speaking_ = false;
+    bool inVoicedRun_ = false;
+    uint64_t voicedRunStart_ = 0;
+    uint64_t lastVoicedEnd_ = 0;
+    std::vector<Transition> transitions_;   // This chunk's, in order
+
+    // Speech-only pre-roll: a ring of held chunks, grown on first use
+    uint64_t preRollFrames_;
+    std::vector<HeldChunk> held_;
+    size_t heldStart_ = 0;
+    size_t heldCount_ = 0;
+    uint64_t heldFrames_ = 0;
+};
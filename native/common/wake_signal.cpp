@@ -0,0 +1,71 @@
+#include "wake_signal.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <cerrno>
+#include <semaphore.h>
+#endif
+
+// Every post is matched by exactly one wait, so the count never exceeds one
+
+#if defined(_WIN32)
+
+WakeSignal::WakeSignal() : semaphore_(CreateSemaphoreW(nullptr, 0, 1, nullptr)) {}
+
+WakeSignal::~WakeSignal() {
+    CloseHandle(static_cast<HANDLE>(semaphore_));
+}
+
+void WakeSignal::Post() {
+    ReleaseSemaphore(static_cast<HANDLE>(semaphore_), 1, nullptr);
+}
+
+void WakeSignal::Wait() {
+    WaitForSingleObject(static_cast<HANDLE>(semaphore_), INFINITE);
+    pending_.exchange(false, std::memory_order_acq_rel);
+}
+
+#elif defined(__APPLE__)
+
+// dispatch_semaphore_signal is a single atomic add unless the worker is parked
+WakeSignal::WakeSignal() : semaphore_(dispatch_semaphore_create(0)) {}
+
+WakeSignal::~WakeSignal() {
+    dispatch_release(static_cast<dispatch_semaphore_t>(semaphore_));
+}
+
+void WakeSignal::Post() {
+    dispatch_semaphore_signal(static_cast<dispatch_semaphore_t>(semaphore_));
+}
+
+void WakeSignal::Wait() {
+    dispatch_semaphore_wait(static_cast<dispatch_semaphore_t>(semaphore_), DISPATCH_TIME_FOREVER);
+    pending_.exchange(false, std::memory_order_acq_rel);
+}
+
+#else
+
+WakeSignal::WakeSignal() : semaphore_(new sem_t) {
+    sem_init(static_cast<sem_t*>(semaphore_), 0, 0);
+}
+
+WakeSignal::~WakeSignal() {
+    sem_destroy(static_cast<sem_t*>(semaphore_));
+    delete static_cast<sem_t*>(semaphore_);
+}
+
+void WakeSignal::Post() {
+    sem_post(static_cast<sem_t*>(semaphore_));
+}
+
+void WakeSignal::Wait() {
+    while (sem_wait(static_cast<sem_t*>(semaphore_)) != 0 && errno == EINTR) {
+    }
+    pending_.exchange(false, std::memory_order_acq_rel);
+}
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+
+// ============================================================================
+// WakeSignal - wake one worker thread from a real-time callback
+//
+// Notify() never blocks, never allocates and takes no lock: it sets a flag
+// and posts the platform semaphore only when the flag was clear, so a burst
+// of notifications costs one post. Wait() blocks until the next Notify(),
+// with acquire ordering against everything the notifier wrote before it.
+// One thread waits; any number may notify.
+// ============================================================================
+
+class WakeSignal {
+public:
+    WakeSignal();
+    ~WakeSignal();
+
+    WakeSignal(const WakeSignal&) = delete;
+    WakeSignal& operator=(const WakeSignal&) = delete;
+
+    void Notify() {
+        if (!pending_.exchange(true, std::memory_order_acq_rel)) {
+            Post();
+        }
+    }
+
+    void Wait();
+
+private:
+    void Post();
+
+    std::atomic<bool> pending_{false};
+    void* semaphore_ = nullptr;
+};
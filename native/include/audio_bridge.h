@@ -4,6 +4,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "audio_chunk_info.h"
+#include "audio_stats.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -11,8 +14,10 @@ extern "C" {
 // Opaque handle type for the audio capture session
 typedef void* AudioRecorderHandle;
 
-// Callback types
-typedef void (*AudioDataCallback)(const uint8_t* data, int32_t length, void* context);
+// Callback types. info is never NULL and only valid for the duration of the call.
+typedef void (*AudioDataCallback)(const uint8_t* data, int32_t length, const AudioChunkInfo* info, void* context);
+// eventType: 0 = start, 1 = stop, 2 = error, 3 = warning (a notice about a
+// start that went ahead, e.g. a latency mode fallback; message is never NULL)
 typedef void (*AudioEventCallback)(int32_t eventType, const char* message, void* context);
 typedef void (*AudioMetadataCallback)(double sampleRate, uint32_t channelsPerFrame,
                                        uint32_t bitsPerChannel, bool isFloat,
@@ -28,7 +33,7 @@ AudioRecorderHandle audio_create(
 
 // Start system audio capture
 // Note: mute parameter only works on macOS (silently ignored on Windows)
-// Note: Windows only supports single process filtering (first PID is used)
+// Note: Windows mixes one loopback client per include PID; exclusion uses only the first PID
 // Note: emitSilence generates silent buffers when no audio is playing (Windows only, macOS always emits)
 int32_t audio_start_system_audio(
     AudioRecorderHandle handle,
@@ -64,6 +69,57 @@ void audio_destroy(AudioRecorderHandle handle);
 // Check if session is running
 bool audio_is_running(AudioRecorderHandle handle);
 
+// ============================================================================
+// Session Options
+// Setters apply to the next start; they return -2 while the session is running.
+// ============================================================================
+
+// Device buffer duration in milliseconds (0 = platform default)
+// Windows: shared-mode WASAPI buffer size; capture is event-driven either way
+// macOS: IO buffer frame size of the tap's aggregate device (system audio only)
+int32_t audio_set_buffer_duration(AudioRecorderHandle handle, double bufferDurationMs);
+
+// Sample rate converter quality: 0 = fast, 1 = balanced (default), 2 = high.
+// Returns -3 for any other value.
+// Windows: taps of the built-in polyphase resampler
+// macOS: AVAudioConverter sample rate converter quality
+int32_t audio_set_resampler_quality(AudioRecorderHandle handle, int32_t quality);
+
+// Channel map: output channel o is the sum over i of device channel i times
+// matrix[o * inputChannels + i], applied natively before resampling and
+// chunking, in place of the mono/stereo choice. Device channels past
+// inputChannels are ignored. NULL or outputChannels 0 clears the map.
+// Returns -3 if either side exceeds AUDIO_DSP_MAX_CHANNELS. A start with a
+// map fails with -9 if the device has fewer than inputChannels channels.
+// Windows: every client of a mixed capture is mapped on its own
+// macOS: the tap sees the tapped output device's channels
+int32_t audio_set_channel_map(AudioRecorderHandle handle, const float* matrix, uint32_t outputChannels,
+                              uint32_t inputChannels);
+
+// Keep a stopped system audio capture's tap and aggregate device for
+// ttlMs (0 = destroy on stop, the default) so that a later start with the
+// same processes, mute and mono settings, from any session, reuses them.
+// Windows: no-op; loopback clients are cheap to create
+// macOS: a muted tap keeps its processes muted while it is kept
+int32_t audio_set_tap_cache_ttl(AudioRecorderHandle handle, double ttlMs);
+
+// How a microphone capture opens its device: 0 = default, 1 = low latency,
+// 2 = exclusive. Returns -3 for any other value. A mode the device refuses
+// falls back to the next one down, with a warning event, and the start goes on.
+// Windows: 1 is shared mode at the engine's minimum period (IAudioClient3;
+// the buffer duration is then ignored), 2 is exclusive mode in the device's
+// own format at its minimum period, or the buffer duration if longer.
+// Loopback always runs at the render engine's period.
+// macOS: no-op; the IO buffer duration sets the latency
+int32_t audio_set_latency_mode(AudioRecorderHandle handle, int32_t mode);
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+// Counters of the current or most recent capture; reset by each start
+int32_t audio_get_stats(AudioRecorderHandle handle, AudioStatsSnapshot* stats);
+
 // ============================================================================
 // Device Enumeration
 // ============================================================================
@@ -83,6 +139,8 @@ typedef struct {
 // List all audio devices
 // Returns 0 on success, populates devices array and count
 // Caller must free with audio_free_device_list
+// The list and the defaults below come from a registry that enumerates once
+// and then follows the platform's device notifications, so lookups are cheap
 int32_t audio_list_devices(AudioDeviceInfo** devices, int32_t* count);
 
 // Free device list allocated by audio_list_devices
@@ -94,6 +152,24 @@ char* audio_get_default_input_device(void);
 // Get default output device UID (caller must free)
 char* audio_get_default_output_device(void);
 
+// ============================================================================
+// Device Watcher API
+// ============================================================================
+
+typedef void* AudioDeviceWatcherHandle;
+
+// Event types: 0 = added, 1 = removed, 2 = default changed.
+// device is the added or removed device, or the new default (NULL when there
+// no longer is one); it is only valid for the duration of the call.
+// isInput tells which list, or which default, changed.
+typedef void (*AudioDeviceChangeCallback)(int32_t eventType, const AudioDeviceInfo* device, bool isInput,
+                                          void* context);
+
+// Callbacks run on a registry thread from creation until destroy returns
+AudioDeviceWatcherHandle audio_device_watcher_create(AudioDeviceChangeCallback callback, void* context);
+
+void audio_device_watcher_destroy(AudioDeviceWatcherHandle handle);
+
 // ============================================================================
 // System Audio Permission API
 // ============================================================================
@@ -132,15 +208,22 @@ void audio_mic_permission_request(PermissionCallback callback, void* context);
 
 typedef void* MicActivityMonitorHandle;
 
-// Event types: 0=change (aggregate), 1=deviceChange (per-device), 2=error
+// Event types: 0=change (aggregate), 1=deviceChange (per-device), 2=error,
+// 3=processChange (per-process)
 typedef void (*MicActivityChangeCallback)(bool isActive, void* context);
 typedef void (*MicActivityDeviceCallback)(const char* deviceId, const char* deviceName, bool isActive, void* context);
 typedef void (*MicActivityErrorCallback)(const char* message, void* context);
+typedef void (*MicActivityProcessCallback)(int32_t pid, const char* name, const char* bundleId, bool isActive, void* context);
 
+// processCallback may be NULL. While started, the monitor keeps a table of
+// the processes using input from per-process notifications, reporting each
+// one that starts or stops; processes already using input are reported on
+// start.
 MicActivityMonitorHandle mic_activity_create(
     MicActivityChangeCallback changeCallback,
     MicActivityDeviceCallback deviceCallback,
     MicActivityErrorCallback errorCallback,
+    MicActivityProcessCallback processCallback,
     void* userContext
 );
 
@@ -162,7 +245,9 @@ int32_t mic_activity_get_active_device_ids(
 
 void mic_activity_free_device_ids(char** deviceIds, int32_t count);
 
-// Get list of processes currently using microphone input
+// Get list of processes currently using microphone input, in the order they
+// started. A started monitor answers from its process table without querying
+// the system.
 // Returns parallel arrays: pids, names, bundleIds (caller must free with mic_activity_free_processes)
 int32_t mic_activity_get_active_processes(
     MicActivityMonitorHandle handle,
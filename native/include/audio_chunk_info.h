@@ -0,0 +1,46 @@
+#ifndef AUDIO_CHUNK_INFO_H
+#define AUDIO_CHUNK_INFO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Timing of a data chunk, passed alongside every AudioDataCallback
+//
+// Kept apart from audio_bridge.h so the Swift bridging header can import the
+// struct without also importing the C API the Swift code implements.
+// ============================================================================
+
+typedef struct {
+    // Host clock time of the chunk's first frame in nanoseconds, derived from
+    // the device timestamps: mach_absolute_time on macOS, QPC on Windows.
+    // 0 when the platform reported no timestamp.
+    uint64_t hostTimeNs;
+
+    // Frames delivered ahead of this chunk since the session started
+    uint64_t framePosition;
+
+    // Position of the chunk's first frame on the device's own sample counter
+    // (WASAPI device position, CoreAudio sample time), in device frames.
+    // Only meaningful when flags has AUDIO_CHUNK_DEVICE_POSITION.
+    uint64_t devicePosition;
+
+    // AUDIO_CHUNK_* bits
+    uint32_t flags;
+} AudioChunkInfo;
+
+// Audio just before this chunk is missing or glitched: the device reported a
+// discontinuity, its sample counter jumped, or a buffer on the way overran
+#define AUDIO_CHUNK_DISCONTINUITY 0x1
+
+// devicePosition is valid
+#define AUDIO_CHUNK_DEVICE_POSITION 0x2
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_CHUNK_INFO_H
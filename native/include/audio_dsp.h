@@ -0,0 +1,86 @@
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Sample kernels shared by every backend
+//
+// Plain C so the Swift code can import it alongside the C++ backends. The
+// implementation is picked once at first use: AVX2 or SSE2 on x86-64, NEON on
+// arm64, scalar elsewhere. All functions are allocation-free and safe to call
+// from a real-time thread. Buffers may be unaligned; in/out may alias only
+// where noted.
+// ============================================================================
+
+// Most channels audio_dsp_mix_channels takes on either side
+#define AUDIO_DSP_MAX_CHANNELS 64
+
+// State for TPDF dither. Results are identical whichever kernel set runs.
+typedef struct {
+    uint32_t lanes[8];
+} AudioDspDitherState;
+
+// Name of the kernel set in use: "avx2", "sse2", "neon" or "scalar"
+const char* audio_dsp_isa(void);
+
+// out[i] = in[i] * gain, optionally clamped to [-1, 1]. in and out may alias.
+void audio_dsp_apply_gain(const float* in, float* out, size_t count, float gain, bool clamp);
+
+// Average all channels of each interleaved frame into one sample
+void audio_dsp_downmix_mono(const float* in, float* out, size_t frames, uint32_t channels);
+
+// Interleaved N channels to interleaved stereo. Mono is duplicated; for more
+// than two channels even-indexed channels are averaged into left and
+// odd-indexed into right (covers L/R pairs in 4.0, 5.1 and 7.1 layouts).
+void audio_dsp_downmix_stereo(const float* in, float* out, size_t frames, uint32_t channels);
+
+// Interleaved inChannels to interleaved outChannels through a row-major
+// outChannels x inChannels matrix: output channel o is the sum over i of
+// input channel i times matrix[o * inChannels + i]. Zero weights are skipped
+// and a row that picks one channel at weight 1 is a copy, so selecting
+// channels costs no more than copying them. in and out must not alias.
+void audio_dsp_mix_channels(const float* in, float* out, size_t frames, uint32_t inChannels, const float* matrix,
+                            uint32_t outChannels);
+
+// Signed little-endian integer PCM of 16, 24 (packed) or 32 bits to float
+// [-1, 1). 32-bit containers with 24 valid bits convert as 32-bit.
+void audio_dsp_int_to_float(const void* in, float* out, size_t count, uint32_t bitsPerSample);
+
+// Float [-1, 1] to int16 with clipping. Pass a dither state for TPDF dither
+// of +/-1 LSB, or NULL to round to nearest.
+void audio_dsp_float_to_int16(const float* in, int16_t* out, size_t count, AudioDspDitherState* dither);
+
+// Seed a dither state. Any seed works, including 0.
+void audio_dsp_dither_init(AudioDspDitherState* dither, uint32_t seed);
+
+// Sum of a[i] * b[i]; the inner loop of FIR filters
+float audio_dsp_dot(const float* a, const float* b, size_t count);
+
+// Per-channel sum of squares and peak magnitude of interleaved frames, written
+// to sumSquares[channels] and peaks[channels]; the basis of level meters
+void audio_dsp_channel_levels(const float* in, size_t frames, uint32_t channels, float* sumSquares, float* peaks);
+
+// Planar <-> interleaved
+void audio_dsp_interleave(const float* const* planes, float* out, size_t frames, uint32_t channels);
+void audio_dsp_deinterleave(const float* in, float* const* planes, size_t frames, uint32_t channels);
+
+// One radix-2 decimation-in-time pass of a complex FFT over n points held as
+// split re[n] / im[n], in place: each group of 2 * half points combines its
+// two halves through twiddle[k] = exp(-i * pi * k / half), passed as
+// twiddleRe[half] / twiddleIm[half]. Run with half = 1, 2, 4 ... n / 2 on
+// bit-reversed input for a whole transform.
+void audio_dsp_fft_stage(float* re, float* im, size_t n, size_t half, const float* twiddleRe,
+                         const float* twiddleIm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_H
@@ -0,0 +1,39 @@
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Lock-free SPSC byte ring for real-time callbacks
+//
+// C wrapper around native/common/byte_ring.h so the Swift IOProc can hand
+// samples to a worker thread without locks or allocation. One thread writes,
+// one thread reads.
+// ============================================================================
+
+typedef struct AudioByteRing AudioByteRing;
+
+// Capacity is rounded up to a power of two; returns NULL on allocation failure
+AudioByteRing* audio_ring_create(size_t capacityBytes);
+void audio_ring_destroy(AudioByteRing* ring);
+
+// Producer: copies all bytes or none; false if the ring is too full
+bool audio_ring_write(AudioByteRing* ring, const void* data, size_t bytes);
+
+// Consumer: copies up to maxBytes and returns the number copied
+size_t audio_ring_read(AudioByteRing* ring, void* dest, size_t maxBytes);
+size_t audio_ring_readable(const AudioByteRing* ring);
+
+// Discard contents; only while neither side is active
+void audio_ring_reset(AudioByteRing* ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_RING_H
@@ -0,0 +1,57 @@
+#ifndef AUDIO_STATS_H
+#define AUDIO_STATS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Lock-free capture counters
+//
+// C wrapper around native/common/capture_stats.h so the Swift capture code can
+// record into the same counters as the C++ platforms. Every call is a few
+// relaxed atomic operations, cheap enough for a real-time callback.
+// ============================================================================
+
+typedef struct AudioStats AudioStats;
+
+// A consistent-enough copy of the counters; durations in nanoseconds
+typedef struct {
+    uint64_t framesCaptured;    // Frames received from the device
+    uint64_t framesEmitted;     // Frames delivered in data chunks
+    uint64_t framesDropped;     // Frames lost to full buffers on the way
+
+    // Time spent in the capture callback (IOProc, packet drain, sample buffer delegate)
+    uint64_t callbackCount;
+    uint64_t callbackP50Ns;
+    uint64_t callbackP99Ns;
+    uint64_t callbackMaxNs;
+
+    // Total time spent converting: format, channel layout and sample rate
+    uint64_t conversionNs;
+} AudioStatsSnapshot;
+
+// Returns NULL on allocation failure
+AudioStats* audio_stats_create(void);
+void audio_stats_destroy(AudioStats* stats);
+
+// Zero every counter; only while nothing is recording into them
+void audio_stats_reset(AudioStats* stats);
+
+// Now on the host clock (mach_absolute_time / QPC), in nanoseconds
+uint64_t audio_stats_now_ns(void);
+
+void audio_stats_record_callback(AudioStats* stats, uint64_t durationNs, uint64_t frames);
+void audio_stats_record_conversion(AudioStats* stats, uint64_t durationNs);
+void audio_stats_add_emitted(AudioStats* stats, uint64_t frames);
+void audio_stats_add_dropped(AudioStats* stats, uint64_t frames);
+
+void audio_stats_snapshot(const AudioStats* stats, AudioStatsSnapshot* snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_STATS_H
@@ -3,89 +3,102 @@ import Foundation
 
 public class AudioBuffer {
     private var buffer: [UInt8]
+    private var scratch: [UInt8]
     private var writeIndex: Int = 0
     private var readIndex: Int = 0
     private var availableBytes: Int = 0
     private let maxBufferSize: Int
 
+    /// Bytes rejected because the ring was full, since the last takeDroppedBytes()
+    private var droppedBytes = 0
+
     private let bytesPerChunk: Int
-    private let chunkDuration: Double
 
     public init(format: AudioStreamBasicDescription, chunkDuration: Double = 0.2) {
         // Pre-calculate chunk parameters
         let bytesPerFrame = Int(format.mBytesPerFrame)
         let samplesPerChunk = Int(format.mSampleRate * chunkDuration)
         self.bytesPerChunk = samplesPerChunk * bytesPerFrame
-        self.chunkDuration = Double(samplesPerChunk) / format.mSampleRate
 
         // Calculate max buffer size to hold ~10 seconds of audio
         let bytesPerSecond = Int(format.mSampleRate) * bytesPerFrame
         self.maxBufferSize = bytesPerSecond * 10
 
-        // Pre-allocated ring buffer
+        // Pre-allocated ring buffer, plus scratch space for chunks that wrap around
         self.buffer = Array(repeating: 0, count: maxBufferSize)
+        self.scratch = Array(repeating: 0, count: bytesPerChunk)
     }
 
     public func append(_ data: Data) {
-        guard availableBytes + data.count <= maxBufferSize else {
+        data.withUnsafeBytes { bytes in
+            if let baseAddress = bytes.baseAddress {
+                append(baseAddress, count: bytes.count)
+            }
+        }
+    }
+
+    /// Copy raw bytes into the ring without creating an intermediate `Data`.
+    public func append(_ source: UnsafeRawPointer, count dataSize: Int) {
+        guard dataSize > 0 else { return }
+        guard availableBytes + dataSize <= maxBufferSize else {
+            droppedBytes += dataSize
             return
         }
 
-        data.withUnsafeBytes { bytes in
-            let sourceBytes = bytes.bindMemory(to: UInt8.self)
-            let dataSize = sourceBytes.count
+        buffer.withUnsafeMutableBytes { ring in
+            let base = ring.baseAddress!
 
             if writeIndex + dataSize <= maxBufferSize {
-                buffer.replaceSubrange(writeIndex..<writeIndex + dataSize, with: sourceBytes)
+                (base + writeIndex).copyMemory(from: source, byteCount: dataSize)
                 writeIndex = (writeIndex + dataSize) % maxBufferSize
             } else {
                 let firstChunkSize = maxBufferSize - writeIndex
                 let secondChunkSize = dataSize - firstChunkSize
 
-                buffer.replaceSubrange(writeIndex..<maxBufferSize, with: sourceBytes.prefix(firstChunkSize))
-                buffer.replaceSubrange(0..<secondChunkSize, with: sourceBytes.suffix(secondChunkSize))
+                (base + writeIndex).copyMemory(from: source, byteCount: firstChunkSize)
+                base.copyMemory(from: source + firstChunkSize, byteCount: secondChunkSize)
 
                 writeIndex = secondChunkSize
             }
         }
 
-        availableBytes += data.count
+        availableBytes += dataSize
     }
 
-    public func processChunks() -> [AudioPacket] {
-        var packets: [AudioPacket] = []
-
-        while let packet = nextChunk() {
-            packets.append(packet)
-        }
-
-        return packets
+    /// Bytes dropped since the previous call
+    public func takeDroppedBytes() -> Int {
+        let bytes = droppedBytes
+        droppedBytes = 0
+        return bytes
     }
 
-    private func nextChunk() -> AudioPacket? {
-        guard availableBytes >= bytesPerChunk else { return nil }
-
-        var chunkData = Data(capacity: bytesPerChunk)
-
-        if readIndex + bytesPerChunk <= maxBufferSize {
-            chunkData.append(contentsOf: buffer[readIndex..<readIndex + bytesPerChunk])
-            readIndex = (readIndex + bytesPerChunk) % maxBufferSize
-        } else {
-            let firstChunkSize = maxBufferSize - readIndex
-            let secondChunkSize = bytesPerChunk - firstChunkSize
-
-            chunkData.append(contentsOf: buffer[readIndex..<maxBufferSize])
-            chunkData.append(contentsOf: buffer[0..<secondChunkSize])
+    /// Hand each complete chunk to `body` without allocating.
+    ///
+    /// The pointer refers to ring storage (or the scratch buffer when the chunk
+    /// wraps) and is only valid for the duration of the call.
+    public func drainChunks(_ body: (UnsafeRawBufferPointer) -> Void) {
+        while availableBytes >= bytesPerChunk {
+            if readIndex + bytesPerChunk <= maxBufferSize {
+                buffer.withUnsafeBytes { ring in
+                    body(UnsafeRawBufferPointer(rebasing: ring[readIndex..<readIndex + bytesPerChunk]))
+                }
+                readIndex = (readIndex + bytesPerChunk) % maxBufferSize
+            } else {
+                let firstChunkSize = maxBufferSize - readIndex
+                let secondChunkSize = bytesPerChunk - firstChunkSize
+
+                buffer.withUnsafeBytes { ring in
+                    scratch.withUnsafeMutableBytes { dest in
+                        dest.baseAddress!.copyMemory(from: ring.baseAddress! + readIndex, byteCount: firstChunkSize)
+                        (dest.baseAddress! + firstChunkSize).copyMemory(from: ring.baseAddress!, byteCount: secondChunkSize)
+                    }
+                }
+                scratch.withUnsafeBytes { body($0) }
+
+                readIndex = secondChunkSize
+            }
 
-            readIndex = secondChunkSize
+            availableBytes -= bytesPerChunk
         }
-
-        availableBytes -= bytesPerChunk
-
-        return AudioPacket(
-            timestamp: Date(),
-            duration: chunkDuration,
-            data: chunkData
-        )
     }
 }
@@ -317,7 +317,8 @@ class AudioDeviceManager {
         return status == noErr ? sampleRate : 0
     }
 
-    private static func getInputChannelCount(deviceID: AudioDeviceID) -> UInt32 {
+    /// Channels across all of a device's input streams
+    static func getInputChannelCount(deviceID: AudioDeviceID) -> UInt32 {
         return getChannelCount(deviceID: deviceID, scope: kAudioDevicePropertyScopeInput)
     }
 
@@ -381,12 +382,54 @@ class AudioDeviceManager {
 
 private let CAudioDeviceInfoSize = 48  // Size of AudioDeviceInfo struct in C
 
+/// Write one AudioDeviceInfo, with strdup'd strings, at itemPointer
+private func storeDeviceInfo(_ device: DeviceInfo, at itemPointer: UnsafeMutableRawPointer) {
+    // uid (offset 0)
+    itemPointer.storeBytes(of: strdup(device.uid), as: UnsafeMutablePointer<CChar>?.self)
+    // name (offset 8)
+    itemPointer.advanced(by: 8).storeBytes(of: strdup(device.name), as: UnsafeMutablePointer<CChar>?.self)
+    // manufacturer (offset 16)
+    itemPointer.advanced(by: 16).storeBytes(of: strdup(device.manufacturer), as: UnsafeMutablePointer<CChar>?.self)
+    // isDefault (offset 24)
+    itemPointer.advanced(by: 24).storeBytes(of: device.isDefault, as: Bool.self)
+    // isInput (offset 25)
+    itemPointer.advanced(by: 25).storeBytes(of: device.isInput, as: Bool.self)
+    // isOutput (offset 26)
+    itemPointer.advanced(by: 26).storeBytes(of: device.isOutput, as: Bool.self)
+    // sampleRate (offset 32 - after padding)
+    itemPointer.advanced(by: 32).storeBytes(of: device.sampleRate, as: Double.self)
+    // channelCount (offset 40)
+    itemPointer.advanced(by: 40).storeBytes(of: device.channelCount, as: UInt32.self)
+}
+
+/// Free the strings of the AudioDeviceInfo at itemPointer
+private func freeDeviceInfoStrings(at itemPointer: UnsafeMutableRawPointer) {
+    // uid (offset 0), name (offset 8), manufacturer (offset 16)
+    for offset in [0, 8, 16] {
+        if let string = itemPointer.advanced(by: offset).load(as: UnsafeMutablePointer<CChar>?.self) {
+            free(string)
+        }
+    }
+}
+
+/// Lend body a temporary AudioDeviceInfo for device
+func withDeviceInfo(_ device: DeviceInfo, _ body: (UnsafeRawPointer) -> Void) {
+    let itemPointer = UnsafeMutableRawPointer.allocate(byteCount: CAudioDeviceInfoSize, alignment: 8)
+    itemPointer.initializeMemory(as: UInt8.self, repeating: 0, count: CAudioDeviceInfoSize)
+    storeDeviceInfo(device, at: itemPointer)
+    defer {
+        freeDeviceInfoStrings(at: itemPointer)
+        itemPointer.deallocate()
+    }
+    body(UnsafeRawPointer(itemPointer))
+}
+
 @_cdecl("audio_list_devices")
 public func audio_list_devices(
     devices: UnsafeMutableRawPointer,  // AudioDeviceInfo** 
     count: UnsafeMutablePointer<Int32>
 ) -> Int32 {
-    let deviceList = AudioDeviceManager.listAllDevices()
+    let deviceList = DeviceRegistry.shared.listDevices()
     
     // Cast to the correct pointer type for the out parameter
     let devicesOut = devices.assumingMemoryBound(to: UnsafeMutableRawPointer?.self)
@@ -404,26 +447,7 @@ public func audio_list_devices(
     )
 
     for (index, device) in deviceList.enumerated() {
-        let offset = index * CAudioDeviceInfoSize
-        let itemPointer = arrayPointer.advanced(by: offset)
-        
-        // Write each field at the correct offset
-        // uid (offset 0)
-        itemPointer.storeBytes(of: strdup(device.uid), as: UnsafeMutablePointer<CChar>?.self)
-        // name (offset 8)
-        itemPointer.advanced(by: 8).storeBytes(of: strdup(device.name), as: UnsafeMutablePointer<CChar>?.self)
-        // manufacturer (offset 16)
-        itemPointer.advanced(by: 16).storeBytes(of: strdup(device.manufacturer), as: UnsafeMutablePointer<CChar>?.self)
-        // isDefault (offset 24)
-        itemPointer.advanced(by: 24).storeBytes(of: device.isDefault, as: Bool.self)
-        // isInput (offset 25)
-        itemPointer.advanced(by: 25).storeBytes(of: device.isInput, as: Bool.self)
-        // isOutput (offset 26)
-        itemPointer.advanced(by: 26).storeBytes(of: device.isOutput, as: Bool.self)
-        // sampleRate (offset 32 - after padding)
-        itemPointer.advanced(by: 32).storeBytes(of: device.sampleRate, as: Double.self)
-        // channelCount (offset 40)
-        itemPointer.advanced(by: 40).storeBytes(of: device.channelCount, as: UInt32.self)
+        storeDeviceInfo(device, at: arrayPointer.advanced(by: index * CAudioDeviceInfoSize))
     }
 
     devicesOut.pointee = arrayPointer
@@ -440,21 +464,7 @@ public func audio_free_device_list(
     guard let devices = devices else { return }
 
     for i in 0..<Int(count) {
-        let offset = i * CAudioDeviceInfoSize
-        let itemPointer = devices.advanced(by: offset)
-        
-        // Free uid string (offset 0)
-        if let uid = itemPointer.load(as: UnsafeMutablePointer<CChar>?.self) {
-            free(uid)
-        }
-        // Free name string (offset 8)
-        if let name = itemPointer.advanced(by: 8).load(as: UnsafeMutablePointer<CChar>?.self) {
-            free(name)
-        }
-        // Free manufacturer string (offset 16)
-        if let manufacturer = itemPointer.advanced(by: 16).load(as: UnsafeMutablePointer<CChar>?.self) {
-            free(manufacturer)
-        }
+        freeDeviceInfoStrings(at: devices.advanced(by: i * CAudioDeviceInfoSize))
     }
 
     devices.deallocate()
@@ -462,7 +472,7 @@ public func audio_free_device_list(
 
 @_cdecl("audio_get_default_input_device")
 public func audio_get_default_input_device() -> UnsafeMutablePointer<CChar>? {
-    guard let uid = AudioDeviceManager.getDefaultInputDeviceUID() else {
+    guard let uid = DeviceRegistry.shared.defaultDeviceUID(isInput: true) else {
         return nil
     }
     return strdup(uid)
@@ -470,8 +480,27 @@ public func audio_get_default_input_device() -> UnsafeMutablePointer<CChar>? {
 
 @_cdecl("audio_get_default_output_device")
 public func audio_get_default_output_device() -> UnsafeMutablePointer<CChar>? {
-    guard let uid = AudioDeviceManager.getDefaultOutputDeviceUID() else {
+    guard let uid = DeviceRegistry.shared.defaultDeviceUID(isInput: false) else {
         return nil
     }
     return strdup(uid)
 }
+
+@_cdecl("audio_device_watcher_create")
+public func audio_device_watcher_create(
+    callback: AudioDeviceChangeCallback?,
+    context: UnsafeMutableRawPointer?
+) -> UnsafeMutableRawPointer? {
+    guard let callback = callback else { return nil }
+    let watcher = DeviceRegistry.Watcher(callback: callback, context: context)
+    DeviceRegistry.shared.addWatcher(watcher)
+    return Unmanaged.passRetained(watcher).toOpaque()
+}
+
+@_cdecl("audio_device_watcher_destroy")
+public func audio_device_watcher_destroy(handle: UnsafeMutableRawPointer?) {
+    guard let handle = handle else { return }
+    let watcher = Unmanaged<DeviceRegistry.Watcher>.fromOpaque(handle)
+    DeviceRegistry.shared.removeWatcher(watcher.takeUnretainedValue())
+    watcher.release()
+}
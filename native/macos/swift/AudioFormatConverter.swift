@@ -2,12 +2,36 @@ import AVFoundation
 import CoreAudio
 import Foundation
 
+/// Streaming sample rate / format conversion stage.
+///
+/// Source bytes are fed in as they arrive from the IOProc or capture callback
+/// and converted output is appended to an `AudioBuffer` in the target format,
+/// which cuts exact-size chunks. One AVAudioConverter runs across the whole
+/// stream, so its filter state and fractional frame position carry over
+/// packet boundaries. The input and output buffers are allocated once.
 public class AudioFormatConverter {
     private let avConverter: AVAudioConverter
     private let sourceFormat: AVAudioFormat
     private let targetFormat: AVAudioFormat
+    private let sourceBytesPerFrame: Int
+    private let targetBytesPerFrame: Int
 
-    public init(sourceFormat: AudioStreamBasicDescription, targetFormat: AudioStreamBasicDescription) throws {
+    // Persistent buffers; the input grows only if a larger packet than expected arrives
+    private var inputBuffer: AVAudioPCMBuffer?
+    private let outputBuffer: AVAudioPCMBuffer
+
+    // State read by the input block: one pending packet at a time
+    private var inputPending = false
+    private var endOfStream = false
+    private var inputBlock: AVAudioConverterInputBlock?
+
+    private static let outputFrameCapacity: AVAudioFrameCount = 4096
+
+    public init(
+        sourceFormat: AudioStreamBasicDescription,
+        targetFormat: AudioStreamBasicDescription,
+        quality: Int32 = 1
+    ) throws {
         var mutableSourceFormat = sourceFormat
         var mutableTargetFormat = targetFormat
 
@@ -17,68 +41,101 @@ public class AudioFormatConverter {
             throw AudioConverterError.invalidFormat
         }
 
-        guard let converter = AVAudioConverter(from: sourceAVFormat, to: targetAVFormat) else {
+        guard let converter = AVAudioConverter(from: sourceAVFormat, to: targetAVFormat),
+              let outputBuffer = AVAudioPCMBuffer(pcmFormat: targetAVFormat, frameCapacity: Self.outputFrameCapacity)
+        else {
             throw AudioConverterError.creationFailed
         }
 
+        // Match the Windows resampler tiers: fast, balanced, high
+        switch quality {
+        case 0:
+            converter.sampleRateConverterQuality = AVAudioQuality.low.rawValue
+        case 2:
+            converter.sampleRateConverterAlgorithm = AVSampleRateConverterAlgorithm_Mastering
+            converter.sampleRateConverterQuality = AVAudioQuality.max.rawValue
+        default:
+            converter.sampleRateConverterQuality = AVAudioQuality.high.rawValue
+        }
+
         self.sourceFormat = sourceAVFormat
         self.targetFormat = targetAVFormat
+        self.sourceBytesPerFrame = Int(sourceFormat.mBytesPerFrame)
+        self.targetBytesPerFrame = Int(targetFormat.mBytesPerFrame)
         self.avConverter = converter
+        self.outputBuffer = outputBuffer
+
+        // Built once, not per call. Returning .noDataNow rather than
+        // .endOfStream keeps the converter primed for the next packet.
+        self.inputBlock = { [unowned self] _, outStatus in
+            if self.inputPending {
+                self.inputPending = false
+                outStatus.pointee = .haveData
+                return self.inputBuffer
+            }
+            outStatus.pointee = self.endOfStream ? .endOfStream : .noDataNow
+            return nil
+        }
     }
 
     public var targetFormatDescription: AudioStreamBasicDescription {
         return targetFormat.streamDescription.pointee
     }
 
-    public func transform(_ packet: AudioPacket) -> AudioPacket {
-        let inputData = packet.data
+    /// Convert a packet of source bytes and append the result to `sink`.
+    public func convert(_ source: UnsafeRawPointer, count: Int, into sink: AudioBuffer) {
+        let frames = count / sourceBytesPerFrame
+        guard frames > 0, let input = reusableInputBuffer(frames: frames) else { return }
 
-        let inputFrameCount = inputData.count / Int(sourceFormat.streamDescription.pointee.mBytesPerFrame)
-        let outputFrameCount = Int(Double(inputFrameCount) * (targetFormat.sampleRate / sourceFormat.sampleRate))
+        input.audioBufferList.pointee.mBuffers.mData!.copyMemory(from: source, byteCount: frames * sourceBytesPerFrame)
+        input.frameLength = AVAudioFrameCount(frames)
+        inputPending = true
 
-        guard let inputBuffer = AVAudioPCMBuffer(
-            pcmFormat: sourceFormat,
-            frameCapacity: AVAudioFrameCount(inputFrameCount)
-        ) else {
-            return packet
-        }
+        drain(into: sink)
+    }
 
-        inputData.withUnsafeBytes { bytes in
-            let dest = inputBuffer.audioBufferList.pointee.mBuffers.mData!
-            dest.copyMemory(from: bytes.baseAddress!, byteCount: inputData.count)
-        }
-        inputBuffer.frameLength = AVAudioFrameCount(inputFrameCount)
+    /// Flush the converter's filter tail at end of stream and rewind it for reuse.
+    public func finish(into sink: AudioBuffer) {
+        endOfStream = true
+        drain(into: sink)
+        avConverter.reset()
+        endOfStream = false
+        inputPending = false
+    }
 
-        guard let outputBuffer = AVAudioPCMBuffer(
-            pcmFormat: targetFormat,
-            frameCapacity: AVAudioFrameCount(outputFrameCount)
-        ) else {
-            return packet
-        }
+    private func drain(into sink: AudioBuffer) {
+        guard let inputBlock = inputBlock else { return }
 
-        var error: NSError?
-        _ = avConverter.convert(to: outputBuffer, error: &error) { _, outStatus in
-            outStatus.pointee = .haveData
-            return inputBuffer
-        }
+        while true {
+            outputBuffer.frameLength = 0
 
-        guard outputBuffer.frameLength > 0 else {
-            return packet
-        }
+            var error: NSError?
+            let status = avConverter.convert(to: outputBuffer, error: &error, withInputFrom: inputBlock)
 
-        let outputData = Data(
-            bytes: outputBuffer.audioBufferList.pointee.mBuffers.mData!,
-            count: Int(outputBuffer.frameLength * targetFormat.streamDescription.pointee.mBytesPerFrame)
-        )
+            let bytes = Int(outputBuffer.frameLength) * targetBytesPerFrame
+            if bytes > 0 {
+                sink.append(outputBuffer.audioBufferList.pointee.mBuffers.mData!, count: bytes)
+            }
 
-        return AudioPacket(
-            timestamp: packet.timestamp,
-            duration: packet.duration,
-            data: outputData
-        )
+            // .haveData means the output filled up and more may be waiting
+            guard status == .haveData else { break }
+        }
+    }
+
+    private func reusableInputBuffer(frames: Int) -> AVAudioPCMBuffer? {
+        let capacity = AVAudioFrameCount(max(frames, 1))
+        if let buffer = inputBuffer, buffer.frameCapacity >= capacity {
+            return buffer
+        }
+        inputBuffer = AVAudioPCMBuffer(pcmFormat: sourceFormat, frameCapacity: capacity)
+        return inputBuffer
     }
 
-    public static func toSampleRate(_ sampleRate: Double, from sourceFormat: AudioStreamBasicDescription) throws -> AudioFormatConverter {
+    public static func toSampleRate(
+        _ sampleRate: Double,
+        from sourceFormat: AudioStreamBasicDescription,
+        quality: Int32 = 1
+    ) throws -> AudioFormatConverter {
         var targetFormat = AudioStreamBasicDescription()
         targetFormat.mSampleRate = sampleRate
         targetFormat.mFormatID = kAudioFormatLinearPCM
@@ -89,7 +146,7 @@ public class AudioFormatConverter {
         targetFormat.mBytesPerFrame = (targetFormat.mBitsPerChannel / 8) * sourceFormat.mChannelsPerFrame
         targetFormat.mBytesPerPacket = targetFormat.mFramesPerPacket * targetFormat.mBytesPerFrame
 
-        return try AudioFormatConverter(sourceFormat: sourceFormat, targetFormat: targetFormat)
+        return try AudioFormatConverter(sourceFormat: sourceFormat, targetFormat: targetFormat, quality: quality)
     }
 
     public static func isValidSampleRate(_ sampleRate: Double) -> Bool {
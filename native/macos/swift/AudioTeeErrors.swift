@@ -6,6 +6,9 @@ public enum AudioTeeError: Error {
     case aggregateDeviceCreationFailed(OSStatus)
     case tapAssignmentFailed(OSStatus)
     case pidTranslationFailed([Int32])
+    case ioProcCreationFailed(OSStatus)
+    case deviceStartFailed(OSStatus)
+    case channelMapMismatch(deviceChannels: UInt32, mapChannels: UInt32)
 }
 
 public enum AudioConverterError: Error {
@@ -0,0 +1,114 @@
+import CoreAudio
+import Foundation
+
+/// A session's channel map, as given to audio_set_channel_map: a row-major
+/// outputs x inputs matrix of weights
+struct ChannelMapSetting {
+    let matrix: [Float]
+    let outputChannels: UInt32
+    let inputChannels: UInt32
+}
+
+/// Brings interleaved Float32 frames to a channel map's layout ahead of
+/// conversion and chunking, so channels the map drops are never resampled or
+/// buffered. The output buffer is allocated up front for `maxFrames` and only
+/// grows if a larger packet arrives.
+final class ChannelMapper {
+    let outputChannels: UInt32
+    private let deviceChannels: UInt32
+    private var matrix: [Float]
+    private var output: UnsafeMutablePointer<Float>
+    private var capacityFrames: Int
+
+    /// Nil if the device has fewer channels than the map reads
+    init?(_ setting: ChannelMapSetting, deviceChannels: UInt32, maxFrames: Int) {
+        guard setting.outputChannels > 0, deviceChannels >= setting.inputChannels,
+              deviceChannels <= UInt32(AUDIO_DSP_MAX_CHANNELS)
+        else {
+            return nil
+        }
+
+        // Widen the matrix with zero weights to every channel of the device
+        var widened = [Float](repeating: 0, count: Int(setting.outputChannels * deviceChannels))
+        for o in 0..<Int(setting.outputChannels) {
+            for i in 0..<Int(setting.inputChannels) {
+                widened[o * Int(deviceChannels) + i] = setting.matrix[o * Int(setting.inputChannels) + i]
+            }
+        }
+
+        self.outputChannels = setting.outputChannels
+        self.deviceChannels = deviceChannels
+        self.matrix = widened
+        self.capacityFrames = max(1, maxFrames)
+        self.output = UnsafeMutablePointer<Float>.allocate(capacity: capacityFrames * Int(setting.outputChannels))
+    }
+
+    deinit {
+        output.deallocate()
+    }
+
+    /// Interleaved Float32 in the map's layout, at the source's rate
+    func format(from source: AudioStreamBasicDescription) -> AudioStreamBasicDescription {
+        return ChannelMapper.interleavedFloat(sampleRate: source.mSampleRate, channels: outputChannels)
+    }
+
+    /// Map `frames` interleaved frames of the device's channels. The result
+    /// stays valid until the next call.
+    func map(_ input: UnsafeRawPointer, frames: Int) -> UnsafeRawBufferPointer {
+        if frames > capacityFrames {
+            output.deallocate()
+            capacityFrames = frames
+            output = UnsafeMutablePointer<Float>.allocate(capacity: capacityFrames * Int(outputChannels))
+        }
+
+        matrix.withUnsafeBufferPointer { weights in
+            audio_dsp_mix_channels(
+                input.assumingMemoryBound(to: Float.self), output, frames, deviceChannels,
+                weights.baseAddress!, outputChannels
+            )
+        }
+        return UnsafeRawBufferPointer(start: output, count: frames * Int(outputChannels) * MemoryLayout<Float>.size)
+    }
+
+    static func interleavedFloat(sampleRate: Double, channels: UInt32) -> AudioStreamBasicDescription {
+        let bytesPerFrame = channels * UInt32(MemoryLayout<Float>.size)
+        return AudioStreamBasicDescription(
+            mSampleRate: sampleRate,
+            mFormatID: kAudioFormatLinearPCM,
+            mFormatFlags: kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked,
+            mBytesPerPacket: bytesPerFrame,
+            mFramesPerPacket: 1,
+            mBytesPerFrame: bytesPerFrame,
+            mChannelsPerFrame: channels,
+            mBitsPerChannel: 32,
+            mReserved: 0
+        )
+    }
+
+    /// Interleave the Float32 buffers of a buffer list, whatever their split
+    /// of channels, into `frames` frames of `channels` at `out`. Allocation
+    /// free, for the IO thread.
+    static func interleave(
+        _ buffers: UnsafeMutableAudioBufferListPointer,
+        frames: Int,
+        channels: Int,
+        into out: UnsafeMutablePointer<Float>
+    ) {
+        var firstChannel = 0
+        for buffer in buffers {
+            let bufferChannels = Int(buffer.mNumberChannels)
+            guard bufferChannels > 0, firstChannel + bufferChannels <= channels else { continue }
+
+            let samples = buffer.mData?.assumingMemoryBound(to: Float.self)
+            let available = samples == nil
+                ? 0 : min(frames, Int(buffer.mDataByteSize) / (bufferChannels * MemoryLayout<Float>.size))
+            for frame in 0..<frames {
+                for c in 0..<bufferChannels {
+                    out[frame * channels + firstChannel + c] = frame < available
+                        ? samples![frame * bufferChannels + c] : 0
+                }
+            }
+            firstChannel += bufferChannels
+        }
+    }
+}
@@ -0,0 +1,93 @@
+import Darwin
+import Foundation
+
+/// Host timestamps for a stream of output chunks; the Swift counterpart of
+/// native/common/chunk_clock.h.
+///
+/// Capture callbacks report the host time of the source frame they deliver.
+/// The clock keeps the latest (host time, source frame) pair and extrapolates
+/// from it, so chunks cut after conversion can be stamped with the time of
+/// their first frame. Device sample times and discontinuities are carried over
+/// the same way; the device counts at the source rate.
+struct ChunkClock {
+    private let nsPerOutputFrame: Double
+    private let outputFramesPerSourceFrame: Double
+    private var anchorHostNs: UInt64 = 0
+    private var anchorOutputFrame: Double = 0
+    private var anchored = false
+    private var anchorDevicePosition: UInt64 = 0
+    private var anchorDeviceOutputFrame: Double = 0
+    private var deviceAnchored = false
+    private var discontinuityOutputFrame: Double?
+
+    /// Output frames handed out so far
+    private(set) var position: UInt64 = 0
+
+    init(sourceSampleRate: Double, outputSampleRate: Double) {
+        nsPerOutputFrame = outputSampleRate > 0 ? 1e9 / outputSampleRate : 0
+        outputFramesPerSourceFrame = sourceSampleRate > 0 ? outputSampleRate / sourceSampleRate : 1
+    }
+
+    /// Source frame `sourceFrame` (counted from the session start) was captured at hostTimeNs
+    mutating func anchor(hostTimeNs: UInt64, sourceFrame: UInt64) {
+        guard hostTimeNs != 0 else { return }
+        anchorHostNs = hostTimeNs
+        anchorOutputFrame = Double(sourceFrame) * outputFramesPerSourceFrame
+        anchored = true
+    }
+
+    /// Source frame `sourceFrame` is at `devicePosition` on the device's sample counter
+    mutating func anchorDevice(position devicePosition: UInt64, sourceFrame: UInt64) {
+        anchorDevicePosition = devicePosition
+        anchorDeviceOutputFrame = Double(sourceFrame) * outputFramesPerSourceFrame
+        deviceAnchored = true
+    }
+
+    /// Audio before source frame `sourceFrame` was lost; flags the chunk holding it
+    mutating func markDiscontinuity(sourceFrame: UInt64) {
+        let frame = Double(sourceFrame) * outputFramesPerSourceFrame
+        discontinuityOutputFrame = min(discontinuityOutputFrame ?? frame, frame)
+    }
+
+    /// Describe the next chunk of `frames` output frames and advance past it
+    mutating func next(frames: Int) -> AudioChunkInfo {
+        let frames = UInt64(max(frames, 0))
+        var info = AudioChunkInfo()
+        info.framePosition = position
+
+        if anchored {
+            let ns = Double(anchorHostNs) + (Double(position) - anchorOutputFrame) * nsPerOutputFrame
+            info.hostTimeNs = ns > 0 ? UInt64(ns.rounded()) : 0
+        }
+
+        if deviceAnchored {
+            let device = Double(anchorDevicePosition)
+                + (Double(position) - anchorDeviceOutputFrame) / outputFramesPerSourceFrame
+            if device >= 0 {
+                info.devicePosition = UInt64(device.rounded())
+                info.flags |= UInt32(AUDIO_CHUNK_DEVICE_POSITION)
+            }
+        }
+
+        // A discontinuity ahead of this chunk's end belongs to it
+        if let frame = discontinuityOutputFrame, frame < Double(position + frames) {
+            info.flags |= UInt32(AUDIO_CHUNK_DISCONTINUITY)
+            discontinuityOutputFrame = nil
+        }
+
+        position += frames
+        return info
+    }
+
+    /// Convert mach_absolute_time ticks to nanoseconds
+    static func nanoseconds(fromHostTime hostTime: UInt64) -> UInt64 {
+        let timebase = ChunkClock.timebase
+        return UInt64(Double(hostTime) * Double(timebase.numer) / Double(timebase.denom))
+    }
+
+    private static let timebase: mach_timebase_info_data_t = {
+        var info = mach_timebase_info_data_t()
+        mach_timebase_info(&info)
+        return info
+    }()
+}
@@ -12,6 +12,7 @@ public typealias AudioRecorderHandle = UnsafeMutableRawPointer
 public typealias AudioDataCallback = @convention(c) (
     UnsafePointer<UInt8>,  // data pointer
     Int32,                  // data length
+    UnsafePointer<AudioChunkInfo>, // chunk timing
     UnsafeMutableRawPointer? // user context
 ) -> Void
 
@@ -44,11 +45,27 @@ enum AudioSource {
 class AudioRecorderSession {
     var source: AudioSource?
     var tapManager: AudioTapManager?
+    var tapConfig: TapConfiguration?
     var recorder: NativeAudioRecorder?
     var micCaptureManager: MicrophoneCaptureManager?
     var micRecorder: MicrophoneRecorder?
     var isRunning: Bool = false
 
+    /// Device IO buffer duration for the next start, in milliseconds (0 = device default)
+    var bufferDurationMs: Double = 0
+
+    /// Sample rate converter quality for the next start (0 = fast, 1 = balanced, 2 = high)
+    var resamplerQuality: Int32 = 1
+
+    /// How long a stopped system audio tap stays in TapPool for reuse, in milliseconds (0 = destroy on stop)
+    var tapCacheTtlMs: Double = 0
+
+    /// Channel map for the next start; nil keeps the mono/stereo choice
+    var channelMap: ChannelMapSetting?
+
+    /// Counters shared by whichever recorder this session runs; reset on each start
+    let stats: OpaquePointer? = audio_stats_create()
+
     let dataCallback: AudioDataCallback?
     let eventCallback: AudioEventCallback?
     let metadataCallback: AudioMetadataCallback?
@@ -66,11 +83,37 @@ class AudioRecorderSession {
         self.userContext = userContext
     }
 
-    func emitData(_ data: Data) {
+    deinit {
+        if let stats = stats {
+            audio_stats_destroy(stats)
+        }
+    }
+
+    func resetStats() {
+        if let stats = stats {
+            audio_stats_reset(stats)
+        }
+    }
+
+    /// Undo a system audio start that failed after the tap was created
+    func resetSystemAudio() {
+        isRunning = false
+        recorder = nil
+        tapManager = nil
+        tapConfig = nil
+        source = nil
+    }
+
+    func emitData(_ data: Data, info: AudioChunkInfo) {
         data.withUnsafeBytes { buffer in
-            if let baseAddress = buffer.baseAddress?.assumingMemoryBound(to: UInt8.self) {
-                dataCallback?(baseAddress, Int32(buffer.count), userContext)
-            }
+            emitData(buffer, info: info)
+        }
+    }
+
+    func emitData(_ buffer: UnsafeRawBufferPointer, info: AudioChunkInfo) {
+        if let baseAddress = buffer.baseAddress?.assumingMemoryBound(to: UInt8.self) {
+            var info = info
+            dataCallback?(baseAddress, Int32(buffer.count), &info, userContext)
         }
     }
 
@@ -140,6 +183,7 @@ public func audio_start_system_audio(
     if session.isRunning {
         return -2 // Already running
     }
+    session.resetStats()
 
     // Convert process arrays
     var includeList: [Int32] = []
@@ -174,10 +218,10 @@ public func audio_start_system_audio(
         isMono: isMono
     )
 
-    // Set up audio tap
-    let tapManager = AudioTapManager()
+    // Set up audio tap, or reuse an idle one of the same configuration
+    let tapManager: AudioTapManager
     do {
-        try tapManager.setupAudioTap(with: tapConfig)
+        tapManager = try TapPool.shared.acquire(tapConfig)
     } catch {
         session.emitEvent(2, message: "Failed to setup audio tap: \(error)")
         return -3
@@ -190,6 +234,7 @@ public func audio_start_system_audio(
 
     session.source = .systemAudio
     session.tapManager = tapManager
+    session.tapConfig = tapConfig
 
     // Create native output handler that calls our callbacks
     let outputHandler = NativeAudioOutputHandler(session: session)
@@ -205,11 +250,21 @@ public func audio_start_system_audio(
             deviceID: deviceID,
             outputHandler: outputHandler,
             convertToSampleRate: targetSampleRate,
-            chunkDuration: chunkDurationSec
+            chunkDuration: chunkDurationSec,
+            bufferDuration: session.bufferDurationMs / 1000.0,
+            resamplerQuality: session.resamplerQuality,
+            channelMap: session.channelMap,
+            stats: session.stats
         )
     } catch AudioFormatError.formatUnavailable(let deviceID, let status) {
         session.emitEvent(2, message: "Failed to get audio format from device \(deviceID): OSStatus \(status)")
         return -5
+    } catch AudioTeeError.channelMapMismatch(let deviceChannels, let mapChannels) {
+        session.resetSystemAudio()
+        session.emitEvent(
+            2, message: "The channel map reads \(mapChannels) channels; the tap has \(deviceChannels)"
+        )
+        return -9
     } catch {
         session.emitEvent(2, message: "Failed to create recorder: \(error)")
         return -6
@@ -218,17 +273,22 @@ public func audio_start_system_audio(
     session.recorder = recorder
     session.isRunning = true
 
-    // Start recording in a background thread
-    DispatchQueue.global(qos: .userInitiated).async {
-        recorder.startRecording()
-
-        // Run the audio processing loop
-        while session.isRunning {
-            let result = CFRunLoopRunInMode(CFRunLoopMode.defaultMode, 0.01, false)
-            if result == CFRunLoopRunResult.stopped || result == CFRunLoopRunResult.finished {
-                break
-            }
-        }
+    // The IOProc runs on CoreAudio's IO thread, so there is nothing to keep a
+    // run loop alive for; starting here also surfaces failures to the caller
+    do {
+        try recorder.startRecording()
+    } catch AudioTeeError.ioProcCreationFailed(let status) {
+        session.resetSystemAudio()
+        session.emitEvent(2, message: "Failed to create IO proc: \(status)")
+        return -7
+    } catch AudioTeeError.deviceStartFailed(let status) {
+        session.resetSystemAudio()
+        session.emitEvent(2, message: "Failed to start audio device: \(status)")
+        return -8
+    } catch {
+        session.resetSystemAudio()
+        session.emitEvent(2, message: "Failed to start recording: \(error)")
+        return -8
     }
 
     return 0
@@ -252,6 +312,7 @@ public func audio_start_microphone(
     if session.isRunning {
         return -2 // Already running
     }
+    session.resetStats()
 
     // Convert device UID if provided
     let deviceUIDString: String? = deviceUID != nil ? String(cString: deviceUID!) : nil
@@ -276,7 +337,10 @@ public func audio_start_microphone(
         convertToSampleRate: targetSampleRate,
         chunkDuration: chunkDurationSec,
         gain: micCaptureManager.getGain(),
-        deviceUID: deviceUIDString
+        deviceUID: deviceUIDString,
+        resamplerQuality: session.resamplerQuality,
+        channelMap: session.channelMap,
+        stats: session.stats
     )
 
     session.micRecorder = micRecorder
@@ -305,6 +369,12 @@ public func audio_start_microphone(
         session.isRunning = false
         session.emitEvent(2, message: "Capture session error: \(message)")
         return -7
+    } catch MicrophoneError.channelMapMismatch(let deviceChannels, let mapChannels) {
+        session.isRunning = false
+        session.emitEvent(
+            2, message: "The channel map reads \(mapChannels) channels; the device has \(deviceChannels)"
+        )
+        return -9
     } catch {
         session.isRunning = false
         session.emitEvent(2, message: "Failed to start microphone: \(error)")
@@ -330,7 +400,11 @@ public func audio_stop(handle: AudioRecorderHandle) -> Int32 {
     // Stop system audio recorder if running
     session.recorder?.stopRecording()
     session.recorder = nil
+    if let tapManager = session.tapManager, let tapConfig = session.tapConfig {
+        TapPool.shared.release(tapManager, config: tapConfig, ttlMs: session.tapCacheTtlMs)
+    }
     session.tapManager = nil
+    session.tapConfig = nil
 
     // Stop microphone recorder if running
     session.micRecorder?.stopRecording()
@@ -360,3 +434,113 @@ public func audio_is_running(handle: AudioRecorderHandle) -> Bool {
     }
     return session.isRunning
 }
+
+/// Set the device IO buffer duration used by the next start
+@_cdecl("audio_set_buffer_duration")
+public func audio_set_buffer_duration(handle: AudioRecorderHandle, bufferDurationMs: Double) -> Int32 {
+    guard let session = Unmanaged<AudioRecorderSession>.fromOpaque(handle).takeUnretainedValue() as AudioRecorderSession? else {
+        return -1
+    }
+
+    if session.isRunning {
+        return -2
+    }
+
+    session.bufferDurationMs = max(0, bufferDurationMs)
+    return 0
+}
+
+/// Set how long the next start's tap is kept for reuse once it stops
+@_cdecl("audio_set_tap_cache_ttl")
+public func audio_set_tap_cache_ttl(handle: AudioRecorderHandle, ttlMs: Double) -> Int32 {
+    guard let session = Unmanaged<AudioRecorderSession>.fromOpaque(handle).takeUnretainedValue() as AudioRecorderSession? else {
+        return -1
+    }
+
+    if session.isRunning {
+        return -2
+    }
+
+    session.tapCacheTtlMs = ttlMs.isFinite ? max(0, ttlMs) : 0
+    return 0
+}
+
+/// Validate the latency mode; Core Audio's latency follows the IO buffer duration
+@_cdecl("audio_set_latency_mode")
+public func audio_set_latency_mode(handle: AudioRecorderHandle, mode: Int32) -> Int32 {
+    guard let session = Unmanaged<AudioRecorderSession>.fromOpaque(handle).takeUnretainedValue() as AudioRecorderSession? else {
+        return -1
+    }
+
+    if mode < 0 || mode > 2 {
+        return -3
+    }
+
+    return session.isRunning ? -2 : 0
+}
+
+/// Set the channel map used by the next start; a nil matrix or no outputs clear it
+@_cdecl("audio_set_channel_map")
+public func audio_set_channel_map(
+    handle: AudioRecorderHandle,
+    matrix: UnsafePointer<Float>?,
+    outputChannels: UInt32,
+    inputChannels: UInt32
+) -> Int32 {
+    guard let session = Unmanaged<AudioRecorderSession>.fromOpaque(handle).takeUnretainedValue() as AudioRecorderSession? else {
+        return -1
+    }
+
+    if session.isRunning {
+        return -2
+    }
+
+    guard let matrix = matrix, outputChannels > 0 else {
+        session.channelMap = nil
+        return 0
+    }
+
+    guard inputChannels > 0, inputChannels <= UInt32(AUDIO_DSP_MAX_CHANNELS),
+          outputChannels <= UInt32(AUDIO_DSP_MAX_CHANNELS)
+    else {
+        return -3
+    }
+
+    session.channelMap = ChannelMapSetting(
+        matrix: Array(UnsafeBufferPointer(start: matrix, count: Int(outputChannels * inputChannels))),
+        outputChannels: outputChannels,
+        inputChannels: inputChannels
+    )
+    return 0
+}
+
+/// Set the sample rate converter quality used by the next start
+@_cdecl("audio_set_resampler_quality")
+public func audio_set_resampler_quality(handle: AudioRecorderHandle, quality: Int32) -> Int32 {
+    guard let session = Unmanaged<AudioRecorderSession>.fromOpaque(handle).takeUnretainedValue() as AudioRecorderSession? else {
+        return -1
+    }
+
+    guard (0...2).contains(quality) else {
+        return -3
+    }
+
+    if session.isRunning {
+        return -2
+    }
+
+    session.resamplerQuality = quality
+    return 0
+}
+
+/// Copy the counters of the current or most recent capture
+@_cdecl("audio_get_stats")
+public func audio_get_stats(handle: AudioRecorderHandle, stats: UnsafeMutablePointer<AudioStatsSnapshot>?) -> Int32 {
+    guard let session = Unmanaged<AudioRecorderSession>.fromOpaque(handle).takeUnretainedValue() as AudioRecorderSession?,
+          let counters = session.stats, let stats = stats else {
+        return -1
+    }
+
+    audio_stats_snapshot(counters, stats)
+    return 0
+}
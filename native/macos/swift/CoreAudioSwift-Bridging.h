@@ -0,0 +1,7 @@
+// C APIs from native/include that the Swift code calls into. Their
+// implementations are compiled into the addon alongside the Swift library.
+
+#include "audio_chunk_info.h"
+#include "audio_dsp.h"
+#include "audio_ring.h"
+#include "audio_stats.h"
@@ -0,0 +1,166 @@
+import CoreAudio
+import Foundation
+
+/// Callback type for device changes: event type (0 = added, 1 = removed,
+/// 2 = default changed), the device (an AudioDeviceInfo, nil when there no
+/// longer is a default), whether it concerns inputs, and the user context
+public typealias AudioDeviceChangeCallback = @convention(c) (
+    Int32,
+    UnsafeRawPointer?,
+    Bool,
+    UnsafeMutableRawPointer?
+) -> Void
+
+/// Device list kept current by Core Audio property listeners.
+///
+/// The first lookup enumerates through AudioDeviceManager and installs
+/// listeners for the device list and both defaults on the system object.
+/// Each notification re-enumerates on the registry's queue, diffs against the
+/// previous list and reports the differences to every watcher. Lookups are
+/// answered from the last enumeration. The registry lives for the rest of the
+/// process.
+final class DeviceRegistry {
+    static let shared = DeviceRegistry()
+
+    final class Watcher {
+        let callback: AudioDeviceChangeCallback
+        let context: UnsafeMutableRawPointer?
+
+        init(callback: AudioDeviceChangeCallback, context: UnsafeMutableRawPointer?) {
+            self.callback = callback
+            self.context = context
+        }
+    }
+
+    private enum Change {
+        case added(DeviceInfo)
+        case removed(DeviceInfo)
+        case defaultChanged(DeviceInfo?, isInput: Bool)
+    }
+
+    // Everything below is only touched on this queue
+    private let queue = DispatchQueue(label: "native-audio.device-registry")
+    private var started = false
+    private var devices: [DeviceInfo] = []
+    private var defaultInput: String?
+    private var defaultOutput: String?
+    private var watchers: [Watcher] = []
+
+    private static let listenedSelectors: [AudioObjectPropertySelector] = [
+        kAudioHardwarePropertyDevices,
+        kAudioHardwarePropertyDefaultInputDevice,
+        kAudioHardwarePropertyDefaultOutputDevice,
+    ]
+
+    func listDevices() -> [DeviceInfo] {
+        return queue.sync {
+            startIfNeeded()
+            return devices
+        }
+    }
+
+    func defaultDeviceUID(isInput: Bool) -> String? {
+        return queue.sync {
+            startIfNeeded()
+            return isInput ? defaultInput : defaultOutput
+        }
+    }
+
+    /// Callbacks run on the registry's queue; once removeWatcher returns, none
+    /// is running or will run for that watcher
+    func addWatcher(_ watcher: Watcher) {
+        queue.sync {
+            startIfNeeded()
+            watchers.append(watcher)
+        }
+    }
+
+    func removeWatcher(_ watcher: Watcher) {
+        queue.sync {
+            watchers.removeAll { $0 === watcher }
+        }
+    }
+
+    private func startIfNeeded() {
+        guard !started else { return }
+        started = true
+
+        for selector in DeviceRegistry.listenedSelectors {
+            var address = AudioObjectPropertyAddress(
+                mSelector: selector,
+                mScope: kAudioObjectPropertyScopeGlobal,
+                mElement: kAudioObjectPropertyElementMain
+            )
+            // Bursts of notifications each re-enumerate; the diff keeps the
+            // reported changes to what actually differs
+            let systemObject = AudioObjectID(kAudioObjectSystemObject)
+            AudioObjectAddPropertyListenerBlock(systemObject, &address, queue) { [weak self] _, _ in
+                self?.refresh()
+            }
+        }
+
+        (devices, defaultInput, defaultOutput) = DeviceRegistry.enumerate()
+    }
+
+    private func refresh() {
+        let (current, currentInput, currentOutput) = DeviceRegistry.enumerate()
+        var changes: [Change] = []
+
+        func key(_ device: DeviceInfo) -> String {
+            return (device.isInput ? "in:" : "out:") + device.uid
+        }
+        let previousKeys = Set(devices.map(key))
+        let currentKeys = Set(current.map(key))
+
+        for device in devices where !currentKeys.contains(key(device)) {
+            changes.append(.removed(device))
+        }
+        for device in current where !previousKeys.contains(key(device)) {
+            changes.append(.added(device))
+        }
+        if currentInput != defaultInput {
+            changes.append(.defaultChanged(current.first { $0.isInput && $0.uid == currentInput }, isInput: true))
+        }
+        if currentOutput != defaultOutput {
+            changes.append(.defaultChanged(current.first { !$0.isInput && $0.uid == currentOutput }, isInput: false))
+        }
+
+        devices = current
+        defaultInput = currentInput
+        defaultOutput = currentOutput
+
+        for change in changes {
+            switch change {
+            case .added(let device):
+                dispatch(0, device: device, isInput: device.isInput)
+            case .removed(let device):
+                dispatch(1, device: device, isInput: device.isInput)
+            case .defaultChanged(let device, let isInput):
+                dispatch(2, device: device, isInput: isInput)
+            }
+        }
+    }
+
+    private func dispatch(_ eventType: Int32, device: DeviceInfo?, isInput: Bool) {
+        guard let device = device else {
+            for watcher in watchers {
+                watcher.callback(eventType, nil, isInput, watcher.context)
+            }
+            return
+        }
+
+        withDeviceInfo(device) { info in
+            for watcher in watchers {
+                watcher.callback(eventType, info, isInput, watcher.context)
+            }
+        }
+    }
+
+    private static func enumerate() -> ([DeviceInfo], String?, String?) {
+        return (
+            AudioDeviceManager.listAllDevices(),
+            AudioDeviceManager.getDefaultInputDeviceUID(),
+            AudioDeviceManager.getDefaultOutputDeviceUID()
+        )
+    }
+}
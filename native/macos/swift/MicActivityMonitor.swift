@@ -7,11 +7,13 @@ import Darwin
 public typealias MicActivityChangeCallback = @convention(c) (Bool, UnsafeMutableRawPointer?) -> Void
 public typealias MicActivityDeviceCallback = @convention(c) (UnsafePointer<CChar>?, UnsafePointer<CChar>?, Bool, UnsafeMutableRawPointer?) -> Void
 public typealias MicActivityErrorCallback = @convention(c) (UnsafePointer<CChar>?, UnsafeMutableRawPointer?) -> Void
+public typealias MicActivityProcessCallback = @convention(c) (Int32, UnsafePointer<CChar>?, UnsafePointer<CChar>?, Bool, UnsafeMutableRawPointer?) -> Void
 
 class MicActivityMonitor {
     private var changeCallback: MicActivityChangeCallback?
     private var deviceCallback: MicActivityDeviceCallback?
     private var errorCallback: MicActivityErrorCallback?
+    private var processCallback: MicActivityProcessCallback?
     private var userContext: UnsafeMutableRawPointer?
     
     private var monitoredDevices: [AudioDeviceID: Bool] = [:]
@@ -19,6 +21,23 @@ class MicActivityMonitor {
     private var isRunning = false
     private var monitorAllDevices = true
     private var lastAggregateState = false
+
+    private struct ProcessIdentity {
+        let name: String
+        let bundleId: String
+    }
+
+    private struct TrackedProcess {
+        let pid: pid_t
+        var isRunningInput: Bool
+        let listener: AudioObjectPropertyListenerBlock
+    }
+
+    // Process table, only touched on the queue
+    private var processListListener: AudioObjectPropertyListenerBlock?
+    private var processes: [AudioObjectID: TrackedProcess] = [:]
+    private var activeProcessObjects: [AudioObjectID] = []
+    private var identities: [pid_t: ProcessIdentity] = [:]
     
     private let queue = DispatchQueue(label: "com.native-audio-node.mic-activity", qos: .userInitiated)
     
@@ -26,11 +45,13 @@ class MicActivityMonitor {
         changeCallback: MicActivityChangeCallback?,
         deviceCallback: MicActivityDeviceCallback?,
         errorCallback: MicActivityErrorCallback?,
+        processCallback: MicActivityProcessCallback?,
         userContext: UnsafeMutableRawPointer?
     ) {
         self.changeCallback = changeCallback
         self.deviceCallback = deviceCallback
         self.errorCallback = errorCallback
+        self.processCallback = processCallback
         self.userContext = userContext
     }
     
@@ -49,6 +70,10 @@ class MicActivityMonitor {
         } else {
             setupDefaultInputDeviceListener()
         }
+
+        queue.sync {
+            startProcessTracking()
+        }
         
         return 0
     }
@@ -59,6 +84,11 @@ class MicActivityMonitor {
         isRunning = false
         removeAllListeners()
         monitoredDevices.removeAll()
+
+        // Also waits out any listener block still running
+        queue.sync {
+            stopProcessTracking()
+        }
         
         return 0
     }
@@ -90,15 +120,194 @@ class MicActivityMonitor {
         return nil
     }
     
+    /// Processes using input, in the order they started. While the monitor
+    /// runs this is answered from the process table; otherwise it scans.
     func getActiveProcesses() -> [(pid: pid_t, name: String, bundleId: String)] {
-        var result: [(pid: pid_t, name: String, bundleId: String)] = []
-        
+        return queue.sync {
+            guard processListListener != nil else {
+                return readProcessObjectList()
+                    .filter { readIsRunningInput($0) }
+                    .map { objectId -> (pid: pid_t, name: String, bundleId: String) in
+                        let pid = readPID(objectId)
+                        let resolved = resolveIdentity(objectId, pid: pid)
+                        return (pid: pid, name: resolved.name, bundleId: resolved.bundleId)
+                    }
+            }
+
+            return activeProcessObjects.compactMap { objectId -> (pid: pid_t, name: String, bundleId: String)? in
+                guard let process = processes[objectId] else { return nil }
+                let known = identity(of: objectId, pid: process.pid)
+                return (pid: process.pid, name: known.name, bundleId: known.bundleId)
+            }
+        }
+    }
+
+    // MARK: - Process Tracking
+
+    // The process table: every process object the HAL lists, with a listener
+    // on its IsRunningInput. Only touched on the queue.
+
+    private func startProcessTracking() {
+        guard processListListener == nil else { return }
+
         var address = AudioObjectPropertyAddress(
             mSelector: kAudioHardwarePropertyProcessObjectList,
             mScope: kAudioObjectPropertyScopeGlobal,
             mElement: kAudioObjectPropertyElementMain
         )
-        
+
+        let listenerBlock: AudioObjectPropertyListenerBlock = { [weak self] _, _ in
+            self?.syncProcessTable()
+        }
+
+        let status = AudioObjectAddPropertyListenerBlock(
+            AudioObjectID(kAudioObjectSystemObject),
+            &address,
+            queue,
+            listenerBlock
+        )
+
+        guard status == noErr else {
+            // getActiveProcesses falls back to scanning
+            emitError("Failed to add process list listener: \(status)")
+            return
+        }
+
+        processListListener = listenerBlock
+        syncProcessTable()
+    }
+
+    private func stopProcessTracking() {
+        guard let listenerBlock = processListListener else { return }
+
+        var address = AudioObjectPropertyAddress(
+            mSelector: kAudioHardwarePropertyProcessObjectList,
+            mScope: kAudioObjectPropertyScopeGlobal,
+            mElement: kAudioObjectPropertyElementMain
+        )
+
+        AudioObjectRemovePropertyListenerBlock(
+            AudioObjectID(kAudioObjectSystemObject),
+            &address,
+            queue,
+            listenerBlock
+        )
+        processListListener = nil
+
+        for objectId in Array(processes.keys) {
+            removeProcessListener(objectId: objectId)
+        }
+        processes.removeAll()
+        activeProcessObjects.removeAll()
+        identities.removeAll()
+    }
+
+    private func syncProcessTable() {
+        guard processListListener != nil else { return }
+
+        let current = Set(readProcessObjectList())
+
+        for objectId in processes.keys.filter({ !current.contains($0) }) {
+            untrackProcess(objectId: objectId)
+        }
+        for objectId in current where processes[objectId] == nil {
+            trackProcess(objectId: objectId)
+        }
+    }
+
+    private func trackProcess(objectId: AudioObjectID) {
+        var address = AudioObjectPropertyAddress(
+            mSelector: kAudioProcessPropertyIsRunningInput,
+            mScope: kAudioObjectPropertyScopeGlobal,
+            mElement: kAudioObjectPropertyElementMain
+        )
+
+        let listenerBlock: AudioObjectPropertyListenerBlock = { [weak self] _, _ in
+            self?.handleProcessInputChange(objectId: objectId)
+        }
+
+        let status = AudioObjectAddPropertyListenerBlock(objectId, &address, queue, listenerBlock)
+
+        // A process that exited before it could be tracked is dropped from the
+        // list by the next list change
+        guard status == noErr else { return }
+
+        processes[objectId] = TrackedProcess(pid: readPID(objectId), isRunningInput: false, listener: listenerBlock)
+        handleProcessInputChange(objectId: objectId)
+    }
+
+    private func untrackProcess(objectId: AudioObjectID) {
+        guard let process = processes[objectId] else { return }
+
+        removeProcessListener(objectId: objectId)
+        if process.isRunningInput {
+            activeProcessObjects.removeAll { $0 == objectId }
+            emitProcessChange(objectId: objectId, pid: process.pid, isActive: false)
+        }
+
+        processes.removeValue(forKey: objectId)
+        // PIDs are reused, so the name goes with the process
+        identities.removeValue(forKey: process.pid)
+    }
+
+    private func removeProcessListener(objectId: AudioObjectID) {
+        guard let process = processes[objectId] else { return }
+
+        var address = AudioObjectPropertyAddress(
+            mSelector: kAudioProcessPropertyIsRunningInput,
+            mScope: kAudioObjectPropertyScopeGlobal,
+            mElement: kAudioObjectPropertyElementMain
+        )
+
+        AudioObjectRemovePropertyListenerBlock(objectId, &address, queue, process.listener)
+    }
+
+    private func handleProcessInputChange(objectId: AudioObjectID) {
+        guard var process = processes[objectId] else { return }
+
+        let isRunningInput = readIsRunningInput(objectId)
+        guard isRunningInput != process.isRunningInput else { return }
+
+        process.isRunningInput = isRunningInput
+        processes[objectId] = process
+
+        if isRunningInput {
+            activeProcessObjects.append(objectId)
+        } else {
+            activeProcessObjects.removeAll { $0 == objectId }
+        }
+
+        emitProcessChange(objectId: objectId, pid: process.pid, isActive: isRunningInput)
+    }
+
+    /// Name and bundle ID of a tracked process, looked up once per PID
+    private func identity(of objectId: AudioObjectID, pid: pid_t) -> ProcessIdentity {
+        if let known = identities[pid] {
+            return known
+        }
+        let resolved = resolveIdentity(objectId, pid: pid)
+        identities[pid] = resolved
+        return resolved
+    }
+
+    private func resolveIdentity(_ objectId: AudioObjectID, pid: pid_t) -> ProcessIdentity {
+        var bundleRef: Unmanaged<CFString>?
+        _ = readProcessProperty(objectId, kAudioProcessPropertyBundleID, into: &bundleRef)
+        let bundleId = (bundleRef?.takeUnretainedValue() as String?) ?? ""
+
+        let app = NSRunningApplication(processIdentifier: pid)
+        let name = app?.localizedName ?? getProcessName(pid: pid) ?? "PID \(pid)"
+
+        return ProcessIdentity(name: name, bundleId: bundleId)
+    }
+
+    private func readProcessObjectList() -> [AudioObjectID] {
+        var address = AudioObjectPropertyAddress(
+            mSelector: kAudioHardwarePropertyProcessObjectList,
+            mScope: kAudioObjectPropertyScopeGlobal,
+            mElement: kAudioObjectPropertyElementMain
+        )
+
         var dataSize: UInt32 = 0
         var status = AudioObjectGetPropertyDataSize(
             AudioObjectID(kAudioObjectSystemObject),
@@ -106,12 +315,12 @@ class MicActivityMonitor {
             0, nil,
             &dataSize
         )
-        
-        guard status == noErr && dataSize > 0 else { return result }
-        
+
+        guard status == noErr && dataSize > 0 else { return [] }
+
         let count = Int(dataSize) / MemoryLayout<AudioObjectID>.size
         var processIDs = [AudioObjectID](repeating: 0, count: count)
-        
+
         status = AudioObjectGetPropertyData(
             AudioObjectID(kAudioObjectSystemObject),
             &address,
@@ -119,53 +328,40 @@ class MicActivityMonitor {
             &dataSize,
             &processIDs
         )
-        
-        guard status == noErr else { return result }
-        
-        for procID in processIDs {
-            var inputAddr = AudioObjectPropertyAddress(
-                mSelector: kAudioProcessPropertyIsRunningInput,
-                mScope: kAudioObjectPropertyScopeGlobal,
-                mElement: kAudioObjectPropertyElementMain
-            )
-            var isRunningInput: UInt32 = 0
-            var inputSize = UInt32(MemoryLayout<UInt32>.size)
-            let inputStatus = AudioObjectGetPropertyData(procID, &inputAddr, 0, nil, &inputSize, &isRunningInput)
-            
-            guard inputStatus == noErr && isRunningInput != 0 else { continue }
-            
-            var pidAddr = AudioObjectPropertyAddress(
-                mSelector: kAudioProcessPropertyPID,
-                mScope: kAudioObjectPropertyScopeGlobal,
-                mElement: kAudioObjectPropertyElementMain
-            )
-            var pid: pid_t = -1
-            var pidSize = UInt32(MemoryLayout<pid_t>.size)
-            AudioObjectGetPropertyData(procID, &pidAddr, 0, nil, &pidSize, &pid)
-            
-            var bundleAddr = AudioObjectPropertyAddress(
-                mSelector: kAudioProcessPropertyBundleID,
-                mScope: kAudioObjectPropertyScopeGlobal,
-                mElement: kAudioObjectPropertyElementMain
-            )
-            var bundleRef: Unmanaged<CFString>?
-            var bundleSize = UInt32(MemoryLayout<Unmanaged<CFString>?>.size)
-            AudioObjectGetPropertyData(procID, &bundleAddr, 0, nil, &bundleSize, &bundleRef)
-            let bundleId = (bundleRef?.takeUnretainedValue() as String?) ?? ""
-            
-            let app = NSRunningApplication(processIdentifier: pid)
-            var name = app?.localizedName
-            
-            if name == nil {
-                name = getProcessName(pid: pid)
-            }
-            
-            result.append((pid: pid, name: name ?? "PID \(pid)", bundleId: bundleId))
-        }
-        
-        return result
+
+        guard status == noErr else { return [] }
+
+        return processIDs
     }
-    
+
+    private func readIsRunningInput(_ objectId: AudioObjectID) -> Bool {
+        var isRunningInput: UInt32 = 0
+        return readProcessProperty(objectId, kAudioProcessPropertyIsRunningInput, into: &isRunningInput)
+            && isRunningInput != 0
+    }
+
+    private func readPID(_ objectId: AudioObjectID) -> pid_t {
+        var pid: pid_t = -1
+        _ = readProcessProperty(objectId, kAudioProcessPropertyPID, into: &pid)
+        return pid
+    }
+
+    private func readProcessProperty<T>(
+        _ objectId: AudioObjectID,
+        _ selector: AudioObjectPropertySelector,
+        into value: inout T
+    ) -> Bool {
+        var address = AudioObjectPropertyAddress(
+            mSelector: selector,
+            mScope: kAudioObjectPropertyScopeGlobal,
+            mElement: kAudioObjectPropertyElementMain
+        )
+        var dataSize = UInt32(MemoryLayout<T>.size)
+        return AudioObjectGetPropertyData(objectId, &address, 0, nil, &dataSize, &value) == noErr
+    }
+
+    // MARK: - Device Tracking
+
     private func setupAllInputDeviceListeners() {
         let inputDevices = getInputDevices()
         for deviceId in inputDevices {
@@ -469,6 +665,17 @@ class MicActivityMonitor {
         }
     }
     
+    private func emitProcessChange(objectId: AudioObjectID, pid: pid_t, isActive: Bool) {
+        guard let processCallback = processCallback else { return }
+        let known = identity(of: objectId, pid: pid)
+
+        known.name.withCString { namePtr in
+            known.bundleId.withCString { bundleIdPtr in
+                processCallback(pid, namePtr, bundleIdPtr, isActive, userContext)
+            }
+        }
+    }
+    
     private func emitError(_ message: String) {
         message.withCString { messagePtr in
             errorCallback?(messagePtr, userContext)
@@ -486,12 +693,14 @@ public func mic_activity_create(
     changeCallback: MicActivityChangeCallback?,
     deviceCallback: MicActivityDeviceCallback?,
     errorCallback: MicActivityErrorCallback?,
+    processCallback: MicActivityProcessCallback?,
     userContext: UnsafeMutableRawPointer?
 ) -> UnsafeMutableRawPointer? {
     let monitor = MicActivityMonitor(
         changeCallback: changeCallback,
         deviceCallback: deviceCallback,
         errorCallback: errorCallback,
+        processCallback: processCallback,
         userContext: userContext
     )
     
@@ -60,6 +60,7 @@ enum MicrophoneError: Error {
     case sessionConfigurationFailed(Error)
     case formatError(String)
     case captureSessionError(String)
+    case channelMapMismatch(deviceChannels: UInt32, mapChannels: UInt32)
 
     var localizedDescription: String {
         switch self {
@@ -75,6 +76,8 @@ enum MicrophoneError: Error {
             return "Audio format error: \(message)"
         case .captureSessionError(let message):
             return "Capture session error: \(message)"
+        case .channelMapMismatch(let deviceChannels, let mapChannels):
+            return "The channel map reads \(mapChannels) channels; the device has \(deviceChannels)"
         }
     }
 }
@@ -91,29 +94,65 @@ class MicrophoneRecorder: NSObject {
     private var chunkDuration: Double
     private var gain: Float
     private var deviceUID: String?
+    private var resamplerQuality: Int32
+    private let channelMap: ChannelMapSetting?
 
     private var audioBuffer: AudioBuffer?
     private var converter: AudioFormatConverter?
     private var finalFormat: AudioStreamBasicDescription?
-    private var sourceFormat: AudioStreamBasicDescription?
+    private var sourceFormat: AudioStreamBasicDescription?     // After the channel map
+    private var captureFormat: AudioStreamBasicDescription?    // As captured
     private var isRecording = false
     private var hasEmittedMetadata = false
 
+    // Sample buffers are asked for as interleaved Float32, but a device can
+    // still hand over one buffer per channel; those are interleaved here.
+    // Both grow to the largest buffer seen and are reused after that.
+    private var bufferListStorage: UnsafeMutableRawPointer?
+    private var bufferListCapacity = 0
+    private var interleaveScratch: UnsafeMutablePointer<Float>?
+    private var interleaveCapacity = 0
+    private var channelMapper: ChannelMapper?
+    private var channelMapFailed = false        // The delivered format had too few channels
+
+    // Chunk timestamps from the sample buffers' presentation times
+    private var chunkClock: ChunkClock?
+    private var capturedFrames: UInt64 = 0
+    private var expectedHostNs: UInt64 = 0     // Where the next sample buffer should start
+    private let stats: OpaquePointer?
+
     init(
         outputHandler: NativeAudioOutputHandler,
         convertToSampleRate: Double? = nil,
         chunkDuration: Double = 0.2,
         gain: Float = 1.0,
-        deviceUID: String? = nil
+        deviceUID: String? = nil,
+        resamplerQuality: Int32 = 1,
+        channelMap: ChannelMapSetting? = nil,
+        stats: OpaquePointer? = nil
     ) {
         self.outputHandler = outputHandler
+        self.stats = stats
         self.targetSampleRate = convertToSampleRate
         self.chunkDuration = chunkDuration
         self.gain = gain
         self.deviceUID = deviceUID
+        self.resamplerQuality = resamplerQuality
+        self.channelMap = channelMap
         super.init()
     }
 
+    deinit {
+        bufferListStorage?.deallocate()
+        interleaveScratch?.deallocate()
+    }
+
+    /// Channels of the device's active format, or nil if it doesn't say
+    private static func channelCount(of device: AVCaptureDevice) -> UInt32? {
+        let description = device.activeFormat.formatDescription
+        return CMAudioFormatDescriptionGetStreamBasicDescription(description)?.pointee.mChannelsPerFrame
+    }
+
     func startRecording() throws {
         guard !isRecording else { return }
 
@@ -131,6 +170,16 @@ class MicrophoneRecorder: NSObject {
             device = defaultDevice
         }
 
+        // Fail the start, rather than the first sample buffer, if the map
+        // reads channels the device doesn't have
+        if let channelMap = channelMap, let deviceChannels = MicrophoneRecorder.channelCount(of: device),
+           deviceChannels < channelMap.inputChannels
+        {
+            throw MicrophoneError.channelMapMismatch(
+                deviceChannels: deviceChannels, mapChannels: channelMap.inputChannels
+            )
+        }
+
         // Configure the capture session
         captureSession.beginConfiguration()
 
@@ -163,6 +212,16 @@ class MicrophoneRecorder: NSObject {
         let audioOutput = AVCaptureAudioDataOutput()
         audioOutput.setSampleBufferDelegate(self, queue: audioQueue)
 
+        // Native rate and channel count, as interleaved Float32: what the
+        // gain, channel map and converter expect
+        audioOutput.audioSettings = [
+            AVFormatIDKey: kAudioFormatLinearPCM,
+            AVLinearPCMIsFloatKey: true,
+            AVLinearPCMBitDepthKey: 32,
+            AVLinearPCMIsNonInterleaved: false,
+            AVLinearPCMIsBigEndianKey: false,
+        ]
+
         if captureSession.canAddOutput(audioOutput) {
             captureSession.addOutput(audioOutput)
             self.audioOutput = audioOutput
@@ -176,6 +235,7 @@ class MicrophoneRecorder: NSObject {
         // Start the session
         isRecording = true
         hasEmittedMetadata = false
+        channelMapFailed = false
 
         captureSession.startRunning()
 
@@ -192,17 +252,17 @@ class MicrophoneRecorder: NSObject {
 
         isRecording = false
 
-        // Process any remaining audio
-        if let buffer = audioBuffer, finalFormat != nil {
-            buffer.processChunks().forEach { packet in
-                let processedPacket = converter?.transform(packet) ?? packet
-                outputHandler.handleAudioPacket(processedPacket)
+        // Stop the session; stopRunning() returns once delegate callbacks have ceased
+        captureSession.stopRunning()
+
+        // Flush the converter tail and any remaining complete chunks
+        audioQueue.sync {
+            if let converter = converter, let audioBuffer = audioBuffer {
+                converter.finish(into: audioBuffer)
             }
+            processChunks()
         }
 
-        // Stop the session
-        captureSession.stopRunning()
-
         outputHandler.handleStreamStop()
     }
 
@@ -213,29 +273,53 @@ class MicrophoneRecorder: NSObject {
             return
         }
 
-        // Create source format (what we receive from the capture session)
-        // AVCaptureSession typically delivers Float32 interleaved audio
-        let sourceFormat = AudioStreamBasicDescription(
-            mSampleRate: format.mSampleRate,
-            mFormatID: kAudioFormatLinearPCM,
-            mFormatFlags: format.mFormatFlags,
-            mBytesPerPacket: format.mBytesPerPacket,
-            mFramesPerPacket: format.mFramesPerPacket,
-            mBytesPerFrame: format.mBytesPerFrame,
-            mChannelsPerFrame: format.mChannelsPerFrame,
-            mBitsPerChannel: format.mBitsPerChannel,
-            mReserved: 0
-        )
-
+        // What captureOutput passes on: the sample buffers' format, or its
+        // interleaved equivalent when they hold one buffer per channel
+        let captureFormat: AudioStreamBasicDescription
+        if format.mFormatFlags & kAudioFormatFlagIsNonInterleaved != 0 {
+            captureFormat = ChannelMapper.interleavedFloat(
+                sampleRate: format.mSampleRate, channels: format.mChannelsPerFrame
+            )
+        } else {
+            captureFormat = AudioStreamBasicDescription(
+                mSampleRate: format.mSampleRate,
+                mFormatID: kAudioFormatLinearPCM,
+                mFormatFlags: format.mFormatFlags,
+                mBytesPerPacket: format.mBytesPerPacket,
+                mFramesPerPacket: format.mFramesPerPacket,
+                mBytesPerFrame: format.mBytesPerFrame,
+                mChannelsPerFrame: format.mChannelsPerFrame,
+                mBitsPerChannel: format.mBitsPerChannel,
+                mReserved: 0
+            )
+        }
+        self.captureFormat = captureFormat
+
+        // Channels the map drops are never converted or buffered
+        channelMapper = nil
+        if let channelMap = channelMap {
+            channelMapper = ChannelMapper(channelMap, deviceChannels: captureFormat.mChannelsPerFrame, maxFrames: 4096)
+            if channelMapper == nil {
+                channelMapFailed = true
+                outputHandler.handleError(
+                    MicrophoneError.channelMapMismatch(
+                        deviceChannels: captureFormat.mChannelsPerFrame, mapChannels: channelMap.inputChannels
+                    ).localizedDescription
+                )
+                return
+            }
+        }
+        let sourceFormat = channelMapper?.format(from: captureFormat) ?? captureFormat
         self.sourceFormat = sourceFormat
 
-        // Set up audio buffer
-        self.audioBuffer = AudioBuffer(format: sourceFormat, chunkDuration: chunkDuration)
-
         // Set up converter if needed
         if let targetRate = targetSampleRate, AudioFormatConverter.isValidSampleRate(targetRate) {
             do {
-                let converter = try AudioFormatConverter.toSampleRate(targetRate, from: sourceFormat)
+                let converter = try AudioFormatConverter.toSampleRate(
+                    targetRate,
+                    from: sourceFormat,
+                    quality: resamplerQuality
+                )
                 self.converter = converter
                 self.finalFormat = converter.targetFormatDescription
             } catch {
@@ -246,6 +330,29 @@ class MicrophoneRecorder: NSObject {
             self.converter = nil
             self.finalFormat = sourceFormat
         }
+
+        // Chunks are cut after conversion, so their frame counts are exact in the final format
+        self.audioBuffer = AudioBuffer(format: finalFormat ?? sourceFormat, chunkDuration: chunkDuration)
+        self.chunkClock = ChunkClock(
+            sourceSampleRate: sourceFormat.mSampleRate,
+            outputSampleRate: (finalFormat ?? sourceFormat).mSampleRate
+        )
+        self.capturedFrames = 0
+        self.expectedHostNs = 0
+    }
+
+    /// Host time of a sample buffer's first frame in nanoseconds, or 0 if it has none
+    private func hostTimeNs(of sampleBuffer: CMSampleBuffer) -> UInt64 {
+        var time = CMSampleBufferGetPresentationTimeStamp(sampleBuffer)
+        guard time.isValid else { return 0 }
+
+        // Presentation times are on the session's clock, which is the host
+        // time clock unless something else was configured
+        if #available(macOS 12.3, *), let clock = captureSession.synchronizationClock {
+            time = CMSyncConvertTime(time, from: clock, to: CMClockGetHostTimeClock())
+        }
+        let seconds = CMTimeGetSeconds(time)
+        return seconds > 0 ? UInt64(seconds * 1e9) : 0
     }
 
     private func createMetadata(for format: AudioStreamBasicDescription) -> NativeAudioMetadata {
@@ -266,7 +373,15 @@ class MicrophoneRecorder: NSObject {
 
 extension MicrophoneRecorder: AVCaptureAudioDataOutputSampleBufferDelegate {
     func captureOutput(_ output: AVCaptureOutput, didOutput sampleBuffer: CMSampleBuffer, from connection: AVCaptureConnection) {
-        guard isRecording else { return }
+        guard isRecording, !channelMapFailed else { return }
+
+        let callbackStart = audio_stats_now_ns()
+        var callbackFrames = 0
+        defer {
+            if let stats = stats {
+                audio_stats_record_callback(stats, audio_stats_now_ns() - callbackStart, UInt64(callbackFrames))
+            }
+        }
 
         // Get the format description on first buffer
         if !hasEmittedMetadata {
@@ -283,15 +398,34 @@ extension MicrophoneRecorder: AVCaptureAudioDataOutputSampleBufferDelegate {
 
         guard audioBuffer != nil else { return }
 
-        // Get audio buffer list from sample buffer
-        var blockBuffer: CMBlockBuffer?
-        var audioBufferList = AudioBufferList()
-        let bufferListSize = MemoryLayout<AudioBufferList>.size
+        // Get the audio buffer list from the sample buffer; it has one
+        // buffer per channel if the samples are not interleaved
+        var bufferListSize = 0
+        guard CMSampleBufferGetAudioBufferListWithRetainedBlockBuffer(
+            sampleBuffer,
+            bufferListSizeNeededOut: &bufferListSize,
+            bufferListOut: nil,
+            bufferListSize: 0,
+            blockBufferAllocator: nil,
+            blockBufferMemoryAllocator: nil,
+            flags: 0,
+            blockBufferOut: nil
+        ) == noErr, bufferListSize > 0 else { return }
+
+        if bufferListSize > bufferListCapacity {
+            bufferListStorage?.deallocate()
+            bufferListStorage = UnsafeMutableRawPointer.allocate(
+                byteCount: bufferListSize, alignment: MemoryLayout<AudioBufferList>.alignment
+            )
+            bufferListCapacity = bufferListSize
+        }
+        let audioBufferList = bufferListStorage!.bindMemory(to: AudioBufferList.self, capacity: 1)
 
+        var blockBuffer: CMBlockBuffer?
         let status = CMSampleBufferGetAudioBufferListWithRetainedBlockBuffer(
             sampleBuffer,
             bufferListSizeNeededOut: nil,
-            bufferListOut: &audioBufferList,
+            bufferListOut: audioBufferList,
             bufferListSize: bufferListSize,
             blockBufferAllocator: nil,
             blockBufferMemoryAllocator: nil,
@@ -301,39 +435,89 @@ extension MicrophoneRecorder: AVCaptureAudioDataOutputSampleBufferDelegate {
 
         guard status == noErr else { return }
 
-        // Process the audio data
-        let audioBuffer = audioBufferList.mBuffers
-        guard let dataPointer = audioBuffer.mData else { return }
-
         let frameCount = Int(CMSampleBufferGetNumSamples(sampleBuffer))
-        let channelCount = Int(self.sourceFormat?.mChannelsPerFrame ?? 1)
-        let bytesPerFrame = Int(self.sourceFormat?.mBytesPerFrame ?? 4)
+        callbackFrames = frameCount
+        let channelCount = Int(self.captureFormat?.mChannelsPerFrame ?? 1)
+        let bytesPerFrame = Int(self.captureFormat?.mBytesPerFrame ?? 4)
+
+        // Process the audio data, interleaved first if it is split over buffers
+        let buffers = UnsafeMutableAudioBufferListPointer(audioBufferList)
+        let dataPointer: UnsafeMutableRawPointer
+        if buffers.count > 1 {
+            let samples = frameCount * channelCount
+            if samples > interleaveCapacity {
+                interleaveScratch?.deallocate()
+                interleaveScratch = UnsafeMutablePointer<Float>.allocate(capacity: samples)
+                interleaveCapacity = samples
+            }
+            ChannelMapper.interleave(buffers, frames: frameCount, channels: channelCount, into: interleaveScratch!)
+            dataPointer = UnsafeMutableRawPointer(interleaveScratch!)
+        } else {
+            guard let data = buffers[0].mData else { return }
+            dataPointer = data
+        }
 
         // Apply gain if needed
         if gain != 1.0 {
             let floatPointer = dataPointer.assumingMemoryBound(to: Float32.self)
             let sampleCount = frameCount * channelCount
 
-            for i in 0..<sampleCount {
-                var sample = floatPointer[i] * gain
-                // Clamp to prevent clipping
-                sample = max(-1.0, min(1.0, sample))
-                floatPointer[i] = sample
+            // In place, clamped to prevent clipping
+            audio_dsp_apply_gain(floatPointer, floatPointer, sampleCount, gain, true)
+        }
+
+        // Sample buffers follow each other without gaps; a presentation time
+        // past the end of the previous buffer means input was dropped
+        let bufferHostNs = hostTimeNs(of: sampleBuffer)
+        let sampleRate = sourceFormat?.mSampleRate ?? 0
+        if bufferHostNs != 0, expectedHostNs != 0, sampleRate > 0 {
+            let gapNs = Double(bufferHostNs) - Double(expectedHostNs)
+            if abs(gapNs) > max(2e6, 2e9 / sampleRate) {
+                chunkClock?.markDiscontinuity(sourceFrame: capturedFrames)
             }
         }
+        if bufferHostNs != 0, sampleRate > 0 {
+            expectedHostNs = bufferHostNs + UInt64(Double(frameCount) * 1e9 / sampleRate)
+        }
 
-        // Convert to Data and add to buffer
-        let dataLength = frameCount * bytesPerFrame
-        let audioData = Data(bytes: dataPointer, count: dataLength)
+        chunkClock?.anchor(hostTimeNs: bufferHostNs, sourceFrame: capturedFrames)
+        capturedFrames += UInt64(frameCount)
+
+        // Convert as samples arrive (or append them untouched), then emit complete chunks
+        guard let audioBuffer = self.audioBuffer else { return }
+        var samples = UnsafeRawPointer(dataPointer)
+        var dataLength = frameCount * bytesPerFrame
+        if let mapper = channelMapper {
+            let mapped = mapper.map(dataPointer, frames: frameCount)
+            samples = mapped.baseAddress!
+            dataLength = mapped.count
+        }
+        if let converter = converter {
+            let conversionStart = audio_stats_now_ns()
+            converter.convert(samples, count: dataLength, into: audioBuffer)
+            if let stats = stats {
+                audio_stats_record_conversion(stats, audio_stats_now_ns() - conversionStart)
+            }
+        } else {
+            audioBuffer.append(samples, count: dataLength)
+        }
 
-        self.audioBuffer?.append(audioData)
+        let dropped = audioBuffer.takeDroppedBytes()
+        if dropped > 0, let stats = stats {
+            audio_stats_add_dropped(stats, UInt64(dropped / max(1, Int(finalFormat?.mBytesPerFrame ?? 4))))
+        }
         processChunks()
     }
 
     private func processChunks() {
-        audioBuffer?.processChunks().forEach { packet in
-            let processedPacket = converter?.transform(packet) ?? packet
-            outputHandler.handleAudioPacket(processedPacket)
+        let bytesPerFrame = max(1, Int(finalFormat?.mBytesPerFrame ?? 4))
+        audioBuffer?.drainChunks { bytes in
+            let frames = bytes.count / bytesPerFrame
+            let info = chunkClock?.next(frames: frames) ?? AudioChunkInfo()
+            if let stats = stats {
+                audio_stats_add_emitted(stats, UInt64(frames))
+            }
+            outputHandler.handleAudioBytes(bytes, info: info)
         }
     }
 }
@@ -21,8 +21,8 @@ class NativeAudioOutputHandler {
         self.session = session
     }
 
-    func handleAudioPacket(_ packet: AudioPacket) {
-        session?.emitData(packet.data)
+    func handleAudioBytes(_ bytes: UnsafeRawBufferPointer, info: AudioChunkInfo) {
+        session?.emitData(bytes, info: info)
     }
 
     func handleMetadata(_ metadata: NativeAudioMetadata) {
@@ -36,6 +36,10 @@ class NativeAudioOutputHandler {
     func handleStreamStop() {
         session?.emitEvent(1) // 1 = stop
     }
+
+    func handleError(_ message: String) {
+        session?.emitEvent(2, message: message) // 2 = error
+    }
 }
 
 // MARK: - Native Audio Recorder
@@ -47,32 +51,117 @@ public class NativeAudioRecorder {
     private var audioBuffer: AudioBuffer?
     private var outputHandler: NativeAudioOutputHandler
     private var converter: AudioFormatConverter?
+    private var bufferFrameSize: UInt32?
+
+    // Real-time handoff: the IOProc only copies into captureRing and signals;
+    // the worker thread does conversion, chunking and delivery
+    private var captureRing: OpaquePointer?
+    private var workerScratch: UnsafeMutableRawPointer?
+
+    // Device timestamps travel beside the samples as Stamp records; the IOProc
+    // owns capturedFrames and the sample-time tracking, the worker owns the clock
+    private var stampRing: OpaquePointer?
+    private var capturedFrames: UInt64 = 0
+    private var expectedSampleTime: Float64?
+    private var lostAudio = false
+    private let sourceBytesPerFrame: Int
+
+    // Devices can deliver their channels split over several buffers (non-
+    // interleaved, or one per stream of an aggregate device); the IOProc then
+    // interleaves them here so the ring always holds whole interleaved frames
+    private var interleaveScratch: UnsafeMutablePointer<Float>?
+    private var interleaveCapacityFrames = 0
+    private let captureChannels: Int
+
+    // Applies the session's channel map, on the worker, ahead of conversion
+    private let channelMapper: ChannelMapper?
+    private var chunkClock: ChunkClock
+    private let outputBytesPerFrame: Int
+    private var workerScratchSize = 0
+    private let stats: OpaquePointer?
+    private let workerSignal = DispatchSemaphore(value: 0)
+    private let workerDone = DispatchSemaphore(value: 0)
+    private let workerLock = NSLock()
+    private var workerStopRequested = false
+    private var workerActive = false
+
+    /// Bytes the IOProc had to drop because the worker fell ~2 seconds behind.
+    /// Written on the IOProc thread; read it after stopRecording().
+    private(set) var overrunBytes = 0
 
     init(
         deviceID: AudioObjectID,
         outputHandler: NativeAudioOutputHandler,
         convertToSampleRate: Double? = nil,
-        chunkDuration: Double = 0.2
+        chunkDuration: Double = 0.2,
+        bufferDuration: Double = 0,
+        resamplerQuality: Int32 = 1,
+        channelMap: ChannelMapSetting? = nil,
+        stats: OpaquePointer? = nil
     ) throws {
         self.deviceID = deviceID
         self.outputHandler = outputHandler
+        self.stats = stats
+
+        // The stream format describes one buffer; the stream configuration
+        // counts the channels of every buffer the IOProc is handed
+        let deviceFormat = try AudioFormatManager.getDeviceFormat(deviceID: deviceID)
+        let isFloat = deviceFormat.mFormatFlags & kAudioFormatFlagIsFloat != 0
+        let isNonInterleaved = deviceFormat.mFormatFlags & kAudioFormatFlagIsNonInterleaved != 0
+        let deviceChannels = max(
+            AudioDeviceManager.getInputChannelCount(deviceID: deviceID), deviceFormat.mChannelsPerFrame
+        )
 
-        // Get source format and set up conversion if requested
-        let sourceFormat = try AudioFormatManager.getDeviceFormat(deviceID: deviceID)
+        let interleaves = isFloat && (isNonInterleaved || deviceChannels > deviceFormat.mChannelsPerFrame)
+        let captureFormat: AudioStreamBasicDescription
+        if interleaves {
+            captureFormat = ChannelMapper.interleavedFloat(sampleRate: deviceFormat.mSampleRate, channels: deviceChannels)
+        } else {
+            captureFormat = deviceFormat
+        }
+        self.captureChannels = Int(captureFormat.mChannelsPerFrame)
 
-        // Set up the audio buffer using source format and configurable chunk duration
-        self.audioBuffer = AudioBuffer(format: sourceFormat, chunkDuration: chunkDuration)
+        if bufferDuration > 0 {
+            self.bufferFrameSize = UInt32(max(1, (captureFormat.mSampleRate * bufferDuration).rounded()))
+        }
+        if interleaves {
+            let frames = max(Int(bufferFrameSize ?? 0), NativeAudioRecorder.maxBufferFrames(deviceID: deviceID))
+            self.interleaveCapacityFrames = frames
+            self.interleaveScratch = UnsafeMutablePointer<Float>.allocate(capacity: frames * captureChannels)
+        }
 
-        if let targetSampleRate = convertToSampleRate {
-            // Validate sample rate
-            guard AudioFormatConverter.isValidSampleRate(targetSampleRate) else {
-                self.converter = nil
-                self.finalFormat = sourceFormat
-                return
+        // ~2 seconds of source audio between the IOProc and the worker, read
+        // back in ~100ms slices of whole frames
+        let sourceBytesPerFrame = max(1, Int(captureFormat.mBytesPerFrame))
+        let sourceBytesPerSecond = Int(captureFormat.mSampleRate) * sourceBytesPerFrame
+        let workerScratchSize = max(1, sourceBytesPerSecond / 10 / sourceBytesPerFrame) * sourceBytesPerFrame
+
+        // Channels the map drops are never converted or buffered
+        if let channelMap = channelMap {
+            guard captureFormat.mFormatFlags & kAudioFormatFlagIsFloat != 0,
+                  let mapper = ChannelMapper(
+                    channelMap, deviceChannels: UInt32(captureChannels),
+                    maxFrames: workerScratchSize / sourceBytesPerFrame
+                  )
+            else {
+                interleaveScratch?.deallocate()
+                throw AudioTeeError.channelMapMismatch(
+                    deviceChannels: UInt32(captureChannels), mapChannels: channelMap.inputChannels
+                )
             }
+            self.channelMapper = mapper
+        } else {
+            self.channelMapper = nil
+        }
+        let sourceFormat = channelMapper?.format(from: captureFormat) ?? captureFormat
 
+        if let targetSampleRate = convertToSampleRate, AudioFormatConverter.isValidSampleRate(targetSampleRate) {
             do {
-                let converter = try AudioFormatConverter.toSampleRate(targetSampleRate, from: sourceFormat)
+                let converter = try AudioFormatConverter.toSampleRate(
+                    targetSampleRate,
+                    from: sourceFormat,
+                    quality: resamplerQuality
+                )
                 self.converter = converter
                 self.finalFormat = converter.targetFormatDescription
             } catch {
@@ -83,15 +172,71 @@ public class NativeAudioRecorder {
             self.converter = nil
             self.finalFormat = sourceFormat
         }
+
+        // Chunks are cut after conversion, so their frame counts are exact in the final format
+        self.audioBuffer = AudioBuffer(format: finalFormat, chunkDuration: chunkDuration)
+        self.chunkClock = ChunkClock(sourceSampleRate: sourceFormat.mSampleRate, outputSampleRate: finalFormat.mSampleRate)
+        self.outputBytesPerFrame = max(1, Int(finalFormat.mBytesPerFrame))
+
+        self.sourceBytesPerFrame = sourceBytesPerFrame
+        self.captureRing = audio_ring_create(sourceBytesPerSecond * 2)
+        self.stampRing = audio_ring_create(NativeAudioRecorder.stampSize * 1024)
+        self.workerScratchSize = workerScratchSize
+        self.workerScratch = UnsafeMutableRawPointer.allocate(byteCount: workerScratchSize, alignment: 16)
+    }
+
+    deinit {
+        cleanupIOProc()
+        stopWorker()
+        if let ring = captureRing {
+            audio_ring_destroy(ring)
+        }
+        if let ring = stampRing {
+            audio_ring_destroy(ring)
+        }
+        workerScratch?.deallocate()
+        interleaveScratch?.deallocate()
+    }
+
+    /// Largest IO buffer the device allows, so the IOProc never outgrows its scratch
+    private static func maxBufferFrames(deviceID: AudioObjectID) -> Int {
+        var address = getPropertyAddress(selector: kAudioDevicePropertyBufferFrameSizeRange)
+        var range = AudioValueRange()
+        var size = UInt32(MemoryLayout<AudioValueRange>.size)
+        let status = AudioObjectGetPropertyData(deviceID, &address, 0, nil, &size, &range)
+        return status == noErr && range.mMaximum >= 1 ? Int(range.mMaximum) : 8192
     }
 
-    func startRecording() {
-        // Send metadata for final format
+    /// Timing of one IOProc buffer, written by the IOProc beside its samples
+    private struct Stamp {
+        var sourceFrame: UInt64 = 0
+        var hostTime: UInt64 = 0            // mach ticks, 0 if invalid
+        var sampleTime: UInt64 = 0          // Device sample time, valid with hasSampleTime
+        var hasSampleTime = false
+        var discontinuity = false
+    }
+
+    private static let stampSize = MemoryLayout<Stamp>.size
+
+    /// Starts capture on the calling thread. The IOProc runs on CoreAudio's own
+    /// IO thread and the worker does the rest, so no thread has to be kept
+    /// spinning a run loop for the session.
+    func startRecording() throws {
+        try createIOProc()
+
+        // Send metadata for final format before any chunk can exist
         let metadata = createMetadata(for: finalFormat)
         outputHandler.handleMetadata(metadata)
         outputHandler.handleStreamStart()
 
-        setupAndStartIOProc()
+        startWorker()
+
+        let status = AudioDeviceStart(deviceID, ioProcID)
+        if status != noErr {
+            cleanupIOProc()
+            stopWorker()
+            throw AudioTeeError.deviceStartFailed(status)
+        }
     }
 
     private func createMetadata(for format: AudioStreamBasicDescription) -> NativeAudioMetadata {
@@ -107,58 +252,214 @@ public class NativeAudioRecorder {
         )
     }
 
-    private func setupAndStartIOProc() {
-        var status = AudioDeviceCreateIOProcID(
-            deviceID,
-            { (inDevice, inNow, inInputData, inInputTime, outOutputData, inOutputTime, inClientData) -> OSStatus in
-                let recorder = Unmanaged<NativeAudioRecorder>.fromOpaque(inClientData!).takeUnretainedValue()
-                return recorder.processAudio(inInputData)
-            },
-            Unmanaged.passUnretained(self).toOpaque(),
-            &ioProcID
+    private func applyBufferFrameSize() {
+        guard var frames = bufferFrameSize else { return }
+
+        // Best effort: if the device rejects the size (outside
+        // kAudioDevicePropertyBufferFrameSizeRange) its default stays in place
+        var address = getPropertyAddress(selector: kAudioDevicePropertyBufferFrameSize)
+        _ = AudioObjectSetPropertyData(
+            deviceID, &address, 0, nil, UInt32(MemoryLayout<UInt32>.size), &frames
         )
+    }
 
-        guard status == noErr else {
-            outputHandler.session?.emitEvent(2, message: "Failed to create IO proc: \(status)")
-            return
-        }
+    private func createIOProc() throws {
+        applyBufferFrameSize()
 
-        status = AudioDeviceStart(deviceID, ioProcID)
+        // A nil queue keeps the block on the HAL's real-time IO thread. The IOProc
+        // is destroyed before the recorder goes away, so self can stay unowned.
+        let status = AudioDeviceCreateIOProcIDWithBlock(&ioProcID, deviceID, nil) {
+            [unowned self] _, inInputData, inInputTime, _, _ in
+            self.processAudio(inInputData, time: inInputTime)
+        }
 
-        if status != noErr {
-            cleanupIOProc()
-            outputHandler.session?.emitEvent(2, message: "Failed to start audio device: \(status)")
+        guard status == noErr, ioProcID != nil else {
+            ioProcID = nil
+            throw AudioTeeError.ioProcCreationFailed(status)
         }
     }
 
-    private func processAudio(_ inputData: UnsafePointer<AudioBufferList>) -> OSStatus {
-        let bufferList = inputData.pointee
-        let firstBuffer = bufferList.mBuffers
+    private func processAudio(_ inputData: UnsafePointer<AudioBufferList>, time: UnsafePointer<AudioTimeStamp>) {
+        let firstBuffer = inputData.pointee.mBuffers
 
         guard firstBuffer.mData != nil && firstBuffer.mDataByteSize > 0 else {
-            return noErr
+            return
         }
 
-        // Append raw audio data to buffer
-        let audioData = Data(bytes: firstBuffer.mData!, count: Int(firstBuffer.mDataByteSize))
-        audioBuffer?.append(audioData)
+        guard let ring = captureRing else { return }
+
+        // Real-time thread: copy and wake the worker, nothing else
+        let callbackStart = audio_stats_now_ns()
+        var source = UnsafeRawPointer(firstBuffer.mData!)
+        var byteCount = Int(firstBuffer.mDataByteSize)
+        if let scratch = interleaveScratch {
+            let bufferFrames = byteCount / max(1, Int(firstBuffer.mNumberChannels) * MemoryLayout<Float>.size)
+            let frames = min(bufferFrames, interleaveCapacityFrames)
+            let buffers = UnsafeMutableAudioBufferListPointer(UnsafeMutablePointer(mutating: inputData))
+            ChannelMapper.interleave(buffers, frames: frames, channels: captureChannels, into: scratch)
+            source = UnsafeRawPointer(scratch)
+            byteCount = frames * sourceBytesPerFrame
+        }
+        let frames = byteCount / sourceBytesPerFrame
+        let timeStamp = time.pointee
+
+        // The HAL's sample time advances by exactly one buffer per callback;
+        // anything else means the device skipped or repeated audio
+        var stamp = Stamp(sourceFrame: capturedFrames)
+        if timeStamp.mFlags.contains(.hostTimeValid) {
+            stamp.hostTime = timeStamp.mHostTime
+        }
+        if timeStamp.mFlags.contains(.sampleTimeValid) {
+            let sampleTime = timeStamp.mSampleTime
+            if let expected = expectedSampleTime, abs(sampleTime - expected) >= 1 {
+                lostAudio = true
+            }
+            expectedSampleTime = sampleTime + Float64(frames)
+            if sampleTime >= 0 {
+                stamp.sampleTime = UInt64(sampleTime)
+                stamp.hasSampleTime = true
+            }
+        }
 
-        processAudioBuffer()
+        if audio_ring_write(ring, source, byteCount) {
+            stamp.discontinuity = lostAudio
+            if let stamps = stampRing,
+               withUnsafeBytes(of: &stamp, { audio_ring_write(stamps, $0.baseAddress!, $0.count) }) {
+                lostAudio = false
+            }
+            capturedFrames += UInt64(frames)
+        } else {
+            overrunBytes += byteCount
+            lostAudio = true
+            if let stats = stats {
+                audio_stats_add_dropped(stats, UInt64(frames))
+            }
+        }
+        workerSignal.signal()
 
-        return noErr
+        if let stats = stats {
+            audio_stats_record_callback(stats, audio_stats_now_ns() - callbackStart, UInt64(frames))
+        }
     }
 
     func stopRecording() {
+        // Stop the IOProc, then let the worker drain what it already captured
+        cleanupIOProc()
+        stopWorker()
+
+        if let converter = converter, let audioBuffer = audioBuffer {
+            converter.finish(into: audioBuffer)
+        }
         processAudioBuffer()
         outputHandler.handleStreamStop()
-        cleanupIOProc()
+    }
+
+    // MARK: - Worker
+
+    private func startWorker() {
+        guard !workerActive else { return }
+        workerActive = true
+
+        workerLock.lock()
+        workerStopRequested = false
+        workerLock.unlock()
+
+        let thread = Thread { [self] in
+            self.workerLoop()
+        }
+        thread.name = "com.coreaudio.recorder.worker"
+        thread.qualityOfService = .userInteractive
+        thread.start()
+    }
+
+    private func stopWorker() {
+        guard workerActive else { return }
+        workerActive = false
+
+        workerLock.lock()
+        workerStopRequested = true
+        workerLock.unlock()
+
+        workerSignal.signal()
+        workerDone.wait()
+    }
+
+    private func workerLoop() {
+        while true {
+            workerSignal.wait()
+            drainCaptureRing()
+
+            workerLock.lock()
+            let stop = workerStopRequested
+            workerLock.unlock()
+            if stop { break }
+        }
+
+        // The IOProc is already stopped; pick up anything written after the last wakeup
+        drainCaptureRing()
+        workerDone.signal()
+    }
+
+    private func drainCaptureRing() {
+        guard let ring = captureRing, let scratch = workerScratch, let audioBuffer = audioBuffer else { return }
+
+        // The newest timestamp wins; older ones describe the same clock
+        if let stamps = stampRing {
+            var stamp = Stamp()
+            while withUnsafeMutableBytes(of: &stamp, { audio_ring_read(stamps, $0.baseAddress!, $0.count) })
+                == NativeAudioRecorder.stampSize
+            {
+                chunkClock.anchor(
+                    hostTimeNs: ChunkClock.nanoseconds(fromHostTime: stamp.hostTime),
+                    sourceFrame: stamp.sourceFrame
+                )
+                if stamp.hasSampleTime {
+                    chunkClock.anchorDevice(position: stamp.sampleTime, sourceFrame: stamp.sourceFrame)
+                }
+                if stamp.discontinuity {
+                    chunkClock.markDiscontinuity(sourceFrame: stamp.sourceFrame)
+                }
+            }
+        }
+
+        while true {
+            var bytes = audio_ring_read(ring, scratch, workerScratchSize)
+            if bytes == 0 { break }
+
+            var samples = UnsafeRawPointer(scratch)
+            if let mapper = channelMapper {
+                let mapped = mapper.map(scratch, frames: bytes / sourceBytesPerFrame)
+                samples = mapped.baseAddress!
+                bytes = mapped.count
+            }
+
+            // Convert as samples arrive (or append them untouched), then emit complete chunks
+            if let converter = converter {
+                let conversionStart = audio_stats_now_ns()
+                converter.convert(samples, count: bytes, into: audioBuffer)
+                if let stats = stats {
+                    audio_stats_record_conversion(stats, audio_stats_now_ns() - conversionStart)
+                }
+            } else {
+                audioBuffer.append(samples, count: bytes)
+            }
+
+            let dropped = audioBuffer.takeDroppedBytes()
+            if dropped > 0, let stats = stats {
+                audio_stats_add_dropped(stats, UInt64(dropped / outputBytesPerFrame))
+            }
+            processAudioBuffer()
+        }
     }
 
     private func processAudioBuffer() {
-        // Process and send complete chunks, applying conversion if needed
-        audioBuffer?.processChunks().forEach { packet in
-            let processedPacket = converter?.transform(packet) ?? packet
-            outputHandler.handleAudioPacket(processedPacket)
+        audioBuffer?.drainChunks { bytes in
+            let frames = bytes.count / outputBytesPerFrame
+            let info = chunkClock.next(frames: frames)
+            if let stats = stats {
+                audio_stats_add_emitted(stats, UInt64(frames))
+            }
+            outputHandler.handleAudioBytes(bytes, info: info)
         }
     }
 
@@ -0,0 +1,84 @@
+import CoreAudio
+import Foundation
+
+/// Keeps the taps and aggregate devices of stopped system audio captures alive
+/// for an idle TTL, so that a restart with the same configuration skips their
+/// creation. Idle taps are not running, but a muted one keeps its processes
+/// muted until it is reused or expires.
+final class TapPool {
+    static let shared = TapPool()
+
+    /// Everything the tap is created from; processes are sorted so that the
+    /// order they were listed in doesn't matter
+    struct Key: Hashable {
+        let processes: [Int32]
+        let muteBehavior: TapMuteBehavior
+        let isExclusive: Bool
+        let isMono: Bool
+
+        init(_ config: TapConfiguration) {
+            processes = config.processes.sorted()
+            muteBehavior = config.muteBehavior
+            isExclusive = config.isExclusive
+            isMono = config.isMono
+        }
+    }
+
+    private struct IdleTap {
+        let manager: AudioTapManager
+        let expiry: DispatchWorkItem
+    }
+
+    private let lock = NSLock()
+    private var idle: [Key: [IdleTap]] = [:]
+    private let queue = DispatchQueue(label: "native-audio.tap-pool")
+
+    /// An idle tap of this configuration, or a newly set up one
+    func acquire(_ config: TapConfiguration) throws -> AudioTapManager {
+        let key = Key(config)
+
+        lock.lock()
+        let reused = idle[key]?.popLast()
+        if idle[key]?.isEmpty == true {
+            idle[key] = nil
+        }
+        lock.unlock()
+
+        if let reused = reused {
+            reused.expiry.cancel()
+            return reused.manager
+        }
+
+        let manager = AudioTapManager()
+        try manager.setupAudioTap(with: config)
+        return manager
+    }
+
+    /// Park a stopped capture's tap for ttlMs; without a TTL it is destroyed
+    /// as soon as the caller lets go of it
+    func release(_ manager: AudioTapManager, config: TapConfiguration, ttlMs: Double) {
+        guard ttlMs > 0 else { return }
+        let key = Key(config)
+
+        let expiry = DispatchWorkItem { [weak self, weak manager] in
+            guard let self = self, let manager = manager else { return }
+            self.expire(manager, key: key)
+        }
+
+        lock.lock()
+        idle[key, default: []].append(IdleTap(manager: manager, expiry: expiry))
+        lock.unlock()
+
+        queue.asyncAfter(deadline: .now() + ttlMs / 1000.0, execute: expiry)
+    }
+
+    private func expire(_ manager: AudioTapManager, key: Key) {
+        // The caller still holds the manager, so the tap is destroyed once it
+        // returns rather than under the lock
+        lock.lock()
+        defer { lock.unlock() }
+        guard var taps = idle[key], let index = taps.firstIndex(where: { $0.manager === manager }) else { return }
+        taps.remove(at: index)
+        idle[key] = taps.isEmpty ? nil : taps
+    }
+}
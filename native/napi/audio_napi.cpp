@@ -1,10 +1,28 @@
 #include <napi.h>
+#include <uv.h>
 #include <thread>
 #include <mutex>
 #include <queue>
 #include <atomic>
+#include <memory>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <functional>
 #include "audio_bridge.h"
+#include "audio_encoder.h"
+#include "capture_engine.h"
+#include "capture_stats.h"
+#include "channel_map.h"
+#include "combined_capture.h"
+#include "chunk_pool.h"
+#include "feature_extractor.h"
+#include "file_sink.h"
+#include "level_meter.h"
+#include "pre_roll_buffer.h"
+#include "shared_ring.h"
+#include "spsc_ring.h"
+#include "voice_activity.h"
 
 // Platform-specific includes
 #ifdef _WIN32
@@ -95,16 +113,240 @@ static void DebugLogImpl(const char* format, ...) {
 // Forward declarations
 class AudioRecorderWrapper;
 
-// Thread-safe queue for events
+// Record types in the event ring. Values 0-9 match the event types seen by JS.
+enum AudioEventType : uint32_t {
+    kEventData = 0,
+    kEventStart = 1,
+    kEventStop = 2,
+    kEventError = 3,
+    kEventMetadata = 4,
+    kEventSpeechStart = 5,
+    kEventSpeechEnd = 6,
+    kEventLevel = 7,         // Payload is a LevelRecord and its levels
+    kEventFeatures = 8,      // Payload is a FeatureRecord and its frames
+    kEventWarning = 9,
+    kEventDataSlab = 100,    // Payload is a ChunkPool::Slab*, delivered as type 0
+};
+
+// Leads the payload of every data record, ahead of the bytes or slab pointer
+struct ChunkRecordHeader {
+    AudioChunkInfo info;
+    uint64_t sequence;      // Data chunks produced before this one; gaps are dropped chunks
+};
+
+// Follows the ChunkRecordHeader of a level record (whose info carries the
+// window's position and host time), ahead of rms[channels], peak[channels]
+// and bands[bandCount] as floats
+struct LevelRecord {
+    uint32_t frames;
+    uint32_t channels;
+    uint32_t bandCount;
+};
+
+// Follows the ChunkRecordHeader of a features record (whose info carries the
+// first frame's position and host time), ahead of frames * bins floats
+struct FeatureRecord {
+    uint32_t frames;
+    uint32_t bins;
+    uint32_t hopFrames;
+};
+
+// What to do when the event ring is full
+enum class OverflowPolicy {
+    DropOldest,     // Discard the oldest queued chunk (default)
+    DropNewest,     // Discard the incoming chunk
+    Block,          // Wait for JS to drain (never while stopping)
+};
+
+static constexpr size_t kDefaultQueueCapacityBytes = 4 * 1024 * 1024;
+
+// What the platform starts return when the device has fewer channels than
+// the channel map reads (audio_set_channel_map)
+static constexpr int32_t kChannelMapMismatch = -9;
+
+// ============================================================================
+// LoopWake - wakes the JS thread from any thread, without a lock or allocation
+//
+// A ThreadSafeFunction call takes the function's queue mutex and allocates a
+// queue entry, which the capture threads must not do. uv_async_send only sets
+// an atomic flag and, if it was clear, writes to the loop's wakeup descriptor;
+// sends made before the loop gets to the handle coalesce into one callback.
+// The handle belongs to the JS thread, which opens and closes it. Its state
+// lives until libuv has finished closing it, and an environment cleanup hook
+// closes it if the environment goes away first.
+// ============================================================================
+
+class LoopWake {
+public:
+    typedef void (*Callback)(napi_env env, void* context);
+
+    LoopWake() = default;
+    ~LoopWake() { Close(); }
+
+    LoopWake(const LoopWake&) = delete;
+    LoopWake& operator=(const LoopWake&) = delete;
+
+    // JS thread. keepAlive: whether the open handle keeps the loop running.
+    bool Open(napi_env env, const char* name, Callback callback, void* context, bool keepAlive);
+
+    // JS thread; no Signal() may be in progress or follow. Pending wakes are dropped.
+    void Close();
+
+    // Any thread: run the callback on the JS thread soon
+    void Signal() const {
+        if (state_) uv_async_send(&state_->async);
+    }
+
+    // From the callback: call fn the way node calls into JS for a native
+    // event, so microtasks run after it and a throw reaches 'uncaughtException'
+    void Call(napi_value fn, size_t argc, const napi_value* argv) const;
+
+private:
+    struct State {
+        uv_async_t async;
+        napi_env env = nullptr;
+        napi_async_context asyncContext = nullptr;
+        Callback callback = nullptr;
+        void* context = nullptr;
+        bool hooked = false;        // The cleanup hook is registered
+        bool calling = false;       // Inside Call(), which may close the handle
+        bool closing = false;       // uv_close has been called
+        bool closed = false;        // libuv is done with the handle
+        bool released = false;      // The owner is done with the state
+    };
+
+    static void OnAsync(uv_async_t* handle);
+    static void OnCleanup(void* data);
+    static void Shut(State* state);
+
+    State* state_ = nullptr;
+};
+
+bool LoopWake::Open(napi_env env, const char* name, Callback callback, void* context, bool keepAlive) {
+    Close();
+
+    uv_loop_t* loop = nullptr;
+    if (napi_get_uv_event_loop(env, &loop) != napi_ok || !loop) return false;
+
+    State* state = new State();
+    if (uv_async_init(loop, &state->async, &LoopWake::OnAsync) != 0) {
+        delete state;
+        return false;
+    }
+    state->async.data = state;
+    state->env = env;
+    state->callback = callback;
+    state->context = context;
+    if (!keepAlive) {
+        uv_unref(reinterpret_cast<uv_handle_t*>(&state->async));
+    }
+
+    napi_value resource;
+    napi_value resourceName;
+    if (napi_create_object(env, &resource) == napi_ok &&
+        napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &resourceName) == napi_ok) {
+        napi_async_init(env, resource, resourceName, &state->asyncContext);
+    }
+    state->hooked = napi_add_env_cleanup_hook(env, &LoopWake::OnCleanup, state) == napi_ok;
+
+    state_ = state;
+    return true;
+}
+
+void LoopWake::Close() {
+    State* state = state_;
+    if (!state) return;
+    state_ = nullptr;
+
+    state->released = true;
+    if (state->hooked) {
+        napi_remove_env_cleanup_hook(state->env, &LoopWake::OnCleanup, state);
+        state->hooked = false;
+    }
+    if (state->closed) {
+        delete state;
+        return;
+    }
+    Shut(state);
+}
+
+void LoopWake::Call(napi_value fn, size_t argc, const napi_value* argv) const {
+    // The state outlives a Close() from inside the call: libuv frees it no
+    // sooner than its close callback, which never runs within ours
+    State* state = state_;
+    if (!state || !state->asyncContext) return;
+    napi_env env = state->env;
+
+    napi_value global;
+    napi_value result;
+    if (napi_get_global(env, &global) != napi_ok) return;
+    state->calling = true;
+    napi_status status = napi_make_callback(env, state->asyncContext, global, fn, argc, argv, &result);
+    state->calling = false;
+
+    if (state->closing && state->asyncContext) {
+        napi_async_destroy(env, state->asyncContext);
+        state->asyncContext = nullptr;
+    }
+
+    bool pending = false;
+    napi_value error;
+    if (status != napi_ok && napi_is_exception_pending(env, &pending) == napi_ok && pending &&
+        napi_get_and_clear_last_exception(env, &error) == napi_ok) {
+        napi_fatal_exception(env, error);
+    }
+}
+
+void LoopWake::OnAsync(uv_async_t* handle) {
+    State* state = static_cast<State*>(handle->data);
+    if (state->closing) return;
+
+    napi_handle_scope scope;
+    if (napi_open_handle_scope(state->env, &scope) != napi_ok) return;
+    state->callback(state->env, state->context);
+    napi_close_handle_scope(state->env, scope);
+}
+
+// The environment is going away with the handle still open
+void LoopWake::OnCleanup(void* data) {
+    State* state = static_cast<State*>(data);
+    state->hooked = false;
+    Shut(state);
+}
+
+void LoopWake::Shut(State* state) {
+    if (state->closing) return;
+    state->closing = true;
+
+    // A Call() in progress still needs its async context, and destroys it
+    if (state->asyncContext && !state->calling) {
+        napi_async_destroy(state->env, state->asyncContext);
+        state->asyncContext = nullptr;
+    }
+    uv_close(reinterpret_cast<uv_handle_t*>(&state->async), [](uv_handle_t* handle) {
+        State* closed = static_cast<State*>(handle->data);
+        closed->closed = true;
+        if (closed->released) {
+            delete closed;
+        }
+    });
+}
+
+// Control events (start/stop/error/warning/metadata) are rare and may come
+// from any thread, so they use a small locked queue. Audio data, and the
+// speech, level and feature events raised alongside it, go through the
+// lock-free ring. Both share one sequence counter so JS sees them in order.
 struct AudioEvent {
-    int32_t type;          // 0=data, 1=start, 2=stop, 3=error, 4=metadata
-    std::vector<uint8_t> data;
+    uint32_t type;         // 1=start, 2=stop, 3=error, 4=metadata, 5=speechStart, 6=speechEnd, 9=warning
+    uint64_t seq;
     std::string message;
     double sampleRate;
     uint32_t channelsPerFrame;
     uint32_t bitsPerChannel;
     bool isFloat;
     std::string encoding;
+    uint64_t framePosition = 0;    // Speech events
+    uint64_t hostTimeNs = 0;
 };
 
 class AudioRecorderWrapper : public Napi::ObjectWrap<AudioRecorderWrapper> {
@@ -114,33 +356,274 @@ public:
     ~AudioRecorderWrapper();
 
 private:
-    static Napi::FunctionReference constructor;
-
     // Instance methods
     Napi::Value StartSystemAudio(const Napi::CallbackInfo& info);
     Napi::Value StartMicrophone(const Napi::CallbackInfo& info);
+    Napi::Value StartCombined(const Napi::CallbackInfo& info);
     Napi::Value Stop(const Napi::CallbackInfo& info);
     Napi::Value IsRunning(const Napi::CallbackInfo& info);
     Napi::Value ProcessEvents(const Napi::CallbackInfo& info);
+    Napi::Value SetEventCallback(const Napi::CallbackInfo& info);
+    Napi::Value GetOverflowCount(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+    Napi::Value CommitPreRoll(const Napi::CallbackInfo& info);
+    Napi::Value CancelStart(const Napi::CallbackInfo& info);
 
     // Callbacks from Swift
-    static void OnData(const uint8_t* data, int32_t length, void* context);
+    static void OnData(const uint8_t* data, int32_t length, const AudioChunkInfo* info, void* context);
     static void OnEvent(int32_t eventType, const char* message, void* context);
     static void OnMetadata(double sampleRate, uint32_t channelsPerFrame,
                           uint32_t bitsPerChannel, bool isFloat,
                           const char* encoding, void* context);
 
     // Queue management
-    void QueueEvent(AudioEvent event);
-    std::vector<AudioEvent> DrainEvents();
+    bool WriteRecord(uint32_t type, const ChunkRecordHeader& header, const void* payload, size_t size);
+    void QueueControlEvent(AudioEvent event);
+    Napi::Array DrainEvents(Napi::Env env);
+    void DiscardEvents();
+    static Napi::Object BuildControlEvent(Napi::Env env, const AudioEvent& event);
+    static void SetChunkInfo(Napi::Env env, Napi::Object& obj, const ChunkRecordHeader& header);
+    static Napi::Value BuildLevelEvent(Napi::Env env, const ChunkRecordHeader& header, const uint8_t* payload,
+                                       size_t size);
+    static Napi::Value BuildFeatureEvent(Napi::Env env, const ChunkRecordHeader& header, const uint8_t* payload,
+                                         size_t size);
+    static Napi::Object BuildDurationStats(Napi::Env env, uint64_t count, uint64_t p50Ns, uint64_t p99Ns,
+                                           uint64_t maxNs);
+    void SnapshotNativeStats(AudioStatsSnapshot* stats) const;
+    static void ReleaseRecord(const SpscRing::Record& record);
+    bool ReadSessionOptions(Napi::Env env, const Napi::Object& options, double chunkDurationMs);
+    bool ReadVoiceActivityOptions(Napi::Env env, const Napi::Object& options);
+    bool ReadMeterOptions(Napi::Env env, const Napi::Object& options);
+    bool ReadFeatureOptions(Napi::Env env, const Napi::Object& options);
+    bool ReadPreRollOptions(Napi::Env env, const Napi::Object& options);
+    bool ReadFileSinkOptions(Napi::Env env, const Napi::Object& options);
+    bool ReadSharedRingOptions(Napi::Env env, const Napi::Object& options);
+    bool ReadChannelMapOptions(Napi::Env env, const Napi::Object& options);
+    static std::vector<int32_t> ReadProcessList(const Napi::Object& options, const char* key);
+    bool IsCapturing() const;
+
+    // Shared capture (opt-in via shared)
+    static bool WantsSharedCapture(const Napi::Object& options);
+
+    // Whatever a start brought up, owned by a CaptureWorker while it runs
+    struct CaptureSession {
+        std::unique_ptr<CaptureSubscription> subscription;
+        std::unique_ptr<CombinedCapture> combined;
+        AudioRecorderHandle handle = nullptr;   // Direct platform session
+        std::string error;                      // Why a start failed, when the code alone doesn't say
+    };
+    class CaptureWorker;
+    typedef std::function<int32_t(CaptureSession&)> CaptureOperation;
+    bool CheckLifecycleIdle(Napi::Env env);
+    Napi::Value StartCapture(Napi::Env env, CaptureOperation start, const char* failure);
+    static int32_t StopSession(CaptureSession& session);
+
+    // Level metering, features, pre-roll, voice activity and encoded output
+    static void OnLevel(const LevelReading& reading, void* context);
+    static void OnFeatures(const FeatureBlock& block, void* context);
+    bool PcmWanted() const;
+    static void OnPreRollChunk(const uint8_t* data, size_t size, const AudioChunkInfo& info, void* context);
+    void ForwardChunk(const uint8_t* data, size_t size, const AudioChunkInfo& info);
+    static void OnGatedChunk(const uint8_t* data, size_t size, const AudioChunkInfo& info, void* context);
+    static void OnSpeech(bool speaking, uint64_t framePosition, uint64_t hostTimeNs, void* context);
+    void DeliverChunk(const uint8_t* data, size_t size, const AudioChunkInfo& info);
+    static void OnEncodedPacket(const uint8_t* data, size_t size, void* context);
+    void WriteChunk(const uint8_t* data, size_t size);
+
+    // Shared ring wake-ups
+    void NotifySharedRing();
+    static void OnSharedRingWake(napi_env env, void* context);
+    void ReleaseSharedRing();
+
+    // Push delivery (opt-in via setEventCallback)
+    void NotifyEventCallback();
+    static void OnEventWake(napi_env env, void* context);
+    void DeliverEvents(Napi::Env env);
+    void ReleaseEventCallback();
 
     AudioRecorderHandle handle_;
-    std::mutex eventMutex_;
-    std::queue<AudioEvent> eventQueue_;
     std::atomic<bool> isDestroyed_{false};
+    std::atomic<bool> stopping_{false};       // Releases producers blocked on a full ring
+
+    // Data ring (single producer: the capture thread) and control queue
+    std::unique_ptr<SpscRing> ring_;
+    std::vector<uint8_t> drainScratch_;         // Claimed event payloads, JS thread only
+    OverflowPolicy overflowPolicy_ = OverflowPolicy::DropOldest;
+    std::atomic<uint64_t> overflowCount_{0};
+    std::atomic<uint64_t> nextSeq_{0};
+    uint64_t chunkSequence_ = 0;       // Producer side only
+    AudioChunkInfo chunkInfo_ = {};    // Timing of the chunk being written or encoded
+    std::mutex controlMutex_;
+    std::vector<AudioEvent> controlQueue_;
+
+    LoopWake eventWake_;
+    Napi::FunctionReference eventCallback_;
+    std::atomic<bool> pushEnabled_{false};
+    std::atomic<int32_t> pushUsers_{0};      // Producers currently inside NotifyEventCallback
+
+    // Zero-copy chunk pool (opt-in via zeroCopy). The pool is sized from the
+    // metadata callback; replaced pools are retired rather than freed because
+    // the capture thread may still be inside Acquire().
+    bool zeroCopy_ = false;
+    double chunkDurationMs_ = 200;
+    std::atomic<ChunkPool*> activePool_{nullptr};
+    std::vector<std::shared_ptr<ChunkPool>> chunkPools_;
+
+    // Output encoding (opt-in via encoding). Like the pool, the encoder is
+    // created from the metadata callback, which always precedes the first
+    // chunk, and is then only used by the thread delivering chunks.
+    AudioEncoding encoding_ = AudioEncoding::Native;
+    int32_t encoderBitrate_ = 0;
+    std::unique_ptr<AudioEncoder> encoder_;
+
+    // Voice activity detection (opt-in via vad), set up alongside the encoder
+    // and run ahead of it
+    bool vadEnabled_ = false;
+    VoiceActivityOptions vadOptions_;
+    std::unique_ptr<VoiceActivityGate> vad_;
+
+    // Level metering (opt-in via meter), set up like the detector and run
+    // ahead of it on every chunk; levelRecord_ is its preallocated record
+    bool meterEnabled_ = false;
+    LevelMeterOptions meterOptions_;
+    std::unique_ptr<LevelMeter> meter_;
+    std::vector<uint8_t> levelRecord_;
+
+    // ASR features (opt-in via features), set up like the meter and run
+    // right after it; featureRecord_ holds the largest block's record
+    bool featuresEnabled_ = false;
+    FeatureOptions featureOptions_;
+    std::unique_ptr<FeatureExtractor> features_;
+    std::vector<uint8_t> featureRecord_;
+
+    // Pre-roll (opt-in via preRoll): the recording starts armed, keeping its
+    // history in preRoll_ instead of delivering it. commitPreRoll() posts the
+    // span of history wanted; the chunk thread flushes it and goes live.
+    bool preRollEnabled_ = false;
+    PreRollOptions preRollOptions_;
+    std::unique_ptr<PreRollBuffer> preRoll_;
+    std::atomic<double> preRollCommitMs_{-1.0};    // Negative until committed
+    bool preRollLive_ = false;                      // Chunk thread only
+
+    // File sink (opt-in via fileSink): output chunks are also, or only,
+    // written to a file by the sink's own thread. The start operation opens
+    // it before the capture can deliver, and the stop event closes it; it is
+    // kept until the next start so its counters stay readable.
+    bool fileSinkEnabled_ = false;
+    FileSinkOptions fileSinkOptions_;
+    bool fileSinkDeliver_ = true;       // Still deliver data events to JS
+    std::unique_ptr<FileSink> fileSink_;
+    bool fileSinkWarned_ = false;       // Chunk thread only: a drop has been reported
+    std::atomic<bool> fileSinkBehind_{false};   // A drop the drain has yet to report
+
+    // Shared ring (opt-in via sharedRing): output PCM is written straight
+    // into a SharedArrayBuffer that JS, typically a worker, reads on its own,
+    // instead of becoming data events. Only JS can wake a reader blocked in
+    // Atomics.wait, so each write schedules an Atomics.notify on this thread,
+    // coalesced like push delivery. The reference keeps the buffer alive; all
+    // of it is kept until the next start, like the file sink.
+    SharedRingWriter sharedRing_;
+    Napi::Reference<Napi::TypedArray> sharedRingRef_;
+    LoopWake sharedRingWake_;
+    Napi::FunctionReference sharedRingNotify_;  // Bound Atomics.notify
+
+    // Shared capture: instead of starting handle_, subscribe to the capture
+    // engine for the source, which delivers through the same callbacks
+    std::unique_ptr<CaptureSubscription> subscription_;
+    ResamplerQuality resamplerQuality_ = ResamplerQuality::Balanced;
+    double bufferDurationMs_ = 0;
+    int32_t latencyMode_ = 0;
+
+    // Channel map (opt-in via channels): set on the platform session, or
+    // handed to the subscriber of a shared capture
+    ChannelMap channelMap_;
+
+    // Combined microphone + system capture: two platform sessions of its own,
+    // aligned into one stream delivered through the same callbacks
+    std::unique_ptr<CombinedCapture> combined_;
+
+    // Start and stop run on the thread pool; while one is in flight the JS
+    // side may only cancel a start, which then tears down whatever it brought up
+    bool lifecycleBusy_ = false;                // JS thread only
+    std::atomic<bool> startCancelled_{false};
+
+    // Queue side of getStats(); capture and conversion counters live with
+    // whatever is capturing, and are kept here once it has been torn down
+    std::atomic<size_t> queueHighWater_{0};    // Written by the producer
+    uint64_t chunksDelivered_ = 0;              // JS thread only
+    DurationHistogram latency_;                 // Chunk host time to DrainEvents, JS thread only
+    AudioStatsSnapshot retiredStats_ = {};
+    bool hasRetiredStats_ = false;
 };
 
-Napi::FunctionReference AudioRecorderWrapper::constructor;
+// Runs a platform start or stop on the libuv thread pool and settles a
+// Promise with the outcome. Both can block for a long time (WASAPI process
+// loopback activation, creating a macOS process tap and aggregate device),
+// which would otherwise freeze the JS thread with them. Thread pool threads
+// are in the implicit MTA on Windows, which mta_thread.h keeps alive.
+class AudioRecorderWrapper::CaptureWorker : public Napi::AsyncWorker {
+public:
+    enum Kind { kStart, kStop };
+
+    CaptureWorker(Napi::Env env, AudioRecorderWrapper* self, Kind kind, CaptureOperation operation,
+                  CaptureSession session, std::string failure)
+        : Napi::AsyncWorker(env, kind == kStart ? "AudioRecorderStart" : "AudioRecorderStop"),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          self_(self),
+          kind_(kind),
+          operation_(std::move(operation)),
+          session_(std::move(session)),
+          failure_(std::move(failure)) {
+        // Keep the recorder alive until the worker settles
+        self_->Ref();
+        self_->lifecycleBusy_ = true;
+    }
+
+    Napi::Promise Promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        result_ = operation_(session_);
+
+        // Cancelled while starting: undo a start that succeeded anyway
+        if (kind_ == kStart && result_ == 0 && self_->startCancelled_) {
+            StopSession(session_);
+            cancelled_ = true;
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        self_->lifecycleBusy_ = false;
+
+        if (cancelled_) {
+            // The start and stop events of the undone session are nobody's
+            self_->DiscardEvents();
+            deferred_.Reject(Napi::Error::New(env, "Start cancelled").Value());
+        } else if (result_ != 0) {
+            std::string reason = session_.error.empty() ? "error code " + std::to_string(result_) : session_.error;
+            deferred_.Reject(Napi::Error::New(env, failure_ + ": " + reason).Value());
+        } else {
+            if (kind_ == kStart) {
+                self_->subscription_ = std::move(session_.subscription);
+                self_->combined_ = std::move(session_.combined);
+            }
+            deferred_.Resolve(env.Undefined());
+        }
+
+        self_->Unref();
+    }
+
+private:
+    Napi::Promise::Deferred deferred_;
+    AudioRecorderWrapper* self_;
+    Kind kind_;
+    CaptureOperation operation_;
+    CaptureSession session_;
+    std::string failure_;
+    int32_t result_ = 0;
+    bool cancelled_ = false;
+};
 
 Napi::Object AudioRecorderWrapper::Init(Napi::Env env, Napi::Object exports) {
     Napi::HandleScope scope(env);
@@ -148,20 +631,24 @@ Napi::Object AudioRecorderWrapper::Init(Napi::Env env, Napi::Object exports) {
     Napi::Function func = DefineClass(env, "AudioRecorderNative", {
         InstanceMethod("startSystemAudio", &AudioRecorderWrapper::StartSystemAudio),
         InstanceMethod("startMicrophone", &AudioRecorderWrapper::StartMicrophone),
+        InstanceMethod("startCombined", &AudioRecorderWrapper::StartCombined),
         InstanceMethod("stop", &AudioRecorderWrapper::Stop),
         InstanceMethod("isRunning", &AudioRecorderWrapper::IsRunning),
         InstanceMethod("processEvents", &AudioRecorderWrapper::ProcessEvents),
+        InstanceMethod("setEventCallback", &AudioRecorderWrapper::SetEventCallback),
+        InstanceMethod("getOverflowCount", &AudioRecorderWrapper::GetOverflowCount),
+        InstanceMethod("getStats", &AudioRecorderWrapper::GetStats),
+        InstanceMethod("commitPreRoll", &AudioRecorderWrapper::CommitPreRoll),
+        InstanceMethod("cancelStart", &AudioRecorderWrapper::CancelStart),
     });
 
-    constructor = Napi::Persistent(func);
-    constructor.SuppressDestruct();
-
     exports.Set("AudioRecorderNative", func);
     return exports;
 }
 
 AudioRecorderWrapper::AudioRecorderWrapper(const Napi::CallbackInfo& info)
-    : Napi::ObjectWrap<AudioRecorderWrapper>(info) {
+    : Napi::ObjectWrap<AudioRecorderWrapper>(info),
+      ring_(std::make_unique<SpscRing>(kDefaultQueueCapacityBytes)) {
     Napi::Env env = info.Env();
 
     handle_ = audio_create(
@@ -178,10 +665,16 @@ AudioRecorderWrapper::AudioRecorderWrapper(const Napi::CallbackInfo& info)
 
 AudioRecorderWrapper::~AudioRecorderWrapper() {
     isDestroyed_ = true;
+    subscription_.reset();
+    combined_.reset();
     if (handle_) {
         audio_destroy(handle_);
         handle_ = nullptr;
     }
+
+    // Return any undelivered slabs to their pools
+    DiscardEvents();
+    ReleaseSharedRing();
 }
 
 Napi::Value AudioRecorderWrapper::StartSystemAudio(const Napi::CallbackInfo& info) {
@@ -221,180 +714,1468 @@ Napi::Value AudioRecorderWrapper::StartSystemAudio(const Napi::CallbackInfo& inf
     }
 
     // Handle process arrays
-    std::vector<int32_t> includeProcesses;
-    std::vector<int32_t> excludeProcesses;
+    std::vector<int32_t> includeProcesses = ReadProcessList(options, "includeProcesses");
+    std::vector<int32_t> excludeProcesses = ReadProcessList(options, "excludeProcesses");
 
-    if (options.Has("includeProcesses") && options.Get("includeProcesses").IsArray()) {
-        Napi::Array arr = options.Get("includeProcesses").As<Napi::Array>();
-        for (uint32_t i = 0; i < arr.Length(); i++) {
-            if (arr.Get(i).IsNumber()) {
-                includeProcesses.push_back(arr.Get(i).As<Napi::Number>().Int32Value());
+    double tapCacheTtlMs = 0;
+    if (options.Has("tapCacheTtlMs") && options.Get("tapCacheTtlMs").IsNumber()) {
+        tapCacheTtlMs = options.Get("tapCacheTtlMs").As<Napi::Number>().DoubleValue();
+    }
+
+    if (!CheckLifecycleIdle(env) || !ReadSessionOptions(env, options, chunkDurationMs)) {
+        return env.Null();
+    }
+
+    CaptureOperation start;
+    if (WantsSharedCapture(options)) {
+        CaptureSource source;
+        source.mute = mute;
+        source.includeProcesses = includeProcesses;
+        source.excludeProcesses = excludeProcesses;
+        source.emitSilence = emitSilence;
+        source.bufferDurationMs = bufferDurationMs_;
+        source.tapCacheTtlMs = tapCacheTtlMs;
+
+        SubscriberFormat format;
+        format.sampleRate = sampleRate;
+        format.chunkDurationMs = chunkDurationMs;
+        format.mono = isMono;
+        format.channels = channelMap_;
+        format.quality = resamplerQuality_;
+
+        start = [this, source, format](CaptureSession& session) {
+            int32_t result = 0;
+            session.subscription = CaptureEngine::Subscribe(
+                source, format,
+                &AudioRecorderWrapper::OnData,
+                &AudioRecorderWrapper::OnEvent,
+                &AudioRecorderWrapper::OnMetadata,
+                this,
+                &result
+            );
+            return result;
+        };
+    } else {
+        audio_set_tap_cache_ttl(handle_, tapCacheTtlMs);
+        AudioRecorderHandle handle = handle_;
+        start = [=](CaptureSession& session) {
+            session.handle = handle;
+            int32_t result = audio_start_system_audio(
+                handle,
+                sampleRate,
+                chunkDurationMs,
+                mute,
+                isMono,
+                emitSilence,
+                includeProcesses.empty() ? nullptr : includeProcesses.data(),
+                static_cast<int32_t>(includeProcesses.size()),
+                excludeProcesses.empty() ? nullptr : excludeProcesses.data(),
+                static_cast<int32_t>(excludeProcesses.size())
+            );
+            if (result == kChannelMapMismatch) {
+                session.error = "the captured audio has fewer channels than the channel map reads";
+            }
+            return result;
+        };
+    }
+
+    return StartCapture(env, std::move(start), "Failed to start system audio recording");
+}
+
+Napi::Value AudioRecorderWrapper::StartMicrophone(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Options object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+
+    // Extract options with defaults
+    double sampleRate = 0;
+    if (options.Has("sampleRate") && options.Get("sampleRate").IsNumber()) {
+        sampleRate = options.Get("sampleRate").As<Napi::Number>().DoubleValue();
+    }
+
+    double chunkDurationMs = 200;
+    if (options.Has("chunkDurationMs") && options.Get("chunkDurationMs").IsNumber()) {
+        chunkDurationMs = options.Get("chunkDurationMs").As<Napi::Number>().DoubleValue();
+    }
+
+    bool isMono = true;
+    if (options.Has("stereo") && options.Get("stereo").IsBoolean()) {
+        isMono = !options.Get("stereo").As<Napi::Boolean>().Value();
+    }
+
+    bool emitSilence = true;
+    if (options.Has("emitSilence") && options.Get("emitSilence").IsBoolean()) {
+        emitSilence = options.Get("emitSilence").As<Napi::Boolean>().Value();
+    }
+
+    const char* deviceUID = nullptr;
+    std::string deviceUIDStr;
+    if (options.Has("deviceId") && options.Get("deviceId").IsString()) {
+        deviceUIDStr = options.Get("deviceId").As<Napi::String>().Utf8Value();
+        deviceUID = deviceUIDStr.c_str();
+    }
+
+    double gain = 1.0;
+    if (options.Has("gain") && options.Get("gain").IsNumber()) {
+        gain = options.Get("gain").As<Napi::Number>().DoubleValue();
+    }
+
+    if (!CheckLifecycleIdle(env) || !ReadSessionOptions(env, options, chunkDurationMs)) {
+        return env.Null();
+    }
+
+    CaptureOperation start;
+    if (WantsSharedCapture(options)) {
+        CaptureSource source;
+        source.microphone = true;
+        source.deviceUID = deviceUIDStr;
+        source.latencyMode = latencyMode_;
+        source.emitSilence = emitSilence;
+        source.bufferDurationMs = bufferDurationMs_;
+
+        // Gain is applied per subscriber, so sessions with different gains still share
+        SubscriberFormat format;
+        format.sampleRate = sampleRate;
+        format.chunkDurationMs = chunkDurationMs;
+        format.mono = isMono;
+        format.channels = channelMap_;
+        format.gain = static_cast<float>(gain);
+        format.quality = resamplerQuality_;
+
+        start = [this, source, format](CaptureSession& session) {
+            int32_t result = 0;
+            session.subscription = CaptureEngine::Subscribe(
+                source, format,
+                &AudioRecorderWrapper::OnData,
+                &AudioRecorderWrapper::OnEvent,
+                &AudioRecorderWrapper::OnMetadata,
+                this,
+                &result
+            );
+            return result;
+        };
+    } else {
+        AudioRecorderHandle handle = handle_;
+        bool hasDevice = deviceUID != nullptr;
+        start = [=](CaptureSession& session) {
+            session.handle = handle;
+            int32_t result = audio_start_microphone(
+                handle,
+                sampleRate,
+                chunkDurationMs,
+                isMono,
+                emitSilence,
+                hasDevice ? deviceUIDStr.c_str() : nullptr,
+                gain
+            );
+            if (result == kChannelMapMismatch) {
+                session.error = "the device has fewer channels than the channel map reads";
             }
+            return result;
+        };
+    }
+
+    return StartCapture(env, std::move(start), "Failed to start microphone recording");
+}
+
+Napi::Value AudioRecorderWrapper::StartCombined(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Options object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+
+    // Both sources are converted to one rate, so there is no native-rate default
+    CombinedCaptureOptions combined;
+    if (options.Has("sampleRate") && options.Get("sampleRate").IsNumber()) {
+        combined.sampleRate = options.Get("sampleRate").As<Napi::Number>().DoubleValue();
+    }
+
+    if (options.Has("chunkDurationMs") && options.Get("chunkDurationMs").IsNumber()) {
+        combined.chunkDurationMs = options.Get("chunkDurationMs").As<Napi::Number>().DoubleValue();
+    }
+
+    if (options.Has("stereo") && options.Get("stereo").IsBoolean()) {
+        combined.mono = !options.Get("stereo").As<Napi::Boolean>().Value();
+    }
+
+    if (options.Has("layout") && options.Get("layout").IsString()) {
+        std::string layout = options.Get("layout").As<Napi::String>().Utf8Value();
+        if (layout == "mix") {
+            combined.layout = CombinedLayout::Mix;
+        } else if (layout == "echo-cancelled") {
+            combined.layout = CombinedLayout::EchoCancelled;
+        } else if (layout != "interleaved") {
+            Napi::TypeError::New(env, "Unknown layout: " + layout).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    if (options.Has("echoTailMs") && options.Get("echoTailMs").IsNumber()) {
+        combined.echoTailMs = options.Get("echoTailMs").As<Napi::Number>().DoubleValue();
+        if (!(combined.echoTailMs > 0 && combined.echoTailMs <= EchoCanceller::kMaxTailMs)) {
+            Napi::RangeError::New(env, "echoTailMs must be a positive number of at most " +
+                                           std::to_string(static_cast<int>(EchoCanceller::kMaxTailMs)))
+                .ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+    if (combined.layout == CombinedLayout::EchoCancelled &&
+        !CombinedCapture::SupportsEchoCancellation(combined.sampleRate)) {
+        Napi::RangeError::New(env, "Echo cancellation needs a sampleRate of at least 3200 Hz")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (options.Has("microphone") && options.Get("microphone").IsObject()) {
+        Napi::Object microphone = options.Get("microphone").As<Napi::Object>();
+        if (microphone.Has("deviceId") && microphone.Get("deviceId").IsString()) {
+            combined.deviceUID = microphone.Get("deviceId").As<Napi::String>().Utf8Value();
+        }
+        if (microphone.Has("gain") && microphone.Get("gain").IsNumber()) {
+            combined.gain = microphone.Get("gain").As<Napi::Number>().DoubleValue();
+        }
+    }
+
+    if (options.Has("system") && options.Get("system").IsObject()) {
+        Napi::Object system = options.Get("system").As<Napi::Object>();
+        if (system.Has("mute") && system.Get("mute").IsBoolean()) {
+            combined.mute = system.Get("mute").As<Napi::Boolean>().Value();
+        }
+        combined.includeProcesses = ReadProcessList(system, "includeProcesses");
+        combined.excludeProcesses = ReadProcessList(system, "excludeProcesses");
+        if (system.Has("tapCacheTtlMs") && system.Get("tapCacheTtlMs").IsNumber()) {
+            combined.tapCacheTtlMs = system.Get("tapCacheTtlMs").As<Napi::Number>().DoubleValue();
         }
     }
 
-    if (options.Has("excludeProcesses") && options.Get("excludeProcesses").IsArray()) {
-        Napi::Array arr = options.Get("excludeProcesses").As<Napi::Array>();
+    if (!CheckLifecycleIdle(env) || !ReadSessionOptions(env, options, combined.chunkDurationMs)) {
+        return env.Null();
+    }
+    combined.bufferDurationMs = bufferDurationMs_;
+    combined.quality = resamplerQuality_;
+    combined.latencyMode = latencyMode_;
+
+    CaptureOperation start = [this, combined](CaptureSession& session) {
+        int32_t result = 0;
+        session.combined = CombinedCapture::Start(
+            combined,
+            &AudioRecorderWrapper::OnData,
+            &AudioRecorderWrapper::OnEvent,
+            &AudioRecorderWrapper::OnMetadata,
+            this,
+            &result
+        );
+        return result;
+    };
+
+    return StartCapture(env, std::move(start), "Failed to start combined recording");
+}
+
+std::vector<int32_t> AudioRecorderWrapper::ReadProcessList(const Napi::Object& options, const char* key) {
+    std::vector<int32_t> processes;
+    if (options.Has(key) && options.Get(key).IsArray()) {
+        Napi::Array arr = options.Get(key).As<Napi::Array>();
         for (uint32_t i = 0; i < arr.Length(); i++) {
             if (arr.Get(i).IsNumber()) {
-                excludeProcesses.push_back(arr.Get(i).As<Napi::Number>().Int32Value());
+                processes.push_back(arr.Get(i).As<Napi::Number>().Int32Value());
             }
         }
     }
+    return processes;
+}
 
-    int32_t result = audio_start_system_audio(
-        handle_,
-        sampleRate,
-        chunkDurationMs,
-        mute,
-        isMono,
-        emitSilence,
-        includeProcesses.empty() ? nullptr : includeProcesses.data(),
-        static_cast<int32_t>(includeProcesses.size()),
-        excludeProcesses.empty() ? nullptr : excludeProcesses.data(),
-        static_cast<int32_t>(excludeProcesses.size())
-    );
+bool AudioRecorderWrapper::ReadSessionOptions(Napi::Env env, const Napi::Object& options, double chunkDurationMs) {
+    // Starting while running fails anyway; leave the live session's queue and pool alone
+    if (IsCapturing()) return true;
 
-    if (result != 0) {
-        std::string errorMsg = "Failed to start system audio recording: error code " + std::to_string(result);
-        Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
+    AudioEncoding encoding = AudioEncoding::Native;
+    if (options.Has("encoding") && options.Get("encoding").IsString()) {
+        std::string name = options.Get("encoding").As<Napi::String>().Utf8Value();
+        if (!ParseAudioEncoding(name, &encoding)) {
+            Napi::TypeError::New(env, "Unknown encoding: " + name).ThrowAsJavaScriptException();
+            return false;
+        }
+        if (!IsAudioEncodingAvailable(encoding)) {
+            Napi::Error::New(env, "Encoding '" + name + "' is not available in this build").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+    encoding_ = encoding;
+
+    encoderBitrate_ = 0;
+    if (options.Has("bitrate") && options.Get("bitrate").IsNumber()) {
+        encoderBitrate_ = options.Get("bitrate").As<Napi::Number>().Int32Value();
+    }
+
+    if (!ReadVoiceActivityOptions(env, options)) return false;
+    if (!ReadMeterOptions(env, options)) return false;
+    if (!ReadFeatureOptions(env, options)) return false;
+    if (!ReadPreRollOptions(env, options)) return false;
+    if (!ReadFileSinkOptions(env, options)) return false;
+    if (!ReadSharedRingOptions(env, options)) return false;
+    if (!ReadChannelMapOptions(env, options)) return false;
+
+    // The previous session's encoder has been flushed and its file closed by its stop event
+    encoder_.reset();
+    fileSink_.reset();
+    fileSinkWarned_ = false;
+    fileSinkBehind_ = false;
+    vad_.reset();
+    meter_.reset();
+    features_.reset();
+    preRoll_.reset();
+    preRollCommitMs_ = -1.0;
+    preRollLive_ = false;
+    chunkSequence_ = 0;
+    chunkInfo_ = {};
+
+    // Counters describe one recording at a time
+    queueHighWater_ = 0;
+    chunksDelivered_ = 0;
+    latency_.Reset();
+    hasRetiredStats_ = false;
+
+    zeroCopy_ = false;
+    if (options.Has("zeroCopy") && options.Get("zeroCopy").IsBoolean()) {
+        zeroCopy_ = options.Get("zeroCopy").As<Napi::Boolean>().Value();
+    }
+    chunkDurationMs_ = chunkDurationMs;
+
+    // A pool from a previous session may not match the new format. Outstanding
+    // slabs keep their own pool alive, so dropping our references is safe.
+    activePool_ = nullptr;
+    chunkPools_.clear();
+
+    overflowPolicy_ = OverflowPolicy::DropOldest;
+    if (options.Has("overflowPolicy") && options.Get("overflowPolicy").IsString()) {
+        std::string policy = options.Get("overflowPolicy").As<Napi::String>().Utf8Value();
+        if (policy == "drop-newest") {
+            overflowPolicy_ = OverflowPolicy::DropNewest;
+        } else if (policy == "block") {
+            overflowPolicy_ = OverflowPolicy::Block;
+        }
+    }
+
+    size_t capacity = kDefaultQueueCapacityBytes;
+    if (options.Has("queueCapacityBytes") && options.Get("queueCapacityBytes").IsNumber()) {
+        double requested = options.Get("queueCapacityBytes").As<Napi::Number>().DoubleValue();
+        if (requested > 0) {
+            capacity = static_cast<size_t>(requested);
+        }
+    }
+
+    double bufferDurationMs = 0;
+    if (options.Has("bufferDurationMs") && options.Get("bufferDurationMs").IsNumber()) {
+        bufferDurationMs = options.Get("bufferDurationMs").As<Napi::Number>().DoubleValue();
+    }
+    audio_set_buffer_duration(handle_, bufferDurationMs);
+    bufferDurationMs_ = bufferDurationMs;
+
+    int32_t resamplerQuality = 1;
+    if (options.Has("resamplerQuality") && options.Get("resamplerQuality").IsString()) {
+        std::string quality = options.Get("resamplerQuality").As<Napi::String>().Utf8Value();
+        if (quality == "fast") {
+            resamplerQuality = 0;
+        } else if (quality == "high") {
+            resamplerQuality = 2;
+        }
+    }
+    audio_set_resampler_quality(handle_, resamplerQuality);
+    resamplerQuality_ = static_cast<ResamplerQuality>(resamplerQuality);
+
+    int32_t latencyMode = 0;
+    if (options.Has("latencyMode") && options.Get("latencyMode").IsString()) {
+        std::string mode = options.Get("latencyMode").As<Napi::String>().Utf8Value();
+        if (mode == "low") {
+            latencyMode = 1;
+        } else if (mode == "exclusive") {
+            latencyMode = 2;
+        }
+    }
+    audio_set_latency_mode(handle_, latencyMode);
+    latencyMode_ = latencyMode;
+
+    audio_set_channel_map(handle_, channelMap_.Empty() ? nullptr : channelMap_.matrix.data(),
+                          channelMap_.outputChannels, channelMap_.inputChannels);
+
+    // Only resize once the previous session's events have been drained
+    if (ring_->Empty() && ring_->Capacity() != SpscRing::CapacityFor(capacity)) {
+        ring_ = std::make_unique<SpscRing>(capacity);
+    }
+
+    stopping_ = false;
+    return true;
+}
+
+// vad: true for the defaults, or an object overriding some of them
+bool AudioRecorderWrapper::ReadVoiceActivityOptions(Napi::Env env, const Napi::Object& options) {
+    vadEnabled_ = false;
+    vadOptions_ = VoiceActivityOptions();
+    if (!options.Has("vad")) return true;
+
+    Napi::Value value = options.Get("vad");
+    if (value.IsBoolean()) {
+        vadEnabled_ = value.As<Napi::Boolean>().Value();
+        return true;
+    }
+    if (value.IsUndefined() || value.IsNull()) return true;
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "vad must be a boolean or an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object vad = value.As<Napi::Object>();
+    auto readMs = [&vad](const char* key, double* out) {
+        if (vad.Has(key) && vad.Get(key).IsNumber()) {
+            *out = std::max(0.0, vad.Get(key).As<Napi::Number>().DoubleValue());
+        }
+    };
+    if (vad.Has("speechOnly") && vad.Get("speechOnly").IsBoolean()) {
+        vadOptions_.speechOnly = vad.Get("speechOnly").As<Napi::Boolean>().Value();
+    }
+    if (vad.Has("thresholdDb") && vad.Get("thresholdDb").IsNumber()) {
+        vadOptions_.thresholdDb = vad.Get("thresholdDb").As<Napi::Number>().DoubleValue();
+    }
+    readMs("minSpeechMs", &vadOptions_.minSpeechMs);
+    readMs("hangoverMs", &vadOptions_.hangoverMs);
+    readMs("preRollMs", &vadOptions_.preRollMs);
+    vadEnabled_ = true;
+    return true;
+}
+
+// meter: true for the defaults, or an object overriding some of them
+bool AudioRecorderWrapper::ReadMeterOptions(Napi::Env env, const Napi::Object& options) {
+    meterEnabled_ = false;
+    meterOptions_ = LevelMeterOptions();
+    if (!options.Has("meter")) return true;
+
+    Napi::Value value = options.Get("meter");
+    if (value.IsBoolean()) {
+        meterEnabled_ = value.As<Napi::Boolean>().Value();
+        return true;
+    }
+    if (value.IsUndefined() || value.IsNull()) return true;
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "meter must be a boolean or an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object meter = value.As<Napi::Object>();
+    if (meter.Has("intervalMs") && meter.Get("intervalMs").IsNumber()) {
+        double intervalMs = meter.Get("intervalMs").As<Napi::Number>().DoubleValue();
+        if (intervalMs > 0) {
+            meterOptions_.intervalMs = intervalMs;
+        }
+    }
+    if (meter.Has("bands") && meter.Get("bands").IsBoolean()) {
+        meterOptions_.bands = meter.Get("bands").As<Napi::Boolean>().Value();
+    }
+    if (meter.Has("pcm") && meter.Get("pcm").IsBoolean()) {
+        meterOptions_.pcm = meter.Get("pcm").As<Napi::Boolean>().Value();
+    }
+    meterEnabled_ = true;
+    return true;
+}
+
+// features: true for the defaults, or an object overriding some of them.
+// Whether they fit the stream's rate is only known once it starts.
+bool AudioRecorderWrapper::ReadFeatureOptions(Napi::Env env, const Napi::Object& options) {
+    featuresEnabled_ = false;
+    featureOptions_ = FeatureOptions();
+    if (!options.Has("features")) return true;
+
+    Napi::Value value = options.Get("features");
+    if (value.IsBoolean()) {
+        featuresEnabled_ = value.As<Napi::Boolean>().Value();
+        return true;
+    }
+    if (value.IsUndefined() || value.IsNull()) return true;
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "features must be a boolean or an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object features = value.As<Napi::Object>();
+    auto readNumber = [&](const char* key, double* out, bool allowZero) {
+        if (!features.Has(key) || !features.Get(key).IsNumber()) return true;
+        double number = features.Get(key).As<Napi::Number>().DoubleValue();
+        if (!std::isfinite(number) || number < 0 || (number == 0 && !allowZero)) {
+            Napi::RangeError::New(env, std::string("features.") + key + " must be a positive number")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        *out = number;
+        return true;
+    };
+    if (!readNumber("windowMs", &featureOptions_.windowMs, false)) return false;
+    if (!readNumber("hopMs", &featureOptions_.hopMs, false)) return false;
+    if (!readNumber("minHz", &featureOptions_.minHz, true)) return false;
+    if (!readNumber("maxHz", &featureOptions_.maxHz, true)) return false;
+
+    if (features.Has("melBins") && features.Get("melBins").IsNumber()) {
+        double bins = features.Get("melBins").As<Napi::Number>().DoubleValue();
+        if (!(bins >= 1 && bins <= FeatureExtractor::kMaxMelBins) || bins != std::floor(bins)) {
+            Napi::RangeError::New(env, "features.melBins must be an integer from 1 to " +
+                                           std::to_string(FeatureExtractor::kMaxMelBins))
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        featureOptions_.melBins = static_cast<uint32_t>(bins);
+    }
+    if (features.Has("fftSize") && features.Get("fftSize").IsNumber()) {
+        double size = features.Get("fftSize").As<Napi::Number>().DoubleValue();
+        if (!(size >= RealFft::kMinSize && size <= RealFft::kMaxSize) ||
+            !RealFft::Supports(static_cast<size_t>(size)) || size != std::floor(size)) {
+            Napi::RangeError::New(env, "features.fftSize must be a power of two from " +
+                                           std::to_string(RealFft::kMinSize) + " to " +
+                                           std::to_string(RealFft::kMaxSize))
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        featureOptions_.fftSize = static_cast<uint32_t>(size);
+    }
+    if (features.Has("pcm") && features.Get("pcm").IsBoolean()) {
+        featureOptions_.pcm = features.Get("pcm").As<Napi::Boolean>().Value();
+    }
+    featuresEnabled_ = true;
+    return true;
+}
+
+// preRoll: true for the defaults, or an object overriding some of them
+bool AudioRecorderWrapper::ReadPreRollOptions(Napi::Env env, const Napi::Object& options) {
+    preRollEnabled_ = false;
+    preRollOptions_ = PreRollOptions();
+    if (!options.Has("preRoll")) return true;
+
+    Napi::Value value = options.Get("preRoll");
+    if (value.IsBoolean()) {
+        preRollEnabled_ = value.As<Napi::Boolean>().Value();
+        return true;
+    }
+    if (value.IsUndefined() || value.IsNull()) return true;
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "preRoll must be a boolean or an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object preRoll = value.As<Napi::Object>();
+    if (preRoll.Has("durationMs") && preRoll.Get("durationMs").IsNumber()) {
+        double durationMs = preRoll.Get("durationMs").As<Napi::Number>().DoubleValue();
+        if (!std::isfinite(durationMs) || durationMs <= 0) {
+            Napi::RangeError::New(env, "preRoll.durationMs must be a positive number").ThrowAsJavaScriptException();
+            return false;
+        }
+        preRollOptions_.durationMs = durationMs;
+    }
+    if (preRoll.Has("int16") && preRoll.Get("int16").IsBoolean()) {
+        preRollOptions_.int16 = preRoll.Get("int16").As<Napi::Boolean>().Value();
+    }
+    preRollEnabled_ = true;
+    return true;
+}
+
+// fileSink: a path, or an object with the path and how to write the file.
+// Called once encoding_ is known, which decides the default container.
+bool AudioRecorderWrapper::ReadFileSinkOptions(Napi::Env env, const Napi::Object& options) {
+    fileSinkEnabled_ = false;
+    fileSinkOptions_ = FileSinkOptions();
+    fileSinkDeliver_ = true;
+    if (!options.Has("fileSink")) return true;
+
+    Napi::Value value = options.Get("fileSink");
+    if (value.IsUndefined() || value.IsNull()) return true;
+
+    std::string containerName;
+    if (value.IsString()) {
+        fileSinkOptions_.path = value.As<Napi::String>().Utf8Value();
+    } else if (value.IsObject()) {
+        Napi::Object sink = value.As<Napi::Object>();
+        if (sink.Has("path") && sink.Get("path").IsString()) {
+            fileSinkOptions_.path = sink.Get("path").As<Napi::String>().Utf8Value();
+        }
+        if (sink.Has("container") && sink.Get("container").IsString()) {
+            containerName = sink.Get("container").As<Napi::String>().Utf8Value();
+        }
+        if (sink.Has("preallocateBytes") && sink.Get("preallocateBytes").IsNumber()) {
+            double bytes = sink.Get("preallocateBytes").As<Napi::Number>().DoubleValue();
+            if (bytes > 0) {
+                fileSinkOptions_.preallocateBytes = static_cast<uint64_t>(bytes);
+            }
+        }
+        if (sink.Has("bufferBytes") && sink.Get("bufferBytes").IsNumber()) {
+            double bytes = sink.Get("bufferBytes").As<Napi::Number>().DoubleValue();
+            if (bytes > 0) {
+                fileSinkOptions_.bufferBytes = static_cast<size_t>(bytes);
+            }
+        }
+        if (sink.Has("deliver") && sink.Get("deliver").IsBoolean()) {
+            fileSinkDeliver_ = sink.Get("deliver").As<Napi::Boolean>().Value();
+        }
+    } else {
+        Napi::TypeError::New(env, "fileSink must be a path or an object").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    if (fileSinkOptions_.path.empty()) {
+        Napi::TypeError::New(env, "fileSink.path must be a non-empty string").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    if (containerName.empty()) {
+        fileSinkOptions_.container = FileSink::ContainerFor(encoding_);
+    } else if (!FileSink::ParseContainer(containerName, &fileSinkOptions_.container)) {
+        Napi::TypeError::New(env, "Unknown fileSink.container: " + containerName).ThrowAsJavaScriptException();
+        return false;
+    } else if (!FileSink::Accepts(fileSinkOptions_.container, encoding_)) {
+        Napi::TypeError::New(env, "fileSink.container '" + containerName + "' cannot hold this encoding")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    fileSinkEnabled_ = true;
+    return true;
+}
+
+// channels: the device channels to keep, as 0-based indices in output order,
+// or { matrix } with a row of input channel weights per output channel
+bool AudioRecorderWrapper::ReadChannelMapOptions(Napi::Env env, const Napi::Object& options) {
+    channelMap_ = ChannelMap();
+    if (!options.Has("channels")) return true;
+
+    Napi::Value value = options.Get("channels");
+    if (value.IsUndefined() || value.IsNull()) return true;
+
+    auto fail = [&env](const std::string& message) {
+        Napi::TypeError::New(env, message).ThrowAsJavaScriptException();
+        return false;
+    };
+
+    uint32_t outputs = 0;
+    uint32_t inputs = 0;
+    std::vector<float> weights;
+    if (value.IsArray()) {
+        Napi::Array indices = value.As<Napi::Array>();
+        std::vector<uint32_t> picks;
+        for (uint32_t i = 0; i < indices.Length(); i++) {
+            Napi::Value index = indices.Get(i);
+            double channel = index.IsNumber() ? index.As<Napi::Number>().DoubleValue() : -1.0;
+            if (!(channel >= 0 && channel < AUDIO_DSP_MAX_CHANNELS) || channel != std::floor(channel)) {
+                return fail("channels must be channel indices from 0 to " + std::to_string(AUDIO_DSP_MAX_CHANNELS - 1));
+            }
+            picks.push_back(static_cast<uint32_t>(channel));
+            inputs = std::max(inputs, picks.back() + 1);
+        }
+        outputs = static_cast<uint32_t>(picks.size());
+        weights.assign(static_cast<size_t>(outputs) * inputs, 0.0f);
+        for (uint32_t o = 0; o < outputs; o++) {
+            weights[o * inputs + picks[o]] = 1.0f;
+        }
+    } else if (value.IsObject() && value.As<Napi::Object>().Get("matrix").IsArray()) {
+        Napi::Array rows = value.As<Napi::Object>().Get("matrix").As<Napi::Array>();
+        outputs = rows.Length();
+        for (uint32_t o = 0; o < outputs; o++) {
+            Napi::Value row = rows.Get(o);
+            if (!row.IsArray() || (o > 0 && row.As<Napi::Array>().Length() != inputs)) {
+                return fail("channels.matrix must be rows of equal length, one per output channel");
+            }
+            Napi::Array coefficients = row.As<Napi::Array>();
+            inputs = coefficients.Length();
+            for (uint32_t i = 0; i < inputs; i++) {
+                Napi::Value weight = coefficients.Get(i);
+                if (!weight.IsNumber()) {
+                    return fail("channels.matrix weights must be numbers");
+                }
+                weights.push_back(weight.As<Napi::Number>().FloatValue());
+            }
+        }
+    } else {
+        return fail("channels must be an array of channel indices or an object with a matrix");
+    }
+
+    if (outputs == 0 || inputs == 0) {
+        return fail("channels must produce at least one channel from at least one channel");
+    }
+    if (!channelMap_.Assign(weights.data(), outputs, inputs)) {
+        return fail("channels is limited to " + std::to_string(AUDIO_DSP_MAX_CHANNELS) + " channels in and out");
+    }
+    return true;
+}
+
+// sharedRing: an Int32Array over the whole SharedArrayBuffer, as the TS layer
+// passes it; Atomics.notify needs the view, the writer its memory
+bool AudioRecorderWrapper::ReadSharedRingOptions(Napi::Env env, const Napi::Object& options) {
+    ReleaseSharedRing();
+    if (!options.Has("sharedRing")) return true;
+
+    Napi::Value value = options.Get("sharedRing");
+    if (value.IsUndefined() || value.IsNull()) return true;
+    if (!value.IsTypedArray() || value.As<Napi::TypedArray>().TypedArrayType() != napi_int32_array) {
+        Napi::TypeError::New(env, "sharedRing must be a SharedArrayBuffer").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (encoding_ == AudioEncoding::Flac || encoding_ == AudioEncoding::Opus) {
+        Napi::TypeError::New(env, "sharedRing carries PCM and cannot be used with this encoding")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    // Read the data pointer through the view: the buffer is shared, which
+    // the ArrayBuffer accessors do not accept
+    Napi::TypedArray view = value.As<Napi::TypedArray>();
+    napi_typedarray_type type;
+    size_t length = 0;
+    void* data = nullptr;
+    napi_value buffer;
+    size_t byteOffset = 0;
+    if (napi_get_typedarray_info(env, view, &type, &length, &data, &buffer, &byteOffset) != napi_ok) {
+        Napi::Error::New(env, "Cannot access sharedRing").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    const char* error = nullptr;
+    if (!sharedRing_.Attach(static_cast<uint8_t*>(data), length * sizeof(int32_t), &error)) {
+        Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+        return false;
+    }
+
+    // Atomics.notify(view, kWritePosition), bound so that OnSharedRingWake
+    // can call it without arguments
+    Napi::Object atomics = env.Global().Get("Atomics").As<Napi::Object>();
+    Napi::Function notify = atomics.Get("notify").As<Napi::Function>();
+    Napi::Function bind = notify.Get("bind").As<Napi::Function>();
+    Napi::Value wake =
+        bind.Call(notify, {atomics, view, Napi::Number::New(env, SharedRingWriter::kWritePosition)});
+    if (env.IsExceptionPending() || !wake.IsFunction()) {
+        sharedRing_.Detach();
+        if (!env.IsExceptionPending()) {
+            Napi::Error::New(env, "Atomics.notify is not available").ThrowAsJavaScriptException();
+        }
+        return false;
+    }
+
+    // A reader waiting on the ring is no reason to keep the process alive
+    if (!sharedRingWake_.Open(env, "AudioRecorderSharedRing", &AudioRecorderWrapper::OnSharedRingWake, this, false)) {
+        sharedRing_.Detach();
+        Napi::Error::New(env, "Cannot wake sharedRing readers").ThrowAsJavaScriptException();
+        return false;
+    }
+    sharedRingRef_ = Napi::Persistent(view);
+    sharedRingNotify_ = Napi::Persistent(wake.As<Napi::Function>());
+    return true;
+}
+
+// Any thread; wakes made before the JS thread runs coalesce into one notify
+void AudioRecorderWrapper::NotifySharedRing() {
+    sharedRingWake_.Signal();
+}
+
+void AudioRecorderWrapper::OnSharedRingWake(napi_env env, void* context) {
+    AudioRecorderWrapper* self = static_cast<AudioRecorderWrapper*>(context);
+    (void)env;
+    if (self->sharedRingNotify_.IsEmpty()) return;
+    self->sharedRingWake_.Call(self->sharedRingNotify_.Value(), 0, nullptr);
+}
+
+// JS thread, while nothing is capturing
+void AudioRecorderWrapper::ReleaseSharedRing() {
+    if (!sharedRing_.Attached()) return;
+
+    sharedRing_.Detach();
+    sharedRingWake_.Close();
+    sharedRingNotify_.Reset();
+    sharedRingRef_.Reset();
+}
+
+bool AudioRecorderWrapper::IsCapturing() const {
+    return subscription_ != nullptr || combined_ != nullptr || audio_is_running(handle_);
+}
+
+bool AudioRecorderWrapper::WantsSharedCapture(const Napi::Object& options) {
+    return options.Has("shared") && options.Get("shared").IsBoolean() &&
+           options.Get("shared").As<Napi::Boolean>().Value();
+}
+
+bool AudioRecorderWrapper::CheckLifecycleIdle(Napi::Env env) {
+    if (lifecycleBusy_) {
+        Napi::Error::New(env, "A start or stop is already in progress").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+Napi::Value AudioRecorderWrapper::StartCapture(Napi::Env env, CaptureOperation start, const char* failure) {
+    if (IsCapturing()) {
+        // Already running, as the platform layers report it
+        Napi::Error::New(env, std::string(failure) + ": error code -2").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // The file is created on the thread pool too, and before the capture
+    // starts, so that it is there for the first chunk
+    if (fileSinkEnabled_) {
+        CaptureOperation capture = std::move(start);
+        start = [this, capture](CaptureSession& session) {
+            fileSink_ = FileSink::Open(fileSinkOptions_, &session.error);
+            if (!fileSink_) return static_cast<int32_t>(-1);
+
+            int32_t result = capture(session);
+            if (result != 0) {
+                fileSink_.reset();
+            }
+            return result;
+        };
+    }
+
+    startCancelled_ = false;
+    CaptureWorker* worker =
+        new CaptureWorker(env, this, CaptureWorker::kStart, std::move(start), CaptureSession(), failure);
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
+// Called on a worker thread, with nothing else touching the session
+int32_t AudioRecorderWrapper::StopSession(CaptureSession& session) {
+    // Leaving a shared capture drains this subscriber and reports stop; the
+    // capture itself stops with its last subscriber
+    if (session.subscription) {
+        session.subscription.reset();
+        return 0;
+    }
+
+    // Stops both sources, delivers the aligned remainder and reports stop
+    if (session.combined) {
+        session.combined.reset();
+        return 0;
+    }
+
+    return session.handle ? audio_stop(session.handle) : 0;
+}
+
+Napi::Value AudioRecorderWrapper::Stop(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!CheckLifecycleIdle(env)) return env.Null();
+
+    // A producer blocked on a full ring would otherwise deadlock audio_stop
+    stopping_ = true;
+
+    // The worker takes over whatever is capturing; its counters are kept here
+    CaptureSession session;
+    if (subscription_ || combined_) {
+        SnapshotNativeStats(&retiredStats_);
+        hasRetiredStats_ = true;
+        session.subscription = std::move(subscription_);
+        session.combined = std::move(combined_);
+    } else {
+        session.handle = handle_;
+    }
+
+    CaptureWorker* worker = new CaptureWorker(env, this, CaptureWorker::kStop, &AudioRecorderWrapper::StopSession,
+                                              std::move(session), "Failed to stop recording");
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
+// Takes effect when the pending start returns: a start that succeeded is
+// stopped again and its Promise rejects
+Napi::Value AudioRecorderWrapper::CancelStart(const Napi::CallbackInfo& info) {
+    if (lifecycleBusy_) {
+        startCancelled_ = true;
+    }
+    return info.Env().Undefined();
+}
+
+Napi::Value AudioRecorderWrapper::IsRunning(const Napi::CallbackInfo& info) {
+    // Not until a pending start has settled
+    return Napi::Boolean::New(info.Env(), !lifecycleBusy_ && IsCapturing());
+}
+
+Napi::Value AudioRecorderWrapper::ProcessEvents(const Napi::CallbackInfo& info) {
+    return DrainEvents(info.Env());
+}
+
+Napi::Value AudioRecorderWrapper::GetOverflowCount(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), static_cast<double>(overflowCount_.load()));
+}
+
+// Flushing happens on the chunk thread with the next chunk, so the history
+// reaches JS shortly after, ahead of the live chunks that follow it
+Napi::Value AudioRecorderWrapper::CommitPreRoll(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!preRollEnabled_ || lifecycleBusy_ || !IsCapturing()) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    double sinceMs = INFINITY;
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        sinceMs = std::max(0.0, info[0].As<Napi::Number>().DoubleValue());
+    }
+
+    // Only the first commit of a recording counts
+    double pending = -1.0;
+    return Napi::Boolean::New(env, preRollCommitMs_.compare_exchange_strong(pending, sinceMs));
+}
+
+Napi::Value AudioRecorderWrapper::GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    AudioStatsSnapshot native = {};
+    if (IsCapturing() || !hasRetiredStats_) {
+        SnapshotNativeStats(&native);
+    } else {
+        native = retiredStats_;
+    }
+
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("framesCaptured", Napi::Number::New(env, static_cast<double>(native.framesCaptured)));
+    stats.Set("framesEmitted", Napi::Number::New(env, static_cast<double>(native.framesEmitted)));
+    stats.Set("framesDropped", Napi::Number::New(env, static_cast<double>(native.framesDropped)));
+    stats.Set("chunksDelivered", Napi::Number::New(env, static_cast<double>(chunksDelivered_)));
+    stats.Set("chunksDropped", Napi::Number::New(env, static_cast<double>(overflowCount_.load())));
+    stats.Set("queueBytes", Napi::Number::New(env, static_cast<double>(ring_->Used())));
+    stats.Set("queueHighWaterBytes", Napi::Number::New(env, static_cast<double>(queueHighWater_.load())));
+    stats.Set("queueCapacityBytes", Napi::Number::New(env, static_cast<double>(ring_->Capacity())));
+    stats.Set("callbackDuration", BuildDurationStats(env, native.callbackCount, native.callbackP50Ns,
+                                                     native.callbackP99Ns, native.callbackMaxNs));
+    stats.Set("latency", BuildDurationStats(env, latency_.Count(), latency_.Percentile(0.50),
+                                            latency_.Percentile(0.99), latency_.Max()));
+    stats.Set("conversionTimeMs", Napi::Number::New(env, static_cast<double>(native.conversionNs) / 1e6));
+
+    // A pending start may still be opening the sink
+    FileSink* sink = lifecycleBusy_ ? nullptr : fileSink_.get();
+    stats.Set("fileBytesWritten", Napi::Number::New(env, sink ? static_cast<double>(sink->BytesWritten()) : 0));
+    stats.Set("fileBytesDropped", Napi::Number::New(env, sink ? static_cast<double>(sink->BytesDropped()) : 0));
+    return stats;
+}
+
+Napi::Object AudioRecorderWrapper::BuildDurationStats(Napi::Env env, uint64_t count, uint64_t p50Ns, uint64_t p99Ns,
+                                                      uint64_t maxNs) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("count", Napi::Number::New(env, static_cast<double>(count)));
+    obj.Set("p50Ms", Napi::Number::New(env, static_cast<double>(p50Ns) / 1e6));
+    obj.Set("p99Ms", Napi::Number::New(env, static_cast<double>(p99Ns) / 1e6));
+    obj.Set("maxMs", Napi::Number::New(env, static_cast<double>(maxNs) / 1e6));
+    return obj;
+}
+
+void AudioRecorderWrapper::SnapshotNativeStats(AudioStatsSnapshot* stats) const {
+    *stats = {};
+    if (subscription_) {
+        subscription_->GetStats(stats);
+    } else if (combined_) {
+        combined_->GetStats(stats);
+    } else if (handle_) {
+        audio_get_stats(handle_, stats);
+    }
+}
+
+Napi::Array AudioRecorderWrapper::DrainEvents(Napi::Env env) {
+    std::vector<AudioEvent> control;
+    {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        control.swap(controlQueue_);
+    }
+
+    // A drop flagged by the chunk thread, reported after everything queued so far
+    if (fileSinkBehind_.exchange(false, std::memory_order_acq_rel)) {
+        AudioEvent warning;
+        warning.type = kEventWarning;
+        warning.seq = nextSeq_.fetch_add(1);
+        warning.message = "File sink fell behind; audio is missing from the file";
+        control.push_back(std::move(warning));
+    }
+
+    Napi::Array result = Napi::Array::New(env);
+    uint32_t count = 0;
+    size_t nextControl = 0;
+    const uint64_t now = audio_stats_now_ns();
+
+    for (;;) {
+        SpscRing::Record record;
+        bool haveRecord = ring_->Peek(&record);
+
+        // Control events queued before this chunk go first
+        while (nextControl < control.size() &&
+               (!haveRecord || control[nextControl].seq < record.header.seq)) {
+            result.Set(count++, BuildControlEvent(env, control[nextControl++]));
+        }
+
+        if (!haveRecord) break;
+
+        // Every record we write leads with a ChunkRecordHeader. A shorter one
+        // was torn by a drop-oldest overwrite: the claim fails and we look
+        // again, or it was never ours and is discarded.
+        if (record.header.size < sizeof(ChunkRecordHeader)) {
+            ring_->Claim(record);
+            continue;
+        }
+
+        // Copied out before claiming, like the payload itself
+        ChunkRecordHeader header;
+        memcpy(&header, record.payload, sizeof(header));
+        const uint8_t* payload = record.payload + sizeof(header);
+        size_t payloadSize = record.header.size - sizeof(header);
+
+        // Speech events are all header, which is already copied out
+        if (record.header.type == kEventSpeechStart || record.header.type == kEventSpeechEnd) {
+            if (!ring_->Claim(record)) continue;
+            AudioEvent speech;
+            speech.type = record.header.type;
+            speech.framePosition = header.info.framePosition;
+            speech.hostTimeNs = header.info.hostTimeNs;
+            result.Set(count++, BuildControlEvent(env, speech));
+            continue;
+        }
+
+        // Events parsed from their payload are copied to scratch and claimed
+        // first, so what they are built from cannot change underneath them
+        if (record.header.type == kEventLevel || record.header.type == kEventFeatures) {
+            drainScratch_.assign(payload, payload + payloadSize);
+            if (!ring_->Claim(record)) continue;
+            Napi::Value event = record.header.type == kEventLevel
+                ? BuildLevelEvent(env, header, drainScratch_.data(), payloadSize)
+                : BuildFeatureEvent(env, header, drainScratch_.data(), payloadSize);
+            if (!event.IsUndefined()) {
+                result.Set(count++, event);
+            }
+            continue;
+        }
+
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("type", Napi::Number::New(env, kEventData));
+
+        if (record.header.type == kEventDataSlab) {
+            // Claim before wrapping: if the producer dropped the record it
+            // already returned the slab to the pool
+            if (payloadSize < sizeof(ChunkPool::Slab*)) {
+                ring_->Claim(record);
+                continue;
+            }
+            ChunkPool::Slab* slab;
+            memcpy(&slab, payload, sizeof(slab));
+            if (!ring_->Claim(record)) continue;
+
+            // Hand the slab to JS; it returns to the pool when the Buffer is collected.
+            // NewOrCopy falls back to a copy (and releases immediately) where external
+            // buffers are disallowed, e.g. Electron with the V8 memory cage.
+            Napi::Buffer<uint8_t> buffer = Napi::Buffer<uint8_t>::NewOrCopy(
+                env, slab->data, slab->size,
+                [](Napi::Env, uint8_t*, ChunkPool::Slab* hint) { ChunkPool::Release(hint); },
+                slab
+            );
+            obj.Set("data", buffer);
+        } else {
+            // Copy straight out of the ring, then claim; a failed claim means
+            // the producer overwrote the record and the copy is discarded
+            Napi::Buffer<uint8_t> buffer = Napi::Buffer<uint8_t>::Copy(env, payload, payloadSize);
+            if (!ring_->Claim(record)) continue;
+            obj.Set("data", buffer);
+        }
+
+        SetChunkInfo(env, obj, header);
+        result.Set(count++, obj);
+
+        chunksDelivered_++;
+        if (header.info.hostTimeNs != 0 && now > header.info.hostTimeNs) {
+            latency_.Record(now - header.info.hostTimeNs);
+        }
+    }
+
+    return result;
+}
+
+void AudioRecorderWrapper::SetChunkInfo(Napi::Env env, Napi::Object& obj, const ChunkRecordHeader& header) {
+    const AudioChunkInfo& info = header.info;
+    obj.Set("sequence", Napi::Number::New(env, static_cast<double>(header.sequence)));
+    obj.Set("framePosition", Napi::Number::New(env, static_cast<double>(info.framePosition)));
+    obj.Set("discontinuity", Napi::Boolean::New(env, (info.flags & AUDIO_CHUNK_DISCONTINUITY) != 0));
+
+    // Nanoseconds since boot outgrow a double's integer range, hence BigInt
+    if (info.hostTimeNs != 0) {
+        obj.Set("hostTime", Napi::BigInt::New(env, info.hostTimeNs));
+    }
+    if (info.flags & AUDIO_CHUNK_DEVICE_POSITION) {
+        obj.Set("devicePosition", Napi::Number::New(env, static_cast<double>(info.devicePosition)));
+    }
+}
+
+Napi::Value AudioRecorderWrapper::BuildLevelEvent(Napi::Env env, const ChunkRecordHeader& header,
+                                                  const uint8_t* payload, size_t size) {
+    if (size < sizeof(LevelRecord)) return env.Undefined();
+
+    LevelRecord level;
+    memcpy(&level, payload, sizeof(level));
+
+    // The counts must describe values the record actually holds
+    size_t valueCount = 2 * static_cast<size_t>(level.channels) + level.bandCount;
+    if (level.channels > AUDIO_DSP_MAX_CHANNELS || level.bandCount > LevelMeter::kBands ||
+        valueCount * sizeof(float) > size - sizeof(level)) {
+        return env.Undefined();
+    }
+    const uint8_t* values = payload + sizeof(level);
+    auto value = [values](size_t index) {
+        float v;
+        memcpy(&v, values + index * sizeof(float), sizeof(v));
+        return v;
+    };
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("type", Napi::Number::New(env, kEventLevel));
+    obj.Set("framePosition", Napi::Number::New(env, static_cast<double>(header.info.framePosition)));
+    if (header.info.hostTimeNs != 0) {
+        obj.Set("hostTime", Napi::BigInt::New(env, header.info.hostTimeNs));
+    }
+    obj.Set("frames", Napi::Number::New(env, level.frames));
+
+    Napi::Array rms = Napi::Array::New(env, level.channels);
+    Napi::Array peak = Napi::Array::New(env, level.channels);
+    for (uint32_t c = 0; c < level.channels; c++) {
+        rms.Set(c, Napi::Number::New(env, value(c)));
+        peak.Set(c, Napi::Number::New(env, value(level.channels + c)));
+    }
+    obj.Set("rms", rms);
+    obj.Set("peak", peak);
+
+    if (level.bandCount == LevelMeter::kBands) {
+        size_t first = 2 * static_cast<size_t>(level.channels);
+        Napi::Object bands = Napi::Object::New(env);
+        bands.Set("low", Napi::Number::New(env, value(first)));
+        bands.Set("mid", Napi::Number::New(env, value(first + 1)));
+        bands.Set("high", Napi::Number::New(env, value(first + 2)));
+        obj.Set("bands", bands);
+    }
+    return obj;
+}
+
+Napi::Value AudioRecorderWrapper::BuildFeatureEvent(Napi::Env env, const ChunkRecordHeader& header,
+                                                    const uint8_t* payload, size_t size) {
+    if (size < sizeof(FeatureRecord)) return env.Undefined();
+
+    FeatureRecord features;
+    memcpy(&features, payload, sizeof(features));
+    size_t valueCount = static_cast<size_t>(features.frames) * features.bins;
+    valueCount = std::min(valueCount, (size - sizeof(features)) / sizeof(float));
+
+    // The payload need not be float-aligned, so copy into a fresh buffer
+    Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, valueCount * sizeof(float));
+    memcpy(buffer.Data(), payload + sizeof(features), valueCount * sizeof(float));
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("type", Napi::Number::New(env, kEventFeatures));
+    obj.Set("framePosition", Napi::Number::New(env, static_cast<double>(header.info.framePosition)));
+    if (header.info.hostTimeNs != 0) {
+        obj.Set("hostTime", Napi::BigInt::New(env, header.info.hostTimeNs));
+    }
+    obj.Set("frames", Napi::Number::New(env, features.frames));
+    obj.Set("bins", Napi::Number::New(env, features.bins));
+    obj.Set("hopFrames", Napi::Number::New(env, features.hopFrames));
+    obj.Set("features", Napi::Float32Array::New(env, valueCount, buffer, 0));
+    return obj;
+}
+
+Napi::Object AudioRecorderWrapper::BuildControlEvent(Napi::Env env, const AudioEvent& event) {
+    Napi::Object obj = Napi::Object::New(env);
+
+    obj.Set("type", Napi::Number::New(env, event.type));
+
+    switch (event.type) {
+        case kEventStart:
+        case kEventStop:
+            // No additional data needed
+            break;
+
+        case kEventError:
+        case kEventWarning:
+            obj.Set("message", Napi::String::New(env, event.message));
+            break;
+
+        case kEventSpeechStart:
+        case kEventSpeechEnd:
+            obj.Set("framePosition", Napi::Number::New(env, static_cast<double>(event.framePosition)));
+            if (event.hostTimeNs != 0) {
+                obj.Set("hostTime", Napi::BigInt::New(env, event.hostTimeNs));
+            }
+            break;
+
+        case kEventMetadata:
+            obj.Set("sampleRate", Napi::Number::New(env, event.sampleRate));
+            obj.Set("channelsPerFrame", Napi::Number::New(env, event.channelsPerFrame));
+            obj.Set("bitsPerChannel", Napi::Number::New(env, event.bitsPerChannel));
+            obj.Set("isFloat", Napi::Boolean::New(env, event.isFloat));
+            obj.Set("encoding", Napi::String::New(env, event.encoding));
+            break;
+    }
+
+    return obj;
+}
+
+void AudioRecorderWrapper::DiscardEvents() {
+    SpscRing::Record record;
+    while (ring_->Peek(&record)) {
+        if (ring_->Claim(record)) {
+            ReleaseRecord(record);
+        }
+    }
+
+    fileSinkBehind_ = false;
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    controlQueue_.clear();
+}
+
+void AudioRecorderWrapper::ReleaseRecord(const SpscRing::Record& record) {
+    if (record.header.type == kEventDataSlab) {
+        ChunkPool::Slab* slab;
+        memcpy(&slab, record.payload + sizeof(ChunkRecordHeader), sizeof(slab));
+        ChunkPool::Release(slab);
+    }
+}
+
+// Push delivery: instead of JS polling processEvents() on a timer, native
+// callbacks wake the event loop through a LoopWake. Every event queued before
+// JS gets to run is delivered in a single batch, so there is at most one call
+// per tick no matter how many chunks arrive.
+Napi::Value AudioRecorderWrapper::SetEventCallback(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsFunction() || info[0].IsNull() || info[0].IsUndefined())) {
+        Napi::TypeError::New(env, "Callback function or null expected").ThrowAsJavaScriptException();
         return env.Null();
     }
 
+    ReleaseEventCallback();
+
+    if (!info[0].IsFunction()) {
+        return env.Undefined();
+    }
+
+    if (!eventWake_.Open(env, "AudioRecorderEvents", &AudioRecorderWrapper::OnEventWake, this, true)) {
+        Napi::Error::New(env, "Cannot schedule event delivery").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    eventCallback_ = Napi::Persistent(info[0].As<Napi::Function>());
+
+    // Keep the JS object alive while deliveries can still target it;
+    // ReleaseEventCallback drops this reference
+    Ref();
+
+    pushEnabled_ = true;
+
+    // Flush anything queued before push delivery was enabled
+    eventWake_.Signal();
+
     return env.Undefined();
 }
 
-Napi::Value AudioRecorderWrapper::StartMicrophone(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+void AudioRecorderWrapper::NotifyEventCallback() {
+    // pushUsers_ lets ReleaseEventCallback wait out a producer that saw push
+    // enabled, without taking a lock on the audio thread
+    pushUsers_.fetch_add(1);
+    if (pushEnabled_) {
+        eventWake_.Signal();
+    }
+    pushUsers_.fetch_sub(1);
+}
+
+void AudioRecorderWrapper::OnEventWake(napi_env env, void* context) {
+    static_cast<AudioRecorderWrapper*>(context)->DeliverEvents(Napi::Env(env));
+}
+
+// Events queued while the callback runs wake the loop again
+void AudioRecorderWrapper::DeliverEvents(Napi::Env env) {
+    if (!pushEnabled_ || eventCallback_.IsEmpty()) return;
+
+    Napi::Array events = DrainEvents(env);
+    if (events.Length() == 0) return;
+
+    napi_value argument = events;
+    eventWake_.Call(eventCallback_.Value(), 1, &argument);
+}
+
+void AudioRecorderWrapper::ReleaseEventCallback() {
+    if (!pushEnabled_.exchange(false)) return;
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Options object expected").ThrowAsJavaScriptException();
-        return env.Null();
+    while (pushUsers_.load() > 0) {
+        std::this_thread::yield();
     }
 
-    Napi::Object options = info[0].As<Napi::Object>();
-
-    // Extract options with defaults
-    double sampleRate = 0;
-    if (options.Has("sampleRate") && options.Get("sampleRate").IsNumber()) {
-        sampleRate = options.Get("sampleRate").As<Napi::Number>().DoubleValue();
-    }
+    eventWake_.Close();
+    eventCallback_.Reset();
+    Unref();
+}
 
-    double chunkDurationMs = 200;
-    if (options.Has("chunkDurationMs") && options.Get("chunkDurationMs").IsNumber()) {
-        chunkDurationMs = options.Get("chunkDurationMs").As<Napi::Number>().DoubleValue();
-    }
+void AudioRecorderWrapper::OnData(const uint8_t* data, int32_t length, const AudioChunkInfo* info,
+                                  void* context) {
+    AudioRecorderWrapper* self = static_cast<AudioRecorderWrapper*>(context);
+    if (self->isDestroyed_ || length <= 0) return;
 
-    bool isMono = true;
-    if (options.Has("stereo") && options.Get("stereo").IsBoolean()) {
-        isMono = !options.Get("stereo").As<Napi::Boolean>().Value();
+    if (self->meter_) {
+        self->meter_->Process(data, static_cast<size_t>(length), *info, &AudioRecorderWrapper::OnLevel, self);
     }
-
-    bool emitSilence = true;
-    if (options.Has("emitSilence") && options.Get("emitSilence").IsBoolean()) {
-        emitSilence = options.Get("emitSilence").As<Napi::Boolean>().Value();
+    if (self->features_) {
+        self->features_->Process(data, static_cast<size_t>(length), *info, &AudioRecorderWrapper::OnFeatures,
+                                 self);
     }
 
-    const char* deviceUID = nullptr;
-    std::string deviceUIDStr;
-    if (options.Has("deviceId") && options.Get("deviceId").IsString()) {
-        deviceUIDStr = options.Get("deviceId").As<Napi::String>().Utf8Value();
-        deviceUID = deviceUIDStr.c_str();
+    if (self->preRoll_ && !self->preRollLive_) {
+        double sinceMs = self->preRollCommitMs_.load(std::memory_order_acquire);
+        if (sinceMs < 0) {
+            self->preRoll_->Push(data, static_cast<size_t>(length), *info);
+            return;
+        }
+        self->preRoll_->Flush(self->preRoll_->FramesFor(sinceMs), &AudioRecorderWrapper::OnPreRollChunk, self);
+        self->preRollLive_ = true;
     }
 
-    double gain = 1.0;
-    if (options.Has("gain") && options.Get("gain").IsNumber()) {
-        gain = options.Get("gain").As<Napi::Number>().DoubleValue();
-    }
+    self->ForwardChunk(data, static_cast<size_t>(length), *info);
+}
 
-    int32_t result = audio_start_microphone(
-        handle_,
-        sampleRate,
-        chunkDurationMs,
-        isMono,
-        emitSilence,
-        deviceUID,
-        gain
-    );
+void AudioRecorderWrapper::OnPreRollChunk(const uint8_t* data, size_t size, const AudioChunkInfo& info,
+                                          void* context) {
+    static_cast<AudioRecorderWrapper*>(context)->ForwardChunk(data, size, info);
+}
 
-    if (result != 0) {
-        std::string errorMsg = "Failed to start microphone recording: error code " + std::to_string(result);
-        Napi::Error::New(env, errorMsg).ThrowAsJavaScriptException();
-        return env.Null();
+void AudioRecorderWrapper::ForwardChunk(const uint8_t* data, size_t size, const AudioChunkInfo& info) {
+    if (vad_) {
+        vad_->Process(data, size, info, &AudioRecorderWrapper::OnGatedChunk, &AudioRecorderWrapper::OnSpeech, this);
+    } else {
+        DeliverChunk(data, size, info);
     }
-
-    return env.Undefined();
 }
 
-Napi::Value AudioRecorderWrapper::Stop(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+// Same thread as the chunk being measured, so this is the ring's producer
+void AudioRecorderWrapper::OnLevel(const LevelReading& reading, void* context) {
+    AudioRecorderWrapper* self = static_cast<AudioRecorderWrapper*>(context);
 
-    int32_t result = audio_stop(handle_);
-    if (result != 0) {
-        Napi::Error::New(env, "Failed to stop recording").ThrowAsJavaScriptException();
-    }
+    LevelRecord level = {reading.frames, reading.channels, reading.bandCount};
+    size_t channelBytes = reading.channels * sizeof(float);
+    size_t size = sizeof(level) + 2 * channelBytes + reading.bandCount * sizeof(float);
+    if (size > self->levelRecord_.size()) return;
+
+    uint8_t* out = self->levelRecord_.data();
+    memcpy(out, &level, sizeof(level));
+    memcpy(out + sizeof(level), reading.rms, channelBytes);
+    memcpy(out + sizeof(level) + channelBytes, reading.peak, channelBytes);
+    memcpy(out + sizeof(level) + 2 * channelBytes, reading.bands, reading.bandCount * sizeof(float));
+
+    ChunkRecordHeader header;
+    header.info = {};
+    header.info.framePosition = reading.framePosition;
+    header.info.hostTimeNs = reading.hostTimeNs;
+    header.sequence = self->chunkSequence_;
+    self->WriteRecord(kEventLevel, header, out, size);
+}
 
-    return env.Undefined();
+// Same thread as the chunk being analysed, like OnLevel
+void AudioRecorderWrapper::OnFeatures(const FeatureBlock& block, void* context) {
+    AudioRecorderWrapper* self = static_cast<AudioRecorderWrapper*>(context);
+
+    FeatureRecord features = {block.frames, block.bins, block.hopFrames};
+    size_t valueBytes = static_cast<size_t>(block.frames) * block.bins * sizeof(float);
+    size_t size = sizeof(features) + valueBytes;
+    if (size > self->featureRecord_.size()) return;
+
+    uint8_t* out = self->featureRecord_.data();
+    memcpy(out, &features, sizeof(features));
+    memcpy(out + sizeof(features), block.values, valueBytes);
+
+    ChunkRecordHeader header;
+    header.info = {};
+    header.info.framePosition = block.framePosition;
+    header.info.hostTimeNs = block.hostTimeNs;
+    header.sequence = self->chunkSequence_;
+    self->WriteRecord(kEventFeatures, header, out, size);
 }
 
-Napi::Value AudioRecorderWrapper::IsRunning(const Napi::CallbackInfo& info) {
-    return Napi::Boolean::New(info.Env(), audio_is_running(handle_));
+// Whether data events carry PCM at all: the meter and the features can each
+// take the place of it
+bool AudioRecorderWrapper::PcmWanted() const {
+    return !(meter_ && !meterOptions_.pcm) && !(features_ && !featureOptions_.pcm);
 }
 
-Napi::Value AudioRecorderWrapper::ProcessEvents(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+void AudioRecorderWrapper::OnGatedChunk(const uint8_t* data, size_t size, const AudioChunkInfo& info,
+                                        void* context) {
+    static_cast<AudioRecorderWrapper*>(context)->DeliverChunk(data, size, info);
+}
 
-    std::vector<AudioEvent> events = DrainEvents();
-    Napi::Array result = Napi::Array::New(env, events.size());
+// Same thread as the chunk being classified, like OnLevel; the record is
+// only its header
+void AudioRecorderWrapper::OnSpeech(bool speaking, uint64_t framePosition, uint64_t hostTimeNs, void* context) {
+    AudioRecorderWrapper* self = static_cast<AudioRecorderWrapper*>(context);
 
-    for (size_t i = 0; i < events.size(); i++) {
-        const AudioEvent& event = events[i];
-        Napi::Object obj = Napi::Object::New(env);
+    ChunkRecordHeader header;
+    header.info = {};
+    header.info.framePosition = framePosition;
+    header.info.hostTimeNs = hostTimeNs;
+    header.sequence = self->chunkSequence_;
+    self->WriteRecord(speaking ? kEventSpeechStart : kEventSpeechEnd, header, nullptr, 0);
+}
 
-        obj.Set("type", Napi::Number::New(env, event.type));
+void AudioRecorderWrapper::DeliverChunk(const uint8_t* data, size_t size, const AudioChunkInfo& info) {
+    // Nothing downstream wants the chunk
+    if (!PcmWanted() && !fileSink_ && !sharedRing_.Attached()) return;
 
-        switch (event.type) {
-            case 0: // data
-                {
-                    Napi::Buffer<uint8_t> buffer = Napi::Buffer<uint8_t>::Copy(
-                        env, event.data.data(), event.data.size()
-                    );
-                    obj.Set("data", buffer);
-                }
-                break;
+    // Encoded packets carry the timing of the chunk that completed them
+    chunkInfo_ = info;
 
-            case 1: // start
-            case 2: // stop
-                // No additional data needed
-                break;
+    if (encoder_) {
+        encoder_->Encode(data, size, &AudioRecorderWrapper::OnEncodedPacket, this);
+    } else {
+        WriteChunk(data, size);
+    }
+}
 
-            case 3: // error
-                obj.Set("message", Napi::String::New(env, event.message));
-                break;
+void AudioRecorderWrapper::OnEncodedPacket(const uint8_t* data, size_t size, void* context) {
+    static_cast<AudioRecorderWrapper*>(context)->WriteChunk(data, size);
+}
 
-            case 4: // metadata
-                obj.Set("sampleRate", Napi::Number::New(env, event.sampleRate));
-                obj.Set("channelsPerFrame", Napi::Number::New(env, event.channelsPerFrame));
-                obj.Set("bitsPerChannel", Napi::Number::New(env, event.bitsPerChannel));
-                obj.Set("isFloat", Napi::Boolean::New(env, event.isFloat));
-                obj.Set("encoding", Napi::String::New(env, event.encoding));
-                break;
+void AudioRecorderWrapper::WriteChunk(const uint8_t* data, size_t size) {
+    if (fileSink_) {
+        // Only flagged here: the drain turns it into the warning, so the
+        // chunk thread neither locks nor allocates when the disk is slow
+        if (!fileSink_->Write(data, size) && !fileSinkWarned_) {
+            fileSinkWarned_ = true;
+            fileSinkBehind_.store(true, std::memory_order_release);
+            NotifyEventCallback();
         }
+    }
 
-        result.Set(i, obj);
+    // The ring takes the place of data events
+    if (sharedRing_.Attached()) {
+        if (sharedRing_.Write(data, size)) {
+            NotifySharedRing();
+        } else {
+            overflowCount_++;
+        }
+        return;
     }
 
-    return result;
-}
+    if (fileSink_ && !fileSinkDeliver_) return;
+    if (!PcmWanted()) return;
 
-void AudioRecorderWrapper::OnData(const uint8_t* data, int32_t length, void* context) {
-    AudioRecorderWrapper* self = static_cast<AudioRecorderWrapper*>(context);
-    if (self->isDestroyed_) return;
+    ChunkRecordHeader header;
+    header.info = chunkInfo_;
+    header.sequence = chunkSequence_++;
 
-    AudioEvent event;
-    event.type = 0;
-    event.data.assign(data, data + length);
-    self->QueueEvent(std::move(event));
+    ChunkPool* pool = activePool_.load(std::memory_order_acquire);
+    ChunkPool::Slab* slab = pool ? pool->Acquire(size) : nullptr;
+    if (slab) {
+        memcpy(slab->data, data, size);
+        if (!WriteRecord(kEventDataSlab, header, &slab, sizeof(slab))) {
+            ChunkPool::Release(slab);
+        }
+    } else {
+        WriteRecord(kEventData, header, data, size);
+    }
 }
 
 void AudioRecorderWrapper::OnEvent(int32_t eventType, const char* message, void* context) {
@@ -402,13 +2183,51 @@ void AudioRecorderWrapper::OnEvent(int32_t eventType, const char* message, void*
     if (self->isDestroyed_) return;
 
     AudioEvent event;
-    // eventType from Swift: 0=start, 1=stop, 2=error
-    // We remap: 1=start, 2=stop, 3=error (0 is reserved for data)
-    event.type = eventType + 1;
+    // eventType from the platform: 0=start, 1=stop, 2=error, 3=warning
+    // We remap: 1=start, 2=stop, 3=error (0 is reserved for data), and
+    // warnings past the types that followed
+    event.type = eventType == 3 ? kEventWarning : static_cast<uint32_t>(eventType + 1);
     if (message) {
         event.message = message;
     }
-    self->QueueEvent(std::move(event));
+
+    // Stop is reported after the capture thread has finished, so emitting the
+    // encoder's tail from here doesn't race the single ring producer. A
+    // commit with no chunk after it still delivers its history, through the
+    // detector, encoder and file sink, before they finish.
+    double sinceMs = self->preRollCommitMs_.load(std::memory_order_acquire);
+    if (event.type == kEventStop && self->preRoll_ && !self->preRollLive_ && sinceMs >= 0) {
+        self->preRoll_->Flush(self->preRoll_->FramesFor(sinceMs), &AudioRecorderWrapper::OnPreRollChunk, self);
+        self->preRollLive_ = true;
+    }
+    if (event.type == kEventStop && self->meter_) {
+        self->meter_->Finish(&AudioRecorderWrapper::OnLevel, self);
+    }
+    if (event.type == kEventStop && self->vad_) {
+        self->vad_->Finish(&AudioRecorderWrapper::OnSpeech, self);
+    }
+    if (event.type == kEventStop && self->encoder_) {
+        self->encoder_->Flush(&AudioRecorderWrapper::OnEncodedPacket, self);
+    }
+
+    // The file is complete before stop is reported. A write that failed
+    // cost the file, not the recording, which stops as asked anyway.
+    std::string sinkError;
+    if (event.type == kEventStop && self->fileSink_ && !self->fileSink_->Close(&sinkError)) {
+        AudioEvent failure;
+        failure.type = kEventWarning;
+        failure.message = sinkError;
+        self->QueueControlEvent(std::move(failure));
+    }
+
+    // Readers learn of the start and stop from the ring itself
+    if (self->sharedRing_.Attached() && (event.type == kEventStart || event.type == kEventStop)) {
+        self->sharedRing_.SetState(event.type == kEventStart ? SharedRingWriter::kCapturing
+                                                             : SharedRingWriter::kStopped);
+        self->NotifySharedRing();
+    }
+
+    self->QueueControlEvent(std::move(event));
 }
 
 void AudioRecorderWrapper::OnMetadata(double sampleRate, uint32_t channelsPerFrame,
@@ -418,28 +2237,228 @@ void AudioRecorderWrapper::OnMetadata(double sampleRate, uint32_t channelsPerFra
     if (self->isDestroyed_) return;
 
     AudioEvent event;
-    event.type = 4;
+    event.type = kEventMetadata;
     event.sampleRate = sampleRate;
     event.channelsPerFrame = channelsPerFrame;
     event.bitsPerChannel = bitsPerChannel;
     event.isFloat = isFloat;
     event.encoding = encoding ? encoding : "";
-    self->QueueEvent(std::move(event));
+
+    double chunkMs = self->chunkDurationMs_ > 0 ? self->chunkDurationMs_ : 100;
+    size_t frames = static_cast<size_t>(std::ceil(sampleRate * chunkMs / 1000.0));
+    frames += frames / 8;  // Headroom for converter rounding
+    uint32_t slabBits = bitsPerChannel;
+    std::string encoderError;
+
+    // Metadata always precedes the first chunk, so set up the meter, features,
+    // pre-roll, detector and encoder here; all but the encoder see the capture
+    // format
+    if (self->meterEnabled_) {
+        PcmFormat input;
+        input.sampleRate = sampleRate;
+        input.channels = channelsPerFrame;
+        input.bitsPerChannel = bitsPerChannel;
+        input.isFloat = isFloat;
+        self->meter_.reset();
+        if (LevelMeter::Supports(input)) {
+            self->meter_ = std::make_unique<LevelMeter>(self->meterOptions_, input);
+            self->levelRecord_.assign(
+                sizeof(LevelRecord) + (2 * channelsPerFrame + LevelMeter::kBands) * sizeof(float), 0);
+        }
+    }
+    bool featuresFailed = false;
+    if (self->featuresEnabled_) {
+        PcmFormat input;
+        input.sampleRate = sampleRate;
+        input.channels = channelsPerFrame;
+        input.bitsPerChannel = bitsPerChannel;
+        input.isFloat = isFloat;
+        self->features_.reset();
+        if (FeatureExtractor::Supports(self->featureOptions_, input)) {
+            self->features_ = std::make_unique<FeatureExtractor>(self->featureOptions_, input, frames);
+            self->featureRecord_.assign(
+                sizeof(FeatureRecord) + self->features_->MaxBlockFrames() * self->features_->Bins() * sizeof(float),
+                0);
+        } else {
+            featuresFailed = true;
+        }
+    }
+    if (self->preRollEnabled_) {
+        PcmFormat input;
+        input.sampleRate = sampleRate;
+        input.channels = channelsPerFrame;
+        input.bitsPerChannel = bitsPerChannel;
+        input.isFloat = isFloat;
+        self->preRoll_.reset();
+        if (PreRollBuffer::Supports(input)) {
+            self->preRoll_ = std::make_unique<PreRollBuffer>(self->preRollOptions_, input, frames);
+        }
+    }
+    if (self->vadEnabled_) {
+        PcmFormat input;
+        input.sampleRate = sampleRate;
+        input.channels = channelsPerFrame;
+        input.bitsPerChannel = bitsPerChannel;
+        input.isFloat = isFloat;
+        self->vad_.reset();
+        if (VoiceActivityGate::Supports(input)) {
+            self->vad_ = std::make_unique<VoiceActivityGate>(self->vadOptions_, input);
+        }
+    }
+
+    // Report the encoder's output format instead of the capture format. A
+    // stream the encoder can't take is delivered as captured instead, so the
+    // session never runs on with nothing to show for it.
+    if (self->encoding_ != AudioEncoding::Native) {
+        PcmFormat input;
+        input.sampleRate = sampleRate;
+        input.channels = channelsPerFrame;
+        input.bitsPerChannel = bitsPerChannel;
+        input.isFloat = isFloat;
+
+        AudioEncoderOptions encoderOptions;
+        encoderOptions.bitrate = self->encoderBitrate_;
+        encoderOptions.maxChunkFrames = frames;
+
+        self->encoder_ = CreateAudioEncoder(self->encoding_, input, encoderOptions, &encoderError);
+        if (self->encoder_) {
+            event.bitsPerChannel = self->encoder_->BitsPerChannel();
+            event.isFloat = self->encoder_->IsFloat();
+            event.encoding = self->encoder_->Name();
+            slabBits = std::max(slabBits, event.bitsPerChannel);
+        }
+    }
+
+    // Size the zero-copy pool for the larger of the capture and output formats
+    if (self->zeroCopy_) {
+        size_t slabBytes = frames * channelsPerFrame * (slabBits / 8);
+
+        ChunkPool* current = self->activePool_.load(std::memory_order_acquire);
+        if (!current || current->SlabBytes() < slabBytes) {
+            std::shared_ptr<ChunkPool> pool = ChunkPool::Create(slabBytes, ChunkPoolSlabCountFor(chunkMs));
+            if (pool) {
+                self->chunkPools_.push_back(pool);
+                self->activePool_.store(pool.get(), std::memory_order_release);
+            }
+        }
+    }
+
+    // The file takes the output format, as JS would see it, unless that is
+    // PCM the encoder fell back to and the container can't hold
+    bool encoderFellBack = !encoderError.empty();
+    bool fileTakesOutput = !encoderFellBack || FileSink::Accepts(self->fileSinkOptions_.container,
+                                                                 AudioEncoding::Native);
+    bool formatChanged = false;
+    if (self->fileSink_ && fileTakesOutput) {
+        FileSinkFormat format;
+        format.sampleRate = event.sampleRate;
+        format.channels = event.channelsPerFrame;
+        format.bitsPerChannel = event.bitsPerChannel;
+        format.isFloat = event.isFloat;
+        formatChanged = !self->fileSink_->Begin(format);
+    }
+
+    // The ring, like the file, takes the output format
+    if (self->sharedRing_.Attached()) {
+        PcmFormat format;
+        format.sampleRate = event.sampleRate;
+        format.channels = event.channelsPerFrame;
+        format.bitsPerChannel = event.bitsPerChannel;
+        format.isFloat = event.isFloat;
+        self->sharedRing_.Begin(format);
+    }
+
+    self->QueueControlEvent(std::move(event));
+
+    if (formatChanged) {
+        AudioEvent failure;
+        failure.type = kEventWarning;
+        failure.message = "The stream format changed; the file ends where it did";
+        self->QueueControlEvent(std::move(failure));
+    }
+
+    if (encoderFellBack) {
+        AudioEvent warning;
+        warning.type = kEventWarning;
+        warning.message = "Cannot encode this stream (" + encoderError + "); delivering it as captured";
+        if (self->fileSink_ && !fileTakesOutput) {
+            warning.message += ", and the file gets no audio";
+        }
+        self->QueueControlEvent(std::move(warning));
+    }
+
+    // The format is only known now, so this can't fail the start; the
+    // recording goes on without features
+    if (featuresFailed) {
+        AudioEvent warning;
+        warning.type = kEventWarning;
+        warning.message = "The feature options don't fit this stream's format; no features are produced";
+        self->QueueControlEvent(std::move(warning));
+    }
 }
 
-void AudioRecorderWrapper::QueueEvent(AudioEvent event) {
-    std::lock_guard<std::mutex> lock(eventMutex_);
-    eventQueue_.push(std::move(event));
+// Called on the capture thread only. Never locks or allocates; what happens
+// when the ring is full depends on overflowPolicy_.
+bool AudioRecorderWrapper::WriteRecord(uint32_t type, const ChunkRecordHeader& header, const void* payload,
+                                       size_t size) {
+    size_t recordSize = sizeof(header) + size;
+    if (recordSize > ring_->MaxPayload()) {
+        overflowCount_++;
+        return false;
+    }
+
+    uint64_t seq = nextSeq_.fetch_add(1);
+
+    uint8_t* dest;
+    while ((dest = ring_->BeginWrite(recordSize)) == nullptr) {
+        switch (overflowPolicy_) {
+            case OverflowPolicy::DropNewest:
+                overflowCount_++;
+                return false;
+
+            case OverflowPolicy::DropOldest: {
+                SpscRing::Record dropped;
+                if (!ring_->DropOldest(&dropped)) {
+                    overflowCount_++;
+                    return false;
+                }
+                ReleaseRecord(dropped);
+                overflowCount_++;
+                break;
+            }
+
+            case OverflowPolicy::Block:
+                if (stopping_ || isDestroyed_) {
+                    overflowCount_++;
+                    return false;
+                }
+                std::this_thread::yield();
+                break;
+        }
+    }
+
+    memcpy(dest, &header, sizeof(header));
+    if (size > 0) {
+        memcpy(dest + sizeof(header), payload, size);
+    }
+    ring_->CommitWrite(type, static_cast<uint32_t>(recordSize), seq);
+
+    size_t used = ring_->Used();
+    if (used > queueHighWater_.load(std::memory_order_relaxed)) {
+        queueHighWater_.store(used, std::memory_order_relaxed);
+    }
+
+    NotifyEventCallback();
+    return true;
 }
 
-std::vector<AudioEvent> AudioRecorderWrapper::DrainEvents() {
-    std::lock_guard<std::mutex> lock(eventMutex_);
-    std::vector<AudioEvent> events;
-    while (!eventQueue_.empty()) {
-        events.push_back(std::move(eventQueue_.front()));
-        eventQueue_.pop();
+void AudioRecorderWrapper::QueueControlEvent(AudioEvent event) {
+    {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        event.seq = nextSeq_.fetch_add(1);
+        controlQueue_.push_back(std::move(event));
     }
-    return events;
+    NotifyEventCallback();
 }
 
 // ============================================================================
@@ -452,6 +2471,9 @@ struct MicActivityEvent {
     std::string deviceId;
     std::string deviceName;
     std::string message;
+    int32_t pid;
+    std::string processName;
+    std::string bundleId;
 };
 
 class MicActivityMonitorWrapper : public Napi::ObjectWrap<MicActivityMonitorWrapper> {
@@ -461,8 +2483,6 @@ public:
     ~MicActivityMonitorWrapper();
 
 private:
-    static Napi::FunctionReference constructor;
-
     Napi::Value Start(const Napi::CallbackInfo& info);
     Napi::Value Stop(const Napi::CallbackInfo& info);
     Napi::Value IsActive(const Napi::CallbackInfo& info);
@@ -473,6 +2493,7 @@ private:
     static void OnChange(bool isActive, void* context);
     static void OnDeviceChange(const char* deviceId, const char* deviceName, bool isActive, void* context);
     static void OnError(const char* message, void* context);
+    static void OnProcessChange(int32_t pid, const char* name, const char* bundleId, bool isActive, void* context);
 
     void QueueEvent(MicActivityEvent event);
     std::vector<MicActivityEvent> DrainEvents();
@@ -483,8 +2504,6 @@ private:
     std::atomic<bool> isDestroyed_{false};
 };
 
-Napi::FunctionReference MicActivityMonitorWrapper::constructor;
-
 Napi::Object MicActivityMonitorWrapper::Init(Napi::Env env, Napi::Object exports) {
     Napi::HandleScope scope(env);
 
@@ -497,9 +2516,6 @@ Napi::Object MicActivityMonitorWrapper::Init(Napi::Env env, Napi::Object exports
         InstanceMethod("processEvents", &MicActivityMonitorWrapper::ProcessEvents),
     });
 
-    constructor = Napi::Persistent(func);
-    constructor.SuppressDestruct();
-
     exports.Set("MicActivityMonitorNative", func);
     return exports;
 }
@@ -514,6 +2530,7 @@ MicActivityMonitorWrapper::MicActivityMonitorWrapper(const Napi::CallbackInfo& i
         &MicActivityMonitorWrapper::OnChange,
         &MicActivityMonitorWrapper::OnDeviceChange,
         &MicActivityMonitorWrapper::OnError,
+        &MicActivityMonitorWrapper::OnProcessChange,
         this
     );
     DebugLog("MicActivityMonitorWrapper: mic_activity_create returned handle=%p", handle_);
@@ -638,6 +2655,16 @@ Napi::Value MicActivityMonitorWrapper::ProcessEvents(const Napi::CallbackInfo& i
             case 2:
                 obj.Set("message", Napi::String::New(env, event.message));
                 break;
+
+            case 3: {
+                Napi::Object process = Napi::Object::New(env);
+                process.Set("pid", Napi::Number::New(env, event.pid));
+                process.Set("name", Napi::String::New(env, event.processName));
+                process.Set("bundleId", Napi::String::New(env, event.bundleId));
+                obj.Set("process", process);
+                obj.Set("isActive", Napi::Boolean::New(env, event.isActive));
+                break;
+            }
         }
 
         result.Set(i, obj);
@@ -678,6 +2705,20 @@ void MicActivityMonitorWrapper::OnError(const char* message, void* context) {
     self->QueueEvent(std::move(event));
 }
 
+void MicActivityMonitorWrapper::OnProcessChange(int32_t pid, const char* name, const char* bundleId, bool isActive,
+                                                void* context) {
+    MicActivityMonitorWrapper* self = static_cast<MicActivityMonitorWrapper*>(context);
+    if (self->isDestroyed_) return;
+
+    MicActivityEvent event;
+    event.type = 3;
+    event.pid = pid;
+    event.processName = name ? name : "";
+    event.bundleId = bundleId ? bundleId : "";
+    event.isActive = isActive;
+    self->QueueEvent(std::move(event));
+}
+
 void MicActivityMonitorWrapper::QueueEvent(MicActivityEvent event) {
     std::lock_guard<std::mutex> lock(eventMutex_);
     eventQueue_.push(std::move(event));
@@ -697,6 +2738,44 @@ std::vector<MicActivityEvent> MicActivityMonitorWrapper::DrainEvents() {
 // Device Enumeration
 // ============================================================================
 
+// Owned copy of an AudioDeviceInfo, for events that outlive the callback
+struct DeviceRecord {
+    std::string uid;
+    std::string name;
+    std::string manufacturer;
+    bool isDefault = false;
+    bool isInput = false;
+    bool isOutput = false;
+    double sampleRate = 0;
+    uint32_t channelCount = 0;
+
+    static DeviceRecord From(const AudioDeviceInfo& device) {
+        DeviceRecord record;
+        record.uid = device.uid ? device.uid : "";
+        record.name = device.name ? device.name : "";
+        record.manufacturer = device.manufacturer ? device.manufacturer : "";
+        record.isDefault = device.isDefault;
+        record.isInput = device.isInput;
+        record.isOutput = device.isOutput;
+        record.sampleRate = device.sampleRate;
+        record.channelCount = device.channelCount;
+        return record;
+    }
+
+    Napi::Object ToObject(Napi::Env env) const {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("id", Napi::String::New(env, uid));
+        obj.Set("name", Napi::String::New(env, name));
+        obj.Set("manufacturer", Napi::String::New(env, manufacturer));
+        obj.Set("isDefault", Napi::Boolean::New(env, isDefault));
+        obj.Set("isInput", Napi::Boolean::New(env, isInput));
+        obj.Set("isOutput", Napi::Boolean::New(env, isOutput));
+        obj.Set("sampleRate", Napi::Number::New(env, sampleRate));
+        obj.Set("channelCount", Napi::Number::New(env, channelCount));
+        return obj;
+    }
+};
+
 Napi::Value ListDevices(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
@@ -710,18 +2789,7 @@ Napi::Value ListDevices(const Napi::CallbackInfo& info) {
 
     Napi::Array arr = Napi::Array::New(env, count);
     for (int32_t i = 0; i < count; i++) {
-        const AudioDeviceInfo& device = deviceList[i];
-
-        Napi::Object obj = Napi::Object::New(env);
-        obj.Set("id", Napi::String::New(env, device.uid ? device.uid : ""));
-        obj.Set("name", Napi::String::New(env, device.name ? device.name : ""));
-        obj.Set("manufacturer", Napi::String::New(env, device.manufacturer ? device.manufacturer : ""));
-        obj.Set("isDefault", Napi::Boolean::New(env, device.isDefault));
-        obj.Set("isInput", Napi::Boolean::New(env, device.isInput));
-        obj.Set("isOutput", Napi::Boolean::New(env, device.isOutput));
-        obj.Set("sampleRate", Napi::Number::New(env, device.sampleRate));
-        obj.Set("channelCount", Napi::Number::New(env, device.channelCount));
-        arr.Set(i, obj);
+        arr.Set(i, DeviceRecord::From(deviceList[i]).ToObject(env));
     }
 
     audio_free_device_list(deviceList, count);
@@ -754,6 +2822,177 @@ Napi::Value GetDefaultOutputDevice(const Napi::CallbackInfo& info) {
     return result;
 }
 
+// ============================================================================
+// Device Watcher
+// ============================================================================
+
+struct DeviceChangeEvent {
+    int32_t type;               // 0 = added, 1 = removed, 2 = default changed
+    bool isInput;
+    bool hasDevice;
+    DeviceRecord device;
+};
+
+// Device changes are rare and come from the platform's notification thread,
+// which isn't real-time, so unlike recorder events they don't need a
+// LoopWake: the registry thread queues them and wakes the event loop through
+// a ThreadSafeFunction, which delivers everything queued so far as one batch.
+// The function is unref'd, so watching alone doesn't keep the process alive.
+class DeviceWatcherWrapper : public Napi::ObjectWrap<DeviceWatcherWrapper> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    DeviceWatcherWrapper(const Napi::CallbackInfo& info);
+    ~DeviceWatcherWrapper();
+
+private:
+    Napi::Value Start(const Napi::CallbackInfo& info);
+    Napi::Value Stop(const Napi::CallbackInfo& info);
+    Napi::Value IsActive(const Napi::CallbackInfo& info);
+
+    static void OnChange(int32_t eventType, const AudioDeviceInfo* device, bool isInput, void* context);
+    void Deliver(Napi::Env env, Napi::Function callback);
+    void StopWatching();
+
+    AudioDeviceWatcherHandle handle_ = nullptr;
+    Napi::ThreadSafeFunction tsfn_;
+    std::mutex eventMutex_;
+    std::vector<DeviceChangeEvent> events_;
+    std::atomic<bool> deliveryPending_{false};
+};
+
+Napi::Object DeviceWatcherWrapper::Init(Napi::Env env, Napi::Object exports) {
+    Napi::HandleScope scope(env);
+
+    Napi::Function func = DefineClass(env, "DeviceWatcherNative", {
+        InstanceMethod("start", &DeviceWatcherWrapper::Start),
+        InstanceMethod("stop", &DeviceWatcherWrapper::Stop),
+        InstanceMethod("isActive", &DeviceWatcherWrapper::IsActive),
+    });
+
+    exports.Set("DeviceWatcherNative", func);
+    return exports;
+}
+
+DeviceWatcherWrapper::DeviceWatcherWrapper(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<DeviceWatcherWrapper>(info) {}
+
+DeviceWatcherWrapper::~DeviceWatcherWrapper() {
+    StopWatching();
+}
+
+Napi::Value DeviceWatcherWrapper::Start(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Callback function expected").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (handle_) {
+        return env.Undefined();
+    }
+
+    tsfn_ = Napi::ThreadSafeFunction::New(
+        env,
+        info[0].As<Napi::Function>(),
+        "DeviceWatcherEvents",
+        0,
+        1,
+        this,
+        [](Napi::Env, DeviceWatcherWrapper* self) {
+            self->Unref();
+        }
+    );
+    tsfn_.Unref(env);
+
+    // Keep the JS object alive while the TSFN can still call into it
+    Ref();
+
+    deliveryPending_ = false;
+    handle_ = audio_device_watcher_create(&DeviceWatcherWrapper::OnChange, this);
+    if (!handle_) {
+        tsfn_.Release();
+        Napi::Error::New(env, "Failed to start device watcher").ThrowAsJavaScriptException();
+    }
+
+    return env.Undefined();
+}
+
+Napi::Value DeviceWatcherWrapper::Stop(const Napi::CallbackInfo& info) {
+    StopWatching();
+    return info.Env().Undefined();
+}
+
+Napi::Value DeviceWatcherWrapper::IsActive(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), handle_ != nullptr);
+}
+
+void DeviceWatcherWrapper::StopWatching() {
+    if (!handle_) return;
+
+    // No callback runs once destroy returns, so nothing can use the TSFN
+    // after its release
+    audio_device_watcher_destroy(handle_);
+    handle_ = nullptr;
+    tsfn_.Release();
+
+    std::lock_guard<std::mutex> lock(eventMutex_);
+    events_.clear();
+}
+
+void DeviceWatcherWrapper::OnChange(int32_t eventType, const AudioDeviceInfo* device, bool isInput,
+                                    void* context) {
+    DeviceWatcherWrapper* self = static_cast<DeviceWatcherWrapper*>(context);
+
+    DeviceChangeEvent event;
+    event.type = eventType;
+    event.isInput = isInput;
+    event.hasDevice = device != nullptr;
+    if (device) {
+        event.device = DeviceRecord::From(*device);
+    }
+    {
+        std::lock_guard<std::mutex> lock(self->eventMutex_);
+        self->events_.push_back(std::move(event));
+    }
+
+    // Coalesce: a pending delivery picks this event up too
+    if (self->deliveryPending_.exchange(true)) return;
+    napi_status status = self->tsfn_.NonBlockingCall([self](Napi::Env env, Napi::Function callback) {
+        self->Deliver(env, callback);
+    });
+    if (status != napi_ok) {
+        self->deliveryPending_ = false;
+    }
+}
+
+void DeviceWatcherWrapper::Deliver(Napi::Env env, Napi::Function callback) {
+    deliveryPending_ = false;
+
+    // env/callback are empty when the TSFN is being torn down
+    if (env == nullptr || callback.IsEmpty()) return;
+
+    std::vector<DeviceChangeEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        events.swap(events_);
+    }
+    if (events.empty()) return;
+
+    Napi::Array result = Napi::Array::New(env, events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        const DeviceChangeEvent& event = events[i];
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("type", Napi::Number::New(env, event.type));
+        obj.Set("isInput", Napi::Boolean::New(env, event.isInput));
+        if (event.hasDevice) {
+            obj.Set("device", event.device.ToObject(env));
+        }
+        result.Set(i, obj);
+    }
+
+    callback.Call({result});
+}
+
 // ============================================================================
 // System Audio Permission API
 // ============================================================================
@@ -888,6 +3127,8 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     MicActivityMonitorWrapper::Init(env, exports);
     DebugLog("Init: MicActivityMonitorWrapper initialized");
 
+    DeviceWatcherWrapper::Init(env, exports);
+
     // Device enumeration
     exports.Set("listDevices", Napi::Function::New(env, ListDevices));
     exports.Set("getDefaultInputDevice", Napi::Function::New(env, GetDefaultInputDevice));
@@ -907,4 +3148,6 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     return exports;
 }
 
+// Init runs once per environment that loads the addon, the main thread and
+// each worker alike; nothing in this file keeps JS handles across them
 NODE_API_MODULE(native_audio, Init)
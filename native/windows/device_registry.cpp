@@ -0,0 +1,297 @@
+// Defines PKEY_AudioEngine_DeviceFormat here rather than expecting a library
+// to; the definitions are selectany, so other translation units don't clash
+#include <initguid.h>
+
+#include "device_registry.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "wasapi_capture.h"
+
+// ============================================================================
+// NotificationClient - forwards endpoint notifications as "list is stale"
+// ============================================================================
+
+class DeviceRegistry::NotificationClient : public IMMNotificationClient {
+public:
+    explicit NotificationClient(DeviceRegistry* registry) : refCount_(1), registry_(registry) {}
+
+    // IUnknown
+    ULONG STDMETHODCALLTYPE AddRef() override {
+        return InterlockedIncrement(&refCount_);
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG ref = InterlockedDecrement(&refCount_);
+        if (ref == 0) {
+            delete this;
+        }
+        return ref;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppv) override {
+        if (riid == IID_IUnknown || riid == __uuidof(IMMNotificationClient)) {
+            *ppv = static_cast<IMMNotificationClient*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    // IMMNotificationClient. These run on a system thread that must not
+    // block, so they only flag the list for the worker.
+    HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR, DWORD) override {
+        registry_->MarkStale();
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR) override {
+        registry_->MarkStale();
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR) override {
+        registry_->MarkStale();
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow, ERole role, LPCWSTR) override {
+        // Defaults are reported for the console role, like GetDefaultAudioEndpoint
+        if (role == eConsole) {
+            registry_->MarkStale();
+        }
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR, const PROPERTYKEY key) override {
+        if (SameKey(key, PKEY_Device_FriendlyName) || SameKey(key, PKEY_AudioEngine_DeviceFormat)) {
+            registry_->MarkStale();
+        }
+        return S_OK;
+    }
+
+private:
+    static bool SameKey(const PROPERTYKEY& a, const PROPERTYKEY& b) {
+        return a.pid == b.pid && IsEqualGUID(a.fmtid, b.fmtid);
+    }
+
+    LONG refCount_;
+    DeviceRegistry* registry_;
+};
+
+// ============================================================================
+// DeviceRegistry
+// ============================================================================
+
+DeviceRegistry& DeviceRegistry::Instance() {
+    // Never destroyed: the worker and the notification registration last as
+    // long as the process
+    static DeviceRegistry* instance = new DeviceRegistry();
+    instance->EnsureStarted();
+    return *instance;
+}
+
+void DeviceRegistry::EnsureStarted() {
+    std::call_once(started_, [this]() {
+        HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+                                      __uuidof(IMMDeviceEnumerator), (void**)&enumerator_);
+        if (SUCCEEDED(hr)) {
+            client_ = new NotificationClient(this);
+            if (FAILED(enumerator_->RegisterEndpointNotificationCallback(client_))) {
+                // Without notifications every lookup has to enumerate
+                client_->Release();
+                client_ = nullptr;
+            }
+        }
+
+        RefreshIfStale();
+        worker_ = std::thread(&DeviceRegistry::WorkerLoop, this);
+    });
+}
+
+void DeviceRegistry::MarkStale() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        stale_ = true;
+    }
+    staleChanged_.notify_one();
+}
+
+std::vector<AudioDeviceInfo> DeviceRegistry::ListDevices() {
+    RefreshIfStale();
+
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    std::vector<AudioDeviceInfo> devices;
+    devices.reserve(devices_.size());
+    for (const Device& device : devices_) {
+        AudioDeviceInfo info = ToDeviceInfo(device);
+        info.uid = _strdup(info.uid);
+        info.name = _strdup(info.name);
+        info.manufacturer = _strdup(info.manufacturer);
+        devices.push_back(info);
+    }
+    return devices;
+}
+
+std::string DeviceRegistry::DefaultDeviceId(bool input) {
+    RefreshIfStale();
+
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    return input ? defaultInput_ : defaultOutput_;
+}
+
+void* DeviceRegistry::AddWatcher(AudioDeviceChangeCallback callback, void* context) {
+    Watcher* watcher = new Watcher{callback, context};
+    std::lock_guard<std::mutex> lock(watcherMutex_);
+    watchers_.push_back(watcher);
+    return watcher;
+}
+
+void DeviceRegistry::RemoveWatcher(void* watcher) {
+    std::lock_guard<std::mutex> lock(watcherMutex_);
+    auto it = std::find(watchers_.begin(), watchers_.end(), static_cast<Watcher*>(watcher));
+    if (it != watchers_.end()) {
+        delete *it;
+        watchers_.erase(it);
+    }
+}
+
+void DeviceRegistry::RefreshIfStale() {
+    std::lock_guard<std::mutex> refresh(refreshMutex_);
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        // Without notifications the list can never be trusted
+        if (!stale_ && client_) return;
+        // Cleared before enumerating: a notification that arrives meanwhile
+        // marks the list stale again
+        stale_ = false;
+    }
+
+    std::string defaultInput;
+    std::string defaultOutput;
+    std::vector<Device> devices = Enumerate(&defaultInput, &defaultOutput);
+
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    if (listed_) {
+        auto contains = [](const std::vector<Device>& list, const Device& device) {
+            return std::any_of(list.begin(), list.end(), [&](const Device& other) {
+                return other.uid == device.uid && other.isInput == device.isInput;
+            });
+        };
+        for (const Device& device : devices_) {
+            if (!contains(devices, device)) {
+                pending_.push_back({kDeviceRemoved, device.isInput, true, device});
+            }
+        }
+        for (const Device& device : devices) {
+            if (!contains(devices_, device)) {
+                pending_.push_back({kDeviceAdded, device.isInput, true, device});
+            }
+        }
+
+        const std::string* previous[] = {&defaultInput_, &defaultOutput_};
+        const std::string* current[] = {&defaultInput, &defaultOutput};
+        for (int i = 0; i < 2; i++) {
+            if (*previous[i] == *current[i]) continue;
+            bool input = i == 0;
+            Change change = {kDefaultChanged, input, false, {}};
+            for (const Device& device : devices) {
+                if (device.isInput == input && device.uid == *current[i]) {
+                    change.hasDevice = true;
+                    change.device = device;
+                }
+            }
+            pending_.push_back(change);
+        }
+    }
+
+    devices_ = std::move(devices);
+    defaultInput_ = std::move(defaultInput);
+    defaultOutput_ = std::move(defaultOutput);
+    listed_ = true;
+
+    // Wake the worker when a lookup found the changes
+    bool report = !pending_.empty();
+    lock.unlock();
+    if (report) {
+        staleChanged_.notify_one();
+    }
+}
+
+void DeviceRegistry::Dispatch(const std::vector<Change>& changes) {
+    std::lock_guard<std::mutex> lock(watcherMutex_);
+    for (const Change& change : changes) {
+        AudioDeviceInfo info = {};
+        if (change.hasDevice) {
+            info = ToDeviceInfo(change.device);
+        }
+        for (Watcher* watcher : watchers_) {
+            watcher->callback(change.type, change.hasDevice ? &info : nullptr, change.isInput, watcher->context);
+        }
+    }
+}
+
+void DeviceRegistry::WorkerLoop() {
+    // Re-enumeration activates endpoints, which needs COM on this thread
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex_);
+            staleChanged_.wait(lock, [this]() { return (stale_ && client_) || !pending_.empty(); });
+        }
+
+        RefreshIfStale();
+
+        std::vector<Change> changes;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            changes.swap(pending_);
+        }
+        Dispatch(changes);
+    }
+}
+
+std::vector<DeviceRegistry::Device> DeviceRegistry::Enumerate(std::string* defaultInput,
+                                                              std::string* defaultOutput) {
+    std::vector<AudioDeviceInfo> infos = AudioDeviceEnumerator::ListAllDevices();
+
+    std::vector<Device> devices;
+    devices.reserve(infos.size());
+    for (AudioDeviceInfo& info : infos) {
+        Device device;
+        device.uid = info.uid ? info.uid : "";
+        device.name = info.name ? info.name : "";
+        device.manufacturer = info.manufacturer ? info.manufacturer : "";
+        device.isDefault = info.isDefault;
+        device.isInput = info.isInput;
+        device.sampleRate = info.sampleRate;
+        device.channelCount = info.channelCount;
+        if (device.isDefault) {
+            *(device.isInput ? defaultInput : defaultOutput) = device.uid;
+        }
+        devices.push_back(std::move(device));
+
+        free(info.uid);
+        free(info.name);
+        free(info.manufacturer);
+    }
+    return devices;
+}
+
+// Borrows the device's strings; valid while the device is
+AudioDeviceInfo DeviceRegistry::ToDeviceInfo(const Device& device) {
+    AudioDeviceInfo info = {};
+    info.uid = const_cast<char*>(device.uid.c_str());
+    info.name = const_cast<char*>(device.name.c_str());
+    info.manufacturer = const_cast<char*>(device.manufacturer.c_str());
+    info.isDefault = device.isDefault;
+    info.isInput = device.isInput;
+    info.isOutput = !device.isInput;
+    info.sampleRate = device.sampleRate;
+    info.channelCount = device.channelCount;
+    return info;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <windows.h>
+#include <mmdeviceapi.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_bridge.h"
+
+// ============================================================================
+// DeviceRegistry - endpoint list kept current by IMMNotificationClient
+//
+// The first lookup enumerates every active endpoint, then registers for
+// endpoint notifications. Notifications only mark the list stale; a worker
+// thread re-enumerates, diffs against the previous list and reports what was
+// added, removed or became the default to every watcher. Lookups made while
+// the list is stale re-enumerate themselves, so they never return a list
+// older than the last notification. The registry lives for the rest of the
+// process.
+// ============================================================================
+
+class DeviceRegistry {
+public:
+    static DeviceRegistry& Instance();
+
+    // Copies of the current list, in the layout of audio_list_devices; the
+    // caller frees them with audio_free_device_list
+    std::vector<AudioDeviceInfo> ListDevices();
+    std::string DefaultDeviceId(bool input);
+
+    // Callbacks run on the registry's worker thread. RemoveWatcher returns
+    // once no callback to that watcher is running.
+    void* AddWatcher(AudioDeviceChangeCallback callback, void* context);
+    void RemoveWatcher(void* watcher);
+
+private:
+    struct Device {
+        std::string uid;
+        std::string name;
+        std::string manufacturer;
+        bool isDefault;
+        bool isInput;
+        double sampleRate;
+        uint32_t channelCount;
+    };
+
+    struct Watcher {
+        AudioDeviceChangeCallback callback;
+        void* context;
+    };
+
+    enum ChangeType : int32_t {
+        kDeviceAdded = 0,
+        kDeviceRemoved = 1,
+        kDefaultChanged = 2,
+    };
+
+    struct Change {
+        int32_t type;
+        bool isInput;
+        bool hasDevice;
+        Device device;
+    };
+
+    class NotificationClient;
+
+    DeviceRegistry() = default;
+
+    void EnsureStarted();
+    void MarkStale();
+    void RefreshIfStale();
+    void Dispatch(const std::vector<Change>& changes);
+    void WorkerLoop();
+
+    static std::vector<Device> Enumerate(std::string* defaultInput, std::string* defaultOutput);
+    static AudioDeviceInfo ToDeviceInfo(const Device& device);
+
+    std::once_flag started_;
+    NotificationClient* client_ = nullptr;
+    IMMDeviceEnumerator* enumerator_ = nullptr;   // Holds the notification registration
+    std::thread worker_;
+
+    // Current list; refreshMutex_ serialises enumeration, stateMutex_ guards
+    // the fields below it
+    std::mutex refreshMutex_;
+    std::mutex stateMutex_;
+    std::condition_variable staleChanged_;
+    bool stale_ = true;
+    bool listed_ = false;               // The first enumeration reports nothing
+    std::vector<Change> pending_;       // Found by a refresh, not yet dispatched
+    std::vector<Device> devices_;
+    std::string defaultInput_;
+    std::string defaultOutput_;
+
+    // Held while callbacks run, so that RemoveWatcher can wait them out
+    std::mutex watcherMutex_;
+    std::vector<Watcher*> watchers_;
+};
@@ -1,7 +1,11 @@
 #include "wasapi_capture.h"
+#include "audio_dsp.h"
 #include <combaseapi.h>
 #include <avrt.h>
+#include <mmreg.h>
+#include <ksmedia.h>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 
 #pragma comment(lib, "ole32.lib")
@@ -27,6 +31,45 @@ static std::string WideToUtf8(const std::wstring& wstr) {
     return result;
 }
 
+// Bits per sample of an integer mix format, or 0 for float. Shared-mode mix
+// formats are float on nearly every device, but not all.
+static uint32_t IntegerSampleBits(const WAVEFORMATEX* format) {
+    if (format->wFormatTag == WAVE_FORMAT_IEEE_FLOAT) return 0;
+    if (format->wFormatTag == WAVE_FORMAT_EXTENSIBLE && format->cbSize >= 22) {
+        auto* extensible = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(format);
+        if (IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)) return 0;
+    }
+    return format->wBitsPerSample;
+}
+
+// Whether the capture thread can convert the format: 32-bit float, or signed
+// integers in 16, packed 24 or 32-bit containers. Exclusive mode hands us the
+// device's format as is, so this is no longer a given.
+static bool ConvertibleFormat(const WAVEFORMATEX* format) {
+    if (format->nChannels == 0 || format->nBlockAlign != format->nChannels * format->wBitsPerSample / 8) {
+        return false;
+    }
+    GUID subFormat = KSDATAFORMAT_SUBTYPE_PCM;
+    if (format->wFormatTag == WAVE_FORMAT_IEEE_FLOAT) {
+        subFormat = KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+    } else if (format->wFormatTag == WAVE_FORMAT_EXTENSIBLE && format->cbSize >= 22) {
+        subFormat = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(format)->SubFormat;
+    } else if (format->wFormatTag != WAVE_FORMAT_PCM) {
+        return false;
+    }
+    if (IsEqualGUID(subFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)) return format->wBitsPerSample == 32;
+    if (!IsEqualGUID(subFormat, KSDATAFORMAT_SUBTYPE_PCM)) return false;
+    return format->wBitsPerSample == 16 || format->wBitsPerSample == 24 || format->wBitsPerSample == 32;
+}
+
+// A copy of the format for CoTaskMemFree, as GetMixFormat would return it
+static WAVEFORMATEX* CopyFormat(const WAVEFORMATEX* format) {
+    size_t size = sizeof(WAVEFORMATEX) + format->cbSize;
+    auto* copy = static_cast<WAVEFORMATEX*>(CoTaskMemAlloc(size));
+    if (copy) memcpy(copy, format, size);
+    return copy;
+}
+
 // ============================================================================
 // ActivationCompletionHandler Implementation
 // ============================================================================
@@ -99,15 +142,27 @@ WasapiCapture::WasapiCapture(
     mixFormat_(nullptr),
     running_(false),
     stopEvent_(nullptr),
+    bufferEvent_(nullptr),
+    bufferDurationMs_(0),
+    latencyMode_(LatencyMode::Default),
     targetSampleRate_(0),
     chunkDurationMs_(200),
     isMono_(true),
     gain_(1.0),
     emitSilence_(true),
     samplesPerChunk_(0),
-    resampleRatio_(1.0) {
+    pushedFrames_(0),
+    maxPacketFrames_(0),
+    sampleBits_(0),
+    resamplerQuality_(ResamplerQuality::Balanced),
+    outputChannels_(1),
+    mixBlockFrames_(0),
+    mixLatencyFrames_(0) {
 
     stopEvent_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+    // Auto-reset: signalled by the audio engine each time a buffer is ready
+    bufferEvent_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
 }
 
 WasapiCapture::~WasapiCapture() {
@@ -116,22 +171,100 @@ WasapiCapture::~WasapiCapture() {
     if (stopEvent_) {
         CloseHandle(stopEvent_);
     }
+    if (bufferEvent_) {
+        CloseHandle(bufferEvent_);
+    }
+    ReleaseAudioClient();
+}
+
+int32_t WasapiCapture::SetBufferDuration(double bufferDurationMs) {
+    if (running_) return -2;
+    bufferDurationMs_ = bufferDurationMs > 0 ? bufferDurationMs : 0;
+    return 0;
+}
+
+int32_t WasapiCapture::SetResamplerQuality(ResamplerQuality quality) {
+    if (running_) return -2;
+    resamplerQuality_ = quality;
+    return 0;
+}
+
+int32_t WasapiCapture::SetLatencyMode(LatencyMode mode) {
+    if (running_) return -2;
+    latencyMode_ = mode;
+    return 0;
+}
+
+int32_t WasapiCapture::SetChannelMap(const float* matrix, uint32_t outputChannels, uint32_t inputChannels) {
+    if (running_) return -2;
+    return channelMap_.Assign(matrix, outputChannels, inputChannels) ? 0 : -3;
+}
+
+WasapiCapture::MixSource::~MixSource() {
+    if (mixFormat) {
+        CoTaskMemFree(mixFormat);
+    }
+    if (captureClient) {
+        captureClient->Release();
+    }
+    if (audioClient) {
+        audioClient->Release();
+    }
+    if (bufferEvent) {
+        CloseHandle(bufferEvent);
+    }
+}
+
+void WasapiCapture::ReleaseAudioClient() {
+    mixSources_.clear();
     if (mixFormat_) {
         CoTaskMemFree(mixFormat_);
+        mixFormat_ = nullptr;
     }
     if (captureClient_) {
         captureClient_->Release();
+        captureClient_ = nullptr;
     }
     if (audioClient_) {
         audioClient_->Release();
+        audioClient_ = nullptr;
     }
 }
 
+HRESULT WasapiCapture::InitializeAudioClient(IAudioClient* client, const WAVEFORMATEX* format, HANDLE event,
+                                             DWORD streamFlags, IAudioCaptureClient** captureClient) {
+    // Event-driven capture: the engine signals the event whenever a period's
+    // worth of data is ready, so the capture thread never polls. In shared mode
+    // the periodicity must be 0; the engine uses its own device period.
+    REFERENCE_TIME bufferDuration = bufferDurationMs_ > 0
+        ? static_cast<REFERENCE_TIME>(bufferDurationMs_ * 10000.0)  // ms -> 100ns units
+        : kDefaultBufferDuration;
+
+    HRESULT hr = client->Initialize(
+        AUDCLNT_SHAREMODE_SHARED,
+        streamFlags | AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+        bufferDuration,
+        0,
+        format,
+        nullptr
+    );
+    if (FAILED(hr)) return hr;
+
+    hr = client->SetEventHandle(event);
+    if (FAILED(hr)) return hr;
+
+    // Get capture client
+    return client->GetService(__uuidof(IAudioCaptureClient), (void**)captureClient);
+}
+
 HRESULT WasapiCapture::InitializeSystemLoopback() {
     IMMDeviceEnumerator* enumerator = nullptr;
     IMMDevice* device = nullptr;
     HRESULT hr;
 
+    // Drop the client from a previous session
+    ReleaseAudioClient();
+
     hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
                           __uuidof(IMMDeviceEnumerator), (void**)&enumerator);
     if (FAILED(hr)) return hr;
@@ -151,23 +284,58 @@ HRESULT WasapiCapture::InitializeSystemLoopback() {
     if (FAILED(hr)) return hr;
 
     // Initialize with loopback flag
-    hr = audioClient_->Initialize(
-        AUDCLNT_SHAREMODE_SHARED,
-        AUDCLNT_STREAMFLAGS_LOOPBACK,
-        10000000,  // 1 second buffer (100ns units)
-        0,
-        mixFormat_,
-        nullptr
-    );
+    return InitializeAudioClient(audioClient_, mixFormat_, bufferEvent_, AUDCLNT_STREAMFLAGS_LOOPBACK,
+                                 &captureClient_);
+}
+
+HRESULT WasapiCapture::InitializeProcessLoopback(DWORD targetPid, PROCESS_LOOPBACK_MODE mode) {
+    // Drop the client from a previous session
+    ReleaseAudioClient();
+
+    HRESULT hr = ActivateProcessLoopback(targetPid, mode, &audioClient_);
     if (FAILED(hr)) return hr;
 
-    // Get capture client
-    hr = audioClient_->GetService(__uuidof(IAudioCaptureClient), (void**)&captureClient_);
+    // Get the mix format
+    hr = audioClient_->GetMixFormat(&mixFormat_);
+    if (FAILED(hr)) return hr;
 
-    return hr;
+    // Initialize the audio client
+    return InitializeAudioClient(audioClient_, mixFormat_, bufferEvent_, 0,  // No additional flags needed
+                                 &captureClient_);
 }
 
-HRESULT WasapiCapture::InitializeProcessLoopback(DWORD targetPid, PROCESS_LOOPBACK_MODE mode) {
+HRESULT WasapiCapture::InitializeProcessMix(const int32_t* pids, int32_t count) {
+    // Drop the client from a previous session
+    ReleaseAudioClient();
+
+    // Process loopback takes a single target per client, so each PID gets its
+    // own client and event; the capture thread mixes them
+    for (int32_t i = 0; i < count; i++) {
+        auto source = std::make_unique<MixSource>();
+
+        // Auto-reset, like bufferEvent_
+        source->bufferEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        if (!source->bufferEvent) return HRESULT_FROM_WIN32(GetLastError());
+
+        HRESULT hr = ActivateProcessLoopback(static_cast<DWORD>(pids[i]),
+                                             PROCESS_LOOPBACK_MODE_INCLUDE_TARGET_PROCESS_TREE,
+                                             &source->audioClient);
+        if (FAILED(hr)) return hr;
+
+        hr = source->audioClient->GetMixFormat(&source->mixFormat);
+        if (FAILED(hr)) return hr;
+
+        hr = InitializeAudioClient(source->audioClient, source->mixFormat, source->bufferEvent, 0,
+                                   &source->captureClient);
+        if (FAILED(hr)) return hr;
+
+        mixSources_.push_back(std::move(source));
+    }
+    return S_OK;
+}
+
+HRESULT WasapiCapture::ActivateProcessLoopback(DWORD targetPid, PROCESS_LOOPBACK_MODE mode,
+                                               IAudioClient** client) {
     // Set up process-specific loopback parameters
     AUDIOCLIENT_ACTIVATION_PARAMS activationParams = {};
     activationParams.ActivationType = AUDIOCLIENT_ACTIVATION_TYPE_PROCESS_LOOPBACK;
@@ -220,31 +388,8 @@ HRESULT WasapiCapture::InitializeProcessLoopback(DWORD targetPid, PROCESS_LOOPBA
     }
 
     // Get IAudioClient from the activated interface
-    hr = activatedInterface->QueryInterface(__uuidof(IAudioClient), (void**)&audioClient_);
+    hr = activatedInterface->QueryInterface(__uuidof(IAudioClient), (void**)client);
     activatedInterface->Release();
-
-    if (FAILED(hr)) {
-        return hr;
-    }
-
-    // Get the mix format
-    hr = audioClient_->GetMixFormat(&mixFormat_);
-    if (FAILED(hr)) return hr;
-
-    // Initialize the audio client
-    hr = audioClient_->Initialize(
-        AUDCLNT_SHAREMODE_SHARED,
-        0,  // No additional flags needed for process loopback
-        10000000,  // 1 second buffer
-        0,
-        mixFormat_,
-        nullptr
-    );
-    if (FAILED(hr)) return hr;
-
-    // Get capture client
-    hr = audioClient_->GetService(__uuidof(IAudioCaptureClient), (void**)&captureClient_);
-
     return hr;
 }
 
@@ -253,6 +398,9 @@ HRESULT WasapiCapture::InitializeMicrophone(const wchar_t* deviceId) {
     IMMDevice* device = nullptr;
     HRESULT hr;
 
+    // Drop the client from a previous session
+    ReleaseAudioClient();
+
     hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
                           __uuidof(IMMDeviceEnumerator), (void**)&enumerator);
     if (FAILED(hr)) return hr;
@@ -267,47 +415,294 @@ HRESULT WasapiCapture::InitializeMicrophone(const wchar_t* deviceId) {
     enumerator->Release();
     if (FAILED(hr)) return hr;
 
-    // Activate audio client
-    hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&audioClient_);
+    // Exclusive mode is refused when another application holds the device
+    // or the user disallowed it; shared mode still works then
+    LatencyMode mode = latencyMode_;
+    if (mode == LatencyMode::Exclusive) {
+        hr = InitializeExclusive(device);
+        if (SUCCEEDED(hr)) {
+            device->Release();
+            return hr;
+        }
+        ReleaseAudioClient();
+        if (eventCallback_) {
+            eventCallback_(3, "Exclusive mode is not available for this device; capturing in shared mode",
+                           userContext_);
+        }
+        mode = LatencyMode::Low;
+    }
+
+    hr = ActivateDevice(device);
+    if (FAILED(hr)) {
+        device->Release();
+        return hr;
+    }
+
+    if (mode == LatencyMode::Low) {
+        hr = InitializeLowLatency();
+        if (hr == S_OK) {
+            device->Release();
+            return hr;
+        }
+        if (latencyMode_ == LatencyMode::Low && eventCallback_) {
+            eventCallback_(3, "Low-latency shared mode is not available for this device; using the default period",
+                           userContext_);
+        }
+
+        // A failed Initialize leaves the client unusable
+        if (FAILED(hr)) {
+            hr = ActivateDevice(device);
+            if (FAILED(hr)) {
+                device->Release();
+                return hr;
+            }
+        }
+    }
     device->Release();
+
+    // Initialize for capture
+    return InitializeAudioClient(audioClient_, mixFormat_, bufferEvent_, 0, &captureClient_);
+}
+
+HRESULT WasapiCapture::ActivateDevice(IMMDevice* device) {
+    ReleaseAudioClient();
+
+    HRESULT hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&audioClient_);
     if (FAILED(hr)) return hr;
 
-    // Get mix format
-    hr = audioClient_->GetMixFormat(&mixFormat_);
+    return audioClient_->GetMixFormat(&mixFormat_);
+}
+
+HRESULT WasapiCapture::InitializeLowLatency() {
+    IAudioClient3* client3 = nullptr;
+    if (FAILED(audioClient_->QueryInterface(__uuidof(IAudioClient3), (void**)&client3))) return S_FALSE;
+
+    // Periods in frames: the engine's default, and the smallest it allows for
+    // this format (IAudioClient3 makes the choice, rather than the buffer)
+    UINT32 defaultPeriod = 0, fundamentalPeriod = 0, minPeriod = 0, maxPeriod = 0;
+    HRESULT hr = client3->GetSharedModeEnginePeriod(mixFormat_, &defaultPeriod, &fundamentalPeriod, &minPeriod,
+                                                    &maxPeriod);
+    if (FAILED(hr) || minPeriod == 0) {
+        client3->Release();
+        return S_FALSE;
+    }
+
+    hr = client3->InitializeSharedAudioStream(AUDCLNT_STREAMFLAGS_EVENTCALLBACK, minPeriod, mixFormat_, nullptr);
+    client3->Release();
     if (FAILED(hr)) return hr;
 
-    // Initialize for capture
-    hr = audioClient_->Initialize(
-        AUDCLNT_SHAREMODE_SHARED,
-        0,
-        10000000,  // 1 second buffer
-        0,
-        mixFormat_,
-        nullptr
-    );
+    hr = audioClient_->SetEventHandle(bufferEvent_);
     if (FAILED(hr)) return hr;
 
-    // Get capture client
-    hr = audioClient_->GetService(__uuidof(IAudioCaptureClient), (void**)&captureClient_);
+    return audioClient_->GetService(__uuidof(IAudioCaptureClient), (void**)&captureClient_);
+}
 
-    return hr;
+HRESULT WasapiCapture::NegotiateExclusiveFormat(IMMDevice* device, WAVEFORMATEX** format) {
+    *format = nullptr;
+
+    // The format the device runs in, as set in the Sound control panel
+    IPropertyStore* props = nullptr;
+    if (SUCCEEDED(device->OpenPropertyStore(STGM_READ, &props))) {
+        PROPVARIANT value;
+        PropVariantInit(&value);
+        if (SUCCEEDED(props->GetValue(PKEY_AudioEngine_DeviceFormat, &value)) && value.vt == VT_BLOB &&
+            value.blob.cbSize >= sizeof(WAVEFORMATEX)) {
+            auto* deviceFormat = reinterpret_cast<const WAVEFORMATEX*>(value.blob.pBlobData);
+            if (value.blob.cbSize >= sizeof(WAVEFORMATEX) + deviceFormat->cbSize && ConvertibleFormat(deviceFormat) &&
+                audioClient_->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, deviceFormat, nullptr) == S_OK) {
+                *format = CopyFormat(deviceFormat);
+            }
+        }
+        PropVariantClear(&value);
+        props->Release();
+    }
+    if (*format) return S_OK;
+
+    // Otherwise the mix format's rate and layout, in the best sample type the
+    // device accepts: {container bits, valid bits, float}
+    static const struct { WORD bits; WORD validBits; bool isFloat; } kCandidates[] = {
+        {32, 32, true}, {32, 32, false}, {32, 24, false}, {24, 24, false}, {16, 16, false},
+    };
+    WAVEFORMATEXTENSIBLE candidate = {};
+    candidate.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    candidate.Format.nChannels = mixFormat_->nChannels;
+    candidate.Format.nSamplesPerSec = mixFormat_->nSamplesPerSec;
+    candidate.Format.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+    candidate.dwChannelMask = mixFormat_->wFormatTag == WAVE_FORMAT_EXTENSIBLE && mixFormat_->cbSize >= 22
+        ? reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(mixFormat_)->dwChannelMask
+        : 0;
+    for (const auto& type : kCandidates) {
+        candidate.Format.wBitsPerSample = type.bits;
+        candidate.Format.nBlockAlign = candidate.Format.nChannels * type.bits / 8;
+        candidate.Format.nAvgBytesPerSec = candidate.Format.nSamplesPerSec * candidate.Format.nBlockAlign;
+        candidate.Samples.wValidBitsPerSample = type.validBits;
+        candidate.SubFormat = type.isFloat ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT : KSDATAFORMAT_SUBTYPE_PCM;
+        if (audioClient_->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, &candidate.Format, nullptr) == S_OK) {
+            *format = CopyFormat(&candidate.Format);
+            return *format ? S_OK : E_OUTOFMEMORY;
+        }
+    }
+    return AUDCLNT_E_UNSUPPORTED_FORMAT;
+}
+
+HRESULT WasapiCapture::InitializeExclusive(IMMDevice* device) {
+    HRESULT hr = ActivateDevice(device);
+    if (FAILED(hr)) return hr;
+
+    WAVEFORMATEX* format = nullptr;
+    hr = NegotiateExclusiveFormat(device, &format);
+    if (FAILED(hr)) return hr;
+
+    // The stream's format from here on, for FinalizeInitialization and the
+    // capture thread
+    CoTaskMemFree(mixFormat_);
+    mixFormat_ = format;
+
+    // Event-driven exclusive mode takes one period as both buffer and
+    // periodicity: the device's minimum, unless a longer buffer was asked for
+    REFERENCE_TIME defaultPeriod = 0, minPeriod = 0;
+    hr = audioClient_->GetDevicePeriod(&defaultPeriod, &minPeriod);
+    if (FAILED(hr)) return hr;
+    REFERENCE_TIME period = std::max(minPeriod, static_cast<REFERENCE_TIME>(bufferDurationMs_ * 10000.0));
+
+    hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, AUDCLNT_STREAMFLAGS_EVENTCALLBACK, period, period,
+                                  mixFormat_, nullptr);
+    if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
+        // Some drivers need the period to be a whole number of their blocks:
+        // the client reports the aligned size, and only a fresh client takes it
+        UINT32 alignedFrames = 0;
+        hr = audioClient_->GetBufferSize(&alignedFrames);
+        if (FAILED(hr)) return hr;
+        period = static_cast<REFERENCE_TIME>(1e7 * alignedFrames / mixFormat_->nSamplesPerSec + 0.5);
+
+        audioClient_->Release();
+        audioClient_ = nullptr;
+        hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&audioClient_);
+        if (FAILED(hr)) return hr;
+        hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, AUDCLNT_STREAMFLAGS_EVENTCALLBACK, period, period,
+                                      mixFormat_, nullptr);
+    }
+    if (FAILED(hr)) return hr;
+
+    hr = audioClient_->SetEventHandle(bufferEvent_);
+    if (FAILED(hr)) return hr;
+
+    return audioClient_->GetService(__uuidof(IAudioCaptureClient), (void**)&captureClient_);
+}
+
+bool WasapiCapture::ChannelMapFits() const {
+    if (channelMap_.Empty()) return true;
+    if (mixSources_.empty()) {
+        return mixFormat_ && mixFormat_->nChannels >= channelMap_.inputChannels;
+    }
+    for (const auto& source : mixSources_) {
+        if (source->mixFormat->nChannels < channelMap_.inputChannels) return false;
+    }
+    return true;
 }
 
 HRESULT WasapiCapture::FinalizeInitialization() {
-    if (!mixFormat_) return E_FAIL;
+    // A mixed capture takes its default rate and layout from the first PID
+    const WAVEFORMATEX* format = mixSources_.empty() ? mixFormat_ : mixSources_.front()->mixFormat;
+    if (!format) return E_FAIL;
 
     // Determine output sample rate
-    double outputSampleRate = targetSampleRate_ > 0 ? targetSampleRate_ : mixFormat_->nSamplesPerSec;
-    resampleRatio_ = outputSampleRate / mixFormat_->nSamplesPerSec;
+    double outputSampleRate = targetSampleRate_ > 0 ? targetSampleRate_ : format->nSamplesPerSec;
 
     // Calculate samples per chunk based on output sample rate
     samplesPerChunk_ = static_cast<size_t>((chunkDurationMs_ / 1000.0) * outputSampleRate);
 
+    // A channel map replaces the mono choice
+    size_t inputChannels = format->nChannels;
+    size_t outputChannels = !channelMap_.Empty() ? channelMap_.outputChannels : isMono_ ? 1 : inputChannels;
+    outputChannels_ = outputChannels;
+
+    // Preallocate every buffer the capture thread uses, so the steady state
+    // on the MMCSS thread never touches the heap. Packets never exceed the
+    // endpoint buffer; ProcessAudioData slices anything larger regardless.
+    size_t maxChunkPush = 0;
+    if (mixSources_.empty()) {
+        UINT32 bufferFrames = 0;
+        if (FAILED(audioClient_->GetBufferSize(&bufferFrames)) || bufferFrames == 0) {
+            bufferFrames = format->nSamplesPerSec;  // 1 second
+        }
+        maxPacketFrames_ = bufferFrames;
+
+        // Resample after downmixing, so the filter runs on as few channels as possible
+        resampler_.Configure(format->nSamplesPerSec, outputSampleRate, static_cast<uint32_t>(outputChannels),
+                             resamplerQuality_, maxPacketFrames_);
+        size_t maxResampledSamples = resampler_.MaxOutputFrames(maxPacketFrames_) * outputChannels;
+
+        sampleBits_ = IntegerSampleBits(format);
+        convertBuffer_.assign(sampleBits_ ? maxPacketFrames_ * inputChannels : 0, 0.0f);
+        channelMatrix_.clear();
+        if (!channelMap_.Empty() && !channelMap_.ForDevice(static_cast<uint32_t>(inputChannels), &channelMatrix_)) {
+            return E_INVALIDARG;
+        }
+
+        gainBuffer_.assign(maxPacketFrames_ * inputChannels, 0.0f);
+        layoutBuffer_.assign(maxPacketFrames_ * outputChannels, 0.0f);
+        resampleBuffer_.assign(maxResampledSamples, 0.0f);
+        maxChunkPush = maxResampledSamples;
+    } else {
+        // Mix in 10 ms blocks, and only once the leading source is a further
+        // 20 ms ahead: that absorbs the phase difference between the clients'
+        // events, while a source that stays behind longer than that (its
+        // process went quiet) is mixed in as silence
+        mixBlockFrames_ = std::max<size_t>(static_cast<size_t>(outputSampleRate / 100.0), 1);
+        mixLatencyFrames_ = mixBlockFrames_ * 2;
+
+        for (auto& source : mixSources_) {
+            UINT32 bufferFrames = 0;
+            if (FAILED(source->audioClient->GetBufferSize(&bufferFrames)) || bufferFrames == 0) {
+                bufferFrames = source->mixFormat->nSamplesPerSec;  // 1 second
+            }
+            source->maxPacketFrames = bufferFrames;
+
+            // Every source is brought to the output layout first, then to the
+            // output rate, each with its own resampler so their clocks line up
+            source->resampler.Configure(source->mixFormat->nSamplesPerSec, outputSampleRate,
+                                        static_cast<uint32_t>(outputChannels), resamplerQuality_, bufferFrames);
+            size_t maxResampledFrames = source->resampler.MaxOutputFrames(bufferFrames);
+
+            uint32_t sourceChannels = source->mixFormat->nChannels;
+            source->sampleBits = IntegerSampleBits(source->mixFormat);
+            source->convertBuffer.assign(source->sampleBits ? bufferFrames * sourceChannels : 0, 0.0f);
+            source->channelMatrix.clear();
+            if (!channelMap_.Empty() && !channelMap_.ForDevice(sourceChannels, &source->channelMatrix)) {
+                return E_INVALIDARG;
+            }
+
+            source->monoBuffer.assign(bufferFrames, 0.0f);
+            source->remapBuffer.assign(bufferFrames * outputChannels, 0.0f);
+            source->resampleBuffer.assign(maxResampledFrames * outputChannels, 0.0f);
+
+            // The mixer never lets a source run more than one packet past the
+            // lead threshold, so this never fills up under normal operation
+            size_t pendingFrames = maxResampledFrames + mixBlockFrames_ + mixLatencyFrames_;
+            source->pending = std::make_unique<ByteRing>(pendingFrames * outputChannels * sizeof(float));
+        }
+
+        mixBuffer_.assign(mixBlockFrames_ * outputChannels, 0.0f);
+        mixScratch_.assign(mixBlockFrames_ * outputChannels, 0.0f);
+        maxChunkPush = mixBuffer_.size();
+    }
+
+    chunkBuffer_.Reset(samplesPerChunk_ * outputChannels, maxChunkPush);
+    silenceBuffer_.assign(samplesPerChunk_ * outputChannels, 0.0f);
+    // Only a single client has one device counter to report
+    chunkClock_.Reset(outputSampleRate, mixSources_.empty() ? format->nSamplesPerSec : 0);
+    pushedFrames_ = 0;
+    stats_.Reset();
+    for (auto& source : mixSources_) {
+        source->clock.Reset(outputSampleRate);
+    }
+
     // Report metadata
     if (metadataCallback_) {
         metadataCallback_(
             outputSampleRate,
-            isMono_ ? 1 : mixFormat_->nChannels,
+            static_cast<uint32_t>(outputChannels),
             32,  // Always output 32-bit float
             true,
             "pcm_f32le",
@@ -318,6 +713,23 @@ HRESULT WasapiCapture::FinalizeInitialization() {
     return S_OK;
 }
 
+HRESULT WasapiCapture::StartAudioClients() {
+    if (mixSources_.empty()) {
+        return audioClient_->Start();
+    }
+
+    for (size_t i = 0; i < mixSources_.size(); i++) {
+        HRESULT hr = mixSources_[i]->audioClient->Start();
+        if (FAILED(hr)) {
+            while (i-- > 0) {
+                mixSources_[i]->audioClient->Stop();
+            }
+            return hr;
+        }
+    }
+    return S_OK;
+}
+
 int32_t WasapiCapture::StartSystemAudio(
     double sampleRate,
     double chunkDurationMs,
@@ -339,15 +751,18 @@ int32_t WasapiCapture::StartSystemAudio(
     HRESULT hr;
 
     // Determine capture mode
-    if (includeCount > 0 && includeProcesses != nullptr) {
+    if (includeCount > 1 && includeProcesses != nullptr) {
+        // Include several processes: one client per PID, mixed natively
+        hr = InitializeProcessMix(includeProcesses, includeCount);
+    } else if (includeCount > 0 && includeProcesses != nullptr) {
         // Include mode: capture only from specified process
-        // Note: WASAPI only supports one process at a time
         hr = InitializeProcessLoopback(
             static_cast<DWORD>(includeProcesses[0]),
             PROCESS_LOOPBACK_MODE_INCLUDE_TARGET_PROCESS_TREE
         );
     } else if (excludeCount > 0 && excludeProcesses != nullptr) {
-        // Exclude mode: capture everything except specified process
+        // Exclude mode: capture everything except specified process. Exclusion
+        // can't be composed from several clients, so only the first PID counts.
         hr = InitializeProcessLoopback(
             static_cast<DWORD>(excludeProcesses[0]),
             PROCESS_LOOPBACK_MODE_EXCLUDE_TARGET_PROCESS_TREE
@@ -364,6 +779,13 @@ int32_t WasapiCapture::StartSystemAudio(
         return -3;
     }
 
+    if (!ChannelMapFits()) {
+        if (eventCallback_) {
+            eventCallback_(2, "The device has fewer channels than the channel map reads", userContext_);
+        }
+        return -9;
+    }
+
     hr = FinalizeInitialization();
     if (FAILED(hr)) {
         if (eventCallback_) {
@@ -372,8 +794,8 @@ int32_t WasapiCapture::StartSystemAudio(
         return -4;
     }
 
-    // Start the audio client
-    hr = audioClient_->Start();
+    // Start the audio clients
+    hr = StartAudioClients();
     if (FAILED(hr)) {
         if (eventCallback_) {
             eventCallback_(2, "Failed to start audio client", userContext_);
@@ -422,6 +844,13 @@ int32_t WasapiCapture::StartMicrophone(
         return -3;
     }
 
+    if (!ChannelMapFits()) {
+        if (eventCallback_) {
+            eventCallback_(2, "The device has fewer channels than the channel map reads", userContext_);
+        }
+        return -9;
+    }
+
     hr = FinalizeInitialization();
     if (FAILED(hr)) {
         if (eventCallback_) {
@@ -466,6 +895,9 @@ int32_t WasapiCapture::Stop() {
     if (audioClient_) {
         audioClient_->Stop();
     }
+    for (auto& source : mixSources_) {
+        source->audioClient->Stop();
+    }
 
     // Emit stop event
     if (eventCallback_) {
@@ -487,47 +919,62 @@ void WasapiCapture::CaptureThread() {
     DWORD taskIndex = 0;
     HANDLE taskHandle = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
 
-    UINT32 packetLength = 0;
-    BYTE* data = nullptr;
-    UINT32 numFramesAvailable = 0;
-    DWORD flags = 0;
-
     // Initialize timing for silence generation
     lastDataTime_ = std::chrono::steady_clock::now();
-    auto chunkDuration = std::chrono::milliseconds(static_cast<int64_t>(chunkDurationMs_));
+    auto chunkDuration = std::chrono::duration<double, std::milli>(chunkDurationMs_);
+
+    // The stop event first, then the buffer event of every client
+    std::vector<HANDLE> waitHandles{ stopEvent_ };
+    if (mixSources_.empty()) {
+        waitHandles.push_back(bufferEvent_);
+    } else {
+        for (auto& source : mixSources_) {
+            waitHandles.push_back(source->bufferEvent);
+        }
+    }
+    DWORD handleCount = static_cast<DWORD>(waitHandles.size());
 
     while (running_) {
-        // Wait for audio data or stop event
-        DWORD waitResult = WaitForSingleObject(stopEvent_, 10);
+        // Sleep until the engine has a buffer for us or we're stopped. When
+        // emitting silence, wake up no later than the next silent chunk is due.
+        DWORD timeout = INFINITE;
+        if (emitSilence_) {
+            auto remaining = chunkDuration - (std::chrono::steady_clock::now() - lastDataTime_);
+            timeout = remaining.count() > 0 ? static_cast<DWORD>(std::ceil(remaining.count())) : 0;
+        }
+
+        DWORD waitResult = WaitForMultipleObjects(handleCount, waitHandles.data(), FALSE, timeout);
         if (waitResult == WAIT_OBJECT_0) {
             break;
         }
-
-        bool receivedAudio = false;
-
-        // Get available audio data
-        HRESULT hr = captureClient_->GetNextPacketSize(&packetLength);
-        if (FAILED(hr)) {
+        if (waitResult == WAIT_FAILED) {
             if (eventCallback_) {
-                eventCallback_(2, "Failed to get packet size", userContext_);
+                eventCallback_(2, "Failed to wait for audio buffer", userContext_);
             }
             break;
         }
 
-        while (packetLength > 0 && running_) {
-            hr = captureClient_->GetBuffer(&data, &numFramesAvailable, &flags, nullptr, nullptr);
-            if (FAILED(hr)) break;
+        bool receivedAudio = false;
 
-            if (!(flags & AUDCLNT_BUFFERFLAGS_SILENT) && data != nullptr) {
-                ProcessAudioData(data, numFramesAvailable);
-                receivedAudio = true;
+        if (waitResult > WAIT_OBJECT_0 && waitResult < WAIT_OBJECT_0 + handleCount) {
+            HRESULT hr = S_OK;
+            if (mixSources_.empty()) {
+                hr = DrainCaptureClient(captureClient_, nullptr, &receivedAudio);
+            } else {
+                // Only the lowest signalled event is reported, so drain every
+                // source; the others' events just cause an empty wakeup
+                for (auto& source : mixSources_) {
+                    hr = DrainCaptureClient(source->captureClient, source.get(), &receivedAudio);
+                    if (FAILED(hr)) break;
+                }
+                MixSources();
+            }
+            if (FAILED(hr)) {
+                if (eventCallback_) {
+                    eventCallback_(2, "Failed to get packet size", userContext_);
+                }
+                break;
             }
-
-            hr = captureClient_->ReleaseBuffer(numFramesAvailable);
-            if (FAILED(hr)) break;
-
-            hr = captureClient_->GetNextPacketSize(&packetLength);
-            if (FAILED(hr)) break;
         }
 
         // Update last data time if we received audio
@@ -538,20 +985,16 @@ void WasapiCapture::CaptureThread() {
         // Generate silence if enabled and no audio received for too long
         if (emitSilence_ && !receivedAudio) {
             auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastDataTime_);
             
-            if (elapsed >= chunkDuration) {
-                // Generate silent chunk
-                size_t numChannels = isMono_ ? 1 : (mixFormat_ ? mixFormat_->nChannels : 2);
-                size_t silentSamples = samplesPerChunk_ * numChannels;
-                
-                if (silentSamples > 0 && dataCallback_) {
-                    std::vector<float> silentBuffer(silentSamples, 0.0f);
-                    dataCallback_(
-                        reinterpret_cast<const uint8_t*>(silentBuffer.data()),
-                        static_cast<int32_t>(silentSamples * sizeof(float)),
-                        userContext_
-                    );
+            if (now - lastDataTime_ >= chunkDuration) {
+                // Emit a silent chunk from the preallocated zero buffer,
+                // stamped as the chunk that just went by
+                if (!silenceBuffer_.empty()) {
+                    uint64_t chunkNs = static_cast<uint64_t>(chunkDurationMs_ * 1e6);
+                    chunkClock_.Anchor(audio_stats_now_ns() - chunkNs, static_cast<double>(chunkClock_.Position()));
+                    chunkClock_.ForgetDevice();
+                    pushedFrames_ += samplesPerChunk_;
+                    EmitChunk(silenceBuffer_.data(), silenceBuffer_.size());
                 }
                 
                 lastDataTime_ = now;
@@ -569,97 +1012,235 @@ void WasapiCapture::CaptureThread() {
     }
 }
 
-void WasapiCapture::ProcessAudioData(const BYTE* data, UINT32 numFrames) {
-    if (!mixFormat_ || numFrames == 0) return;
+HRESULT WasapiCapture::DrainCaptureClient(IAudioCaptureClient* client, MixSource* source, bool* receivedAudio) {
+    UINT32 packetLength = 0;
+    BYTE* data = nullptr;
+    UINT32 numFramesAvailable = 0;
+    DWORD flags = 0;
+    UINT64 devicePosition = 0;
+    UINT64 qpcPosition = 0;
+
+    // Drain every packet that is ready; one event may cover several. Only a
+    // failure to query the packet size is fatal, as before.
+    HRESULT hr = client->GetNextPacketSize(&packetLength);
+    if (FAILED(hr)) return hr;
 
-    // Convert to float (assuming input is float - WASAPI typically provides float)
-    const float* floatData = reinterpret_cast<const float*>(data);
-    size_t numChannels = mixFormat_->nChannels;
-    size_t totalSamples = numFrames * numChannels;
+    while (packetLength > 0 && running_) {
+        StatsTimer timer;
+        hr = client->GetBuffer(&data, &numFramesAvailable, &flags, &devicePosition, &qpcPosition);
+        if (FAILED(hr)) break;
 
-    std::vector<float> processedData;
+        // The QPC position is in 100ns units; the engine leaves it 0 when it has none
+        uint64_t hostTimeNs = (flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR) ? 0 : qpcPosition * 100;
 
-    // Apply gain if capturing microphone
-    if (gain_ != 1.0) {
-        processedData.resize(totalSamples);
-        for (size_t i = 0; i < totalSamples; i++) {
-            processedData[i] = floatData[i] * static_cast<float>(gain_);
+        // The engine lost audio before this packet, e.g. because we read too late
+        if (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) {
+            if (source) {
+                source->discontinuity = true;
+            } else {
+                chunkClock_.MarkDiscontinuity(static_cast<double>(pushedFrames_));
+            }
         }
-        floatData = processedData.data();
-    }
 
-    // Convert to mono if needed
-    std::vector<float> monoData;
-    if (isMono_ && numChannels > 1) {
-        ConvertToMono(floatData, numFrames, monoData);
-        floatData = monoData.data();
-        numChannels = 1;
-        totalSamples = numFrames;
-    }
+        if (!(flags & AUDCLNT_BUFFERFLAGS_SILENT) && data != nullptr) {
+            if (source) {
+                QueueMixSource(*source, data, numFramesAvailable, hostTimeNs);
+            } else {
+                chunkClock_.AnchorDevice(devicePosition, static_cast<double>(pushedFrames_));
+                ProcessAudioData(data, numFramesAvailable, hostTimeNs);
+            }
+            *receivedAudio = true;
+        }
 
-    // Resample if needed
-    std::vector<float> resampledData;
-    size_t outputFrames = numFrames;
-    if (resampleRatio_ != 1.0) {
-        ResampleAudio(floatData, numFrames * numChannels, resampledData);
-        floatData = resampledData.data();
-        outputFrames = resampledData.size() / numChannels;
-        totalSamples = resampledData.size();
-    }
+        hr = client->ReleaseBuffer(numFramesAvailable);
+        if (FAILED(hr)) break;
+        stats_.RecordCallback(timer.ElapsedNs(), numFramesAvailable);
 
-    // Add to chunk buffer
-    size_t outputSamples = outputFrames * numChannels;
-    for (size_t i = 0; i < outputSamples; i++) {
-        chunkBuffer_.push_back(floatData[i]);
+        hr = client->GetNextPacketSize(&packetLength);
+        if (FAILED(hr)) break;
     }
+    return S_OK;
+}
 
-    // Emit chunks when buffer is full
-    size_t samplesNeeded = samplesPerChunk_ * (isMono_ ? 1 : numChannels);
-    while (chunkBuffer_.size() >= samplesNeeded && dataCallback_) {
-        // Emit chunk
+void WasapiCapture::EmitChunk(const float* samples, size_t count) {
+    AudioChunkInfo info = chunkClock_.Next(count / outputChannels_);
+    stats_.AddEmitted(count / outputChannels_);
+    if (dataCallback_) {
         dataCallback_(
-            reinterpret_cast<const uint8_t*>(chunkBuffer_.data()),
-            static_cast<int32_t>(samplesNeeded * sizeof(float)),
+            reinterpret_cast<const uint8_t*>(samples),
+            static_cast<int32_t>(count * sizeof(float)),
+            &info,
             userContext_
         );
-
-        // Remove emitted samples from buffer
-        chunkBuffer_.erase(chunkBuffer_.begin(), chunkBuffer_.begin() + samplesNeeded);
     }
 }
 
-void WasapiCapture::ConvertToMono(const float* input, size_t frames, std::vector<float>& output) {
-    size_t channels = mixFormat_->nChannels;
-    output.resize(frames);
+void WasapiCapture::ProcessAudioData(const BYTE* data, UINT32 numFrames, uint64_t hostTimeNs) {
+    if (!mixFormat_ || numFrames == 0) return;
+
+    const BYTE* input = data;
+    size_t inputChannels = mixFormat_->nChannels;
+    size_t inputFrameBytes = mixFormat_->nBlockAlign;
+
+    auto emitChunk = [this](const float* chunk, size_t samples) { EmitChunk(chunk, samples); };
 
-    for (size_t i = 0; i < frames; i++) {
-        float sum = 0.0f;
-        for (size_t c = 0; c < channels; c++) {
-            sum += input[i * channels + c];
+    // The packet's first frame lands after everything pushed so far
+    chunkClock_.Anchor(hostTimeNs, static_cast<double>(pushedFrames_));
+
+    while (numFrames > 0) {
+        size_t frames = std::min<size_t>(numFrames, maxPacketFrames_);
+        const float* floatData = reinterpret_cast<const float*>(input);
+        size_t numChannels = inputChannels;
+        size_t totalSamples = frames * numChannels;
+
+        if (sampleBits_) {
+            audio_dsp_int_to_float(input, convertBuffer_.data(), totalSamples, sampleBits_);
+            floatData = convertBuffer_.data();
         }
-        output[i] = sum / channels;
+
+        // Apply gain if capturing microphone
+        if (gain_ != 1.0) {
+            audio_dsp_apply_gain(floatData, gainBuffer_.data(), totalSamples, static_cast<float>(gain_), false);
+            floatData = gainBuffer_.data();
+        }
+
+        // Bring the audio to the output layout: the channel map, or mono if asked for
+        if (!channelMatrix_.empty()) {
+            audio_dsp_mix_channels(floatData, layoutBuffer_.data(), frames, static_cast<uint32_t>(numChannels),
+                                   channelMatrix_.data(), static_cast<uint32_t>(outputChannels_));
+            floatData = layoutBuffer_.data();
+            numChannels = outputChannels_;
+            totalSamples = frames * numChannels;
+        } else if (isMono_ && numChannels > 1) {
+            audio_dsp_downmix_mono(floatData, layoutBuffer_.data(), frames, static_cast<uint32_t>(numChannels));
+            floatData = layoutBuffer_.data();
+            numChannels = 1;
+            totalSamples = frames;
+        }
+
+        // Resample if needed
+        if (!resampler_.IsPassthrough()) {
+            StatsTimer timer;
+            totalSamples = resampler_.Process(floatData, frames, resampleBuffer_.data()) * numChannels;
+            floatData = resampleBuffer_.data();
+            stats_.RecordConversion(timer.ElapsedNs());
+        }
+
+        // Accumulate and emit complete chunks
+        pushedFrames_ += totalSamples / numChannels;
+        chunkBuffer_.Push(floatData, totalSamples, emitChunk);
+
+        input += frames * inputFrameBytes;
+        numFrames -= static_cast<UINT32>(frames);
     }
 }
 
-void WasapiCapture::ResampleAudio(const float* input, size_t inputSamples, std::vector<float>& output) {
-    size_t outputSamples = static_cast<size_t>(inputSamples * resampleRatio_);
-    output.resize(outputSamples);
+void WasapiCapture::QueueMixSource(MixSource& source, const BYTE* data, UINT32 numFrames, uint64_t hostTimeNs) {
+    if (numFrames == 0) return;
+
+    source.clock.Anchor(hostTimeNs, static_cast<double>(source.queuedFrames));
+
+    const BYTE* input = data;
+    size_t inputChannels = source.mixFormat->nChannels;
+    size_t inputFrameBytes = source.mixFormat->nBlockAlign;
+    size_t outputChannels = outputChannels_;
+
+    while (numFrames > 0) {
+        size_t frames = std::min<size_t>(numFrames, source.maxPacketFrames);
+        const float* floatData = reinterpret_cast<const float*>(input);
+
+        if (source.sampleBits) {
+            audio_dsp_int_to_float(input, source.convertBuffer.data(), frames * inputChannels, source.sampleBits);
+            floatData = source.convertBuffer.data();
+        }
+
+        // Bring the source to the output layout. Clients of one engine share a
+        // layout in practice; anything else goes through mono.
+        if (!source.channelMatrix.empty()) {
+            audio_dsp_mix_channels(floatData, source.remapBuffer.data(), frames, static_cast<uint32_t>(inputChannels),
+                                   source.channelMatrix.data(), static_cast<uint32_t>(outputChannels));
+            floatData = source.remapBuffer.data();
+        } else if (inputChannels != outputChannels) {
+            const float* mono = floatData;
+            if (inputChannels > 1) {
+                audio_dsp_downmix_mono(floatData, source.monoBuffer.data(), frames,
+                                       static_cast<uint32_t>(inputChannels));
+                mono = source.monoBuffer.data();
+            }
+            if (outputChannels == 1) {
+                floatData = mono;
+            } else {
+                float* out = source.remapBuffer.data();
+                for (size_t i = 0; i < frames; i++) {
+                    for (size_t c = 0; c < outputChannels; c++) {
+                        out[i * outputChannels + c] = mono[i];
+                    }
+                }
+                floatData = out;
+            }
+        }
 
-    // Simple linear interpolation resampling
-    for (size_t i = 0; i < outputSamples; i++) {
-        double srcIndex = i / resampleRatio_;
-        size_t srcIndexInt = static_cast<size_t>(srcIndex);
-        double frac = srcIndex - srcIndexInt;
+        size_t outputFrames = frames;
+        if (!source.resampler.IsPassthrough()) {
+            StatsTimer timer;
+            outputFrames = source.resampler.Process(floatData, frames, source.resampleBuffer.data());
+            floatData = source.resampleBuffer.data();
+            stats_.RecordConversion(timer.ElapsedNs());
+        }
 
-        if (srcIndexInt + 1 < inputSamples) {
-            output[i] = static_cast<float>(
-                input[srcIndexInt] * (1.0 - frac) + input[srcIndexInt + 1] * frac
-            );
-        } else if (srcIndexInt < inputSamples) {
-            output[i] = input[srcIndexInt];
+        // All-or-nothing; a full FIFO only happens if the mixer stalled, and
+        // dropping the packet then is the same as the source going quiet
+        if (source.pending->Write(floatData, outputFrames * outputChannels * sizeof(float))) {
+            source.queuedFrames += outputFrames;
         } else {
-            output[i] = 0.0f;
+            source.discontinuity = true;
+            stats_.AddDropped(outputFrames);
         }
+
+        input += frames * inputFrameBytes;
+        numFrames -= static_cast<UINT32>(frames);
+    }
+}
+
+void WasapiCapture::MixSources() {
+    auto emitChunk = [this](const float* chunk, size_t samples) { EmitChunk(chunk, samples); };
+
+    const size_t frameBytes = outputChannels_ * sizeof(float);
+    const size_t blockBytes = mixBlockFrames_ * frameBytes;
+
+    for (;;) {
+        size_t leadFrames = 0;
+        MixSource* lead = nullptr;
+        for (auto& source : mixSources_) {
+            size_t frames = source->pending->Readable() / frameBytes;
+            if (!lead || frames > leadFrames) {
+                leadFrames = frames;
+                lead = source.get();
+            }
+        }
+        if (leadFrames < mixBlockFrames_ + mixLatencyFrames_) break;
+
+        // The block is timed by the source it is waiting for
+        chunkClock_.Anchor(lead->clock.TimeAt(static_cast<double>(lead->mixedFrames)),
+                           static_cast<double>(pushedFrames_));
+
+        // Sources that are behind contribute what they have and silence for
+        // the rest. The sum is not clamped; float output has headroom.
+        std::fill(mixBuffer_.begin(), mixBuffer_.end(), 0.0f);
+        for (auto& source : mixSources_) {
+            size_t samples = source->pending->Read(mixScratch_.data(), blockBytes) / sizeof(float);
+            for (size_t i = 0; i < samples; i++) {
+                mixBuffer_[i] += mixScratch_[i];
+            }
+            source->mixedFrames += samples / outputChannels_;
+            if (source->discontinuity) {
+                chunkClock_.MarkDiscontinuity(static_cast<double>(pushedFrames_));
+                source->discontinuity = false;
+            }
+        }
+
+        pushedFrames_ += mixBlockFrames_;
+        chunkBuffer_.Push(mixBuffer_.data(), mixBuffer_.size(), emitChunk);
     }
 }
 
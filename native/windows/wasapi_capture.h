@@ -12,6 +12,14 @@
 #include <mutex>
 #include <string>
 #include <chrono>
+#include <memory>
+
+#include "byte_ring.h"
+#include "capture_stats.h"
+#include "channel_map.h"
+#include "chunk_accumulator.h"
+#include "chunk_clock.h"
+#include "resampler.h"
 
 // ============================================================================
 // Windows 10 2004+ Process Loopback API Definitions
@@ -59,6 +67,13 @@ typedef struct _AUDIOCLIENT_ACTIVATION_PARAMS {
 // Forward declarations
 class WasapiCapture;
 
+// How a microphone client is opened; see audio_set_latency_mode
+enum class LatencyMode : int32_t {
+    Default = 0,    // Shared mode at the engine's default period
+    Low = 1,        // Shared mode at the engine's minimum period (IAudioClient3)
+    Exclusive = 2,  // The device alone, in its native format, at its minimum period
+};
+
 // Completion handler for async audio interface activation
 class ActivationCompletionHandler : public IActivateAudioInterfaceCompletionHandler {
 public:
@@ -120,30 +135,95 @@ public:
     int32_t Stop();
     bool IsRunning() const { return running_; }
 
+    // Device buffer duration used by the next start (0 = default)
+    int32_t SetBufferDuration(double bufferDurationMs);
+
+    // Sample rate converter quality used by the next start
+    int32_t SetResamplerQuality(ResamplerQuality quality);
+
+    // How the next microphone start opens its device
+    int32_t SetLatencyMode(LatencyMode mode);
+
+    // Channel map used by the next start in place of the mono choice; see
+    // audio_set_channel_map
+    int32_t SetChannelMap(const float* matrix, uint32_t outputChannels, uint32_t inputChannels);
+
+    // Counters of the current or last capture
+    void GetStats(AudioStatsSnapshot* stats) const { stats_.Snapshot(stats); }
+
 private:
+    // Default shared-mode buffer: 1 second (100ns units). Event-driven capture
+    // drains it every device period, so this only bounds how far we may lag.
+    static constexpr REFERENCE_TIME kDefaultBufferDuration = 10000000;
+
+    // Initialize an activated audio client for event-driven shared-mode capture
+    HRESULT InitializeAudioClient(IAudioClient* client, const WAVEFORMATEX* format, HANDLE event,
+                                  DWORD streamFlags, IAudioCaptureClient** captureClient);
+
+    // Release the audio client interfaces and mix format from the last session
+    void ReleaseAudioClient();
+
     // Initialize system-wide loopback (fallback for older Windows or no process filter)
     HRESULT InitializeSystemLoopback();
 
     // Initialize process-specific loopback (Windows 10 2004+)
     HRESULT InitializeProcessLoopback(DWORD targetPid, PROCESS_LOOPBACK_MODE mode);
 
-    // Initialize microphone capture
+    // Initialize one include-mode process loopback client per PID, mixed into a single stream
+    HRESULT InitializeProcessMix(const int32_t* pids, int32_t count);
+
+    // Activate a process loopback client on the virtual loopback device
+    static HRESULT ActivateProcessLoopback(DWORD targetPid, PROCESS_LOOPBACK_MODE mode, IAudioClient** client);
+
+    // Initialize microphone capture in the requested latency mode, falling
+    // back, with a warning event, to the modes the device allows
     HRESULT InitializeMicrophone(const wchar_t* deviceId);
 
+    // Activate a fresh client on the device, with its mix format
+    HRESULT ActivateDevice(IMMDevice* device);
+
+    // Shared mode at the engine's minimum period. S_FALSE, with the client
+    // untouched, if the client has no IAudioClient3 or no period for the format.
+    HRESULT InitializeLowLatency();
+
+    // Exclusive mode in a format the device takes directly, replacing
+    // mixFormat_ with it
+    HRESULT InitializeExclusive(IMMDevice* device);
+
+    // A format for exclusive mode, allocated with CoTaskMemAlloc: the
+    // device's own format if it is one we can convert, else the mix format's
+    // rate and channels in the first sample type the device accepts
+    HRESULT NegotiateExclusiveFormat(IMMDevice* device, WAVEFORMATEX** format);
+
+    // Whether every client's format has the channels the channel map reads
+    bool ChannelMapFits() const;
+
     // Common initialization after audio client is set up
     HRESULT FinalizeInitialization();
 
+    // Start every client of the session, or none of them
+    HRESULT StartAudioClients();
+
     // Audio capture thread
     void CaptureThread();
 
-    // Convert audio data to target format
-    void ProcessAudioData(const BYTE* data, UINT32 numFrames);
+    // Hand every packet the client has ready to ProcessAudioData, or to the
+    // mixer's FIFO for `source` when mixing
+    struct MixSource;
+    HRESULT DrainCaptureClient(IAudioCaptureClient* client, MixSource* source, bool* receivedAudio);
 
-    // Sample rate conversion (simple linear interpolation)
-    void ResampleAudio(const float* input, size_t inputFrames, std::vector<float>& output);
+    // Convert audio data to target format. hostTimeNs is the QPC time of the
+    // packet's first frame (0 if unknown).
+    void ProcessAudioData(const BYTE* data, UINT32 numFrames, uint64_t hostTimeNs);
 
-    // Convert stereo to mono
-    void ConvertToMono(const float* input, size_t frames, std::vector<float>& output);
+    // Convert one source's packet to the output rate and layout and queue it for mixing
+    void QueueMixSource(MixSource& source, const BYTE* data, UINT32 numFrames, uint64_t hostTimeNs);
+
+    // Hand a finished chunk to the data callback with its timing
+    void EmitChunk(const float* samples, size_t count);
+
+    // Sum every source's queued audio into mix blocks while the leading source is far enough ahead
+    void MixSources();
 
     // Callbacks
     AudioDataCallback dataCallback_;
@@ -151,7 +231,8 @@ private:
     AudioMetadataCallback metadataCallback_;
     void* userContext_;
 
-    // Audio client interfaces
+    // Audio client interfaces, and the format of the stream: the engine's mix
+    // format, or in exclusive mode the device format negotiated for it
     IAudioClient* audioClient_;
     IAudioCaptureClient* captureClient_;
     WAVEFORMATEX* mixFormat_;
@@ -160,24 +241,80 @@ private:
     std::thread captureThread_;
     std::atomic<bool> running_;
     HANDLE stopEvent_;
+    HANDLE bufferEvent_;        // Signalled by the audio engine when data is ready
+    double bufferDurationMs_;
+    LatencyMode latencyMode_;
 
     // Audio format settings
     double targetSampleRate_;
     double chunkDurationMs_;
     bool isMono_;
+    ChannelMap channelMap_;
     double gain_;
     bool emitSilence_;
     
     // Silence generation tracking
     std::chrono::steady_clock::time_point lastDataTime_;
 
-    // Buffer for accumulating audio chunks
-    std::vector<float> chunkBuffer_;
+    // Circular accumulator that cuts processed audio into chunks
+    ChunkAccumulator<float> chunkBuffer_;
     size_t samplesPerChunk_;
 
+    // Chunk timestamps: output frames pushed into chunkBuffer_ so far, and the
+    // clock mapping them to QPC time
+    ChunkClock chunkClock_;
+    uint64_t pushedFrames_;
+    AudioStats stats_;
+
+    // Scratch buffers sized in FinalizeInitialization for the largest packet
+    size_t maxPacketFrames_;
+    uint32_t sampleBits_;                  // Of an integer mix format; 0 for float
+    std::vector<float> convertBuffer_;
+    std::vector<float> gainBuffer_;
+    std::vector<float> layoutBuffer_;      // Downmixed or channel-mapped
+    std::vector<float> channelMatrix_;     // channelMap_ for the mix format's channels
+    std::vector<float> silenceBuffer_;
+
     // Resampling state
-    double resampleRatio_;
+    Resampler resampler_;
+    ResamplerQuality resamplerQuality_;
     std::vector<float> resampleBuffer_;
+
+    // One process loopback client of a mixed capture. Each source is brought
+    // to the output rate and channel layout on its own, then queued until the
+    // mixer sums it with the others.
+    struct MixSource {
+        ~MixSource();
+
+        IAudioClient* audioClient = nullptr;
+        IAudioCaptureClient* captureClient = nullptr;
+        WAVEFORMATEX* mixFormat = nullptr;
+        HANDLE bufferEvent = nullptr;
+
+        size_t maxPacketFrames = 0;
+        uint32_t sampleBits = 0;
+        std::vector<float> convertBuffer;
+        std::vector<float> channelMatrix;
+        std::vector<float> monoBuffer;
+        std::vector<float> remapBuffer;
+        std::vector<float> resampleBuffer;
+        Resampler resampler;
+        std::unique_ptr<ByteRing> pending;  // Output-format frames awaiting the mixer
+
+        // QPC times of the frames in `pending`, counted from the session start
+        ChunkClock clock;
+        uint64_t queuedFrames = 0;
+        uint64_t mixedFrames = 0;
+        bool discontinuity = false;         // Lost audio not yet reported by the mixer
+    };
+
+    // Mixed capture state; empty unless several include PIDs were given
+    std::vector<std::unique_ptr<MixSource>> mixSources_;
+    size_t outputChannels_;
+    size_t mixBlockFrames_;
+    size_t mixLatencyFrames_;
+    std::vector<float> mixBuffer_;
+    std::vector<float> mixScratch_;
 };
 
 // Device enumeration helper
@@ -1,4 +1,5 @@
 #include "audio_bridge.h"
+#include "device_registry.h"
 #include "wasapi_capture.h"
 #include "mta_thread.h"
 #include <combaseapi.h>
@@ -135,6 +136,55 @@ bool audio_is_running(AudioRecorderHandle handle) {
     return capture->IsRunning();
 }
 
+int32_t audio_set_buffer_duration(AudioRecorderHandle handle, double bufferDurationMs) {
+    if (!handle) return -1;
+
+    auto* capture = static_cast<WasapiCapture*>(handle);
+    return capture->SetBufferDuration(bufferDurationMs);
+}
+
+int32_t audio_set_resampler_quality(AudioRecorderHandle handle, int32_t quality) {
+    if (!handle) return -1;
+    if (quality < 0 || quality > 2) return -3;
+
+    auto* capture = static_cast<WasapiCapture*>(handle);
+    return capture->SetResamplerQuality(static_cast<ResamplerQuality>(quality));
+}
+
+int32_t audio_set_channel_map(AudioRecorderHandle handle, const float* matrix, uint32_t outputChannels,
+                              uint32_t inputChannels) {
+    if (!handle) return -1;
+
+    auto* capture = static_cast<WasapiCapture*>(handle);
+    return capture->SetChannelMap(matrix, outputChannels, inputChannels);
+}
+
+// No-op on Windows: loopback clients have no tap to keep warm, so the TTL is
+// ignored and only the running check applies
+int32_t audio_set_tap_cache_ttl(AudioRecorderHandle handle, double ttlMs) {
+    (void)ttlMs;
+    if (!handle) return -1;
+
+    auto* capture = static_cast<WasapiCapture*>(handle);
+    return capture->IsRunning() ? -2 : 0;
+}
+
+int32_t audio_set_latency_mode(AudioRecorderHandle handle, int32_t mode) {
+    if (!handle) return -1;
+    if (mode < 0 || mode > 2) return -3;
+
+    auto* capture = static_cast<WasapiCapture*>(handle);
+    return capture->SetLatencyMode(static_cast<LatencyMode>(mode));
+}
+
+int32_t audio_get_stats(AudioRecorderHandle handle, AudioStatsSnapshot* stats) {
+    if (!handle || !stats) return -1;
+
+    auto* capture = static_cast<WasapiCapture*>(handle);
+    capture->GetStats(stats);
+    return 0;
+}
+
 // ============================================================================
 // Device Enumeration
 // ============================================================================
@@ -151,14 +201,14 @@ int32_t audio_list_devices(AudioDeviceInfo** devices, int32_t* count) {
     }
     
     try {
-        std::vector<AudioDeviceInfo> deviceList = AudioDeviceEnumerator::ListAllDevices();
+        std::vector<AudioDeviceInfo> deviceList = DeviceRegistry::Instance().ListDevices();
         
         if (!deviceList.empty()) {
             // Allocate array of AudioDeviceInfo
             *devices = new AudioDeviceInfo[deviceList.size()];
             *count = static_cast<int32_t>(deviceList.size());
             
-            // Copy device info (strings are already allocated by the enumerator)
+            // Copy device info (strings are already allocated by the registry)
             for (size_t i = 0; i < deviceList.size(); i++) {
                 (*devices)[i] = deviceList[i];
             }
@@ -186,33 +236,31 @@ void audio_free_device_list(AudioDeviceInfo* devices, int32_t count) {
 }
 
 char* audio_get_default_input_device(void) {
-    EnsureMTAInitialized();
-    
-    std::wstring id = AudioDeviceEnumerator::GetDefaultInputDeviceId();
-    if (id.empty()) return nullptr;
-    
-    // Convert to UTF-8
-    int len = WideCharToMultiByte(CP_UTF8, 0, id.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    if (len <= 0) return nullptr;
-    
-    char* result = static_cast<char*>(malloc(len));
-    WideCharToMultiByte(CP_UTF8, 0, id.c_str(), -1, result, len, nullptr, nullptr);
-    return result;
+    if (!EnsureMTAInitialized()) return nullptr;
+
+    std::string id = DeviceRegistry::Instance().DefaultDeviceId(true);
+    return id.empty() ? nullptr : _strdup(id.c_str());
 }
 
 char* audio_get_default_output_device(void) {
-    EnsureMTAInitialized();
-    
-    std::wstring id = AudioDeviceEnumerator::GetDefaultOutputDeviceId();
-    if (id.empty()) return nullptr;
-    
-    // Convert to UTF-8
-    int len = WideCharToMultiByte(CP_UTF8, 0, id.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    if (len <= 0) return nullptr;
-    
-    char* result = static_cast<char*>(malloc(len));
-    WideCharToMultiByte(CP_UTF8, 0, id.c_str(), -1, result, len, nullptr, nullptr);
-    return result;
+    if (!EnsureMTAInitialized()) return nullptr;
+
+    std::string id = DeviceRegistry::Instance().DefaultDeviceId(false);
+    return id.empty() ? nullptr : _strdup(id.c_str());
+}
+
+// ============================================================================
+// Device Watcher
+// ============================================================================
+
+AudioDeviceWatcherHandle audio_device_watcher_create(AudioDeviceChangeCallback callback, void* context) {
+    if (!callback || !EnsureMTAInitialized()) return nullptr;
+    return DeviceRegistry::Instance().AddWatcher(callback, context);
+}
+
+void audio_device_watcher_destroy(AudioDeviceWatcherHandle handle) {
+    if (!handle) return;
+    DeviceRegistry::Instance().RemoveWatcher(handle);
 }
 
 // ============================================================================
@@ -253,6 +301,7 @@ struct MicActivityMonitorState {
     MicActivityChangeCallback changeCallback;
     MicActivityDeviceCallback deviceCallback;
     MicActivityErrorCallback errorCallback;
+    MicActivityProcessCallback processCallback;
     void* userContext;
     bool isRunning;
 };
@@ -261,6 +310,7 @@ MicActivityMonitorHandle mic_activity_create(
     MicActivityChangeCallback changeCallback,
     MicActivityDeviceCallback deviceCallback,
     MicActivityErrorCallback errorCallback,
+    MicActivityProcessCallback processCallback,
     void* userContext
 ) {
     // Note: We don't initialize COM here to avoid conflicts with Electron's COM state
@@ -270,6 +320,7 @@ MicActivityMonitorHandle mic_activity_create(
         changeCallback,
         deviceCallback,
         errorCallback,
+        processCallback,
         userContext,
         false
     };
@@ -0,0 +1,112 @@
+import { EventEmitter } from 'events'
+import { getDeviceWatcherNative } from './binding.js'
+import type { AudioDeviceWatcherEvents, DeviceWatcherNativeClass, DeviceWatcherNativeEvent } from './types.js'
+
+/**
+ * Reports audio devices being added and removed, and default device changes.
+ *
+ * Events come straight from the native device registry (Core Audio property listeners on
+ * macOS, `IMMNotificationClient` on Windows), the same one that answers `listAudioDevices()`,
+ * so there is nothing to poll. A running watcher doesn't keep the process alive.
+ *
+ * @example
+ * ```typescript
+ * import { AudioDeviceWatcher } from 'native-audio-node'
+ *
+ * const watcher = new AudioDeviceWatcher()
+ *
+ * watcher.on('added', (device) => console.log('Connected:', device.name))
+ * watcher.on('defaultChanged', (device, isInput) => {
+ *   console.log(`Default ${isInput ? 'input' : 'output'}:`, device?.name ?? 'none')
+ * })
+ *
+ * watcher.start()
+ *
+ * // Later...
+ * watcher.stop()
+ * ```
+ */
+export class AudioDeviceWatcher {
+  private events = new EventEmitter()
+  private native: DeviceWatcherNativeClass
+
+  constructor() {
+    const supportedPlatforms = ['darwin', 'win32']
+    if (!supportedPlatforms.includes(process.platform)) {
+      throw new Error(`native-audio-node only supports macOS and Windows. Current platform: ${process.platform}`)
+    }
+
+    const DeviceWatcherNative = getDeviceWatcherNative()
+    this.native = new DeviceWatcherNative()
+  }
+
+  on<K extends keyof AudioDeviceWatcherEvents>(event: K, listener: AudioDeviceWatcherEvents[K]): this {
+    this.events.on(event, listener)
+    return this
+  }
+
+  once<K extends keyof AudioDeviceWatcherEvents>(event: K, listener: AudioDeviceWatcherEvents[K]): this {
+    this.events.once(event, listener)
+    return this
+  }
+
+  off<K extends keyof AudioDeviceWatcherEvents>(event: K, listener: AudioDeviceWatcherEvents[K]): this {
+    this.events.off(event, listener)
+    return this
+  }
+
+  removeAllListeners<K extends keyof AudioDeviceWatcherEvents>(event?: K): this {
+    this.events.removeAllListeners(event)
+    return this
+  }
+
+  /**
+   * Start reporting changes. Changes from before this call are not reported; use
+   * `listAudioDevices()` for the current state.
+   */
+  start(): void {
+    if (this.native.isActive()) {
+      return
+    }
+
+    this.native.start((events) => {
+      for (const event of events) {
+        this.handleNativeEvent(event)
+      }
+    })
+  }
+
+  /**
+   * Stop reporting changes. Changes not yet delivered are dropped.
+   */
+  stop(): void {
+    this.native.stop()
+  }
+
+  /**
+   * Check if the watcher is currently running.
+   */
+  isRunning(): boolean {
+    return this.native.isActive()
+  }
+
+  private handleNativeEvent(event: DeviceWatcherNativeEvent): void {
+    switch (event.type) {
+      case 0: // added
+        if (event.device) {
+          this.events.emit('added', event.device)
+        }
+        break
+
+      case 1: // removed
+        if (event.device) {
+          this.events.emit('removed', event.device)
+        }
+        break
+
+      case 2: // defaultChanged
+        this.events.emit('defaultChanged', event.device ?? null, event.isInput)
+        break
+    }
+  }
+}
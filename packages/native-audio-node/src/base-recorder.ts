@@ -1,17 +1,30 @@
 import { EventEmitter } from 'events'
 import { getAudioRecorderNative } from './binding.js'
-import type { AudioRecorderEvents, AudioChunk, AudioMetadata, AudioRecorderNativeClass } from './types.js'
+import type {
+  AudioRecorderEvents,
+  AudioChunk,
+  AudioMetadata,
+  AudioRecorderNativeClass,
+  AudioRecorderStats,
+  EventDeliveryMode,
+  NativeEvent,
+  StartOptions,
+} from './types.js'
 
 /**
  * Abstract base class for audio recorders.
- * Provides shared EventEmitter functionality, polling, and lifecycle management.
+ * Provides shared EventEmitter functionality, event delivery, and lifecycle management.
  */
 export abstract class BaseAudioRecorder {
   protected events = new EventEmitter()
   protected native: AudioRecorderNativeClass
   protected running = false
   protected pollInterval: ReturnType<typeof setInterval> | null = null
+  protected pushDelivery = false
   protected metadata: AudioMetadata | null = null
+  // Native start or stop in flight; both run on the thread pool
+  protected starting: Promise<void> | null = null
+  protected stopping: Promise<void> | null = null
 
   constructor() {
     // Check platform at construction time
@@ -49,13 +62,22 @@ export abstract class BaseAudioRecorder {
   }
 
   protected processNativeEvents(): void {
-    const events = this.native.processEvents()
+    this.handleNativeEvents(this.native.processEvents())
+  }
 
+  protected handleNativeEvents(events: NativeEvent[]): void {
     for (const event of events) {
       switch (event.type) {
         case 0: // data
           if (event.data) {
-            const chunk: AudioChunk = { data: event.data }
+            const chunk: AudioChunk = {
+              data: event.data,
+              sequence: event.sequence ?? 0,
+              framePosition: event.framePosition ?? 0,
+              hostTime: event.hostTime,
+              devicePosition: event.devicePosition,
+              discontinuity: event.discontinuity ?? false,
+            }
             this.emit('data', chunk)
           }
           break
@@ -82,10 +104,64 @@ export abstract class BaseAudioRecorder {
           }
           this.emit('metadata', this.metadata)
           break
+
+        case 5: // speechStart
+        case 6: // speechEnd
+          this.emit(event.type === 5 ? 'speechStart' : 'speechEnd', {
+            framePosition: event.framePosition ?? 0,
+            hostTime: event.hostTime,
+          })
+          break
+
+        case 7: // level
+          this.emit('level', {
+            framePosition: event.framePosition ?? 0,
+            hostTime: event.hostTime,
+            frames: event.frames ?? 0,
+            rms: event.rms ?? [],
+            peak: event.peak ?? [],
+            bands: event.bands,
+          })
+          break
+
+        case 8: // features
+          if (event.features) {
+            this.emit('features', {
+              framePosition: event.framePosition ?? 0,
+              hostTime: event.hostTime,
+              frames: event.frames ?? 0,
+              bins: event.bins ?? 0,
+              hopFrames: event.hopFrames ?? 0,
+              data: event.features,
+            })
+          }
+          break
+
+        case 9: // warning
+          this.emit('warning', event.message || 'Unknown warning')
+          break
       }
     }
   }
 
+  protected startDelivery(mode: EventDeliveryMode = 'poll'): void {
+    if (mode === 'push') {
+      // Native side batches everything queued before the next tick into one call
+      this.native.setEventCallback((events) => this.handleNativeEvents(events))
+      this.pushDelivery = true
+    } else {
+      this.startPolling()
+    }
+  }
+
+  protected stopDelivery(): void {
+    this.stopPolling()
+    if (this.pushDelivery) {
+      this.native.setEventCallback(null)
+      this.pushDelivery = false
+    }
+  }
+
   protected startPolling(): void {
     // Start polling for events from the native addon
     // Use a fast interval to ensure low latency for audio data
@@ -106,30 +182,103 @@ export abstract class BaseAudioRecorder {
   /**
    * Start audio capture. Must be implemented by subclasses.
    */
-  abstract start(): Promise<void>
+  abstract start(options?: StartOptions): Promise<void>
 
   /**
-   * Stop audio capture.
+   * Run a native start, which opens the device off the JavaScript thread, and begin delivering
+   * events once it succeeds. A timeout or abort cancels it: the Promise rejects straight away and
+   * a native start that still succeeds afterwards is stopped again.
    */
-  stop(): Promise<void> {
-    return new Promise((resolve) => {
-      if (!this.running) {
-        resolve()
-        return
+  protected async startNative(
+    name: string,
+    start: () => Promise<void>,
+    delivery: EventDeliveryMode | undefined,
+    options: StartOptions = {}
+  ): Promise<void> {
+    if (this.stopping) await this.stopping.catch(() => undefined)
+    if (this.starting) await this.starting
+    if (this.running) throw new Error(`${name} is already running`)
+    options.signal?.throwIfAborted()
+
+    // Delivery begins as part of the start settling, so a stop() waiting on it sees the result
+    let abandoned = false
+    const started = start().then(() => {
+      if (abandoned) return this.discardSession()
+      this.running = true
+      this.startDelivery(delivery)
+    })
+    const settled = started
+      .catch(() => undefined)
+      .finally(() => {
+        if (this.starting === settled) this.starting = null
+      })
+    this.starting = settled
+
+    let timer: ReturnType<typeof setTimeout> | undefined
+    let onAbort: (() => void) | undefined
+    const interrupted = new Promise<never>((_, reject) => {
+      const timeoutMs = options.timeoutMs
+      if (timeoutMs !== undefined) {
+        timer = setTimeout(() => reject(new Error(`${name} did not start within ${timeoutMs}ms`)), timeoutMs)
+      }
+      const signal = options.signal
+      if (signal) {
+        onAbort = () => reject(signal.reason)
+        signal.addEventListener('abort', onAbort, { once: true })
       }
+    })
+
+    try {
+      await Promise.race([started, interrupted])
+    } catch (error) {
+      // Native undoes a start still in progress; one that has already returned is stopped above
+      abandoned = true
+      this.native.cancelStart()
+      throw error
+    } finally {
+      clearTimeout(timer)
+      if (onAbort) options.signal?.removeEventListener('abort', onAbort)
+    }
+  }
+
+  // A start that succeeded after its caller gave up on it; its events are dropped
+  private async discardSession(): Promise<void> {
+    await this.native.stop()
+    this.native.processEvents()
+  }
+
+  /**
+   * Stop audio capture. A start still in progress is cancelled. The device is closed off the
+   * JavaScript thread; the final chunk and `stop` event are emitted before the Promise resolves.
+   */
+  stop(): Promise<void> {
+    if (!this.stopping) {
+      this.stopping = this.stopNative().finally(() => {
+        this.stopping = null
+      })
+    }
+    return this.stopping
+  }
 
-      // Stop the polling interval
-      this.stopPolling()
+  private async stopNative(): Promise<void> {
+    if (this.starting) {
+      this.native.cancelStart()
+      await this.starting
+    }
+    if (!this.running) return
 
-      // Process any remaining events
-      this.processNativeEvents()
+    // Stop polling / push delivery
+    this.stopDelivery()
 
-      // Stop the native addon
-      this.native.stop()
-      this.running = false
+    // Process any remaining events
+    this.processNativeEvents()
 
-      resolve()
-    })
+    // Stop the native addon
+    await this.native.stop()
+    this.running = false
+
+    // Deliver the final chunk and stop event emitted while shutting down
+    this.processNativeEvents()
   }
 
   /**
@@ -139,6 +288,31 @@ export abstract class BaseAudioRecorder {
     return this.running
   }
 
+  /**
+   * Number of chunks dropped because the native event queue was full.
+   * Counts across sessions for the lifetime of the recorder.
+   */
+  getOverflowCount(): number {
+    return this.native.getOverflowCount()
+  }
+
+  /**
+   * Performance counters of the current or most recent recording: frames captured, emitted and
+   * dropped, event queue depth, native callback time and capture-to-JavaScript latency.
+   */
+  getStats(): AudioRecorderStats {
+    return this.native.getStats()
+  }
+
+  /**
+   * Go live on a recording started with `preRoll`: the last `sinceMs` of history (all of it by
+   * default) is delivered as ordinary chunks with their original `framePosition` and `hostTime`,
+   * followed by live audio. Returns false if the recorder isn't armed or was already committed.
+   */
+  commit(sinceMs?: number): boolean {
+    return this.native.commitPreRoll(sinceMs)
+  }
+
   /**
    * Get the current audio metadata.
    * Returns null if recording hasn't started or metadata hasn't been received yet.
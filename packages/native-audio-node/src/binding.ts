@@ -2,6 +2,7 @@ import { createRequire } from 'module'
 import type {
   AudioDevice,
   AudioRecorderNativeConstructor,
+  DeviceWatcherNativeConstructor,
   MicActivityMonitorNativeConstructor,
 } from './types.js'
 
@@ -16,6 +17,9 @@ export interface NativeAddon {
   // Mic activity monitor class
   MicActivityMonitorNative: MicActivityMonitorNativeConstructor
 
+  // Device change notifications
+  DeviceWatcherNative: DeviceWatcherNativeConstructor
+
   // Device management
   listDevices(): AudioDevice[]
   getDefaultInputDevice(): string | null
@@ -124,3 +128,10 @@ export function getAudioRecorderNative(): AudioRecorderNativeConstructor {
 export function getMicActivityMonitorNative(): MicActivityMonitorNativeConstructor {
   return loadBinding().MicActivityMonitorNative
 }
+
+/**
+ * Get the DeviceWatcherNative constructor from the native addon.
+ */
+export function getDeviceWatcherNative(): DeviceWatcherNativeConstructor {
+  return loadBinding().DeviceWatcherNative
+}
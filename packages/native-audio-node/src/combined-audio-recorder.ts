@@ -0,0 +1,77 @@
+import { BaseAudioRecorder } from './base-recorder.js'
+import type { CombinedRecorderOptions, StartOptions } from './types.js'
+import { sharedRingView } from './shared-audio-ring.js'
+
+/**
+ * Captures the microphone and system audio together as one native stream.
+ *
+ * Both sources are converted to a common sample rate and aligned on the host clock using
+ * the device timestamps of every buffer, with drift between the two devices corrected
+ * natively. Chunks are `pcm_f32le` (unless `encoding` says otherwise) and either interleave
+ * the sources, microphone channels first, or mix them, or carry the microphone alone with
+ * the system audio's echo cancelled from it.
+ *
+ * @example
+ * ```typescript
+ * import { CombinedAudioRecorder } from 'native-audio-node'
+ *
+ * const recorder = new CombinedAudioRecorder({
+ *   sampleRate: 16000,
+ *   layout: 'interleaved', // channel 0: microphone, channel 1: system audio
+ *   system: { mute: false },
+ * })
+ *
+ * recorder.on('data', (chunk) => {
+ *   const samples = new Float32Array(chunk.data.buffer, chunk.data.byteOffset, chunk.data.length / 4)
+ * })
+ *
+ * await recorder.start()
+ * // ... record audio
+ * await recorder.stop()
+ * ```
+ */
+export class CombinedAudioRecorder extends BaseAudioRecorder {
+  private options: CombinedRecorderOptions
+
+  constructor(options: CombinedRecorderOptions = {}) {
+    super()
+    this.options = options
+  }
+
+  /**
+   * Start capturing both sources.
+   * @param options Timeout and abort signal for this start
+   * @throws Error if already running, if permission is denied, or if either source fails to start
+   */
+  start(options?: StartOptions): Promise<void> {
+    return this.startNative(
+      'CombinedAudioRecorder',
+      () =>
+        this.native.startCombined({
+          sampleRate: this.options.sampleRate,
+          chunkDurationMs: this.options.chunkDurationMs,
+          stereo: this.options.stereo,
+          layout: this.options.layout,
+          echoTailMs: this.options.echoTailMs,
+          latencyMode: this.options.latencyMode,
+          microphone: this.options.microphone,
+          system: this.options.system,
+          zeroCopy: this.options.zeroCopy,
+          queueCapacityBytes: this.options.queueCapacityBytes,
+          overflowPolicy: this.options.overflowPolicy,
+          bufferDurationMs: this.options.bufferDurationMs,
+          resamplerQuality: this.options.resamplerQuality,
+          encoding: this.options.encoding,
+          bitrate: this.options.bitrate,
+          vad: this.options.vad,
+          meter: this.options.meter,
+          features: this.options.features,
+          preRoll: this.options.preRoll,
+          fileSink: this.options.fileSink,
+          sharedRing: sharedRingView(this.options.sharedRing),
+        }),
+      this.options.delivery,
+      options
+    )
+  }
+}
@@ -5,6 +5,9 @@ import type { AudioDevice } from './types.js'
  * List all audio devices on the system.
  * Returns both input and output devices with their properties.
  *
+ * Devices are enumerated once and then kept current by native change notifications, so this
+ * is cheap to call. Use `AudioDeviceWatcher` to be told about changes instead of polling.
+ *
  * @example
  * ```typescript
  * import { listAudioDevices } from 'native-audio-node'
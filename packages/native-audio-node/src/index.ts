@@ -1,25 +1,53 @@
 // Recorder classes
 export { SystemAudioRecorder } from './system-audio-recorder.js'
 export { MicrophoneRecorder } from './microphone-recorder.js'
+export { CombinedAudioRecorder } from './combined-audio-recorder.js'
 
 // Microphone activity monitoring
 export { MicrophoneActivityMonitor } from './microphone-activity-monitor.js'
 
 // Device enumeration
 export { listAudioDevices, getDefaultInputDevice, getDefaultOutputDevice } from './devices.js'
+export { AudioDeviceWatcher } from './audio-device-watcher.js'
+
+// Shared-memory delivery to worker threads
+export { createSharedAudioRing, SharedAudioRingReader } from './shared-audio-ring.js'
 
 // Types
 export type {
   AudioRecorderOptions,
   SystemAudioRecorderOptions,
   MicrophoneRecorderOptions,
+  CombinedRecorderOptions,
+  CombinedLayout,
   MicrophoneActivityMonitorOptions,
   MicrophoneActivityMonitorEvents,
   AudioChunk,
   AudioMetadata,
+  AudioRecorderStats,
+  DurationStats,
   AudioDevice,
+  AudioDeviceWatcherEvents,
   AudioProcess,
   AudioRecorderEvents,
+  EventDeliveryMode,
+  OverflowPolicy,
+  ResamplerQuality,
+  LatencyMode,
+  AudioEncoding,
+  VoiceActivityOptions,
+  SpeechEvent,
+  MeterOptions,
+  LevelEvent,
+  FeatureOptions,
+  FeatureEvent,
+  PreRollOptions,
+  FileSinkOptions,
+  FileContainer,
+  SharedAudioRingFormat,
+  SharedAudioRingState,
+  ChannelMap,
+  StartOptions,
 } from './types.js'
 
 // Permission API
@@ -138,9 +138,10 @@ export class MicrophoneActivityMonitor {
   /**
    * Get list of processes currently using the microphone.
    *
-   * **macOS:** Uses Core Audio's kAudioHardwarePropertyProcessObjectList API
-   * to identify which applications are actively using microphone input.
-   * Returns process name, PID, and bundle identifier.
+   * **macOS:** Uses Core Audio's process objects to identify which applications
+   * are actively using microphone input. While the monitor runs, this is answered
+   * from a process table kept current by per-process notifications, so it is cheap
+   * to call on every event. Returns process name, PID, and bundle identifier.
    *
    * **Windows:** Uses WASAPI IAudioSessionManager2 to enumerate active capture
    * sessions on the default microphone device. Returns process name and PID.
@@ -225,6 +226,12 @@ export class MicrophoneActivityMonitor {
       case 2: // error
         this.events.emit('error', new Error(event.message || 'Unknown error'))
         break
+
+      case 3: // processChange
+        if (event.process && event.isActive !== undefined) {
+          this.events.emit('processChange', event.process, event.isActive)
+        }
+        break
     }
   }
 
@@ -1,5 +1,6 @@
 import { BaseAudioRecorder } from './base-recorder.js'
-import type { MicrophoneRecorderOptions } from './types.js'
+import type { MicrophoneRecorderOptions, StartOptions } from './types.js'
+import { sharedRingView } from './shared-audio-ring.js'
 
 /**
  * Captures microphone audio on macOS using Core Audio.
@@ -39,16 +40,13 @@ export class MicrophoneRecorder extends BaseAudioRecorder {
 
   /**
    * Start capturing microphone audio.
+   * @param options Timeout and abort signal for this start
    * @throws Error if already running or if permission is denied
    */
-  start(): Promise<void> {
-    return new Promise((resolve, reject) => {
-      if (this.running) {
-        reject(new Error('MicrophoneRecorder is already running'))
-        return
-      }
-
-      try {
+  start(options?: StartOptions): Promise<void> {
+    return this.startNative(
+      'MicrophoneRecorder',
+      () =>
         this.native.startMicrophone({
           sampleRate: this.options.sampleRate,
           chunkDurationMs: this.options.chunkDurationMs,
@@ -56,14 +54,25 @@ export class MicrophoneRecorder extends BaseAudioRecorder {
           emitSilence: this.options.emitSilence ?? true,
           deviceId: this.options.deviceId,
           gain: this.options.gain,
-        })
-
-        this.running = true
-        this.startPolling()
-        resolve()
-      } catch (error) {
-        reject(error)
-      }
-    })
+          latencyMode: this.options.latencyMode,
+          zeroCopy: this.options.zeroCopy,
+          queueCapacityBytes: this.options.queueCapacityBytes,
+          overflowPolicy: this.options.overflowPolicy,
+          bufferDurationMs: this.options.bufferDurationMs,
+          resamplerQuality: this.options.resamplerQuality,
+          encoding: this.options.encoding,
+          bitrate: this.options.bitrate,
+          vad: this.options.vad,
+          meter: this.options.meter,
+          features: this.options.features,
+          preRoll: this.options.preRoll,
+          fileSink: this.options.fileSink,
+          sharedRing: sharedRingView(this.options.sharedRing),
+          channels: this.options.channels,
+          shared: this.options.shared,
+        }),
+      this.options.delivery,
+      options
+    )
   }
 }
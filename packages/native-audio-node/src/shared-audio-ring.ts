@@ -0,0 +1,212 @@
+import type { SharedAudioRingFormat, SharedAudioRingState } from './types.js'
+
+// Header layout, in Int32 slots; mirrors native/common/shared_ring.h
+const WRITE_POSITION = 0
+const READ_POSITION = 1
+const DROPPED_CHUNKS = 2
+const STATE = 3
+const FORMAT_SEQUENCE = 4
+const FORMAT_POSITION = 5
+const SAMPLE_RATE = 6
+const CHANNELS = 7
+const BITS_PER_CHANNEL = 8
+const IS_FLOAT = 9
+const CAPACITY = 10
+
+const HEADER_BYTES = 64
+const MIN_CAPACITY = 1024
+const MAX_CAPACITY = 2 ** 30
+
+const STATES: SharedAudioRingState[] = ['idle', 'capturing', 'stopped']
+
+/**
+ * Create a ring for the `sharedRing` recorder option.
+ *
+ * The buffer holds a small header and `capacityBytes` of audio, rounded up to a power of two.
+ * Hand the same buffer to a worker and read it there with {@link SharedAudioRingReader}.
+ *
+ * @param capacityBytes Audio the ring can hold before chunks are dropped; 1 MiB by default
+ */
+export function createSharedAudioRing(capacityBytes = 1024 * 1024): SharedArrayBuffer {
+  if (!(capacityBytes > 0) || capacityBytes > MAX_CAPACITY) {
+    throw new RangeError(`capacityBytes must be between 1 and ${MAX_CAPACITY}`)
+  }
+
+  let capacity = MIN_CAPACITY
+  while (capacity < capacityBytes) {
+    capacity *= 2
+  }
+
+  const buffer = new SharedArrayBuffer(HEADER_BYTES + capacity)
+  Atomics.store(new Int32Array(buffer, 0, HEADER_BYTES / 4), CAPACITY, capacity)
+  return buffer
+}
+
+/** The view the native recorder takes a ring as */
+export function sharedRingView(buffer: SharedArrayBuffer | undefined): Int32Array | undefined {
+  return buffer ? new Int32Array(buffer) : undefined
+}
+
+/**
+ * Reads the PCM a recorder writes into a shared ring, typically in a worker thread.
+ *
+ * The recorder copies each chunk straight into the buffer from its native thread and advances
+ * the ring's write position; nothing per chunk reaches either thread's event loop. A reader
+ * blocks in `Atomics.wait()` until there is data. Only JavaScript can end such a wait, so the
+ * recorder's thread calls `Atomics.notify()` after writes, batched; if that thread is busy,
+ * wake-ups come late but no audio is lost until the ring is full. Chunks that don't fit are
+ * dropped whole and counted by {@link droppedChunks}.
+ *
+ * One reader per ring. A ring can be reused across recordings; it carries on where it was.
+ *
+ * @example
+ * ```typescript
+ * // main thread
+ * const ring = createSharedAudioRing()
+ * new Worker('./dsp.js', { workerData: ring })
+ * await new MicrophoneRecorder({ sharedRing: ring }).start()
+ *
+ * // dsp.js
+ * const reader = new SharedAudioRingReader(workerData)
+ * const frame = new Uint8Array(16384)
+ * while (reader.waitForData()) {
+ *   const bytes = reader.read(frame)
+ *   analyze(frame.subarray(0, bytes), reader.format)
+ * }
+ * ```
+ */
+export class SharedAudioRingReader {
+  private header: Int32Array
+  private data: Uint8Array
+  private capacity: number
+  private formatSequence = 0
+  private currentFormat: SharedAudioRingFormat | null = null
+  private pendingFormat: { format: SharedAudioRingFormat; position: number } | null = null
+
+  constructor(buffer: SharedArrayBuffer) {
+    this.header = new Int32Array(buffer, 0, HEADER_BYTES / 4)
+    this.capacity = Atomics.load(this.header, CAPACITY)
+    if (this.capacity < MIN_CAPACITY || buffer.byteLength < HEADER_BYTES + this.capacity) {
+      throw new TypeError('Not a shared audio ring; create it with createSharedAudioRing()')
+    }
+    this.data = new Uint8Array(buffer, HEADER_BYTES, this.capacity)
+  }
+
+  /** Format of the next bytes {@link read} returns; null until the recorder has reported one */
+  get format(): SharedAudioRingFormat | null {
+    this.refreshFormat()
+    if (this.pendingFormat && this.pendingFormat.position === Atomics.load(this.header, READ_POSITION)) {
+      this.adoptPendingFormat()
+    }
+    return this.currentFormat
+  }
+
+  /** Whether the recorder writing the ring has started, is capturing or has stopped */
+  get state(): SharedAudioRingState {
+    return STATES[Atomics.load(this.header, STATE)] ?? 'idle'
+  }
+
+  /** Bytes written and not yet read */
+  get available(): number {
+    return (Atomics.load(this.header, WRITE_POSITION) - Atomics.load(this.header, READ_POSITION)) >>> 0
+  }
+
+  /** Chunks the recorder dropped because the ring was full */
+  get droppedChunks(): number {
+    return Atomics.load(this.header, DROPPED_CHUNKS) >>> 0
+  }
+
+  /**
+   * Block the calling thread until there is data to read or the recorder stops.
+   *
+   * @param timeoutMs Give up after this long
+   * @returns Whether there is data; false on timeout, or once a stopped recorder's data is read
+   */
+  waitForData(timeoutMs = Infinity): boolean {
+    const deadline = performance.now() + timeoutMs
+    for (;;) {
+      const write = Atomics.load(this.header, WRITE_POSITION)
+      if (write !== Atomics.load(this.header, READ_POSITION)) {
+        return true
+      }
+      if (this.state === 'stopped') {
+        return false
+      }
+
+      // Woken by writes and by the recorder starting and stopping
+      const remaining = deadline - performance.now()
+      if (remaining <= 0) {
+        return false
+      }
+      Atomics.wait(this.header, WRITE_POSITION, write, remaining)
+    }
+  }
+
+  /**
+   * Copy as many whole frames as are available and fit into `target`, without blocking. Stops
+   * short of a format change, so that everything returned is in {@link format}.
+   *
+   * @returns The number of bytes copied
+   */
+  read(target: Uint8Array): number {
+    this.refreshFormat()
+
+    const read = Atomics.load(this.header, READ_POSITION)
+    let bytes = Math.min((Atomics.load(this.header, WRITE_POSITION) - read) >>> 0, target.byteLength)
+    if (this.pendingFormat) {
+      const untilFormat = (this.pendingFormat.position - read) >>> 0
+      if (untilFormat === 0) {
+        this.adoptPendingFormat()
+      } else {
+        bytes = Math.min(bytes, untilFormat)
+      }
+    }
+
+    const format = this.currentFormat
+    if (format) {
+      const frameBytes = format.channelsPerFrame * (format.bitsPerChannel / 8)
+      bytes -= bytes % frameBytes
+    }
+    if (bytes === 0) {
+      return 0
+    }
+
+    const offset = read & (this.capacity - 1)
+    const first = Math.min(bytes, this.capacity - offset)
+    target.set(this.data.subarray(offset, offset + first))
+    if (first < bytes) {
+      target.set(this.data.subarray(0, bytes - first), first)
+    }
+
+    Atomics.store(this.header, READ_POSITION, (read + bytes) | 0)
+    return bytes
+  }
+
+  // The recorder publishes a format with the position it applies from; a change is only
+  // picked up once its sequence number is even and the same before and after
+  private refreshFormat(): void {
+    const sequence = Atomics.load(this.header, FORMAT_SEQUENCE)
+    if (sequence === this.formatSequence || sequence & 1) {
+      return
+    }
+
+    const format: SharedAudioRingFormat = {
+      sampleRate: Atomics.load(this.header, SAMPLE_RATE),
+      channelsPerFrame: Atomics.load(this.header, CHANNELS),
+      bitsPerChannel: Atomics.load(this.header, BITS_PER_CHANNEL),
+      isFloat: Atomics.load(this.header, IS_FLOAT) !== 0,
+    }
+    const position = Atomics.load(this.header, FORMAT_POSITION)
+    if (Atomics.load(this.header, FORMAT_SEQUENCE) !== sequence) {
+      return
+    }
+
+    this.formatSequence = sequence
+    this.pendingFormat = { format, position }
+  }
+
+  private adoptPendingFormat(): void {
+    this.currentFormat = this.pendingFormat?.format ?? this.currentFormat
+    this.pendingFormat = null
+  }
+}
@@ -1,5 +1,6 @@
 import { BaseAudioRecorder } from './base-recorder.js'
-import type { SystemAudioRecorderOptions } from './types.js'
+import type { SystemAudioRecorderOptions, StartOptions } from './types.js'
+import { sharedRingView } from './shared-audio-ring.js'
 
 /**
  * Captures system audio on macOS using Core Audio process taps.
@@ -34,16 +35,13 @@ export class SystemAudioRecorder extends BaseAudioRecorder {
 
   /**
    * Start capturing system audio.
+   * @param options Timeout and abort signal for this start
    * @throws Error if already running or if permission is denied
    */
-  start(): Promise<void> {
-    return new Promise((resolve, reject) => {
-      if (this.running) {
-        reject(new Error('SystemAudioRecorder is already running'))
-        return
-      }
-
-      try {
+  start(options?: StartOptions): Promise<void> {
+    return this.startNative(
+      'SystemAudioRecorder',
+      () =>
         this.native.startSystemAudio({
           sampleRate: this.options.sampleRate,
           chunkDurationMs: this.options.chunkDurationMs,
@@ -52,14 +50,25 @@ export class SystemAudioRecorder extends BaseAudioRecorder {
           emitSilence: this.options.emitSilence ?? true,
           includeProcesses: this.options.includeProcesses,
           excludeProcesses: this.options.excludeProcesses,
-        })
-
-        this.running = true
-        this.startPolling()
-        resolve()
-      } catch (error) {
-        reject(error)
-      }
-    })
+          tapCacheTtlMs: this.options.tapCacheTtlMs,
+          zeroCopy: this.options.zeroCopy,
+          queueCapacityBytes: this.options.queueCapacityBytes,
+          overflowPolicy: this.options.overflowPolicy,
+          bufferDurationMs: this.options.bufferDurationMs,
+          resamplerQuality: this.options.resamplerQuality,
+          encoding: this.options.encoding,
+          bitrate: this.options.bitrate,
+          vad: this.options.vad,
+          meter: this.options.meter,
+          features: this.options.features,
+          preRoll: this.options.preRoll,
+          fileSink: this.options.fileSink,
+          sharedRing: sharedRingView(this.options.sharedRing),
+          channels: this.options.channels,
+          shared: this.options.shared,
+        }),
+      this.options.delivery,
+      options
+    )
   }
 }
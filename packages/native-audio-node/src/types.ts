@@ -1,6 +1,74 @@
 // Common audio chunk structure
 export interface AudioChunk {
   data: Buffer
+  /**
+   * Number of chunks produced before this one in the current recording. A gap means
+   * chunks were dropped on the way to JavaScript (see `getOverflowCount()`).
+   */
+  sequence: number
+  /**
+   * Frames delivered ahead of this chunk since the recording started.
+   * With FLAC or Opus, the position of the PCM chunk that completed the packet.
+   */
+  framePosition: number
+  /**
+   * Host clock time of the chunk's first frame in nanoseconds, taken from the device timestamps:
+   * `mach_absolute_time` on macOS, `QueryPerformanceCounter` on Windows. Monotonic; compare chunks
+   * with each other or with other timestamps on the same clock.
+   * Undefined when the platform reported no timestamp.
+   */
+  hostTime?: bigint
+  /**
+   * Position of the chunk's first frame on the device's own sample counter, in device frames.
+   * Undefined for macOS microphones, combined recordings and Windows process mixes.
+   */
+  devicePosition?: number
+  /**
+   * Audio just before this chunk was lost or glitched: the device reported a discontinuity
+   * (`AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY` on Windows, a sample time jump on macOS)
+   * or a native buffer overran.
+   */
+  discontinuity: boolean
+}
+
+/** Distribution of a duration, in milliseconds. Percentiles are accurate to about 6%. */
+export interface DurationStats {
+  count: number
+  p50Ms: number
+  p99Ms: number
+  maxMs: number
+}
+
+/**
+ * Counters of the current recording, or of the last one once it has stopped.
+ * Reset by each `start()`.
+ */
+export interface AudioRecorderStats {
+  /** Frames received from the device, at the device rate */
+  framesCaptured: number
+  /** Frames delivered in chunks, at the output rate */
+  framesEmitted: number
+  /** Frames lost natively before conversion, e.g. to a full mixing or shared-capture buffer */
+  framesDropped: number
+  /** Chunks handed to JavaScript */
+  chunksDelivered: number
+  /** Chunks dropped because the event queue was full; same as `getOverflowCount()` */
+  chunksDropped: number
+  /** Bytes waiting in the event queue */
+  queueBytes: number
+  /** Most bytes waiting in the event queue at once */
+  queueHighWaterBytes: number
+  queueCapacityBytes: number
+  /** Time spent in the native capture callback per device buffer */
+  callbackDuration: DurationStats
+  /** From a chunk's `hostTime` to its delivery to JavaScript */
+  latency: DurationStats
+  /** Total time spent resampling and converting */
+  conversionTimeMs: number
+  /** Audio bytes written by the file sink; 0 without one */
+  fileBytesWritten: number
+  /** Audio bytes the file sink dropped because the disk fell behind */
+  fileBytesDropped: number
 }
 
 // Audio metadata from native layer
@@ -12,6 +80,266 @@ export interface AudioMetadata {
   encoding: string
 }
 
+/**
+ * How native events reach JavaScript.
+ * - 'poll': drain the native queue on a 10ms timer
+ * - 'push': the native layer wakes the event loop only when events are queued
+ */
+export type EventDeliveryMode = 'poll' | 'push'
+
+/**
+ * What the native event queue does when JavaScript falls behind and it fills up.
+ * - 'drop-oldest': discard the oldest queued chunk to make room
+ * - 'drop-newest': discard the incoming chunk
+ * - 'block': make the capture thread wait for JavaScript to drain the queue
+ */
+export type OverflowPolicy = 'drop-oldest' | 'drop-newest' | 'block'
+
+/**
+ * Sample rate converter quality, used when `sampleRate` differs from the device rate.
+ * - 'fast': shortest filters, lowest CPU
+ * - 'balanced': good alias rejection for speech recognition
+ * - 'high': longest filters, best stopband
+ */
+export type ResamplerQuality = 'fast' | 'balanced' | 'high'
+
+/**
+ * How a microphone is opened. **Windows only** - macOS latency follows `bufferDurationMs`.
+ * - 'default': shared mode at the audio engine's default period (typically 10ms)
+ * - 'low': shared mode at the smallest period the engine allows for the device (IAudioClient3),
+ *   often 2-3ms; `bufferDurationMs` is ignored
+ * - 'exclusive': the device alone, in its own format, at its minimum period (or `bufferDurationMs`
+ *   if longer), bypassing the system mixer; other applications cannot use it meanwhile
+ *
+ * A mode the device refuses falls back to the next one down with a `warning` event.
+ * The `metadata` event reports the sample rate and channels the device was opened with.
+ */
+export type LatencyMode = 'default' | 'low' | 'exclusive'
+
+/**
+ * Output encoding of data chunks, produced natively on the capture side.
+ * - 'pcm_s16le': 16-bit PCM, dithered when the capture format is float
+ * - 'pcm_f32le': 32-bit float PCM
+ * - 'flac': a native FLAC stream; the first chunk holds the stream header, every other chunk is one frame
+ * - 'opus': one raw Opus packet (20ms) per chunk; requires an addon built against libopus
+ */
+export type AudioEncoding = 'pcm_s16le' | 'pcm_f32le' | 'flac' | 'opus'
+
+/**
+ * Native voice activity detection. Audio is classified in 10 ms frames by its energy in the
+ * speech band (250-3500 Hz) relative to a tracked noise floor, and by how much of the frame's
+ * energy that band holds.
+ */
+export interface VoiceActivityOptions {
+  /**
+   * Only deliver chunks that contain speech, plus `preRollMs` of audio before it.
+   * Otherwise every chunk is delivered and only the speech events are added.
+   * Skipped chunks show up as jumps in `framePosition`, not in `sequence`.
+   *
+   * @default true
+   */
+  speechOnly?: boolean
+  /**
+   * How far above the noise floor speech band energy must be, in dB. Lower is more sensitive.
+   *
+   * @default 9
+   */
+  thresholdDb?: number
+  /**
+   * Voiced audio needed before speech starts; shorter clicks and bumps are ignored.
+   *
+   * @default 60
+   */
+  minSpeechMs?: number
+  /**
+   * Unvoiced audio needed before speech ends, so pauses between words don't split it.
+   *
+   * @default 400
+   */
+  hangoverMs?: number
+  /**
+   * Audio delivered ahead of speech start in speech-only mode, rounded out to whole chunks.
+   *
+   * @default 300
+   */
+  preRollMs?: number
+}
+
+/**
+ * Native level metering. RMS and peak levels are computed per channel on the capture thread
+ * and reported as `level` events, one per `intervalMs` of audio.
+ */
+export interface MeterOptions {
+  /**
+   * Audio covered by each `level` event.
+   *
+   * @default 33
+   */
+  intervalMs?: number
+  /**
+   * Also report low (below 250 Hz), mid (250-4000 Hz) and high (above 4000 Hz) band levels
+   * of the mono mix.
+   *
+   * @default false
+   */
+  bands?: boolean
+  /**
+   * Keep delivering `data` chunks. With `false` only `level` events (and any speech events)
+   * reach JS, sparing the copy and the garbage of shipping PCM nobody reads.
+   *
+   * @default true
+   */
+  pcm?: boolean
+}
+
+/**
+ * Native log-mel features for speech recognition, computed on the capture thread after the sample
+ * rate converter. The mono mix is cut into Hann-windowed frames of `windowMs` every `hopMs`; each
+ * frame is the natural log of its power spectrum through `melBins` triangular filters on the HTK
+ * mel scale, floored at 1e-10. Frames are reported as `features` events, one per chunk.
+ */
+export interface FeatureOptions {
+  /**
+   * Frame length.
+   *
+   * @default 25
+   */
+  windowMs?: number
+  /**
+   * Step between the starts of consecutive frames.
+   *
+   * @default 10
+   */
+  hopMs?: number
+  /**
+   * Mel filters, and so values, per frame (1-256).
+   *
+   * @default 80
+   */
+  melBins?: number
+  /**
+   * FFT length, a power of two from 16 to 8192 that holds a window. Zero padding past the window
+   * gives a finer spectrum.
+   *
+   * @default The smallest that fits
+   */
+  fftSize?: number
+  /**
+   * Lower edge of the lowest filter, in Hz.
+   *
+   * @default 0
+   */
+  minHz?: number
+  /**
+   * Upper edge of the highest filter, in Hz; at most half the sample rate.
+   *
+   * @default Half the sample rate
+   */
+  maxHz?: number
+  /**
+   * Keep delivering `data` chunks. With `false` only `features` events (and other non-PCM
+   * events) reach JS; at 16 kHz, 80 bins every 10 ms take half the bytes of float PCM.
+   *
+   * @default true
+   */
+  pcm?: boolean
+}
+
+/**
+ * Pre-roll history for an armed recording. Until `commit()` is called, captured audio is kept in a
+ * fixed-size native ring instead of being delivered; older audio is overwritten.
+ */
+export interface PreRollOptions {
+  /**
+   * History kept while armed.
+   *
+   * @default 2000
+   */
+  durationMs?: number
+  /**
+   * Store float audio as 16-bit PCM, halving the ring's memory. Committed chunks are still
+   * delivered in the recorder's format.
+   *
+   * @default false
+   */
+  int16?: boolean
+}
+
+/**
+ * Container of a native file sink.
+ * - 'wav': PCM; sizes are patched on stop (they saturate past 4 GiB)
+ * - 'caf': PCM in Core Audio Format, readable even if the recording never stopped cleanly
+ * - 'ogg': Ogg Opus, for `encoding: 'opus'`
+ * - 'flac': the native FLAC stream, for `encoding: 'flac'`
+ */
+export type FileContainer = 'wav' | 'caf' | 'ogg' | 'flac'
+
+/**
+ * Native file sink. Output chunks are written to the file by a native I/O thread, in large
+ * block-aligned writes, without passing through JavaScript. The file holds exactly what `data`
+ * events would carry, after `vad` and `encoding`, and is complete once `stop()` resolves.
+ */
+export interface FileSinkOptions {
+  /** File to create; an existing file is overwritten */
+  path: string
+  /**
+   * @default 'ogg' for Opus, 'flac' for FLAC, otherwise 'wav'
+   */
+  container?: FileContainer
+  /**
+   * Keep delivering `data` events as well. With `false` nothing of the audio reaches JS, which
+   * takes JavaScript off the hot path of record-to-disk sessions.
+   *
+   * @default true
+   */
+  deliver?: boolean
+  /** Disk space to reserve up front, in bytes; what isn't used is given back on stop */
+  preallocateBytes?: number
+  /**
+   * Buffer between the capture and the I/O thread, in bytes. If the disk falls this far
+   * behind, chunks are dropped from the file, counted by `fileBytesDropped` and reported once
+   * as an `error`.
+   *
+   * @default 4194304 (4 MiB)
+   */
+  bufferBytes?: number
+}
+
+/** Format of the PCM in a shared ring, as the recorder's `metadata` event reports it */
+export interface SharedAudioRingFormat {
+  sampleRate: number
+  channelsPerFrame: number
+  bitsPerChannel: number
+  isFloat: boolean
+}
+
+/**
+ * Where the recorder writing a shared ring is.
+ * - 'idle': it hasn't started
+ * - 'capturing': it is writing
+ * - 'stopped': it has stopped; what is left in the ring is all there is
+ */
+export type SharedAudioRingState = 'idle' | 'capturing' | 'stopped'
+
+/**
+ * Which device channels a recording keeps, applied natively before resampling and chunking.
+ * - `number[]`: 0-based device channels, in output order; `[2, 3]` keeps channels 3 and 4
+ * - `{ matrix }`: one row per output channel, weighting each device channel; device channels
+ *   past the end of the rows are ignored
+ */
+export type ChannelMap = number[] | { matrix: number[][] }
+
+/** Options for one `start()` call */
+export interface StartOptions {
+  /**
+   * Reject if the native start hasn't finished within this many milliseconds. A start that
+   * finishes later is stopped again rather than left running.
+   */
+  timeoutMs?: number
+  /** Abort a pending start, with the same clean-up as a timeout */
+  signal?: AbortSignal
+}
+
 // Common options shared by all recorder types
 export interface AudioRecorderOptions {
   sampleRate?: number
@@ -27,6 +355,149 @@ export interface AudioRecorderOptions {
    * @default true
    */
   emitSilence?: boolean
+  /**
+   * How events are delivered from the native layer.
+   *
+   * - `'poll'`: check for new events every 10ms, even when nothing is queued
+   * - `'push'`: native callbacks wake the event loop through a libuv async handle, which
+   *   takes no lock and allocates nothing on the audio thread;
+   *   everything queued before the next JS tick is emitted as one batch, so the
+   *   event loop only wakes when there is data
+   *
+   * @default 'poll'
+   */
+  delivery?: EventDeliveryMode
+  /**
+   * Hand chunks to JavaScript without copying them.
+   *
+   * Chunks are written into preallocated native slabs and exposed as external
+   * Buffers; a slab returns to the pool when its Buffer is garbage collected.
+   * If every slab is in use, chunks fall back to a regular copy. Runtimes that
+   * disallow external buffers (e.g. Electron) always copy.
+   *
+   * @default false
+   */
+  zeroCopy?: boolean
+  /**
+   * Size of the lock-free queue between the capture thread and JavaScript, in bytes.
+   * Rounded up to a power of two. A single chunk can use at most half of it.
+   *
+   * @default 4194304 (4 MiB)
+   */
+  queueCapacityBytes?: number
+  /**
+   * What to do when the queue is full. Dropped chunks are counted by `getOverflowCount()`.
+   *
+   * `'block'` avoids data loss but stalls the capture thread, which may cause glitches.
+   *
+   * @default 'drop-oldest'
+   */
+  overflowPolicy?: OverflowPolicy
+  /**
+   * Device buffer duration in milliseconds.
+   *
+   * **Windows:** Size of the shared-mode WASAPI buffer. Capture is event-driven, so chunks are
+   * delivered as soon as the engine completes each device period (typically 10ms).
+   * **macOS:** IO buffer size of the system audio tap device; ignored for microphones.
+   *
+   * @default Platform default
+   */
+  bufferDurationMs?: number
+  /**
+   * Sample rate converter quality.
+   *
+   * **Windows:** Filter length of the built-in polyphase resampler.
+   * **macOS:** AVAudioConverter sample rate converter quality.
+   *
+   * @default 'balanced'
+   */
+  resamplerQuality?: ResamplerQuality
+  /**
+   * Encode chunks natively before they reach JavaScript. The `metadata` event reports the
+   * resulting format. With FLAC and Opus, chunk sizes follow the codec's frames rather than
+   * `chunkDurationMs`, and any buffered tail is delivered just before `stop`. A stream the
+   * encoder can't take (Opus at 44.1 kHz, say) is delivered as captured, with a `warning`.
+   *
+   * @default The capture format (`pcm_f32le` on Windows, the converter's format on macOS)
+   */
+  encoding?: AudioEncoding
+  /**
+   * Target bitrate in bits per second for lossy encodings (Opus).
+   *
+   * @default Codec default
+   */
+  bitrate?: number
+  /**
+   * Share one native capture with every other shared recorder on the same source
+   * (the same process filter and mute setting, or the same microphone).
+   *
+   * The capture runs at the device's native format. Each recorder gets its own sample rate,
+   * channel layout, chunk duration and gain, converted on its own native thread. Chunks are
+   * `pcm_f32le` unless `encoding` says otherwise. `bufferDurationMs` is taken from whichever
+   * recorder started the capture.
+   *
+   * @default false
+   */
+  shared?: boolean
+  /**
+   * Detect speech natively and emit `speechStart` / `speechEnd` events. Pass `true` for the
+   * defaults (speech-only delivery) or an object to tune them. Runs before `encoding`, so
+   * encoded streams only contain the delivered chunks.
+   *
+   * @default false
+   */
+  vad?: boolean | VoiceActivityOptions
+  /**
+   * Meter levels natively and emit `level` events. Pass `true` for the defaults or an object
+   * to tune them. Measures the captured audio, ahead of `vad` and `encoding`.
+   *
+   * @default false
+   */
+  meter?: boolean | MeterOptions
+  /**
+   * Compute log-mel features natively and emit `features` events. Pass `true` for the defaults
+   * (80 bins, 25 ms windows every 10 ms) or an object to tune them. Sees the audio at `sampleRate`,
+   * ahead of `vad` and `encoding`. If the options don't fit the stream (a window the FFT can't
+   * hold, filters above the Nyquist frequency), a `warning` is emitted and no features follow.
+   *
+   * @default false
+   */
+  features?: boolean | FeatureOptions
+  /**
+   * Start armed: capture runs but nothing is delivered until `commit()`, which flushes up to
+   * `durationMs` of history into the `data` stream and goes live. Pass `true` for the defaults
+   * or an object to tune them. Level events keep flowing while armed.
+   *
+   * @default false
+   */
+  preRoll?: boolean | PreRollOptions
+  /**
+   * Write the recording to a file natively. Pass a path for a WAV file (or the encoding's
+   * container) or an object to tune it.
+   *
+   * @default None
+   */
+  fileSink?: string | FileSinkOptions
+  /**
+   * Write the output PCM into a ring from `createSharedAudioRing()` instead of emitting `data`
+   * events, for a worker to read with `SharedAudioRingReader`. Chunks are copied into the
+   * buffer natively; a full ring drops them, counted by `getOverflowCount()`. Not for FLAC or
+   * Opus output. Other events are emitted as usual.
+   *
+   * @default None
+   */
+  sharedRing?: SharedArrayBuffer
+  /**
+   * Keep only some of the device's channels, or mix them down with your own weights, natively
+   * and ahead of the sample rate converter, so unused channels never reach JavaScript. Replaces
+   * `stereo`. The start fails if the device has fewer channels than the map reads; with
+   * `shared`, the subscriber reports an `error` instead. Up to 64 channels in and out.
+   *
+   * **macOS:** system audio taps have the channels of their mixdown (one or two).
+   *
+   * @default All channels (`stereo`) or a mono downmix
+   */
+  channels?: ChannelMap
 }
 
 // System audio specific options
@@ -38,7 +509,7 @@ export interface SystemAudioRecorderOptions extends AudioRecorderOptions {
   mute?: boolean
   /**
    * Only capture audio from these process IDs.
-   * **Note:** On Windows, only the first process ID is used (OS limitation).
+   * On Windows, each process is captured by its own loopback client and mixed natively into one stream.
    */
   includeProcesses?: number[]
   /**
@@ -46,12 +517,85 @@ export interface SystemAudioRecorderOptions extends AudioRecorderOptions {
    * **Note:** On Windows, only the first process ID is used (OS limitation).
    */
   excludeProcesses?: number[]
+  /**
+   * Keep the process tap and aggregate device for this many milliseconds after `stop()`, so that
+   * a later start with the same processes, `mute` and `stereo` settings reuses them instead of
+   * creating new ones. A muted tap keeps its processes muted while it is kept.
+   * **macOS only** - This option has no effect on Windows.
+   *
+   * @default 0 (destroyed on stop)
+   */
+  tapCacheTtlMs?: number
 }
 
 // Microphone specific options
 export interface MicrophoneRecorderOptions extends AudioRecorderOptions {
   deviceId?: string
   gain?: number
+  /**
+   * How the microphone is opened, for live monitoring (see `LatencyMode`).
+   * **Windows only** - This option has no effect on macOS.
+   * @default 'default'
+   */
+  latencyMode?: LatencyMode
+}
+
+/**
+ * How a combined recording lays out its two sources.
+ * - 'interleaved': microphone channels first, then system audio channels, in every frame
+ * - 'mix': both sources summed into one set of channels
+ * - 'echo-cancelled': the microphone only, with the system audio used as the echo reference and removed
+ *   from it by an adaptive filter, for recording yourself over speakers instead of headphones
+ */
+export type CombinedLayout = 'interleaved' | 'mix' | 'echo-cancelled'
+
+// Combined microphone + system audio options
+export interface CombinedRecorderOptions extends Omit<AudioRecorderOptions, 'emitSilence' | 'shared' | 'channels'> {
+  /**
+   * Sample rate both sources are converted to.
+   * @default 48000
+   */
+  sampleRate?: number
+  /**
+   * Channels per source: with `stereo`, each source contributes two channels.
+   * Interleaved output therefore has 2 (mono) or 4 (stereo) channels.
+   */
+  stereo?: boolean
+  /**
+   * @default 'interleaved'
+   */
+  layout?: CombinedLayout
+  /**
+   * With the 'echo-cancelled' layout, how much reverberation after the direct echo the filter models, in
+   * milliseconds, up to 500. The delay from the speakers to the microphone is found separately and does not
+   * count towards it. Longer tails cancel more of a reverberant room but converge more slowly.
+   * @default 128
+   */
+  echoTailMs?: number
+  /**
+   * How the microphone is opened, for live monitoring (see `LatencyMode`).
+   * **Windows only** - This option has no effect on macOS.
+   * @default 'default'
+   */
+  latencyMode?: LatencyMode
+  microphone?: {
+    deviceId?: string
+    gain?: number
+  }
+  system?: {
+    /**
+     * Mute the captured processes' audio output.
+     * **macOS only** - This option has no effect on Windows.
+     */
+    mute?: boolean
+    includeProcesses?: number[]
+    excludeProcesses?: number[]
+    /**
+     * Keep the process tap for this many milliseconds after `stop()` (see `SystemAudioRecorderOptions`).
+     * **macOS only** - This option has no effect on Windows.
+     */
+    tapCacheTtlMs?: number
+  }
 }
 
 // Audio device information
@@ -73,18 +617,76 @@ export interface AudioRecorderEvents {
   start: () => void
   stop: () => void
   error: (error: Error) => void
+  /** A notice about a recording that carries on, such as a `latencyMode` the device refused */
+  warning: (message: string) => void
+  speechStart: (event: SpeechEvent) => void
+  speechEnd: (event: SpeechEvent) => void
+  level: (event: LevelEvent) => void
+  features: (event: FeatureEvent) => void
+}
+
+/** Where voice activity detection placed a speech boundary */
+export interface SpeechEvent {
+  /** Frame position of the boundary, on the same scale as `AudioChunk.framePosition` */
+  framePosition: number
+  /** Host clock time of the boundary in nanoseconds, when the chunk had one */
+  hostTime?: bigint
+}
+
+/** Levels of one metering interval. Values are linear, 1 being full scale. */
+export interface LevelEvent {
+  /** Frame position of the interval's first frame, on the same scale as `AudioChunk.framePosition` */
+  framePosition: number
+  /** Host clock time of that frame in nanoseconds, when the chunk had one */
+  hostTime?: bigint
+  /** Frames measured; shorter than `intervalMs` only for the last event before stop */
+  frames: number
+  /** RMS level per channel */
+  rms: number[]
+  /** Peak magnitude per channel */
+  peak: number[]
+  /** RMS level of each band of the mono mix, with `bands: true` */
+  bands?: { low: number; mid: number; high: number }
+}
+
+/** Feature frames completed by one chunk */
+export interface FeatureEvent {
+  /** Frame position where the first frame's window starts, on the same scale as `AudioChunk.framePosition` */
+  framePosition: number
+  /** Host clock time of that frame in nanoseconds, when the chunk had one */
+  hostTime?: bigint
+  /** Feature frames in `data` */
+  frames: number
+  /** Values per frame (`melBins`) */
+  bins: number
+  /** Audio frames between the starts of consecutive feature frames */
+  hopFrames: number
+  /** `frames * bins` log-mel values, frame by frame */
+  data: Float32Array
 }
 
 // Native addon event interface (internal)
 export interface NativeEvent {
-  type: number // 0=data, 1=start, 2=stop, 3=error, 4=metadata
+  type: number // 0=data, 1=start, 2=stop, 3=error, 4=metadata, 5=speechStart, 6=speechEnd, 7=level, 8=features, 9=warning
   data?: Buffer
+  sequence?: number
+  framePosition?: number
+  hostTime?: bigint
+  devicePosition?: number
+  discontinuity?: boolean
   message?: string
   sampleRate?: number
   channelsPerFrame?: number
   bitsPerChannel?: number
   isFloat?: boolean
   encoding?: string
+  frames?: number
+  rms?: number[]
+  peak?: number[]
+  bands?: { low: number; mid: number; high: number }
+  bins?: number
+  hopFrames?: number
+  features?: Float32Array
 }
 
 // ============================================================================
@@ -144,22 +746,79 @@ export interface MicrophoneActivityMonitorEvents {
    */
   deviceChange: (device: AudioDevice, isActive: boolean) => void
 
+  /**
+   * Emitted when a process starts or stops using the microphone.
+   * Processes already using it are reported when the monitor starts.
+   * On Windows this is not emitted yet.
+   */
+  processChange: (process: AudioProcess, isActive: boolean) => void
+
   /**
    * Emitted when an error occurs during monitoring.
    */
   error: (error: Error) => void
 }
 
+/**
+ * Events emitted by AudioDeviceWatcher
+ */
+export interface AudioDeviceWatcherEvents {
+  /**
+   * Emitted when a device appears, e.g. a headset is plugged in.
+   */
+  added: (device: AudioDevice) => void
+
+  /**
+   * Emitted when a device goes away. `device` is the device as it was last listed.
+   */
+  removed: (device: AudioDevice) => void
+
+  /**
+   * Emitted when the default input (`isInput`) or output device changes.
+   * `device` is the new default, or null if there no longer is one.
+   */
+  defaultChanged: (device: AudioDevice | null, isInput: boolean) => void
+}
+
+/**
+ * Native event from the device watcher.
+ * @internal
+ */
+export interface DeviceWatcherNativeEvent {
+  type: number // 0=added, 1=removed, 2=defaultChanged
+  isInput: boolean
+  device?: AudioDevice
+}
+
+/**
+ * Native device watcher class interface.
+ * @internal
+ */
+export interface DeviceWatcherNativeClass {
+  start(callback: (events: DeviceWatcherNativeEvent[]) => void): void
+  stop(): void
+  isActive(): boolean
+}
+
+/**
+ * Native device watcher constructor.
+ * @internal
+ */
+export interface DeviceWatcherNativeConstructor {
+  new (): DeviceWatcherNativeClass
+}
+
 /**
  * Native event from mic activity monitor.
  * @internal
  */
 export interface MicActivityNativeEvent {
-  type: number // 0=change, 1=deviceChange, 2=error
+  type: number // 0=change, 1=deviceChange, 2=error, 3=processChange
   isActive?: boolean
   deviceId?: string
   deviceName?: string
   message?: string
+  process?: { pid: number; name: string; bundleId: string }
   processes?: Array<{ pid: number; name: string; bundleId: string }>
 }
 
@@ -194,7 +853,23 @@ export interface AudioRecorderNativeClass {
     emitSilence?: boolean
     includeProcesses?: number[]
     excludeProcesses?: number[]
-  }): void
+    tapCacheTtlMs?: number
+    zeroCopy?: boolean
+    queueCapacityBytes?: number
+    overflowPolicy?: OverflowPolicy
+    bufferDurationMs?: number
+    resamplerQuality?: ResamplerQuality
+    encoding?: AudioEncoding
+    bitrate?: number
+    vad?: boolean | VoiceActivityOptions
+    meter?: boolean | MeterOptions
+    features?: boolean | FeatureOptions
+    preRoll?: boolean | PreRollOptions
+    fileSink?: string | FileSinkOptions
+    sharedRing?: Int32Array
+    channels?: ChannelMap
+    shared?: boolean
+  }): Promise<void>
   startMicrophone(options: {
     sampleRate?: number
     chunkDurationMs?: number
@@ -202,10 +877,54 @@ export interface AudioRecorderNativeClass {
     emitSilence?: boolean
     deviceId?: string
     gain?: number
-  }): void
-  stop(): void
+    latencyMode?: LatencyMode
+    zeroCopy?: boolean
+    queueCapacityBytes?: number
+    overflowPolicy?: OverflowPolicy
+    bufferDurationMs?: number
+    resamplerQuality?: ResamplerQuality
+    encoding?: AudioEncoding
+    bitrate?: number
+    vad?: boolean | VoiceActivityOptions
+    meter?: boolean | MeterOptions
+    features?: boolean | FeatureOptions
+    preRoll?: boolean | PreRollOptions
+    fileSink?: string | FileSinkOptions
+    sharedRing?: Int32Array
+    channels?: ChannelMap
+    shared?: boolean
+  }): Promise<void>
+  startCombined(options: {
+    sampleRate?: number
+    chunkDurationMs?: number
+    stereo?: boolean
+    layout?: CombinedLayout
+    echoTailMs?: number
+    latencyMode?: LatencyMode
+    microphone?: { deviceId?: string; gain?: number }
+    system?: { mute?: boolean; includeProcesses?: number[]; excludeProcesses?: number[]; tapCacheTtlMs?: number }
+    zeroCopy?: boolean
+    queueCapacityBytes?: number
+    overflowPolicy?: OverflowPolicy
+    bufferDurationMs?: number
+    resamplerQuality?: ResamplerQuality
+    encoding?: AudioEncoding
+    bitrate?: number
+    vad?: boolean | VoiceActivityOptions
+    meter?: boolean | MeterOptions
+    features?: boolean | FeatureOptions
+    preRoll?: boolean | PreRollOptions
+    fileSink?: string | FileSinkOptions
+    sharedRing?: Int32Array
+  }): Promise<void>
+  stop(): Promise<void>
+  cancelStart(): void
   isRunning(): boolean
   processEvents(): NativeEvent[]
+  setEventCallback(callback: ((events: NativeEvent[]) => void) | null): void
+  getOverflowCount(): number
+  getStats(): AudioRecorderStats
+  commitPreRoll(sinceMs?: number): boolean
 }
 
 export interface AudioRecorderNativeConstructor {